@@ -0,0 +1,417 @@
+#include "BatchApp.h"
+#include <Log.h>
+#include <core/AllocationCounters.h>
+#include <core/Clock.h>
+#include <core/CommandLine.h>
+#include <scene/ChunkedModel.h>
+#include <scene/ObjLoader.h>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string_view>
+#include <unordered_map>
+
+namespace app
+{
+namespace {
+// a swapchain that keeps failing to deliver images (e.g. a zero sized surface) ends the batch
+constexpr int MAX_FRAME_ATTEMPTS = 16;
+// larger thumbnails than this are beyond what the capture path is meant for
+constexpr int MAX_SIZE = 16384;
+// models loaded ahead of the one being rendered, each one holds a whole scene in memory
+constexpr std::size_t MAX_PREFETCH = 64;
+
+const std::vector<CameraPreset> &getKnownPresets()
+{
+    static const std::vector<CameraPreset> presets = {
+        {"front", 0.0f, 0.0f},
+        {"back", 3.14159265f, 0.0f},
+        {"left", -1.57079633f, 0.0f},
+        {"right", 1.57079633f, 0.0f},
+        {"top", 0.0f, 1.55f},
+        {"bottom", 0.0f, -1.55f},
+        // isometric: 45 degrees around, arctan(1/sqrt(2)) up
+        {"iso", 0.78539816f, 0.61547971f},
+    };
+    return presets;
+}
+
+bool isModelFile(const std::filesystem::path &path)
+{
+    const auto extension = path.extension();
+    return extension == ".obj" || extension == ".OBJ";
+}
+
+double msSince(std::uint64_t start)
+{
+    return rw::nsToMs(rw::nowNs() - start);
+}
+} // namespace
+
+bool BatchApp::isBatchMode(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string {argv[i]} == "--batch") return true;
+    }
+    return false;
+}
+
+BatchApp::BatchApp(int argc, char **argv)
+{
+    mCaptureOptions.directory = "thumbnails";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--batch")
+        {
+            continue;
+        }
+        else if (arg.rfind("--views=", 0) == 0)
+        {
+            addCameraPresets(arg.substr(8));
+        }
+        else if (arg.rfind("--size=", 0) == 0)
+        {
+            const std::string_view size = std::string_view {arg}.substr(7);
+            const auto separator = size.find('x');
+            glm::ivec2 parsed;
+            if (separator == std::string_view::npos || !rw::parseNumber(size.substr(0, separator), parsed.x, 1, MAX_SIZE) ||
+                !rw::parseNumber(size.substr(separator + 1), parsed.y, 1, MAX_SIZE))
+            {
+                WLOG("Invalid value in {}, expected <width>x<height>, keeping {}x{}", arg, mSize.x, mSize.y);
+            }
+            else
+            {
+                mSize = parsed;
+            }
+        }
+        else if (arg.rfind("--output=", 0) == 0)
+        {
+            mCaptureOptions.directory = arg.substr(9);
+        }
+        else if (arg.rfind("--capture-format=", 0) == 0)
+        {
+            if (!rw::parseImageFormat(arg.substr(17), mCaptureOptions.format))
+            {
+                WLOG("Unknown capture format {}, using png", arg.substr(17));
+            }
+        }
+        else if (arg.rfind("--prefetch=", 0) == 0)
+        {
+            rw::parseOptionValue(arg, mPrefetch, 1, MAX_PREFETCH);
+        }
+        else if (arg.rfind("--gpu=", 0) == 0)
+        {
+            mDeviceSelection.preferred = arg.substr(6);
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            WLOG("Unknown batch option {}", arg);
+        }
+        else
+        {
+            addInput(arg);
+        }
+    }
+    if (mPresets.empty())
+    {
+        addCameraPresets("iso");
+    }
+    if (mModels.empty())
+    {
+        WLOG("Batch: no models to render");
+        return;
+    }
+
+    // shaders load while the device is created
+    auto shaders = std::async(std::launch::async, [this]() { mShaders.preload(rw::SceneRenderer::getShaderNames()); });
+    mWindow = std::make_unique<rw::Window>("rw_model_viewer batch", mSize.x, mSize.y, false);
+    mDevice = std::make_unique<rw::Device>(*mWindow, mDeviceSelection);
+    mRenderer = std::make_unique<rw::Renderer>(*mWindow, *mDevice);
+    shaders.get();
+}
+
+void BatchApp::addInput(const std::string &path)
+{
+    namespace fs = std::filesystem;
+    // @file: one model path per line
+    if (path.rfind('@', 0) == 0)
+    {
+        std::ifstream list {path.substr(1)};
+        if (!list) RT_THROW("Cannot open model list " + path.substr(1));
+        std::string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line.front() != '#') addInput(line);
+        }
+        return;
+    }
+
+    if (fs::is_directory(path))
+    {
+        std::vector<std::string> found;
+        for (const auto &entry : fs::recursive_directory_iterator(path))
+        {
+            if (entry.is_regular_file() && isModelFile(entry.path())) found.push_back(entry.path().string());
+        }
+        // stable order, so reruns write the same files in the same order
+        std::sort(found.begin(), found.end());
+        mModels.insert(mModels.end(), found.begin(), found.end());
+        return;
+    }
+    mModels.push_back(path);
+}
+
+void BatchApp::addCameraPresets(const std::string &list)
+{
+    std::size_t begin = 0;
+    while (begin <= list.size())
+    {
+        const auto end = std::min(list.find(',', begin), list.size());
+        const auto name = list.substr(begin, end - begin);
+        begin = end + 1;
+        if (name.empty()) continue;
+
+        const auto &known = getKnownPresets();
+        auto found = std::find_if(known.begin(), known.end(), [&name](const CameraPreset &preset) { return preset.name == name; });
+        if (found == known.end())
+        {
+            WLOG("Unknown camera preset {}", name);
+            continue;
+        }
+        mPresets.push_back(*found);
+    }
+}
+
+BatchApp::ImportResult BatchApp::import(const std::string &path) const
+{
+    ImportResult result;
+    const std::uint64_t start = rw::nowNs();
+    try
+    {
+        if (rw::ChunkedModel::isChunkedModel(path)) RT_THROW("streamed models can't be rendered in batch mode");
+        result.scene = std::make_unique<rw::Scene>();
+        rw::ObjLoader::load(path, *result.scene);
+    }
+    catch (const std::exception &e)
+    {
+        result.scene.reset();
+        result.error = e.what();
+    }
+    result.importMs = msSince(start);
+    return result;
+}
+
+void BatchApp::run()
+{
+    if (!mWindow) return;
+
+    // pipelines are created once, the cache is shared with the interactive viewer
+    rw::PipelineCache pipelineCache {*mDevice, rw::PipelineCache::readFromDisk(rw::PipelineCache::defaultPath())};
+    rw::SceneRenderer sceneRenderer {*mDevice, mRenderer->getSwapChainRenderPass(), mShaders, mRenderer->getAsyncCompute(), pipelineCache.getHandle()};
+    rw::FrameCapture capture {*mDevice, mCaptureOptions};
+
+    // models with the same file name in different directories get the index appended
+    std::vector<std::string> outputNames(mModels.size());
+    std::unordered_map<std::string, std::size_t> stemCount;
+    for (std::size_t i = 0; i < mModels.size(); ++i)
+    {
+        const auto stem = std::filesystem::path {mModels[i]}.stem().string();
+        const auto count = stemCount[stem]++;
+        outputNames[i] = count == 0 ? stem : stem + "_" + std::to_string(i);
+    }
+
+    rw::ThreadPool importers {mPrefetch};
+    std::deque<std::future<ImportResult>> pending;
+    std::size_t nextImport = 0;
+    auto prefetch = [&]() {
+        while (pending.size() < mPrefetch && nextImport < mModels.size())
+        {
+            const auto &path = mModels[nextImport++];
+            pending.push_back(importers.submit([this, &path]() {
+                rw::AllocationScope allocations {rw::AllocationTag::Loading};
+                return import(path);
+            }));
+        }
+    };
+
+    LOG("Batch: {} model(s) x {} view(s) at {}x{}, {} import(s) in flight, writing to {}", mModels.size(), mPresets.size(), mSize.x, mSize.y,
+        mPrefetch, mCaptureOptions.directory);
+
+    double importMs = 0.0;
+    double waitMs = 0.0;
+    double uploadMs = 0.0;
+    double renderMs = 0.0;
+    std::size_t rendered = 0;
+    std::size_t failed = 0;
+    std::size_t images = 0;
+
+    std::array<rw::AllocationCount, static_cast<std::size_t>(rw::AllocationTag::Count)> allocationsAtStart {};
+    for (std::size_t tag = 0; tag < allocationsAtStart.size(); ++tag)
+    {
+        allocationsAtStart[tag] = rw::getAllocationCount(static_cast<rw::AllocationTag>(tag));
+    }
+    const std::uint64_t hostAllocationsAtStart = mDevice->getHostMemoryStats().getTotalAllocations();
+
+    const std::uint64_t batchStart = rw::nowNs();
+    prefetch();
+    for (std::size_t i = 0; i < mModels.size(); ++i)
+    {
+        std::uint64_t stageStart = rw::nowNs();
+        ImportResult imported = pending.front().get();
+        pending.pop_front();
+        waitMs += msSince(stageStart);
+        // keep the importers busy while this model is on the GPU
+        prefetch();
+
+        importMs += imported.importMs;
+        if (!imported.scene)
+        {
+            ELOG("Batch: skipping {}: {}", mModels[i], imported.error);
+            failed++;
+            continue;
+        }
+
+        stageStart = rw::nowNs();
+        sceneRenderer.upload(*imported.scene);
+        uploadMs += msSince(stageStart);
+
+        stageStart = rw::nowNs();
+        bool complete = true;
+        rw::AllocationScope allocations {rw::AllocationTag::Render};
+        for (const auto &preset : mPresets)
+        {
+            buildSnapshot(*imported.scene, preset, mSnapshot);
+            if (!renderView(sceneRenderer, capture, mSnapshot, outputNames[i] + "_" + preset.name))
+            {
+                complete = false;
+                break;
+            }
+            images++;
+        }
+        renderMs += msSince(stageStart);
+        if (!complete)
+        {
+            ELOG("Batch: the swap chain stopped delivering images, aborting after {}", mModels[i]);
+            failed += mModels.size() - i;
+            break;
+        }
+        rendered++;
+
+        LOG_EVERY_MS(2000, "Batch: {}/{} model(s), {:.1f} models/min", i + 1, mModels.size(),
+            static_cast<double>(rendered) * 60000.0 / msSince(batchStart));
+        glfwPollEvents();
+    }
+
+    capture.flush();
+    vkDeviceWaitIdle(mDevice->getDevice());
+    pipelineCache.save(rw::PipelineCache::defaultPath());
+
+    const double totalMs = msSince(batchStart);
+    const auto encoding = capture.takeStats();
+    const double perModel = rendered > 0 ? 1.0 / static_cast<double>(rendered) : 0.0;
+    LOG("Batch done: {} model(s) rendered, {} failed, {} image(s) in {:.1f} s, {:.1f} models/min, {:.1f} images/min",
+        rendered, failed, images, totalMs / 1000.0, static_cast<double>(rendered) * 60000.0 / totalMs,
+        static_cast<double>(images) * 60000.0 / totalMs);
+    // import and encode run on worker threads, only the wait for an import stalls the render loop
+    LOG("Batch per model: import {:.1f} ms (waited {:.1f} ms), upload {:.1f} ms, render {:.1f} ms, encode {:.1f} ms, {:.1f} MiB written",
+        importMs * perModel, waitMs * perModel, uploadMs * perModel, renderMs * perModel, encoding.encodeMs * perModel,
+        static_cast<double>(encoding.bytes) / (1024.0 * 1024.0));
+    // per image, the loading share is spread over the images of each model
+    const double perImage = images > 0 ? 1.0 / static_cast<double>(images) : 0.0;
+    std::string allocations;
+    for (std::size_t tag = 0; tag < allocationsAtStart.size(); ++tag)
+    {
+        const auto count = rw::getAllocationCount(static_cast<rw::AllocationTag>(tag));
+        allocations += fmt::format("{}{} {:.1f} ({:.1f} KiB)", allocations.empty() ? "" : ", ", rw::getAllocationTagName(static_cast<rw::AllocationTag>(tag)),
+                                   static_cast<double>(count.allocations - allocationsAtStart[tag].allocations) * perImage,
+                                   static_cast<double>(count.bytes - allocationsAtStart[tag].bytes) * perImage / 1024.0);
+    }
+    LOG("Batch allocations per image: {}", allocations);
+    const auto host = mDevice->getHostMemoryStats();
+    std::uint64_t hostPeak = 0;
+    for (const auto &scope : host.scopes) hostPeak += scope.peakBytes;
+    LOG("Batch Vulkan host memory: {:.1f} KiB in {} allocation(s), {:.1f} KiB summed scope peaks, {:.2f} allocation(s) per image",
+        static_cast<double>(host.getBytes()) / 1024.0, host.getAllocations(), static_cast<double>(hostPeak) / 1024.0,
+        static_cast<double>(host.getTotalAllocations() - hostAllocationsAtStart) * perImage);
+    if (encoding.failed > 0)
+    {
+        ELOG("Batch: {} image(s) could not be written", encoding.failed);
+    }
+}
+
+void BatchApp::buildSnapshot(const rw::Scene &scene, const CameraPreset &preset, rw::FrameSnapshot &snapshot)
+{
+    // frame() keeps the orbit angles, so set them first
+    mCamera.setOrbit(glm::vec3 {0.0f}, 1.0f, preset.yaw, preset.pitch);
+    mCamera.setAspectRatio(mRenderer->getAspectRatio());
+    mCamera.frame(scene.getBounds());
+
+    snapshot.view = mCamera.getView();
+    snapshot.projection = mCamera.getProjection();
+    snapshot.viewProjection = snapshot.projection * snapshot.view;
+    snapshot.cameraPosition = mCamera.getPosition();
+    snapshot.inputTimestamp = 0;
+    snapshot.capture = true;
+    snapshot.streamedDraws.clear();
+
+    // the camera frames the whole model, there is nothing to cull
+    mNodes.resize(scene.getNodes().size());
+    for (std::uint32_t i = 0; i < mNodes.size(); ++i) mNodes[i] = i;
+    mBatcher.build(scene, mNodes, rw::DrawPass::Scene, snapshot.viewProjection, snapshot.batches, snapshot.instances);
+
+    snapshot.skinnedDraws.clear();
+    snapshot.jointPalettes.clear();
+    if (!scene.hasAnimation()) return;
+
+    // animated models are shown in the first pose of their clips
+    const auto &animated = scene.getAnimatedNodes();
+    mAnimated.resize(animated.size());
+    for (std::uint32_t i = 0; i < mAnimated.size(); ++i) mAnimated[i] = i;
+    mAnimation.evaluate(scene, mAnimated, 0.0, snapshot.jointPalettes, mPaletteOffsets);
+    for (std::size_t i = 0; i < animated.size(); ++i)
+    {
+        const auto instance = static_cast<std::uint32_t>(snapshot.instances.size());
+        snapshot.instances.push_back(rw::InstanceData {animated[i].transform, scene.getMaterial(animated[i].material).baseColor});
+        snapshot.skinnedDraws.push_back(rw::SkinnedDraw {animated[i].mesh, mPaletteOffsets[i], instance});
+    }
+}
+
+bool BatchApp::renderView(rw::SceneRenderer &sceneRenderer, rw::FrameCapture &capture, const rw::FrameSnapshot &snapshot, const std::string &name)
+{
+    // unlike the viewer, a batch must not drop images when the encoders fall behind
+    capture.waitForFreeSlot();
+    for (int attempt = 0; attempt < MAX_FRAME_ATTEMPTS; ++attempt)
+    {
+        auto command = mRenderer->beginFrame();
+        if (!command)
+        {
+            // the swapchain was recreated, try again with the new one
+            glfwPollEvents();
+            continue;
+        }
+
+        const int frameIndex = mRenderer->getFrameIndex();
+        sceneRenderer.prepare(snapshot, frameIndex, mRenderer->getExtent(), mRenderer->getFrameArena());
+        mRenderer->submitCompute();
+        sceneRenderer.recordUploads(command, frameIndex);
+        sceneRenderer.drawShadows(command, snapshot, frameIndex);
+        sceneRenderer.drawVisibility(command, snapshot, frameIndex, mRenderer->getExtent(), mRenderer->getExtent());
+        mRenderer->beginSwapChainRenderPass(command);
+        sceneRenderer.draw(command, snapshot, frameIndex);
+        mRenderer->endSwapChainRenderPass(command);
+        const bool captured = mRenderer->captureFrame(capture, name);
+        mRenderer->endFrame();
+        capture.poll();
+        if (!captured) RT_THROW("Frame capture is not available on this device");
+        return true;
+    }
+    return false;
+}
+}
@@ -0,0 +1,83 @@
+#ifndef BATCHAPP_H
+#define BATCHAPP_H
+
+#include <Window.h>
+#include <core/ThreadPool.h>
+#include <render/Device.h>
+#include <render/FrameCapture.h>
+#include <render/InstanceBatcher.h>
+#include <render/PipelineCache.h>
+#include <render/Renderer.h>
+#include <render/SceneRenderer.h>
+#include <render/ShaderCache.h>
+#include <scene/AnimationPlayer.h>
+#include <scene/Camera.h>
+#include <scene/Scene.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace app
+{
+struct CameraPreset
+{
+    std::string name;
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+};
+
+// Renders every model of a list or directory from a set of camera presets into image files.
+// The following models are imported on worker threads while the current one renders, device,
+// pipelines, readback buffers and per frame buffers are shared by all models. The window is
+// hidden, it only exists because the swapchain needs a surface.
+class BatchApp
+{
+public:
+    BatchApp(int argc, char **argv);
+    ~BatchApp() = default;
+
+    void run();
+
+    static bool isBatchMode(int argc, char **argv);
+
+private:
+    struct ImportResult
+    {
+        std::unique_ptr<rw::Scene> scene;
+        std::string error;
+        double importMs = 0.0;
+    };
+
+    void addInput(const std::string &path);
+    void addCameraPresets(const std::string &list);
+    ImportResult import(const std::string &path) const;
+    void buildSnapshot(const rw::Scene &scene, const CameraPreset &preset, rw::FrameSnapshot &snapshot);
+    bool renderView(rw::SceneRenderer &sceneRenderer, rw::FrameCapture &capture, const rw::FrameSnapshot &snapshot, const std::string &name);
+
+private:
+    std::vector<std::string> mModels;
+    std::vector<CameraPreset> mPresets;
+    rw::CaptureOptions mCaptureOptions;
+    rw::DeviceSelectionOptions mDeviceSelection;
+    glm::ivec2 mSize {512, 512};
+    std::size_t mPrefetch = 2;
+
+    std::unique_ptr<rw::Window> mWindow;
+    std::unique_ptr<rw::Device> mDevice;
+    std::unique_ptr<rw::Renderer> mRenderer;
+    rw::ShaderCache mShaders;
+
+    // reused for every view of every model
+    rw::ThreadPool mWorkers;
+    rw::AnimationPlayer mAnimation {mWorkers};
+    rw::InstanceBatcher mBatcher {mWorkers};
+    rw::Camera mCamera;
+    rw::FrameSnapshot mSnapshot;
+    std::vector<std::uint32_t> mNodes;
+    std::vector<std::uint32_t> mAnimated;
+    std::vector<std::uint32_t> mPaletteOffsets;
+};
+}
+
+#endif // BATCHAPP_H
@@ -1,27 +1,905 @@
 #include "DemoApp.h"
 #include <Input.h>
 #include <Log.h>
+#include <core/AllocationCounters.h>
+#include <core/Clock.h>
+#include <core/CommandLine.h>
+#include <core/StartupTimeline.h>
+#include <core/Trace.h>
+#include <render/SceneRenderer.h>
+#include <scene/ChunkedModel.h>
+#include <scene/Frustum.h>
+#include <scene/ObjLoader.h>
 #define UNUSE(x) (void)x
 
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <random>
+
 namespace app
 {
+namespace {
+constexpr double RELOAD_POLL_TIMEOUT = 0.02;
+constexpr float DEMO_LIGHT_RANGE = 0.08f; // of the bounds diagonal
+// of the interactive point density and budget, a refined frame still has to finish before the next input
+constexpr float MAX_POINT_REFINEMENT = 4.0f;
+
+// Scatters point and spot lights over the bounds; seeded, so a reload places them again the same way.
+void addDemoLights(rw::Scene &scene, const rw::BoundingBox &bounds, std::uint32_t count)
+{
+    if (count == 0 || !bounds.isValid()) return;
+
+    std::mt19937 random {count};
+    std::uniform_real_distribution<float> unit {0.0f, 1.0f};
+    const float range = std::max(glm::length(bounds.extent()) * DEMO_LIGHT_RANGE, 1.0e-3f);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        rw::Light light;
+        light.type = i % 4 == 3 ? rw::LightType::Spot : rw::LightType::Point;
+        light.position = bounds.min + bounds.extent() * glm::vec3(unit(random), unit(random), unit(random));
+        light.range = range * (0.5f + unit(random));
+        light.color = glm::vec3(unit(random), unit(random), unit(random)) * 0.8f + 0.2f;
+        // the falloff is inverse square, keep the brightness independent of the model's scale
+        light.intensity = 0.25f * light.range * light.range;
+        light.direction = glm::normalize(glm::vec3(unit(random) - 0.5f, -1.0f, unit(random) - 0.5f));
+        scene.addLight(light);
+    }
+}
+
+const char *renderModeName(rw::RenderMode mode)
+{
+    switch (mode)
+    {
+    case rw::RenderMode::DepthPrepass:
+        return "prepass";
+    case rw::RenderMode::Visibility:
+        return "visibility";
+    default:
+        return "forward";
+    }
+}
+}
+
 DemoApp::DemoApp(int argc, char **argv)
 {
-    UNUSE(argc);
-    UNUSE(argv);
+    rw::Tracer::get().setThreadName("main");
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--continuous")
+        {
+            mScheduler.setMode(rw::FrameScheduler::Mode::Continuous);
+        }
+        else if (arg.rfind("--gpu=", 0) == 0)
+        {
+            mDeviceSelection.preferred = arg.substr(6);
+        }
+        else if (arg == "--gpu-calibrate")
+        {
+            mDeviceSelection.calibrate = true;
+        }
+        else if (arg == "--no-occlusion")
+        {
+            mOcclusionEnabled = false;
+        }
+        else if (arg == "--static-commands")
+        {
+            mStaticCommands = true;
+        }
+        else if (arg == "--no-watch")
+        {
+            mWatch = false;
+        }
+        else if (arg == "--dynamic-resolution" || arg.rfind("--dynamic-resolution=", 0) == 0)
+        {
+            mDynamicResolution = true;
+            if (arg.size() > 21)
+            {
+                rw::parseOptionValue(arg, mResolutionOptions.targetMs, 0.1, 1000.0);
+            }
+        }
+        else if (arg.rfind("--min-scale=", 0) == 0)
+        {
+            rw::parseOptionValue(arg, mResolutionOptions.minScale, 0.01f, 1.0f);
+        }
+        else if (arg == "--no-shadows")
+        {
+            mShadows = false;
+        }
+        else if (arg.rfind("--shadow-resolution=", 0) == 0)
+        {
+            rw::parseOptionValue(arg, mShadowOptions.resolution, 1u, 16384u);
+        }
+        else if (arg.rfind("--render-mode=", 0) == 0)
+        {
+            const std::string mode = arg.substr(14);
+            if (mode == "prepass")
+            {
+                mRenderMode = rw::RenderMode::DepthPrepass;
+            }
+            else if (mode == "visibility")
+            {
+                mRenderMode = rw::RenderMode::Visibility;
+            }
+            else if (mode != "forward")
+            {
+                WLOG("Unknown render mode {}, using forward", mode);
+            }
+        }
+        else if (arg.rfind("--lights=", 0) == 0)
+        {
+            rw::parseOptionValue(arg, mLightCount, 0u, std::numeric_limits<std::uint32_t>::max());
+        }
+        else if (arg.rfind("--points=", 0) == 0)
+        {
+            mPointCloudPath = arg.substr(9);
+        }
+        else if (arg.rfind("--point-budget=", 0) == 0)
+        {
+            // millions of points per frame
+            std::uint64_t millions = mPointOptions.pointBudget / 1000000ull;
+            if (rw::parseOptionValue(arg, millions, 1, std::numeric_limits<std::uint64_t>::max() / 1000000ull))
+            {
+                mPointOptions.pointBudget = millions * 1000000ull;
+            }
+        }
+        else if (arg.rfind("--build-chunks=", 0) == 0)
+        {
+            mChunkOutputPath = arg.substr(15);
+        }
+        else if (arg == "--compress-chunks")
+        {
+            mChunkOptions.compress = true;
+        }
+        else if (arg.rfind("--stream-cache=", 0) == 0)
+        {
+            // MiB
+            std::uint64_t megabytes = mStreamingOptions.cacheBytes >> 20;
+            if (rw::parseOptionValue(arg, megabytes, 1, std::numeric_limits<std::uint64_t>::max() >> 20))
+            {
+                mStreamingOptions.cacheBytes = megabytes << 20;
+            }
+        }
+        else if (arg == "--capture" || arg.rfind("--capture=", 0) == 0)
+        {
+            mCaptureAll = true;
+            if (arg.size() > 10)
+            {
+                mCaptureOptions.directory = arg.substr(10);
+            }
+        }
+        else if (arg == "--trace" || arg.rfind("--trace=", 0) == 0)
+        {
+            if (arg.size() > 8)
+            {
+                mTracePath = arg.substr(8);
+            }
+            rw::Tracer::get().start();
+        }
+        else if (arg.rfind("--capture-format=", 0) == 0)
+        {
+            if (!rw::parseImageFormat(arg.substr(17), mCaptureOptions.format))
+            {
+                WLOG("Unknown capture format {}, using png", arg.substr(17));
+            }
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            WLOG("Unknown option {}", arg);
+        }
+        else if (rw::PointCloud::isPointCloud(arg))
+        {
+            mPointCloudPath = arg;
+        }
+        else
+        {
+            mModelPath = arg;
+        }
+    }
+
+    mShadowCascades = rw::ShadowCascades {mShadowOptions};
+    mPointCloud = rw::PointCloud {mPointOptions};
+
+    // preprocessing only: convert the model into the streamable layout and skip the viewer
+    if (!mChunkOutputPath.empty())
+    {
+        if (mModelPath.empty()) RT_THROW("--build-chunks needs a model to convert");
+        rw::ObjLoader::load(mModelPath, mScene);
+        rw::ChunkedModel::build(mScene, mChunkOutputPath, mChunkOptions);
+        return;
+    }
+
+    // everything which does not need the device overlaps with window/instance/device creation
+    startLoading();
+    {
+        rw::StartupPhase phase{"window"};
+        mWindow = std::make_unique<rw::Window>("rw_model_viewer", 1280, 720);
+    }
+    mDevice = std::make_unique<rw::Device>(*mWindow, mDeviceSelection);
+    {
+        rw::StartupPhase phase{"swap chain"};
+        mRenderer = std::make_unique<rw::Renderer>(*mWindow, *mDevice);
+    }
+}
+
+void DemoApp::startLoading()
+{
+    mModelTask = mStartup.add("model import", [this]() {
+        if (rw::ChunkedModel::isChunkedModel(mModelPath))
+        {
+            mStreamer = std::make_unique<rw::ChunkStreamer>(mModelPath, mStreamingOptions);
+        }
+        else if (!mModelPath.empty())
+        {
+            rw::ObjLoader::load(mModelPath, mScene);
+        }
+    });
+    mPointCloudTask = mStartup.add("point cloud import", [this]() {
+        if (!mPointCloudPath.empty()) mPointCloud.load(mPointCloudPath);
+    });
+    mShaderTask = mStartup.add("shader load", [this]() {
+        mShaders.preload(rw::SceneRenderer::getShaderNames());
+        if (mDynamicResolution) mShaders.preload(rw::ScaledRenderTarget::getShaderNames());
+    });
+    mPipelineCacheTask = mStartup.add("pipeline cache read", [this]() {
+        mPipelineCacheData = rw::PipelineCache::readFromDisk(rw::PipelineCache::defaultPath());
+    });
+}
+
+void DemoApp::startWatching()
+{
+    if (!mWatch || mStreamer || mModelPath.empty()) return;
+
+    // materials are re-read with the model, so edits to them reload it as well
+    std::vector<std::filesystem::path> files {mModelPath};
+    std::error_code error;
+    const auto directory = std::filesystem::absolute(mModelPath).parent_path();
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() == ".mtl") files.push_back(entry.path());
+    }
+
+    mWatcher = std::make_unique<rw::FileWatcher>(std::move(files), [this](const std::vector<std::filesystem::path> &changed) {
+        LOG("{} changed, reloading", changed.front().filename().string());
+        mReloadRequested = true;
+        mScheduler.requestRedraw(rw::RedrawReason::Reload);
+    });
+    LOG("Watching {} file(s) for changes", mWatcher->getFiles().size());
+}
+
+void DemoApp::updateReload()
+{
+    if (!mReload.valid())
+    {
+        if (!mReloadRequested.exchange(false)) return;
+        // mScene is only read by the main loop until the result is taken over below
+        mReload = std::async(std::launch::async, [this]() {
+            rw::AllocationScope allocations{rw::AllocationTag::Loading};
+            const std::uint64_t start = rw::nowNs();
+            ReloadResult result;
+            result.scene = std::make_unique<rw::Scene>();
+            try
+            {
+                rw::ObjLoader::load(mModelPath, *result.scene);
+                addDemoLights(*result.scene, result.scene->getBounds(), mLightCount);
+            }
+            catch (const std::exception &e)
+            {
+                result.error = e.what();
+                return result;
+            }
+            result.diff = rw::GeometryDiff::compute(mScene.getGeometry(), result.scene->getGeometry());
+            result.importMs = static_cast<double>(rw::nowNs() - start) / 1.0e6;
+            return result;
+        });
+        return;
+    }
+    if (mReload.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+    ReloadResult result = mReload.get();
+    if (!result.error.empty())
+    {
+        WLOG("Reload failed, keeping the previous model: {}", result.error);
+        return;
+    }
+
+    result.diff.generation = ++mGeometryGeneration;
+    LOG("Reloaded {} in {:.1f} ms: {} mesh(es) kept, {} updated, {} created, {} removed, {} KiB to upload",
+        mModelPath, result.importMs, result.diff.kept, result.diff.updated, result.diff.created, result.diff.removed,
+        result.diff.uploadBytes / 1024);
+    mScene = std::move(*result.scene);
+    mShadowBounds = mScene.getBounds();
+    mPendingGeometry = std::make_shared<const rw::GeometryDiff>(std::move(result.diff));
+    mScheduler.requestRedraw(rw::RedrawReason::Reload);
 }
 
 void DemoApp::run()
 {
-    auto input = mWindow.getInput();
-    while(!mWindow.isClose())
+    if (!mWindow) return;
+
+    mStartup.wait(mPipelineCacheTask);
+    mPipelineCache = std::make_unique<rw::PipelineCache>(*mDevice, mPipelineCacheData);
+    mPipelineCacheData = {};
+
+    mStartup.wait(mShaderTask);
+    rw::SceneRenderer sceneRenderer = [this]() {
+        rw::StartupPhase phase{"pipelines"};
+        return rw::SceneRenderer{*mDevice, mRenderer->getSwapChainRenderPass(), mShaders, mRenderer->getAsyncCompute(), mPipelineCache->getHandle()};
+    }();
+
+    if (mDynamicResolution)
+    {
+        mRenderer->enableDynamicResolution(mResolutionOptions, mShaders, mPipelineCache->getHandle());
+        mDynamicResolution = mRenderer->getResolutionController() != nullptr;
+    }
+
+    {
+        rw::StartupPhase phase{"wait for model"};
+        mStartup.wait(mModelTask);
+        mStartup.wait(mPointCloudTask);
+    }
+    if (mStreamer)
+    {
+        mCamera.frame(mStreamer->getBounds());
+        mStreamer->setLoadedCallback([this]() { mScheduler.requestRedraw(rw::RedrawReason::Streaming); });
+        addDemoLights(mScene, mStreamer->getBounds(), mLightCount);
+        mShadowBounds = mStreamer->getBounds();
+    }
+    else if (!mModelPath.empty())
+    {
+        mShadowBounds = mScene.getBounds();
+        mCamera.frame(mShadowBounds);
+        addDemoLights(mScene, mShadowBounds, mLightCount);
+    }
+    if (!mPointCloud.isEmpty())
+    {
+        // the scan does not cast shadows, only the framing covers it
+        rw::BoundingBox bounds = mPointCloud.getBounds();
+        bounds.expand(mStreamer ? mStreamer->getBounds() : mShadowBounds);
+        mCamera.frame(bounds);
+    }
+    {
+        rw::StartupPhase phase{"geometry upload"};
+        sceneRenderer.upload(mScene);
+        if (!mPointCloud.isEmpty())
+        {
+            mPointCloud.fitTo(rw::PointRasterizer::getMaxPoints(*mDevice));
+            sceneRenderer.uploadPoints(mPointCloud);
+        }
+    }
+
+    // F12 grabs single frames, --capture every presented one
+    mCapture = std::make_unique<rw::FrameCapture>(*mDevice, mCaptureOptions);
+    rw::RenderThread renderThread {*mRenderer, sceneRenderer, mCapture.get()};
+    renderThread.start();
+    bool startupReported = false;
+
+    auto input = mWindow->getInput();
+    mLastReport = rw::nowNs();
+    mLastSize = mWindow->size();
+    mScheduler.setWakeCallback([]() { glfwPostEmptyEvent(); });
+    // playing clips need a new pose every frame, even in on demand mode
+    mScheduler.setAnimating(mScene.hasAnimation());
+    mAnimationStart = rw::nowNs();
+    mScheduler.requestRedraw(rw::RedrawReason::Resize);
+    startWatching();
+    LOG("Rendering mode: {}", mScheduler.getMode() == rw::FrameScheduler::Mode::OnDemand ? "on demand" : "continuous");
+
+    while(!mWindow->isClose() && !renderThread.hasFailed())
+    {
+        // the render thread still works on the previous snapshot, keep the window responsive meanwhile
+        const bool renderBusy = renderThread.getConsumedSequence() < renderThread.getPublishedSequence();
+        const bool minimized = mLastSize.x == 0 || mLastSize.y == 0;
+        double timeout = minimized ? rw::FrameScheduler::IDLE_TIMEOUT : mScheduler.getWaitTimeout(renderBusy);
+        // nothing wakes the loop when a reload finishes, look for it often enough
+        if (mReload.valid()) timeout = std::min(timeout, RELOAD_POLL_TIMEOUT);
+        if (timeout > 0.0)
+        {
+            TRACE_SCOPE("wait events");
+            glfwWaitEventsTimeout(timeout);
+        }
+        else
+        {
+            glfwPollEvents();
+        }
+
+        const std::uint64_t oldestInput = input->processEvents([this](const rw::InputEvent &event) { handleInput(event); });
+        if (oldestInput != 0 && mPendingInput == 0)
+        {
+            mPendingInput = oldestInput;
+            mPendingInputSequence = 0;
+        }
+        // once a snapshot carrying the input was picked up it is on its way to present
+        if (mPendingInputSequence != 0 && renderThread.getConsumedSequence() >= mPendingInputSequence)
+        {
+            mPendingInput = 0;
+            mPendingInputSequence = 0;
+        }
+        // a consumed snapshot can still be dropped before its diff reached the renderer's mesh table
+        if (mPendingGeometry && renderThread.getAppliedGeometryGeneration() >= mPendingGeometry->generation)
+        {
+            mPendingGeometry.reset();
+        }
+        if (mShadowSequence != 0 && renderThread.getConsumedSequence() >= mShadowSequence)
+        {
+            for (std::uint32_t i = 0; i < mShadowKeys.size(); ++i) mShadowCascades.confirm(i, mShadowKeys[i]);
+            mShadowSequence = 0;
+        }
+        // the scene is only swapped between snapshots and once the previous update was picked up
+        if (!renderBusy && !mPendingGeometry)
+        {
+            updateReload();
+        }
+
+        const glm::ivec2 size = mWindow->size();
+        if (size != mLastSize || renderThread.takeRedrawRequest())
+        {
+            // a dropped frame may have carried shadow casters, draw every cascade again
+            mShadowCascades.invalidate();
+            mLastSize = size;
+            mScheduler.requestRedraw(rw::RedrawReason::Resize);
+        }
+
+        if (!renderThread.hasFailed() && !minimized && !renderBusy)
+        {
+            if (mScheduler.needsRedraw())
+            {
+                // anything but the refinement itself goes back to the interactive point budget
+                if ((mScheduler.takeRedrawReasons() & ~static_cast<std::uint32_t>(rw::RedrawReason::Refinement)) != 0)
+                {
+                    mPointCloud.setRefinement(1.0f);
+                    queuePointRefinement();
+                }
+                auto &snapshot = renderThread.beginSnapshot();
+                {
+                    TRACE_SCOPE("build snapshot");
+                    rw::AllocationScope allocations{rw::AllocationTag::Frame};
+                    buildSnapshot(snapshot);
+                }
+                const std::uint64_t sequence = renderThread.publishSnapshot();
+                if (mPendingInput != 0 && mPendingInputSequence == 0)
+                {
+                    mPendingInputSequence = sequence;
+                }
+                if (!mShadowKeys.empty())
+                {
+                    mShadowSequence = sequence;
+                }
+            }
+            else
+            {
+                // nothing changed, spend the idle time on progressive refinement
+                mScheduler.runIdleTask();
+            }
+        }
+
+        if (!startupReported && renderThread.getFirstPresentTime() != 0)
+        {
+            rw::StartupTimeline::get().print(renderThread.getFirstPresentTime());
+            startupReported = true;
+        }
+        // finished readbacks are also handed to the encoders while no frames are rendered
+        mCapture->poll();
+        reportStats(renderThread);
+        // keeps the per thread trace buffers from filling up
+        if (rw::Tracer::isEnabled()) rw::Tracer::get().collect();
+    }
+
+    mWatcher.reset();
+    if (mReload.valid()) mReload.wait();
+    renderThread.stop();
+    vkDeviceWaitIdle(mDevice->getDevice());
+    // writes out the captures still in flight
+    mCapture.reset();
+    mPipelineCache->save(rw::PipelineCache::defaultPath());
+    if (rw::Tracer::isEnabled()) stopTrace();
+    renderThread.rethrowIfFailed();
+}
+
+void DemoApp::stopTrace()
+{
+    const auto stats = rw::Tracer::get().stop(mTracePath);
+    LOG("Trace: {} event(s) from {} thread(s) written to {}, {} dropped", stats.events, stats.threads, mTracePath, stats.dropped);
+}
+
+// While the view rests, each idle step doubles the point density and budget and redraws, until
+// the visible chunks are drawn completely or the refinement limit is reached.
+void DemoApp::queuePointRefinement()
+{
+    if (mPointCloud.isEmpty() || mPointRefinementQueued) return;
+
+    mPointRefinementQueued = true;
+    mScheduler.addIdleTask([this]() {
+        const auto &stats = mPointCloud.getStats();
+        const float refinement = mPointCloud.getRefinement();
+        if (stats.selectedPoints >= stats.visiblePoints || refinement >= MAX_POINT_REFINEMENT)
+        {
+            mPointRefinementQueued = false;
+            return false;
+        }
+        mPointCloud.setRefinement(std::min(refinement * 2.0f, MAX_POINT_REFINEMENT));
+        mScheduler.requestRedraw(rw::RedrawReason::Refinement);
+        return true;
+    });
+}
+
+void DemoApp::buildSnapshot(rw::FrameSnapshot &snapshot)
+{
+    const glm::ivec2 size = mWindow->size();
+    if (size.x > 0 && size.y > 0)
+    {
+        mCamera.setAspectRatio(static_cast<float>(size.x) / static_cast<float>(size.y));
+    }
+
+    snapshot.view = mCamera.getView();
+    snapshot.projection = mCamera.getProjection();
+    snapshot.viewProjection = snapshot.projection * snapshot.view;
+    snapshot.cameraPosition = mCamera.getPosition();
+    snapshot.inputTimestamp = mPendingInput;
+    snapshot.capture = mCaptureAll || mCaptureRequested;
+    snapshot.geometry = mPendingGeometry;
+    snapshot.renderMode = mRenderMode;
+    snapshot.staticCommands = mStaticCommands;
+    mCaptureRequested = false;
+
+    const rw::Frustum frustum {snapshot.viewProjection};
+    const auto &nodes = mScene.getNodes();
+    mVisibleNodes.clear();
+    for (std::uint32_t i = 0; i < nodes.size(); ++i)
+    {
+        if (frustum.intersects(nodes[i].worldBounds))
+        {
+            mVisibleNodes.push_back(i);
+        }
+    }
+    if (mOcclusionEnabled)
+    {
+        mOcclusion.prepare(mScene, mVisibleNodes, snapshot.viewProjection, snapshot.cameraPosition);
+        mOcclusion.cull(mScene, mVisibleNodes);
+    }
+    mBatcher.build(mScene, mVisibleNodes, rw::DrawPass::Scene, snapshot.viewProjection, snapshot.batches, snapshot.instances);
+    mLightBinner.bin(mScene.getLights(), snapshot.view, snapshot.projection, mCamera.getNear(), mCamera.getFar(), snapshot.lightGrid,
+                     snapshot.lights, snapshot.lightClusters, snapshot.lightIndices);
+
+    snapshot.streamedDraws.clear();
+    if (mStreamer)
+    {
+        mStreamer->update(mCamera, frustum, static_cast<float>(size.y), mVisibleChunks);
+        if (!mVisibleChunks.empty())
+        {
+            // chunks are baked into model space, they all share one instance
+            const auto instance = static_cast<std::uint32_t>(snapshot.instances.size());
+            snapshot.instances.push_back(rw::InstanceData {glm::mat4 {1.0f}, mScene.getMaterial(rw::Scene::DEFAULT_MATERIAL).baseColor});
+            for (auto &chunk : mVisibleChunks)
+            {
+                snapshot.streamedDraws.push_back(rw::StreamedDraw {chunk.id, std::move(chunk.mesh), instance});
+            }
+        }
+    }
+
+    snapshot.pointDraws.clear();
+    if (!mPointCloud.isEmpty())
+    {
+        mPointCloud.select(mCamera, frustum, static_cast<float>(size.y), snapshot.pointDraws);
+    }
+
+    snapshot.shadowCascades.clear();
+    snapshot.shadowBatches.clear();
+    mShadowKeys.clear();
+    if (mShadows)
+    {
+        buildShadows(snapshot);
+    }
+
+    snapshot.skinnedDraws.clear();
+    if (!mScene.hasAnimation())
+    {
+        snapshot.jointPalettes.clear();
+        return;
+    }
+
+    const auto &animated = mScene.getAnimatedNodes();
+    mVisibleAnimated.clear();
+    for (std::uint32_t i = 0; i < animated.size(); ++i)
+    {
+        if (frustum.intersects(animated[i].worldBounds))
+        {
+            mVisibleAnimated.push_back(i);
+        }
+    }
+    if (mOcclusionEnabled)
+    {
+        mOcclusion.cullAnimated(mScene, mVisibleAnimated);
+    }
+
+    const double time = static_cast<double>(rw::nowNs() - mAnimationStart) / 1.0e9;
+    mAnimation.evaluate(mScene, mVisibleAnimated, time, snapshot.jointPalettes, mPaletteOffsets);
+
+    // animated instances follow the batched ones, each is drawn on its own
+    for (std::size_t i = 0; i < mVisibleAnimated.size(); ++i)
+    {
+        const auto &node = animated[mVisibleAnimated[i]];
+        const auto instance = static_cast<std::uint32_t>(snapshot.instances.size());
+        snapshot.instances.push_back(rw::InstanceData {node.transform, mScene.getMaterial(node.material).baseColor});
+        snapshot.skinnedDraws.push_back(rw::SkinnedDraw {node.mesh, mPaletteOffsets[i], instance});
+    }
+}
+
+void DemoApp::buildShadows(rw::FrameSnapshot &snapshot)
+{
+    // the cached maps hold the scene nodes and the resident chunks, which only change on reload and streaming
+    std::uint64_t chunkHash = 0;
+    for (const auto &draw : snapshot.streamedDraws) chunkHash += (draw.chunk + 1ull) * 0x9E3779B97F4A7C15ull;
+    mShadowCascades.update(mCamera, mShadowBounds, mGeometryGeneration * 1099511628211ull ^ chunkHash);
+
+    snapshot.lightDirection = mShadowCascades.getOptions().lightDirection;
+    snapshot.shadowResolution = mShadowCascades.getOptions().resolution;
+    const auto &nodes = mScene.getNodes();
+    for (const auto &cascade : mShadowCascades.getCascades())
+    {
+        rw::ShadowCascadeDraw draw {cascade.viewProjection, cascade.splitDepth, cascade.key, cascade.needsCasters};
+        if (cascade.needsCasters)
+        {
+            // every node inside the cascade casts, visible to the camera or not
+            const rw::Frustum frustum {cascade.viewProjection};
+            mShadowNodes.clear();
+            for (std::uint32_t i = 0; i < nodes.size(); ++i)
+            {
+                if (frustum.intersects(nodes[i].worldBounds)) mShadowNodes.push_back(i);
+            }
+            mBatcher.build(mScene, mShadowNodes, rw::DrawPass::Shadow, cascade.viewProjection, mShadowBatches, mShadowInstances);
+
+            const auto firstInstance = static_cast<std::uint32_t>(snapshot.instances.size());
+            draw.firstBatch = static_cast<std::uint32_t>(snapshot.shadowBatches.size());
+            draw.batchCount = static_cast<std::uint32_t>(mShadowBatches.size());
+            for (auto batch : mShadowBatches)
+            {
+                batch.firstInstance += firstInstance;
+                snapshot.shadowBatches.push_back(batch);
+            }
+            snapshot.instances.insert(snapshot.instances.end(), mShadowInstances.begin(), mShadowInstances.end());
+            mShadowKeys.push_back(cascade.key);
+        }
+        else
+        {
+            mShadowKeys.push_back(0);
+        }
+        snapshot.shadowCascades.push_back(draw);
+    }
+    if (std::all_of(mShadowKeys.begin(), mShadowKeys.end(), [](std::uint64_t key) { return key == 0; })) mShadowKeys.clear();
+}
+
+void DemoApp::handleInput(const rw::InputEvent &event)
+{
+    auto input = mWindow->getInput();
+    switch (event.type)
+    {
+    case rw::InputEventType::Key:
+        if (event.code == GLFW_KEY_ESCAPE && event.action == GLFW_PRESS)
+        {
+            mWindow->close();
+        }
+        else if (event.code == GLFW_KEY_F12 && event.action == GLFW_PRESS)
+        {
+            mCaptureRequested = true;
+            mScheduler.requestRedraw(rw::RedrawReason::Input);
+        }
+        else if (event.code == GLFW_KEY_F9 && event.action == GLFW_PRESS)
+        {
+            if (rw::Tracer::isEnabled())
+            {
+                stopTrace();
+            }
+            else
+            {
+                rw::Tracer::get().start();
+                LOG("Tracing, press F9 again to write {}", mTracePath);
+            }
+        }
+        else if (event.code == GLFW_KEY_F5 && event.action == GLFW_PRESS)
+        {
+            // forward, depth prepass, visibility buffer
+            mRenderMode = static_cast<rw::RenderMode>((static_cast<int>(mRenderMode) + 1) % 3);
+            LOG("Render mode: {}", renderModeName(mRenderMode));
+            mScheduler.requestRedraw(rw::RedrawReason::Input);
+        }
+        else if (event.code == GLFW_KEY_F6 && event.action == GLFW_PRESS)
+        {
+            mStaticCommands = !mStaticCommands;
+            LOG("Static command buffers: {}", mStaticCommands ? "on, forward mode only" : "off");
+            mScheduler.requestRedraw(rw::RedrawReason::Input);
+        }
+        break;
+    case rw::InputEventType::CursorPosition:
+    {
+        glm::vec2 cursor = input->getCursorPosition();
+        if (input->getMouseButtonState(GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+        {
+            glm::vec2 delta = cursor - mLastCursor;
+            mCamera.orbit(-delta.x * 0.005f, delta.y * 0.005f);
+            mScheduler.requestRedraw(rw::RedrawReason::Camera);
+        }
+        mLastCursor = cursor;
+        break;
+    }
+    case rw::InputEventType::Scroll:
+        mCamera.zoom(event.y > 0.0 ? 0.9f : 1.1f);
+        mScheduler.requestRedraw(rw::RedrawReason::Camera);
+        break;
+    default:
+        break;
+    }
+}
+
+void DemoApp::reportStats(rw::RenderThread &renderThread)
+{
+    const std::uint64_t now = rw::nowNs();
+    if (now - mLastReport < 1000000000ull) return;
+    const double seconds = static_cast<double>(now - mLastReport) / 1.0e9;
+    mLastReport = now;
+
+    const auto stats = renderThread.takeStats();
+    const double cpuUsage = mCpuUsage.sample();
+    const double gpuUsage = 100.0 * stats.gpuBusyMs / (seconds * 1000.0);
+    LOG("{:.1f} fps, cpu {:.1f}% of a core, gpu {:.1f}% busy ({:.2f} ms/frame), render thread {:.2f} ms/frame, {} draw call(s), {} visible instance(s)",
+        static_cast<double>(stats.framesPresented) / seconds, cpuUsage, gpuUsage, stats.gpuFrameMs, stats.cpuFrameMs,
+        stats.scene.drawCalls, stats.scene.instances);
+    if (stats.scene.skinnedDraws > 0)
     {
-        glfwPollEvents();
+        LOG("Skinning: {} animated node(s), {} vertices skinned per frame", stats.scene.skinnedDraws, stats.scene.skinnedVertices);
+    }
+    if (stats.computeBusyMs > 0.0)
+    {
+        // on a dedicated compute family the two add up to more than the wall time they span when they overlap
+        LOG("Queue busy time: graphics {:.1f}%, compute {:.1f}% ({})", gpuUsage, 100.0 * stats.computeBusyMs / (seconds * 1000.0),
+            mDevice->hasAsyncCompute() ? "async" : "shared with graphics");
+    }
+
+    if (mDynamicResolution)
+    {
+        const auto &resolution = stats.resolution;
+        LOG("Resolution: scale {:.2f} ({}x{}), {:.2f} to {:.2f} over the last second with {} change(s), {:.2f} ms of {:.1f} ms GPU budget",
+            resolution.scale, stats.sceneExtent.width, stats.sceneExtent.height, resolution.minScale, resolution.maxScale, resolution.changes,
+            resolution.smoothedMs, mResolutionOptions.targetMs);
+    }
+
+    if (mShadows && stats.framesPresented > 0)
+    {
+        const auto &shadows = mShadowCascades.getStats();
+        const double frames = static_cast<double>(stats.framesPresented);
+        LOG("Shadows: {} cascade(s) at {}px, {:.2f} reused and {:.2f} redrawn per frame, {} recentered and {} invalidated, {} shadow draw call(s) last frame",
+            shadows.cascades, mShadowCascades.getOptions().resolution, static_cast<double>(stats.shadowCascadesReused) / frames,
+            static_cast<double>(stats.shadowCascadesDrawn) / frames, shadows.moved, shadows.changed, stats.scene.shadowDrawCalls);
+        mShadowCascades.resetStats();
+    }
+
+    if (stats.staticReused + stats.staticRecorded > 0)
+    {
+        // the recording cost of a reused frame is the one of its last recording
+        LOG("Static commands: {} frame(s) reused and {} recorded their batches, {:.3f} ms of recording saved per frame",
+            stats.staticReused, stats.staticRecorded, stats.staticSavedMs / static_cast<double>(stats.staticReused + stats.staticRecorded));
+    }
 
-        if (input->getKeyState(GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    if (stats.fragmentFrames > 0 && stats.fragments.pixels > 0)
+    {
+        // fragments shaded per pixel drawn; 1 means no overdraw is paid for in shading
+        const auto &fragments = stats.fragments;
+        const double pixels = static_cast<double>(fragments.pixels);
+        LOG("Overdraw ({}): {:.2f} shaded fragment(s) per pixel, {:.2f} depth/visibility fragment(s) per pixel over {} frame(s)",
+            renderModeName(stats.scene.renderMode), static_cast<double>(fragments.shading) / pixels, static_cast<double>(fragments.prepass) / pixels,
+            stats.fragmentFrames);
+    }
+
+    if (!mPointCloud.isEmpty() && stats.framesPresented > 0)
+    {
+        // compute time covers every pass of the compute queue, skinning included
+        const auto &points = mPointCloud.getStats();
+        const double drawn = static_cast<double>(stats.pointsDrawn);
+        LOG("Points: {:.1f} M points/s, {:.2f} M per frame from {} of {} chunk(s){}, {:.0f} M points per second of compute time ({})",
+            drawn / seconds / 1.0e6, drawn / static_cast<double>(stats.framesPresented) / 1.0e6, points.visibleChunks, points.chunks,
+            points.budgetLimited ? " at the budget" : "", stats.computeBusyMs > 0.0 ? drawn / stats.computeBusyMs / 1.0e3 : 0.0,
+            stats.scene.pointInt64Atomics ? "64-bit atomics" : "separate depth and color passes");
+    }
+
+    const auto &sorting = mBatcher.getStats();
+    if (sorting.builds > 0)
+    {
+        const double builds = static_cast<double>(sorting.builds);
+        LOG("Draw sort: {:.0f} packet(s) into {:.1f} batch(es) per build, {:.1f} radix pass(es), {:.3f} ms; last frame {} mesh bind(s), {} skipped",
+            static_cast<double>(sorting.packets) / builds, static_cast<double>(sorting.batches) / builds,
+            static_cast<double>(sorting.radixPasses) / builds, sorting.sortMs / builds, stats.scene.meshBinds, stats.scene.meshBindsSkipped);
+        mBatcher.resetStats();
+    }
+
+    if (!mScene.getLights().empty())
+    {
+        const auto &lights = mLightBinner.getStats();
+        LOG("Lights: {} of {} binned, {} lit cluster(s) with {:.1f} light(s) on average, {} at most, {} dropped, {} index(es), binning {:.2f} ms",
+            lights.binnedLights, lights.lights, lights.litClusters,
+            lights.litClusters > 0 ? static_cast<double>(lights.indices) / lights.litClusters : 0.0, lights.maxPerCluster, lights.overflow,
+            lights.indices, lights.binMs);
+    }
+
+    if (mOcclusionEnabled)
+    {
+        const auto &occlusion = mOcclusion.getStats();
+        LOG("Occlusion: {} occluder(s) with {} triangle(s), culled {} of {} node(s), raster {:.2f} ms, pyramid {:.2f} ms, test {:.2f} ms",
+            occlusion.occluders, occlusion.occluderTriangles, occlusion.culled, occlusion.tested, occlusion.rasterMs, occlusion.pyramidMs,
+            occlusion.testMs);
+    }
+    if (mStreamer)
+    {
+        const auto streaming = mStreamer->getStats();
+        LOG("Streaming: {} chunk(s) / {} MiB in RAM, {} on GPU / {} MiB, {} queued, {} reading, {} loaded, {} cancelled, {} evicted",
+            streaming.residentChunks, streaming.residentBytes >> 20, stats.scene.streamedChunks, stats.scene.streamedBytes >> 20,
+            streaming.pending, streaming.inFlight, streaming.loaded, streaming.cancelled, streaming.evicted);
+        if (streaming.decodedBytes > 0)
         {
-            mWindow.close();
+            // ratio over every chunk read so far, nodes which did not shrink are stored raw
+            LOG("Streaming decode: compression ratio {:.2f}, {:.2f} GB/s per I/O thread, {} MiB decoded",
+                static_cast<double>(streaming.rawBytes) / static_cast<double>(streaming.storedBytes),
+                static_cast<double>(streaming.decodedBytes) / static_cast<double>(std::max<std::uint64_t>(streaming.decodeNs, 1)),
+                streaming.decodedBytes >> 20);
         }
     }
+
+    const auto capture = mCapture->takeStats();
+    if (capture.captured > 0 || capture.encoded > 0 || capture.dropped > 0)
+    {
+        LOG("Capture: {} frame(s) read back, {} encoded ({:.1f} MiB/s, {:.2f} ms/image), {} dropped, {} failed, queue depth {}",
+            capture.captured, capture.encoded, static_cast<double>(capture.bytes) / (1024.0 * 1024.0) / seconds,
+            capture.encoded > 0 ? capture.encodeMs / static_cast<double>(capture.encoded) : 0.0, capture.dropped, capture.failed,
+            capture.queueDepth);
+    }
+
+    // a steady count per frame is a container growing or a temporary being built every frame
+    std::string allocations;
+    for (std::size_t i = 0; i < mLastAllocations.size(); ++i)
+    {
+        const auto tag = static_cast<rw::AllocationTag>(i);
+        const auto count = rw::getAllocationCount(tag);
+        if (stats.framesPresented > 0)
+        {
+            const double frames = static_cast<double>(stats.framesPresented);
+            allocations += fmt::format("{}{} {:.1f} ({:.1f} KiB)", allocations.empty() ? "" : ", ", rw::getAllocationTagName(tag),
+                                       static_cast<double>(count.allocations - mLastAllocations[i].allocations) / frames,
+                                       static_cast<double>(count.bytes - mLastAllocations[i].bytes) / frames / 1024.0);
+        }
+        mLastAllocations[i] = count;
+    }
+    const auto host = mDevice->getHostMemoryStats();
+    if (stats.framesPresented > 0)
+    {
+        LOG("Allocations per frame: {}", allocations);
+        LOG("Frame arenas: {:.1f} of {:.1f} KiB used, {} block allocation(s) since start", static_cast<double>(stats.frameArenas.used) / 1024.0,
+            static_cast<double>(stats.frameArenas.capacity) / 1024.0, stats.frameArenas.blockAllocations);
+        std::string scopes;
+        for (std::uint32_t i = 0; i < rw::HostAllocatorStats::SCOPE_COUNT; ++i)
+        {
+            if (host.scopes[i].bytes == 0) continue;
+            scopes += fmt::format("{}{} {:.1f} KiB", scopes.empty() ? "" : ", ", rw::HostAllocator::getScopeName(i),
+                                  static_cast<double>(host.scopes[i].bytes) / 1024.0);
+        }
+        LOG("Vulkan host memory: {:.1f} KiB in {} allocation(s) ({}), {:.2f} allocation(s) per frame, {:.1f} KiB driver internal",
+            static_cast<double>(host.getBytes()) / 1024.0, host.getAllocations(), scopes,
+            static_cast<double>(host.getTotalAllocations() - mLastHostAllocations) / static_cast<double>(stats.framesPresented),
+            static_cast<double>(host.getInternalBytes()) / 1024.0);
+    }
+    mLastHostAllocations = host.getTotalAllocations();
+
+    const auto &latency = stats.inputLatency;
+    if (latency.samples > 0)
+    {
+        LOG("Input to present latency: last {:.2f} ms, avg {:.2f} ms, min {:.2f} ms, max {:.2f} ms ({} frames), dropped events {}",
+            latency.lastMs, latency.avgMs, latency.minMs, latency.maxMs, latency.samples, mWindow->getInput()->getDroppedEventCount());
+    }
+
+    const auto logStats = rw::getLoggerStats();
+    if (logStats.overruns != mLastLogOverruns)
+    {
+        WLOG("Logger queue overran, {} message(s) lost so far", logStats.overruns);
+        mLastLogOverruns = logStats.overruns;
+    }
 }
 }
@@ -2,7 +2,36 @@
 #define DEMOAPP_H
 
 #include <Window.h>
+#include <Input.h>
+#include <core/AllocationCounters.h>
+#include <core/CpuUsage.h>
+#include <core/FileWatcher.h>
+#include <core/FrameScheduler.h>
+#include <core/TaskGraph.h>
+#include <core/ThreadPool.h>
 #include <render/Device.h>
+#include <render/FrameCapture.h>
+#include <render/InstanceBatcher.h>
+#include <render/PipelineCache.h>
+#include <render/RenderThread.h>
+#include <render/Renderer.h>
+#include <render/ShaderCache.h>
+#include <scene/AnimationPlayer.h>
+#include <scene/Camera.h>
+#include <scene/ChunkStreamer.h>
+#include <scene/GeometryDiff.h>
+#include <scene/LightBinner.h>
+#include <scene/OcclusionCuller.h>
+#include <scene/PointCloud.h>
+#include <scene/Scene.h>
+#include <scene/ShadowCascades.h>
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace app
 {
@@ -15,8 +44,109 @@ public:
     void run();
 
 private:
-    rw::Window mWindow {"rw_model_viewer", 1280, 720};
-    rw::Device mDevice {mWindow};
+    void handleInput(const rw::InputEvent &event);
+    void buildSnapshot(rw::FrameSnapshot &snapshot);
+    void buildShadows(rw::FrameSnapshot &snapshot);
+    void reportStats(rw::RenderThread &renderThread);
+    void startLoading();
+    void startWatching();
+    void updateReload();
+    void stopTrace();
+    void queuePointRefinement();
+
+private:
+    struct ReloadResult
+    {
+        std::unique_ptr<rw::Scene> scene;
+        rw::GeometryDiff diff;
+        std::string error;
+        double importMs = 0.0;
+    };
+
+    std::string mModelPath;
+    std::string mChunkOutputPath;
+    rw::ChunkedModelOptions mChunkOptions;
+    rw::ChunkStreamerOptions mStreamingOptions;
+    rw::DeviceSelectionOptions mDeviceSelection;
+    rw::CaptureOptions mCaptureOptions;
+    bool mCaptureAll = false;
+    bool mCaptureRequested = false;
+    // F9 starts and stops a CPU trace, --trace records from startup until exit
+    std::string mTracePath = "trace.json";
+    rw::FrameScheduler mScheduler;
+
+    // filled by the startup tasks, which run while window and device are created
+    rw::Scene mScene;
+    std::unique_ptr<rw::ChunkStreamer> mStreamer;
+    // laser scan drawn next to the model, from --points or a .xyz/.pts model argument
+    std::string mPointCloudPath;
+    rw::PointCloudOptions mPointOptions;
+    rw::PointCloud mPointCloud;
+    rw::ShaderCache mShaders;
+    std::vector<char> mPipelineCacheData;
+    rw::TaskGraph mStartup;
+    rw::TaskGraph::TaskId mModelTask = 0;
+    rw::TaskGraph::TaskId mPointCloudTask = 0;
+    bool mPointRefinementQueued = false;
+    rw::TaskGraph::TaskId mShaderTask = 0;
+    rw::TaskGraph::TaskId mPipelineCacheTask = 0;
+
+    std::unique_ptr<rw::Window> mWindow;
+    std::unique_ptr<rw::Device> mDevice;
+    std::unique_ptr<rw::Renderer> mRenderer;
+    std::unique_ptr<rw::PipelineCache> mPipelineCache;
+    std::unique_ptr<rw::FrameCapture> mCapture;
+
+    rw::Camera mCamera;
+    rw::CpuUsage mCpuUsage;
+    glm::ivec2 mLastSize {0};
+
+    // simulation thread state
+    std::vector<std::uint32_t> mVisibleNodes;
+    rw::ThreadPool mWorkers;
+    rw::InstanceBatcher mBatcher {mWorkers};
+    rw::AnimationPlayer mAnimation {mWorkers};
+    rw::OcclusionCuller mOcclusion {mWorkers};
+    rw::LightBinner mLightBinner {mWorkers};
+    std::uint32_t mLightCount = 0;
+    // F5 cycles through the modes
+    rw::RenderMode mRenderMode = rw::RenderMode::Forward;
+    // F6 toggles, batches drawn from pre-recorded command buffers
+    bool mStaticCommands = false;
+    bool mOcclusionEnabled = true;
+    bool mDynamicResolution = false;
+    rw::ResolutionOptions mResolutionOptions;
+    // cached shadow cascades; the keys of the last published casters are confirmed once consumed
+    bool mShadows = true;
+    rw::ShadowOptions mShadowOptions;
+    rw::ShadowCascades mShadowCascades;
+    rw::BoundingBox mShadowBounds;
+    std::vector<std::uint32_t> mShadowNodes;
+    std::vector<rw::DrawBatch> mShadowBatches;
+    std::vector<rw::InstanceData> mShadowInstances;
+    std::vector<std::uint64_t> mShadowKeys;
+    std::uint64_t mShadowSequence = 0;
+    std::vector<std::uint32_t> mVisibleAnimated;
+    std::vector<std::uint32_t> mPaletteOffsets;
+    std::vector<rw::StreamedChunk> mVisibleChunks;
+    std::uint64_t mAnimationStart = 0;
+    std::uint64_t mPendingInput = 0;
+    std::uint64_t mPendingInputSequence = 0;
+
+    // hot reload of the model file, the import and diff run next to the main loop
+    bool mWatch = true;
+    std::unique_ptr<rw::FileWatcher> mWatcher;
+    std::atomic<bool> mReloadRequested {false};
+    std::future<ReloadResult> mReload;
+    std::uint64_t mGeometryGeneration = 0;
+    // attached to every snapshot until the render thread applied it
+    std::shared_ptr<const rw::GeometryDiff> mPendingGeometry;
+
+    glm::vec2 mLastCursor {0.0f};
+    std::uint64_t mLastReport = 0;
+    std::size_t mLastLogOverruns = 0;
+    std::array<rw::AllocationCount, static_cast<std::size_t>(rw::AllocationTag::Count)> mLastAllocations {};
+    std::uint64_t mLastHostAllocations = 0;
 };
 }
 
@@ -1,22 +1,107 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+#include <Log.h>
+#include <core/SpscRing.h>
+
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 
 namespace rw {
+enum class InputEventType : std::uint8_t {
+    Key,
+    MouseButton,
+    CursorPosition,
+    Scroll
+};
+
+struct InputEvent {
+    InputEventType type;
+    int code;      // key or mouse button
+    int action;    // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+    int mods;
+    double x;      // cursor position or scroll offset
+    double y;
+    std::uint64_t timestamp; // nowNs() when the event was received from GLFW
+};
+
+// Window callbacks (producer) push timestamped events into a lock-free ring. The thread which
+// simulates/renders (consumer) drains it with processEvents(), which also updates the polled state.
 class Input : public std::enable_shared_from_this<Input> {
     friend class Window;
 public:
+    static constexpr std::size_t EVENT_QUEUE_SIZE = 1024;
+
     Input() = default;
 
-    int getKeyState(int key) {
-        return mKeys.at(key);
+    // consumer side
+    int getKeyState(int key) const {
+        return (key >= 0 && key < static_cast<int>(mKeys.size())) ? mKeys[key] : GLFW_RELEASE;
+    }
+    int getMouseButtonState(int button) const {
+        return (button >= 0 && button < static_cast<int>(mMouseButtons.size())) ? mMouseButtons[button] : GLFW_RELEASE;
+    }
+    glm::vec2 getCursorPosition() const { return mCursorPosition; }
+
+    // Applies all queued events in order and forwards each one to handler.
+    // Returns the timestamp of the oldest event consumed, or 0 when the queue was empty.
+    template <typename Handler>
+    std::uint64_t processEvents(Handler &&handler) {
+        std::uint64_t oldest = 0;
+        InputEvent event;
+        while (mEvents.pop(event))
+        {
+            if (oldest == 0) oldest = event.timestamp;
+            apply(event);
+            handler(event);
+        }
+        return oldest;
+    }
+    std::uint64_t processEvents() {
+        return processEvents([](const InputEvent &) {});
     }
 
+    std::uint64_t getDroppedEventCount() const { return mDroppedEvents.load(std::memory_order_relaxed); }
+
 private:
-    std::array<int, GLFW_KEY_LAST> mKeys;
+    // producer side
+    void pushEvent(const InputEvent &event) {
+        if (!mEvents.push(event))
+        {
+            mDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+            WLOG_EVERY_MS(1000, "Input queue full, dropping events");
+        }
+    }
+
+    void apply(const InputEvent &event) {
+        switch (event.type)
+        {
+        case InputEventType::Key:
+            if (event.code >= 0 && event.code < static_cast<int>(mKeys.size())) mKeys[event.code] = event.action;
+            break;
+        case InputEventType::MouseButton:
+            if (event.code >= 0 && event.code < static_cast<int>(mMouseButtons.size())) mMouseButtons[event.code] = event.action;
+            break;
+        case InputEventType::CursorPosition:
+            mCursorPosition = glm::vec2(static_cast<float>(event.x), static_cast<float>(event.y));
+            break;
+        case InputEventType::Scroll:
+            break;
+        }
+    }
+
+private:
+    SpscRing<InputEvent, EVENT_QUEUE_SIZE> mEvents;
+    std::atomic<std::uint64_t> mDroppedEvents {0};
+
+    std::array<int, GLFW_KEY_LAST + 1> mKeys {};
+    std::array<int, GLFW_MOUSE_BUTTON_LAST + 1> mMouseButtons {};
+    glm::vec2 mCursorPosition {0.0f};
 };
 }
 
@@ -3,6 +3,9 @@
 
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 
 #define UNUSE(x) (void)x
@@ -11,13 +14,104 @@
 
 #define VK_CHECK(x, msg) do { auto res = (x); if (res != VK_SUCCESS) { RT_THROW(msg); } } while(0)
 
-#ifdef LOGGER_ENABLED
+// Compile-time minimum level. Anything below it is removed by the preprocessor,
+// so its arguments are never evaluated and no formatting code is emitted.
+#define RW_LOG_LEVEL_DEBUG 0
+#define RW_LOG_LEVEL_INFO 1
+#define RW_LOG_LEVEL_WARN 2
+#define RW_LOG_LEVEL_ERROR 3
+#define RW_LOG_LEVEL_OFF 4
+
+#ifndef RW_LOG_LEVEL
+#define RW_LOG_LEVEL RW_LOG_LEVEL_INFO
+#endif
+
+namespace rw {
+
+struct LoggerStats
+{
+    std::size_t overruns = 0;   // messages discarded because the queue was full
+    std::uint64_t suppressed = 0; // messages swallowed by rate-limited call sites
+};
+
+// Switches the default logger to an asynchronous one: callers only format into
+// a slot of a preallocated queue, a background thread does the actual I/O.
+// When the queue is full the oldest message is overwritten instead of blocking.
+void initLogger(std::size_t queueSize = 8192);
+// Flushes pending messages and joins the background thread.
+void shutdownLogger();
+LoggerStats getLoggerStats();
+
+class LoggerGuard
+{
+public:
+    explicit LoggerGuard(std::size_t queueSize = 8192) { initLogger(queueSize); }
+    ~LoggerGuard() { shutdownLogger(); }
+
+    LoggerGuard(const LoggerGuard &) = delete;
+    LoggerGuard &operator=(const LoggerGuard &) = delete;
+};
+
+// Per call site limiter used by the *_EVERY_MS macros.
+class LogRateLimiter
+{
+public:
+    explicit LogRateLimiter(std::uint64_t intervalMs) : mIntervalNs{intervalMs * 1000000ull} {}
+
+    // Returns true when the call site may log; suppressed receives the number
+    // of messages dropped since the previous accepted one.
+    bool allow(std::uint64_t &suppressed);
+
+private:
+    std::uint64_t mIntervalNs;
+    std::atomic<std::uint64_t> mNextNs{0};
+    std::atomic<std::uint64_t> mSuppressed{0};
+};
+
+} // namespace rw
+
+#define RW_LOG_DISABLED() do { } while(0)
+
+#define RW_LOG_RATE_LIMITED(LOG_MACRO, intervalMs, ...) \
+    do { \
+        static ::rw::LogRateLimiter rwLogLimiter_{intervalMs}; \
+        std::uint64_t rwLogSuppressed_ = 0; \
+        if (rwLogLimiter_.allow(rwLogSuppressed_)) { \
+            LOG_MACRO(__VA_ARGS__); \
+            if (rwLogSuppressed_ > 0) { LOG_MACRO("\t({} similar message(s) suppressed)", rwLogSuppressed_); } \
+        } \
+    } while(0)
+
+#if defined(LOGGER_ENABLED) && RW_LOG_LEVEL <= RW_LOG_LEVEL_DEBUG
+#define DLOG(...) do { spdlog::debug(__VA_ARGS__); } while(0)
+#define DLOG_EVERY_MS(ms, ...) RW_LOG_RATE_LIMITED(DLOG, ms, __VA_ARGS__)
+#else
+#define DLOG(...) RW_LOG_DISABLED()
+#define DLOG_EVERY_MS(ms, ...) RW_LOG_DISABLED()
+#endif
+
+#if defined(LOGGER_ENABLED) && RW_LOG_LEVEL <= RW_LOG_LEVEL_INFO
 #define LOG(...) do { spdlog::info(__VA_ARGS__); } while(0)
+#define LOG_EVERY_MS(ms, ...) RW_LOG_RATE_LIMITED(LOG, ms, __VA_ARGS__)
+#else
+#define LOG(...) RW_LOG_DISABLED()
+#define LOG_EVERY_MS(ms, ...) RW_LOG_DISABLED()
+#endif
+
+#if defined(LOGGER_ENABLED) && RW_LOG_LEVEL <= RW_LOG_LEVEL_WARN
 #define WLOG(...) do { spdlog::warn(__VA_ARGS__); } while(0)
+#define WLOG_EVERY_MS(ms, ...) RW_LOG_RATE_LIMITED(WLOG, ms, __VA_ARGS__)
+#else
+#define WLOG(...) RW_LOG_DISABLED()
+#define WLOG_EVERY_MS(ms, ...) RW_LOG_DISABLED()
+#endif
+
+#if defined(LOGGER_ENABLED) && RW_LOG_LEVEL <= RW_LOG_LEVEL_ERROR
 #define ELOG(...) do { spdlog::error(__VA_ARGS__); } while(0)
+#define ELOG_EVERY_MS(ms, ...) RW_LOG_RATE_LIMITED(ELOG, ms, __VA_ARGS__)
 #else
-#define LOG(...) (void)__VA_ARGS__
-#define WLOG(...)(void)__VA_ARGS__
-#define ELOG(...)(void)__VA_ARGS__
+#define ELOG(...) RW_LOG_DISABLED()
+#define ELOG_EVERY_MS(ms, ...) RW_LOG_DISABLED()
 #endif
+
 #endif // LOG_H
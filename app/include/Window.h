@@ -6,6 +6,7 @@
 
 #include <glm/glm.hpp>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -14,7 +15,8 @@ namespace rw {
 class Input;
 class Window {
 public:
-    Window(const std::string &title, const std::int32_t &width, const int32_t &height);
+    // hidden windows still get a surface and swapchain, used for batch rendering
+    Window(const std::string &title, const std::int32_t &width, const int32_t &height, bool visible = true);
     Window(const Window&) = delete;
     Window(Window &&) = delete;
     Window& operator=(const Window&) = delete;
@@ -22,15 +24,17 @@ public:
     ~Window();
 
     // Vulkan stuffs
-    void createSurface(VkInstance instance, VkSurfaceKHR *surface);
+    void createSurface(VkInstance instance, const VkAllocationCallbacks *allocator, VkSurfaceKHR *surface);
 
     // Window stuffs
     bool isClose() const { return glfwWindowShouldClose(mWindow); }
-    bool wasResized() const { return mWasResized; }
-    void resetSizeState() { mWasResized = false; }
     void close() const { glfwSetWindowShouldClose(mWindow, GLFW_TRUE);}
+
+    // size state is written by the event thread and may be read from the render thread
+    bool wasResized() const { return mWasResized.load(std::memory_order_acquire); }
+    void resetSizeState() { mWasResized.store(false, std::memory_order_release); }
     glm::ivec2 size() const {
-        return glm::ivec2(mWidth, mHeight);
+        return glm::ivec2(mWidth.load(std::memory_order_acquire), mHeight.load(std::memory_order_acquire));
     }
 
     std::shared_ptr<Input> getInput() const {
@@ -39,11 +43,14 @@ public:
 private:
     static void framebuffer_size_callback(GLFWwindow *win, int width, int height);
     static void key_callback(GLFWwindow *win, int key, int scancode, int action, int mods);
+    static void mouse_button_callback(GLFWwindow *win, int button, int action, int mods);
+    static void cursor_position_callback(GLFWwindow *win, double x, double y);
+    static void scroll_callback(GLFWwindow *win, double xoffset, double yoffset);
 private:
     GLFWwindow *mWindow;
-    int32_t mWidth;
-    int32_t mHeight;
-    bool mWasResized;
+    std::atomic<int32_t> mWidth;
+    std::atomic<int32_t> mHeight;
+    std::atomic<bool> mWasResized;
 
     std::shared_ptr<Input> mInput;
 };
@@ -0,0 +1,43 @@
+#ifndef ALLOCATIONCOUNTERS_H
+#define ALLOCATIONCOUNTERS_H
+
+#include <cstdint>
+
+namespace rw {
+// Who asked for the memory, set per thread by AllocationScope.
+enum class AllocationTag : std::uint8_t {
+    Other,
+    Frame,     // snapshot building on the main thread and its parallel jobs
+    Render,    // the render thread
+    Streaming, // chunk reads on the I/O threads
+    Loading,   // startup tasks and reloads
+    Count
+};
+
+// Running totals since program start, take the difference of two samples for a rate.
+struct AllocationCount {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+// Every operator new of the program is counted under the tag of the calling thread, so per frame
+// allocations show up without wrapping the engine's containers. Frees are not tracked.
+AllocationCount getAllocationCount(AllocationTag tag);
+AllocationTag getAllocationTag();
+const char *getAllocationTagName(AllocationTag tag);
+
+// Counts the allocations of the calling thread under tag while it lives.
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocationTag tag);
+    ~AllocationScope();
+
+    AllocationScope(const AllocationScope &) = delete;
+    AllocationScope &operator=(const AllocationScope &) = delete;
+
+private:
+    AllocationTag mPrevious;
+};
+}
+
+#endif // ALLOCATIONCOUNTERS_H
@@ -0,0 +1,22 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace rw {
+using Clock = std::chrono::steady_clock;
+
+// Monotonic timestamp in nanoseconds, shared by input events, frame timing and tracing.
+inline std::uint64_t nowNs()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+inline double nsToMs(std::uint64_t ns)
+{
+    return static_cast<double>(ns) / 1.0e6;
+}
+}
+
+#endif // CLOCK_H
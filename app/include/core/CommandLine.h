@@ -0,0 +1,38 @@
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <Log.h>
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace rw {
+// Parses all of text as a number within [min, max]; the negated range check also rejects nan.
+template <typename T>
+bool parseNumber(std::string_view text, T &value, std::type_identity_t<T> min, std::type_identity_t<T> max)
+{
+    T parsed {};
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if (result.ec != std::errc {} || result.ptr != text.data() + text.size() || !(parsed >= min && parsed <= max)) return false;
+    value = parsed;
+    return true;
+}
+
+// Parses the value after the '=' of a --name=value argument; malformed or out of range input is
+// reported and leaves value unchanged.
+template <typename T>
+bool parseOptionValue(const std::string &arg, T &value, std::type_identity_t<T> min, std::type_identity_t<T> max)
+{
+    if (!parseNumber(std::string_view {arg}.substr(arg.find('=') + 1), value, min, max))
+    {
+        WLOG("Invalid value in {}, keeping {}", arg, value);
+        return false;
+    }
+    return true;
+}
+}
+
+#endif // COMMANDLINE_H
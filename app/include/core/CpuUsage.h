@@ -0,0 +1,30 @@
+#ifndef CPUUSAGE_H
+#define CPUUSAGE_H
+
+#include <core/Clock.h>
+
+#include <ctime>
+
+namespace rw {
+// Process CPU time relative to wall time since the previous sample, 100% == one busy core.
+class CpuUsage {
+public:
+    CpuUsage() : mLastCpu {std::clock()}, mLastWall {nowNs()} {}
+
+    double sample() {
+        const std::clock_t cpu = std::clock();
+        const std::uint64_t wall = nowNs();
+        const double cpuSeconds = static_cast<double>(cpu - mLastCpu) / CLOCKS_PER_SEC;
+        const double wallSeconds = static_cast<double>(wall - mLastWall) / 1.0e9;
+        mLastCpu = cpu;
+        mLastWall = wall;
+        return wallSeconds > 0.0 ? 100.0 * cpuSeconds / wallSeconds : 0.0;
+    }
+
+private:
+    std::clock_t mLastCpu;
+    std::uint64_t mLastWall;
+};
+}
+
+#endif // CPUUSAGE_H
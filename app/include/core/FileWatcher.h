@@ -0,0 +1,50 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace rw {
+// Reports edits of a set of files from a background thread. Editors save in bursts (truncate,
+// write, rename over the original), so changes are collected until the files have been quiet
+// for the debounce interval and then reported in one callback. Uses inotify on the parent
+// directories on Linux, which also catches files replaced by a rename, and polls the
+// modification times elsewhere.
+class FileWatcher {
+public:
+    using Callback = std::function<void(const std::vector<std::filesystem::path> &changed)>;
+
+    FileWatcher(std::vector<std::filesystem::path> files, Callback callback,
+                std::chrono::milliseconds debounce = std::chrono::milliseconds(200));
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    const std::vector<std::filesystem::path> &getFiles() const { return mFiles; }
+
+private:
+    void run();
+    bool waitForChanges(std::vector<std::filesystem::path> &changed);
+
+private:
+    std::vector<std::filesystem::path> mFiles;
+    Callback mCallback;
+    std::chrono::milliseconds mDebounce;
+    std::atomic<bool> mRunning {true};
+    std::thread mThread;
+
+#ifdef __linux__
+    int mFd = -1;
+    std::vector<std::pair<int, std::filesystem::path>> mDirectories; // watch descriptor, directory
+#else
+    std::vector<std::filesystem::file_time_type> mWriteTimes;
+#endif
+};
+}
+
+#endif // FILEWATCHER_H
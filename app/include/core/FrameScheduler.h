@@ -0,0 +1,67 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace rw {
+enum class RedrawReason : std::uint32_t {
+    Input = 1u << 0,
+    Camera = 1u << 1,
+    Resize = 1u << 2,
+    Streaming = 1u << 3,
+    Animation = 1u << 4,
+    Refinement = 1u << 5,
+    Reload = 1u << 6,
+};
+
+// Decides when the event thread has to produce a new frame. In on-demand mode a frame is only
+// built when something requested a redraw; while nothing is dirty queued idle tasks run one step
+// at a time (progressive refinement) and the event thread sleeps in glfwWaitEventsTimeout().
+class FrameScheduler {
+public:
+    enum class Mode {
+        OnDemand,
+        Continuous
+    };
+
+    // Idle step, returns true while it has more work to do.
+    using IdleTask = std::function<bool()>;
+
+    void setMode(Mode mode) { mMode = mode; }
+    Mode getMode() const { return mMode; }
+
+    // Can be called from any thread; the wake callback is used to interrupt the event wait.
+    void requestRedraw(RedrawReason reason);
+    void setWakeCallback(std::function<void()> wake) { mWake = std::move(wake); }
+
+    // Keeps redrawing every frame while an animation is playing.
+    void setAnimating(bool animating) { mAnimating = animating; }
+
+    bool needsRedraw() const;
+    // Returns the RedrawReason bits accumulated since the previous frame and clears them.
+    std::uint32_t takeRedrawReasons();
+
+    void addIdleTask(IdleTask task) { mIdleTasks.push_back(std::move(task)); }
+    bool hasIdleTasks() const { return !mIdleTasks.empty(); }
+    // Runs one step of the front idle task, returns false if there was nothing to do.
+    bool runIdleTask();
+
+    // Timeout for glfwWaitEventsTimeout(), 0 means poll without blocking.
+    double getWaitTimeout(bool rendererBusy) const;
+
+    static constexpr double IDLE_TIMEOUT = 0.5;
+    static constexpr double BUSY_TIMEOUT = 0.001;
+
+private:
+    Mode mMode = Mode::OnDemand;
+    bool mAnimating = false;
+    std::atomic<std::uint32_t> mReasons {0};
+    std::function<void()> mWake;
+    std::deque<IdleTask> mIdleTasks;
+};
+}
+
+#endif // FRAMESCHEDULER_H
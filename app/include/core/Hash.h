@@ -0,0 +1,45 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace rw {
+// Word-at-a-time FNV style hash with a final avalanche; used for content addressing,
+// not for anything security related.
+inline std::uint64_t hashMix(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline std::uint64_t hashCombine(std::uint64_t seed, std::uint64_t value)
+{
+    return (seed ^ value) * 0x100000001b3ull;
+}
+
+inline std::uint64_t hashBytes(const void *data, std::size_t size, std::uint64_t seed = 0xcbf29ce484222325ull)
+{
+    auto bytes = static_cast<const std::uint8_t*>(data);
+    std::uint64_t h = seed;
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        h = hashCombine(h, word);
+    }
+    for (; i < size; ++i)
+    {
+        h = hashCombine(h, bytes[i]);
+    }
+    return hashMix(h ^ size);
+}
+}
+
+#endif // HASH_H
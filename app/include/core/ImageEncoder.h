@@ -0,0 +1,34 @@
+#ifndef IMAGEENCODER_H
+#define IMAGEENCODER_H
+
+#include <cstdint>
+#include <string>
+
+namespace rw {
+enum class ImageFormat {
+    Png,
+    Exr,
+    Raw
+};
+
+// 8 bit, 4 channel pixels as they come out of a readback buffer. Only read, never copied.
+struct ImageView {
+    const std::uint8_t *pixels = nullptr;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t rowPitch = 0; // bytes
+    bool bgra = false;
+    bool srgb = false;
+};
+
+// Returns false for an unknown name (png, exr, raw).
+bool parseImageFormat(const std::string &name, ImageFormat &format);
+const char *getImageExtension(ImageFormat format);
+
+// Encodes and writes the image, returns the number of bytes written. PNG is written without
+// compression (stored deflate blocks) to keep up with capture at frame rate, EXR as uncompressed
+// half float linear RGB and raw as tightly packed RGBA rows. Throws on I/O errors.
+std::uint64_t encodeImage(const ImageView &image, ImageFormat format, const std::string &path);
+}
+
+#endif // IMAGEENCODER_H
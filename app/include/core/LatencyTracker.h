@@ -0,0 +1,34 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <cstdint>
+
+namespace rw {
+struct LatencyStats {
+    double lastMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double avgMs = 0.0;
+    std::uint64_t samples = 0;
+};
+
+// Measures input-event-to-present latency. The frame which consumed input remembers the
+// oldest event timestamp and closes the sample once its image has been handed to present.
+// Must be used from the thread that consumes input and presents.
+class LatencyTracker {
+public:
+    void onInputConsumed(std::uint64_t eventTimestamp);
+    void onPresent(std::uint64_t presentTimestamp);
+
+    bool hasPendingInput() const { return mPendingTimestamp != 0; }
+    const LatencyStats &getStats() const { return mStats; }
+    void resetStats() { mStats = LatencyStats {}; }
+
+private:
+    std::uint64_t mPendingTimestamp = 0;
+    double mTotalMs = 0.0;
+    LatencyStats mStats;
+};
+}
+
+#endif // LATENCYTRACKER_H
@@ -0,0 +1,108 @@
+#ifndef LINEARARENA_H
+#define LINEARARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rw {
+struct ArenaStats {
+    std::size_t used = 0;
+    std::size_t capacity = 0;
+    // heap blocks taken so far, stops growing once the arena fits a whole frame
+    std::uint64_t blockAllocations = 0;
+};
+
+// Bump allocator for data that lives for one frame or one job. Allocating moves a pointer and
+// nothing is freed on its own, reset() or rewind() recycle everything at once. A full block is
+// chained to a new one; the next reset merges them into a single block big enough for all of it,
+// so once the working set is known the arena does not touch the heap again.
+class LinearArena {
+public:
+    struct Marker {
+        std::size_t block = 0;
+        std::size_t offset = 0;
+    };
+
+    explicit LinearArena(std::size_t blockSize = 64 * 1024);
+
+    LinearArena(const LinearArena &) = delete;
+    LinearArena &operator=(const LinearArena &) = delete;
+
+    void *allocate(std::size_t bytes, std::size_t alignment);
+    void reset() { rewind(Marker {}); }
+
+    Marker mark() const { return Marker {mCurrent, mOffset}; }
+    // Frees everything allocated after the marker was taken.
+    void rewind(const Marker &marker);
+
+    ArenaStats getStats() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;
+        std::size_t size = 0;
+    };
+
+    void addBlock(std::size_t minSize);
+
+private:
+    std::size_t mBlockSize;
+    std::vector<Block> mBlocks;
+    std::size_t mCurrent = 0;
+    std::size_t mOffset = 0;
+    std::uint64_t mBlockAllocations = 0;
+};
+
+// STL allocator drawing from an arena, deallocate() is a no-op. Containers using it must not
+// outlive the next reset or rewind of the arena.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena &arena) : mArena {&arena} {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : mArena {other.getArena()} {}
+
+    T *allocate(std::size_t count) { return static_cast<T *>(mArena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T *, std::size_t) {}
+
+    LinearArena *getArena() const { return mArena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return mArena == other.getArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return mArena != other.getArena(); }
+
+private:
+    LinearArena *mArena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Rewinds the arena to where it was when the scope started.
+class ArenaScope {
+public:
+    explicit ArenaScope(LinearArena &arena) : mArena {arena}, mMarker {arena.mark()} {}
+    ~ArenaScope() { mArena.rewind(mMarker); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    template <typename T>
+    ArenaVector<T> makeVector() const { return ArenaVector<T>(ArenaAllocator<T>(mArena)); }
+
+private:
+    LinearArena &mArena;
+    LinearArena::Marker mMarker;
+};
+
+// Scratch arena of the calling thread for temporaries of a function or a worker job, scoped
+// with an ArenaScope so nested users each give back what they took.
+LinearArena &getThreadArena();
+}
+
+#endif // LINEARARENA_H
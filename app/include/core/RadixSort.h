@@ -0,0 +1,51 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <core/ThreadPool.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rw {
+// 64-bit key and the index of the item it orders.
+struct SortItem {
+    std::uint64_t key;
+    std::uint32_t index;
+};
+
+struct RadixSortStats {
+    std::size_t items = 0;
+    // digit passes scattered, digits all keys have in common are skipped
+    std::uint32_t passes = 0;
+    // slices of the input counted and scattered in parallel
+    std::uint32_t blocks = 0;
+};
+
+// Stable LSD radix sort over 8-bit digits. Each pass counts the digits of every block on the
+// pool, turns the counts into per-block offsets ordered by block and scatters the blocks in
+// parallel, which keeps equal keys in input order. The scratch buffers are kept between calls.
+class RadixSorter {
+public:
+    explicit RadixSorter(ThreadPool &pool);
+
+    RadixSorter(const RadixSorter &) = delete;
+    RadixSorter &operator=(const RadixSorter &) = delete;
+
+    void sort(std::vector<SortItem> &items);
+
+    const RadixSortStats &getStats() const { return mStats; }
+
+private:
+    static constexpr std::uint32_t BUCKETS = 256;
+
+    ThreadPool &mPool;
+    std::vector<SortItem> mScratch;
+    std::vector<std::array<std::uint32_t, BUCKETS>> mCounts; // per block, offsets after counting
+    std::vector<std::uint64_t> mDifferences;                 // per block, bits some key differs in
+    RadixSortStats mStats;
+};
+}
+
+#endif // RADIXSORT_H
@@ -0,0 +1,56 @@
+#ifndef RESOLUTIONCONTROLLER_H
+#define RESOLUTIONCONTROLLER_H
+
+#include <cstdint>
+
+namespace rw {
+struct ResolutionOptions {
+    double targetMs = 16.0; // GPU time budget per frame
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+};
+
+struct ResolutionStats {
+    float scale = 1.0f; // current
+    float minScale = 1.0f;
+    float maxScale = 1.0f;
+    std::uint32_t changes = 0;
+    double smoothedMs = 0.0;
+};
+
+// Picks the render scale (fraction of the output width and height) from measured GPU frame
+// times. Cost is taken as proportional to the pixel count, i.e. to scale squared. The scale drops
+// as soon as the smoothed time exceeds the budget and only grows again while the frame is well
+// under it, in small steps, so it does not oscillate around the target. Timings arrive a few
+// frames late, after every change the controller waits for them to reflect the new scale.
+class ResolutionController {
+public:
+    explicit ResolutionController(const ResolutionOptions &options = {});
+
+    // Feeds the GPU time of one completed frame, returns the scale for the next one.
+    float update(double gpuMs);
+    float getScale() const { return mScale; }
+    const ResolutionOptions &getOptions() const { return mOptions; }
+
+    const ResolutionStats &getStats() const { return mStats; }
+    void resetStats();
+
+    static constexpr double OVER_BUDGET = 1.05;  // shrink above this fraction of the target
+    static constexpr double UNDER_BUDGET = 0.80; // grow below it
+    static constexpr float MAX_GROWTH = 0.05f;   // per change
+    static constexpr float QUANTUM = 1.0f / 64.0f;
+    static constexpr std::uint32_t SETTLE_FRAMES = 4;
+
+private:
+    void setScale(float scale);
+
+private:
+    ResolutionOptions mOptions;
+    float mScale = 1.0f;
+    double mSmoothedMs = 0.0;
+    std::uint32_t mSettle = 0;
+    ResolutionStats mStats;
+};
+}
+
+#endif // RESOLUTIONCONTROLLER_H
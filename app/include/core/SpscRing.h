@@ -0,0 +1,57 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace rw {
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// Bounded wait-free single producer / single consumer ring buffer.
+// push() must only be called from one thread and pop() from one (other) thread.
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+    bool push(const T &value) {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mCachedTail >= Capacity)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head - mCachedTail >= Capacity) return false;
+        }
+        mSlots[head & (Capacity - 1)] = value;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail == mCachedHead)
+        {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (tail == mCachedHead) return false;
+        }
+        value = mSlots[tail & (Capacity - 1)];
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size() const {
+        return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    // producer and consumer indices live on separate cache lines to avoid false sharing
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> mHead {0};
+    std::size_t mCachedTail = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> mTail {0};
+    std::size_t mCachedHead = 0;
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> mSlots {};
+};
+}
+
+#endif // SPSCRING_H
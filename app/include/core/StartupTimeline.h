@@ -0,0 +1,53 @@
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rw {
+struct StartupPhaseRecord {
+    std::string name;
+    std::uint64_t beginNs = 0;
+    std::uint64_t endNs = 0;
+    std::thread::id thread;
+};
+
+// Collects the phases of application startup from any thread, so overlapping
+// work shows up side by side when the timeline is printed.
+class StartupTimeline {
+public:
+    static StartupTimeline &get();
+
+    void record(std::string name, std::uint64_t beginNs, std::uint64_t endNs);
+    // Logs every phase relative to the timeline origin, once.
+    void print(std::uint64_t firstFrameNs);
+
+private:
+    StartupTimeline();
+
+    std::uint64_t mOriginNs;
+    std::thread::id mMainThread;
+    std::mutex mMutex;
+    std::vector<StartupPhaseRecord> mPhases;
+    bool mPrinted = false;
+};
+
+// Records the scope it lives in as one startup phase.
+class StartupPhase {
+public:
+    explicit StartupPhase(const char *name);
+    ~StartupPhase();
+
+    StartupPhase(const StartupPhase &) = delete;
+    StartupPhase &operator=(const StartupPhase &) = delete;
+
+private:
+    const char *mName;
+    std::uint64_t mBeginNs;
+};
+}
+
+#endif // STARTUPTIMELINE_H
@@ -0,0 +1,35 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace rw {
+// Small dependency graph for one-off work such as startup loading. Every task gets its
+// own thread and starts as soon as the tasks it depends on have finished; a failing
+// dependency fails its dependents. Each task is recorded as a startup phase.
+class TaskGraph {
+public:
+    using TaskId = std::size_t;
+
+    TaskGraph() = default;
+    ~TaskGraph();
+
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    TaskId add(std::string name, std::function<void()> task, std::vector<TaskId> dependencies = {});
+
+    // Blocks until the task is done, rethrows its exception.
+    void wait(TaskId id);
+    void waitAll();
+
+private:
+    std::vector<std::shared_future<void>> mTasks;
+};
+}
+
+#endif // TASKGRAPH_H
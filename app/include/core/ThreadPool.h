@@ -0,0 +1,73 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace rw {
+// Fixed set of worker threads for short CPU jobs (animation sampling, sorting, decoding).
+// Long blocking work such as file I/O should get its own pool so it cannot starve these.
+class ThreadPool {
+public:
+    // 0 uses one thread per hardware thread minus the caller.
+    explicit ThreadPool(std::size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template <typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // Splits [0, count) into chunks of at least minChunk items and runs fn(begin, end) on the
+    // workers and the calling thread. Returns once every chunk is done, rethrows the first exception.
+    // fn is called through a pointer instead of being copied into a std::function, so a steady
+    // stream of calls does not allocate.
+    template <typename F>
+    void parallelFor(std::size_t count, std::size_t minChunk, F &&fn)
+    {
+        using Function = std::remove_reference_t<F>;
+        runParallel(count, minChunk, [](void *context, std::size_t begin, std::size_t end) { (*static_cast<Function *>(context))(begin, end); },
+                    const_cast<void *>(static_cast<const void *>(std::addressof(fn))));
+    }
+
+    std::size_t getThreadCount() const { return mWorkers.size(); }
+
+private:
+    using RangeFunction = void (*)(void *, std::size_t, std::size_t);
+    struct ParallelJob;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+    void runParallel(std::size_t count, std::size_t minChunk, RangeFunction function, void *context);
+    void releaseJob(ParallelJob *job);
+
+private:
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    // ring buffer, only grows; a deque would take and free a block every few tasks
+    std::vector<std::function<void()>> mTasks;
+    std::size_t mTaskHead = 0;
+    std::size_t mTaskCount = 0;
+    // finished parallelFor jobs kept for the next call, guarded by mMutex
+    std::vector<std::unique_ptr<ParallelJob>> mFreeJobs;
+    bool mStopping = false;
+};
+}
+
+#endif // THREADPOOL_H
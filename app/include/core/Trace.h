@@ -0,0 +1,107 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <core/Clock.h>
+#include <core/SpscRing.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace rw {
+struct TraceEvent {
+    // a string literal or a name from Tracer::intern(), never freed while the tracer exists
+    const char *name = nullptr;
+    std::uint64_t beginNs = 0;
+    std::uint64_t endNs = 0;
+};
+
+struct TraceStats {
+    std::uint64_t events = 0;
+    std::uint64_t dropped = 0;
+    std::uint32_t threads = 0;
+};
+
+// Scoped CPU markers from any thread, written out as Chrome trace JSON (chrome://tracing, Perfetto).
+// Each thread pushes into its own wait-free ring, created the first time it records, and collect()
+// moves them into one list. While tracing is off a scope costs one relaxed load.
+class Tracer {
+public:
+    static constexpr std::size_t THREAD_CAPACITY = 16384;
+
+    static Tracer &get();
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    // Forgets earlier events and starts recording.
+    void start();
+    // Stops recording and writes everything recorded since start() to path.
+    TraceStats stop(const std::string &path);
+    // Drains the thread rings, called regularly while tracing so they do not fill up.
+    void collect();
+
+    void record(const char *name, std::uint64_t beginNs, std::uint64_t endNs);
+    // Stable copy of a name built at runtime, such as a task name.
+    const char *intern(const std::string &name);
+    // Labels the calling thread in the trace, cheap enough to call whether tracing is on or not.
+    void setThreadName(const char *name);
+
+private:
+    struct ThreadBuffer {
+        std::uint32_t id = 0;
+        std::atomic<std::uint64_t> dropped {0};
+        SpscRing<TraceEvent, THREAD_CAPACITY> events;
+    };
+
+    struct CollectedEvent {
+        std::uint32_t thread;
+        TraceEvent event;
+    };
+
+    Tracer() = default;
+    ThreadBuffer &threadBuffer();
+    void collectLocked();
+    std::uint32_t threadId();
+
+    static std::atomic<bool> sEnabled;
+    static thread_local std::uint32_t sThreadId;
+    static thread_local ThreadBuffer *sThreadBuffer;
+
+    std::mutex mMutex;
+    // buffers outlive their threads, a worker may still have events in flight when it exits
+    std::vector<std::unique_ptr<ThreadBuffer>> mThreads;
+    std::vector<std::pair<std::uint32_t, const char *>> mThreadNames;
+    std::vector<CollectedEvent> mEvents;
+    std::unordered_set<std::string> mNames;
+    std::atomic<std::uint32_t> mNextThreadId {1};
+};
+
+// Records the scope it lives in as one trace event when tracing is on.
+class TraceScope {
+public:
+    // a null name records nothing, for names that are only interned while tracing
+    explicit TraceScope(const char *name) : mName{Tracer::isEnabled() ? name : nullptr}, mBeginNs{mName ? nowNs() : 0}
+    {
+    }
+    ~TraceScope()
+    {
+        if (mName) Tracer::get().record(mName, mBeginNs, nowNs());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *mName;
+    std::uint64_t mBeginNs;
+};
+}
+
+#define RW_TRACE_CONCAT_(a, b) a##b
+#define RW_TRACE_CONCAT(a, b) RW_TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ::rw::TraceScope RW_TRACE_CONCAT(traceScope, __LINE__){name}
+
+#endif // TRACE_H
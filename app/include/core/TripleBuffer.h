@@ -0,0 +1,43 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rw {
+// Lock-free triple buffer for one producer and one consumer thread. The producer fills
+// getWriteBuffer() and publish()es it, the consumer fetch()es the most recent published
+// value. Neither side ever blocks, stale values are silently overwritten.
+template <typename T>
+class TripleBuffer {
+public:
+    T &getWriteBuffer() { return mBuffers[mWriteIdx]; }
+
+    void publish() {
+        std::uint8_t previous = mMiddle.exchange(static_cast<std::uint8_t>(mWriteIdx | FRESH_BIT), std::memory_order_acq_rel);
+        mWriteIdx = previous & INDEX_MASK;
+    }
+
+    // Returns true when a newer value than the current read buffer was available.
+    bool fetch() {
+        if ((mMiddle.load(std::memory_order_acquire) & FRESH_BIT) == 0) return false;
+        std::uint8_t previous = mMiddle.exchange(mReadIdx, std::memory_order_acq_rel);
+        mReadIdx = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T &getReadBuffer() const { return mBuffers[mReadIdx]; }
+
+private:
+    static constexpr std::uint8_t FRESH_BIT = 0x4;
+    static constexpr std::uint8_t INDEX_MASK = 0x3;
+
+    std::array<T, 3> mBuffers {};
+    std::uint8_t mWriteIdx = 0;
+    std::atomic<std::uint8_t> mMiddle {1};
+    std::uint8_t mReadIdx = 2;
+};
+}
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,60 @@
+#ifndef ASYNCCOMPUTE_H
+#define ASYNCCOMPUTE_H
+
+#include <render/Device.h>
+#include <render/GpuTimer.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rw
+{
+  // Records a pass into the frame's compute command buffer, returns false when it had nothing to do.
+  using ComputePass = std::function<bool(VkCommandBuffer command, int frameIndex)>;
+
+  // Per-frame compute submission on the compute queue family. Work for frame N is submitted
+  // before its graphics work and signals a semaphore that only the graphics stages reading
+  // the results wait on, so it overlaps with the previous frame still rasterizing. Buffers
+  // written here and read by graphics must be shared between both families (see
+  // Device::createBuffer) when the device has a dedicated compute family.
+  class AsyncCompute
+  {
+  public:
+    using PassId = uint32_t;
+
+    AsyncCompute(Device& dev, uint32_t frameCount);
+    ~AsyncCompute();
+
+    AsyncCompute(const AsyncCompute&) = delete;
+    AsyncCompute& operator=(const AsyncCompute&) = delete;
+
+    PassId addPass(ComputePass pass);
+    void removePass(PassId id);
+
+    // Records and submits all passes of the frame. Returns the semaphore graphics has to wait
+    // on, VK_NULL_HANDLE when no pass recorded anything.
+    VkSemaphore submit(int frameIndex);
+
+    GpuTimer& getGpuTimer() { return *mGpuTimer; }
+
+  private:
+    struct Pass
+    {
+      PassId id;
+      ComputePass record;
+    };
+
+    Device& device;
+    std::vector<Pass> mPasses;
+    PassId mNextPassId = { 0 };
+
+    std::vector<VkCommandBuffer> mCommandBuffers;
+    std::vector<VkSemaphore> mFinishedSemaphores;
+    std::vector<VkFence> mFences;
+    std::unique_ptr<GpuTimer> mGpuTimer;
+  };
+}
+
+#endif // ASYNCCOMPUTE_H
@@ -10,7 +10,8 @@ namespace rw
   class Buffer
   {
   public:
-	Buffer(Device &dev, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment = 1);
+	Buffer(Device &dev, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment = 1,
+		bool sharedWithCompute = false);
 	~Buffer();
 
 	Buffer(const Buffer&) = delete;
@@ -18,9 +19,16 @@ namespace rw
 
 	void update(const std::vector<uint8_t>& data);
 
+	VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	void unmap();
+	void writeToBuffer(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+	// makes device writes visible to the host for memory which is not host coherent
+	VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
 	VkBuffer getHandler() const { return mBuffer; }
 	VkDeviceMemory getMemoryDevice() const { return mMemoryDevice; }
-	const void* getMappedMemory() const { return mapped; }
+	void* getMappedMemory() const { return mapped; }
 
 	VkDeviceSize getBufferSize() const { return mBufferSize; }
 	VkDeviceSize getAlignmentSize() const { return mAlignmentSize; }
@@ -0,0 +1,38 @@
+#ifndef COMMANDTRACE_H
+#define COMMANDTRACE_H
+
+#include <core/Trace.h>
+#include <render/Device.h>
+
+namespace rw
+{
+  // Trace scope around recording a pass which also labels the commands recorded inside it,
+  // so the same names show up in frame debuggers and GPU profilers. Records nothing while
+  // tracing is off.
+  class CommandTraceScope
+  {
+  public:
+    CommandTraceScope(const Device& dev, VkCommandBuffer command, const char* name)
+      : mScope{ name }, mDevice{ Tracer::isEnabled() && dev.hasDebugLabels() ? &dev : nullptr }, mCommand{ command }
+    {
+      if (mDevice) mDevice->beginLabel(mCommand, name);
+    }
+
+    ~CommandTraceScope()
+    {
+      if (mDevice) mDevice->endLabel(mCommand);
+    }
+
+    CommandTraceScope(const CommandTraceScope&) = delete;
+    CommandTraceScope& operator=(const CommandTraceScope&) = delete;
+
+  private:
+    TraceScope mScope;
+    const Device* mDevice;
+    VkCommandBuffer mCommand;
+  };
+}
+
+#define TRACE_COMMANDS(device, command, name) ::rw::CommandTraceScope RW_TRACE_CONCAT(commandTraceScope, __LINE__){ device, command, name }
+
+#endif // COMMANDTRACE_H
@@ -0,0 +1,29 @@
+#ifndef COMPUTEPIPELINE_H
+#define COMPUTEPIPELINE_H
+
+#include <render/Device.h>
+
+#include <vector>
+
+namespace rw
+{
+  class ComputePipeline
+  {
+  public:
+    ComputePipeline(Device& dev, const std::vector<char>& code, VkPipelineLayout layout, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    ~ComputePipeline();
+
+    ComputePipeline(const ComputePipeline&) = delete;
+    ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+    void bind(VkCommandBuffer command);
+    VkPipeline getHandler() const { return mPipeline; }
+
+  private:
+    Device& device;
+    VkPipeline mPipeline = { VK_NULL_HANDLE };
+    VkShaderModule mShaderModule = { VK_NULL_HANDLE };
+  };
+}
+
+#endif // COMPUTEPIPELINE_H
@@ -2,12 +2,13 @@
 #define DEVICE_H
 
 #include <Window.h>
+#include <render/DeviceSelector.h>
+#include <render/HostAllocator.h>
 #include <render/PhysicalDevice.h>
 
 #include <cstdint>
 #include <optional>
 #include <vector>
-#include <unordered_map>
 
 namespace rw {
 
@@ -15,9 +16,11 @@ namespace rw {
   {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // a compute-only family when the device has one, otherwise the graphics family
+    std::optional<uint32_t> computeFamily;
 
-    bool isComplete() {
-      return graphicsFamily.has_value() && presentFamily.has_value();
+    bool isComplete() const {
+      return graphicsFamily.has_value() && presentFamily.has_value() && computeFamily.has_value();
     }
   };
 
@@ -31,50 +34,86 @@ namespace rw {
 
   class Device {
   public:
-    Device(Window& window);
+    Device(Window& window, const DeviceSelectionOptions& selection = {});
     ~Device();
 
     VkDevice getDevice() const { return mDevice; }
+    // pass to every create and destroy call, counts the driver's host memory
+    const VkAllocationCallbacks* getAllocator() const { return mHostAllocator.getCallbacks(); }
+    HostAllocatorStats getHostMemoryStats() const { return mHostAllocator.getStats(); }
     VkCommandPool getCommandPool() const { return mCommandPool; }
     VkQueue getGraphicsQueue() const { return mGraphicsQueue; }
     VkQueue getPresentQueue() const { return mPresentQueue; }
+    VkQueue getComputeQueue() const { return mComputeQueue; }
+    VkCommandPool getComputeCommandPool() const { return mComputeCommandPool; }
+    // true when compute work runs on its own queue family and can overlap with rendering
+    bool hasAsyncCompute() const { return mQueueFamilyIndices.computeFamily != mQueueFamilyIndices.graphicsFamily; }
     VkSurfaceKHR getSurface() const { return mSurface; }
-    PhysicalDevice getCurrentPhysicalDevice() { return mPhysicalDevice; }
+    const PhysicalDevice& getCurrentPhysicalDevice() const { return mPhysicalDevice; }
+    const VkPhysicalDeviceFeatures& getEnabledFeatures() const { return mEnabledFeatures; }
+    // shaders may use 64-bit atomics on storage buffers
+    bool hasBufferInt64Atomics() const { return mBufferInt64Atomics; }
+
+    // VK_EXT_debug_utils is enabled, begin/endLabel() may only be called when it is
+    bool hasDebugLabels() const { return mCmdBeginLabel != nullptr; }
+    void beginLabel(VkCommandBuffer command, const char* name) const;
+    void endLabel(VkCommandBuffer command) const;
 
     VkCommandBuffer beginSingleTimeCommand();
     void endSingleTimeCommand(VkCommandBuffer command);
 
     VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 
     void createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    // sharedWithCompute makes the buffer usable from the graphics and compute queue families without ownership transfers
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+      bool sharedWithCompute = false);
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
-    QueueFamilyIndices findQueueFamilies();
-    SwapChainSupportDetails getSwapChainSupport();
+    // queried once when the physical device is picked
+    const QueueFamilyIndices& findQueueFamilies() const { return mQueueFamilyIndices; }
+    // formats and present modes are cached, only the capabilities (current extent) are re-queried
+    SwapChainSupportDetails getSwapChainSupport() const;
 
   private:
     void createInstance();
     void getPhysicalDevices();
-    void pickPhysicalDevice();
+    void pickPhysicalDevice(const DeviceSelectionOptions& selection);
     void createSurface();
     void createCommandPool();
     void createLogicalDevice();
+    void queryQueueFamilies();
+    void querySurfaceSupport();
 
     std::vector<const char*> requiredExtensions();
+    static bool supportsInstanceExtension(const char* name);
 
   private:
     Window& mWindow;
+    // declared first, it outlives every object the driver allocated through it
+    HostAllocator mHostAllocator;
     VkInstance mInstance;
     PhysicalDevice mPhysicalDevice;
-    std::unordered_map<VkPhysicalDeviceType, PhysicalDevice> gpus;
+    std::vector<PhysicalDevice> mGpus;
     VkDevice mDevice;
     VkSurfaceKHR mSurface;
     VkCommandPool mCommandPool;
+    VkCommandPool mComputeCommandPool;
+    VkPhysicalDeviceFeatures mEnabledFeatures = {};
+    bool mBufferInt64Atomics = false;
+    PFN_vkCmdBeginDebugUtilsLabelEXT mCmdBeginLabel = nullptr;
+    PFN_vkCmdEndDebugUtilsLabelEXT mCmdEndLabel = nullptr;
+
+    // capabilities cached after the physical device is picked
+    QueueFamilyIndices mQueueFamilyIndices;
+    std::vector<VkSurfaceFormatKHR> mSurfaceFormats;
+    std::vector<VkPresentModeKHR> mPresentModes;
 
     // queues
     VkQueue mGraphicsQueue;
     VkQueue mPresentQueue;
+    VkQueue mComputeQueue;
   };
 }
 
@@ -0,0 +1,64 @@
+#ifndef DEVICESELECTOR_H
+#define DEVICESELECTOR_H
+
+#include <render/PhysicalDevice.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rw
+{
+  struct DeviceSelectionOptions
+  {
+    // index or part of the device name (--gpu=), overrides the score when the device is usable
+    std::string preferred;
+    // measure devices without a cached calibration result (--gpu-calibrate)
+    bool calibrate = { false };
+  };
+
+  struct DeviceCandidate
+  {
+    uint32_t index = { 0 };
+    bool suitable = { false };
+    std::string rejectReason;
+    double score = { 0.0 };
+    double bandwidthGBs = { 0.0 }; // 0 when never calibrated
+  };
+
+  // Picks the physical device to render on. Unusable devices (no graphics/present queue,
+  // missing extensions or features) are rejected, the rest is scored by device type,
+  // memory, queue families and features. A short transfer bandwidth probe, cached per
+  // device UUID and driver version, outweighs the static score once it is available.
+  class DeviceSelector
+  {
+  public:
+    // allocator is used for the calibration device
+    DeviceSelector(VkSurfaceKHR surface, const std::vector<const char*>& requiredExtensions, const DeviceSelectionOptions& options,
+      const VkAllocationCallbacks* allocator = nullptr);
+
+    // Returns the index of the chosen device, throws when none is usable.
+    uint32_t select(const std::vector<PhysicalDevice>& devices);
+
+    static std::string calibrationCachePath();
+
+  private:
+    DeviceCandidate evaluate(const PhysicalDevice& device, uint32_t index) const;
+    double staticScore(const PhysicalDevice& device) const;
+    int findPreferred(const std::vector<PhysicalDevice>& devices) const;
+
+    // Copies a device local buffer a few times, returns GB/s or 0 on failure.
+    static double measureBandwidth(const PhysicalDevice& device, const VkAllocationCallbacks* allocator);
+    void loadCalibration();
+    void saveCalibration() const;
+
+  private:
+    VkSurfaceKHR mSurface;
+    std::vector<const char*> mRequiredExtensions;
+    DeviceSelectionOptions mOptions;
+    const VkAllocationCallbacks* mAllocator = { nullptr };
+    std::unordered_map<std::string, double> mCalibration;
+  };
+}
+
+#endif // DEVICESELECTOR_H
@@ -0,0 +1,70 @@
+#ifndef FRAGMENTCOUNTER_H
+#define FRAGMENTCOUNTER_H
+
+#include <render/Device.h>
+
+#include <array>
+#include <vector>
+
+namespace rw
+{
+  // Fragment shader invocations of one frame, split by the pass that ran them.
+  struct FragmentCounts
+  {
+    uint64_t prepass = { 0 }; // depth prepass or visibility pass
+    uint64_t shading = { 0 }; // passes computing lit colors
+    uint64_t pixels = { 0 };  // of the scene extent the frame was drawn at
+  };
+
+  // Pipeline statistics queries counting the fragment shader invocations of each frame's passes, the
+  // cost overdraw adds to shading. Like GpuTimer, results are read back when the same frame slot is
+  // recorded again. Needs the pipelineStatisticsQuery feature, without it nothing is counted.
+  class FragmentCounter
+  {
+  public:
+    enum Pass : uint32_t
+    {
+      PREPASS = 0,
+      SHADING = 1,
+      PASS_COUNT = 2
+    };
+
+    FragmentCounter(Device& dev, uint32_t frameCount);
+    ~FragmentCounter();
+
+    FragmentCounter(const FragmentCounter&) = delete;
+    FragmentCounter& operator=(const FragmentCounter&) = delete;
+
+    bool isSupported() const { return mQueryPool != VK_NULL_HANDLE; }
+
+    // Collects the slot's previous results and resets its queries; outside of any render pass, before begin().
+    void reset(VkCommandBuffer command, uint32_t frameIndex, VkExtent2D extent);
+    // A pass's query has to begin and end in the same subpass. Passes not counted this frame read as 0.
+    void begin(VkCommandBuffer command, uint32_t frameIndex, Pass pass);
+    void end(VkCommandBuffer command, uint32_t frameIndex, Pass pass);
+
+    const FragmentCounts& getLast() const { return mLast; }
+    // Number of frames counted so far, tells whether getLast() is a new sample.
+    uint64_t getSampleCount() const { return mSampleCount; }
+
+  private:
+    struct Slot
+    {
+      bool pending = { false };
+      uint32_t passes = { 0 }; // bit per Pass begun this frame
+      uint64_t pixels = { 0 };
+    };
+
+    void collect(uint32_t frameIndex);
+
+  private:
+    Device& device;
+    VkQueryPool mQueryPool = { VK_NULL_HANDLE };
+    std::vector<Slot> mSlots;
+
+    FragmentCounts mLast;
+    uint64_t mSampleCount = { 0 };
+  };
+}
+
+#endif // FRAGMENTCOUNTER_H
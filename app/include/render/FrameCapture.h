@@ -0,0 +1,107 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <core/ImageEncoder.h>
+#include <core/ThreadPool.h>
+#include <render/Buffer.h>
+#include <render/Device.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rw
+{
+  struct CaptureOptions
+  {
+    std::string directory = { "captures" }; // created with the first file
+    ImageFormat format = { ImageFormat::Png };
+    // readback buffers; frames in flight plus queued encodes, a frame is dropped when all are busy
+    uint32_t slots = { 6 };
+    // 0 uses half of the hardware threads
+    uint32_t encoderThreads = { 0 };
+  };
+
+  struct CaptureStats
+  {
+    uint64_t captured = { 0 }; // copies submitted
+    uint64_t encoded = { 0 };  // files written
+    uint64_t dropped = { 0 };  // frames skipped because every slot was busy
+    uint64_t failed = { 0 };   // encoder errors
+    uint64_t bytes = { 0 };    // written to disk
+    double encodeMs = { 0.0 }; // summed over the encoder threads
+    uint32_t queueDepth = { 0 }; // slots in flight or waiting for an encoder, sampled
+  };
+
+  // Copies images into host visible readback buffers without waiting for the GPU. Every slot owns
+  // a fence signalled after the frame's work, poll() hands finished slots to an encoder pool which
+  // reads the mapped memory in place and returns the slot once the file is written.
+  // record()/submit() belong to the thread which submits to the graphics queue, poll() and
+  // takeStats() may be called from any thread.
+  class FrameCapture
+  {
+  public:
+    FrameCapture(Device& dev, const CaptureOptions& options);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Records the copy of image (in layout, restored afterwards) into a free slot, the file is written
+    // as <directory>/<name>.<extension>. Returns false and counts a dropped frame when no slot is
+    // free or the format can't be encoded.
+    bool record(VkCommandBuffer command, VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout, const std::string& name);
+    // Signals the fence of the recorded slot once everything submitted to queue so far is done.
+    void submit(VkQueue queue);
+    // The recorded command buffer was never submitted.
+    void discard();
+    // Hands slots whose copy finished to the encoders.
+    void poll();
+    // Blocks until a slot is free, for callers which must not drop frames.
+    void waitForFreeSlot();
+    // Blocks until every submitted capture has been written.
+    void flush();
+
+    const CaptureOptions& getOptions() const { return mOptions; }
+    // frame_000042, used for captures of the interactive viewer
+    static std::string getFrameName(uint64_t frameNumber);
+    // Returns the stats accumulated since the previous call.
+    CaptureStats takeStats();
+
+  private:
+    enum class SlotState : uint32_t { Free, Recorded, Submitted, Encoding };
+
+    struct Slot
+    {
+      std::unique_ptr<Buffer> buffer;
+      VkFence fence = { VK_NULL_HANDLE };
+      std::atomic<SlotState> state{ SlotState::Free };
+      ImageView image;
+      std::string name;
+    };
+
+    void encode(Slot& slot);
+
+  private:
+    Device& device;
+    CaptureOptions mOptions;
+    std::once_flag mDirectoryCreated;
+    VkMemoryPropertyFlags mMemoryFlags = { 0 };
+    std::vector<std::unique_ptr<Slot>> mSlots;
+    Slot* mRecorded = { nullptr };
+
+    std::atomic<uint64_t> mCaptured{ 0 };
+    std::atomic<uint64_t> mEncoded{ 0 };
+    std::atomic<uint64_t> mDropped{ 0 };
+    std::atomic<uint64_t> mFailed{ 0 };
+    std::atomic<uint64_t> mBytes{ 0 };
+    std::atomic<uint64_t> mEncodeNs{ 0 };
+
+    // declared last, so queued encodes finish before the slots go away
+    std::unique_ptr<ThreadPool> mEncoders;
+  };
+}
+
+#endif // FRAMECAPTURE_H
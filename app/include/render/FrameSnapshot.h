@@ -0,0 +1,111 @@
+#ifndef FRAMESNAPSHOT_H
+#define FRAMESNAPSHOT_H
+
+#include <render/InstanceBatcher.h>
+#include <scene/GeometryDiff.h>
+#include <scene/LightBinner.h>
+#include <scene/PointCloud.h>
+#include <scene/ShadowCascades.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rw
+{
+  // One animated node, skinned by the compute pass and drawn from the skinned vertex buffer.
+  struct SkinnedDraw
+  {
+    SkinnedMeshId mesh;
+    uint32_t paletteOffset; // first joint matrix in FrameSnapshot::jointPalettes
+    uint32_t instance;      // transform and color in FrameSnapshot::instances
+  };
+
+  // One resident chunk of a streamed model. The snapshot shares ownership of the geometry, so the
+  // render thread can upload it even if the RAM cache evicted it in the meantime.
+  struct StreamedDraw
+  {
+    uint32_t chunk;
+    std::shared_ptr<const MeshData> mesh;
+    uint32_t instance;
+  };
+
+  // One shadow cascade of the key light. Static casters are only carried while the cascade's cached
+  // map may still have to be redrawn for key, the render thread skips them once it drew that key.
+  struct ShadowCascadeDraw
+  {
+    glm::mat4 viewProjection{ 1.0f };
+    float splitDepth = { 0.0f };
+    uint64_t key = { 0 };
+    bool hasCasters = { false };
+    uint32_t firstBatch = { 0 }; // static casters in FrameSnapshot::shadowBatches
+    uint32_t batchCount = { 0 };
+  };
+
+  // How the opaque scene is shaded.
+  enum class RenderMode
+  {
+    Forward,      // one pass, every fragment passing the depth test at the time is shaded
+    DepthPrepass, // depth of everything first, then only the fragments matching it are shaded
+    Visibility    // instance and normal per pixel first, then one lighting pass over the screen
+  };
+
+  // Everything the render thread needs to draw one frame. Built by the simulation thread,
+  // handed over through a TripleBuffer and treated as immutable afterwards.
+  struct FrameSnapshot
+  {
+    uint64_t sequence = { 0 };
+
+    // camera
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::mat4 viewProjection{ 1.0f };
+    glm::vec3 cameraPosition{ 0.0f };
+
+    // visible set with its transforms, already grouped into instanced draws
+    std::vector<DrawBatch> batches;
+    std::vector<InstanceData> instances;
+
+    // visible animated nodes with their sampled joint palettes
+    std::vector<SkinnedDraw> skinnedDraws;
+    std::vector<glm::mat4> jointPalettes;
+
+    // chunks of the streamed model covering the view
+    std::vector<StreamedDraw> streamedDraws;
+
+    // prefixes of the visible point cloud chunks, rasterized by the compute queue
+    std::vector<PointSelection> pointDraws;
+
+    // lights binned into the view's clusters, an (offset, count) range of lightIndices per cluster
+    ClusterGrid lightGrid;
+    std::vector<ClusterLight> lights;
+    std::vector<glm::uvec2> lightClusters;
+    std::vector<uint32_t> lightIndices;
+
+    // cascaded shadows of the key light, none when shadows are off; the casters' instances follow the
+    // visible ones in instances, the streamed chunks and skinned draws above cast shadows as well
+    glm::vec3 lightDirection{ 0.0f, 1.0f, 0.0f };
+    uint32_t shadowResolution = { 0 };
+    std::vector<ShadowCascadeDraw> shadowCascades;
+    std::vector<DrawBatch> shadowBatches;
+
+    RenderMode renderMode = { RenderMode::Forward };
+    // draw the batches from command buffers recorded once and reused while they do not change,
+    // forward mode only
+    bool staticCommands = { false };
+
+    // geometry of a reloaded model, repeated in every snapshot until one of them was picked up;
+    // batches of this snapshot already refer to the new mesh ids
+    std::shared_ptr<const GeometryDiff> geometry;
+
+    // copy the presented image out for the frame capture
+    bool capture = { false };
+
+    // oldest input event not yet presented, 0 if none
+    uint64_t inputTimestamp = { 0 };
+  };
+}
+
+#endif // FRAMESNAPSHOT_H
@@ -0,0 +1,50 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <render/Device.h>
+
+#include <vector>
+
+namespace rw
+{
+  // Timestamp queries around each frame's command buffer on one queue family. Results are read
+  // back when the same frame slot is recorded again, i.e. after its fence has been waited on.
+  class GpuTimer
+  {
+  public:
+    GpuTimer(Device& dev, uint32_t frameCount, uint32_t queueFamily);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    bool isSupported() const { return mQueryPool != VK_NULL_HANDLE; }
+
+    void begin(VkCommandBuffer command, uint32_t frameIndex);
+    void end(VkCommandBuffer command, uint32_t frameIndex);
+    // The command buffer of the frame was recorded but never submitted.
+    void discard(uint32_t frameIndex) { mPending[frameIndex] = false; }
+
+    double getLastFrameMs() const { return mLastFrameMs; }
+    // Number of frames measured so far, tells whether getLastFrameMs() is a new sample.
+    uint64_t getSampleCount() const { return mSampleCount; }
+    // GPU busy time accumulated since the previous call.
+    double takeBusyMs();
+
+  private:
+    void collect(uint32_t frameIndex);
+
+  private:
+    Device& device;
+    VkQueryPool mQueryPool = { VK_NULL_HANDLE };
+    double mTimestampPeriodNs = { 1.0 };
+    uint64_t mTimestampMask = { ~0ull };
+    std::vector<bool> mPending;
+
+    double mLastFrameMs = { 0.0 };
+    uint64_t mSampleCount = { 0 };
+    double mBusyMs = { 0.0 };
+  };
+}
+
+#endif // GPUTIMER_H
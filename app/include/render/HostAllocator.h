@@ -0,0 +1,75 @@
+#ifndef HOSTALLOCATOR_H
+#define HOSTALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace rw
+{
+  // per VkSystemAllocationScope
+  struct HostScopeStats
+  {
+    uint64_t bytes = { 0 };       // alive now
+    uint64_t allocations = { 0 }; // alive now
+    uint64_t peakBytes = { 0 };
+    uint64_t totalAllocations = { 0 }; // since start, reallocations included
+    uint64_t internalBytes = { 0 };    // reported by the driver, not allocated through us
+  };
+
+  struct HostAllocatorStats
+  {
+    static constexpr uint32_t SCOPE_COUNT = { 5 }; // command, object, cache, device, instance
+    std::array<HostScopeStats, SCOPE_COUNT> scopes = {};
+
+    uint64_t getBytes() const;
+    uint64_t getAllocations() const;
+    uint64_t getTotalAllocations() const;
+    uint64_t getInternalBytes() const;
+  };
+
+  // VkAllocationCallbacks handed to every create and destroy call, counting the driver's host
+  // memory per allocation scope. A command scope allocation per frame points at a command pool
+  // or descriptor set being created while recording.
+  class HostAllocator
+  {
+  public:
+    HostAllocator();
+
+    HostAllocator(const HostAllocator&) = delete;
+    HostAllocator& operator=(const HostAllocator&) = delete;
+
+    const VkAllocationCallbacks* getCallbacks() const { return &mCallbacks; }
+    HostAllocatorStats getStats() const;
+
+    static const char* getScopeName(uint32_t scope);
+
+  private:
+    struct alignas(64) Counters
+    {
+      std::atomic<uint64_t> bytes = { 0 };
+      std::atomic<uint64_t> allocations = { 0 };
+      std::atomic<uint64_t> peakBytes = { 0 };
+      std::atomic<uint64_t> totalAllocations = { 0 };
+      std::atomic<uint64_t> internalBytes = { 0 };
+    };
+
+    void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+    void free(void* memory);
+    Counters& getCounters(VkSystemAllocationScope scope);
+
+    static VKAPI_ATTR void* VKAPI_CALL allocateCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void* VKAPI_CALL reallocateCallback(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL freeCallback(void* userData, void* memory);
+    static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+  private:
+    VkAllocationCallbacks mCallbacks = {};
+    std::array<Counters, HostAllocatorStats::SCOPE_COUNT> mScopes;
+  };
+}
+
+#endif // HOSTALLOCATOR_H
@@ -0,0 +1,102 @@
+#ifndef INSTANCEBATCHER_H
+#define INSTANCEBATCHER_H
+
+#include <core/RadixSort.h>
+#include <core/ThreadPool.h>
+#include <scene/Scene.h>
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace rw
+{
+  // Per instance vertex data, bound at binding 1 with VK_VERTEX_INPUT_RATE_INSTANCE.
+  struct InstanceData
+  {
+    glm::mat4 model;
+    glm::vec4 color;
+  };
+
+  // Pass a set of draws is recorded in, the most significant field of their sort keys.
+  enum class DrawPass : uint32_t
+  {
+    Shadow = 0,
+    Scene = 1
+  };
+
+  // 64-bit draw sort key, compared as an integer. From the most significant bits: pass (4),
+  // pipeline (8), mesh (24), material (16) and depth bucket (12). Sorting by it groups draws by
+  // the state they bind, the costliest change first, and orders the instances of a batch front
+  // to back. Every pass has a single mesh pipeline so far, its field is 0.
+  struct DrawKey
+  {
+    static constexpr uint32_t DEPTH_BITS = { 12u };
+    static constexpr uint32_t MATERIAL_BITS = { 16u };
+    static constexpr uint32_t MESH_BITS = { 24u };
+    static constexpr uint32_t PIPELINE_BITS = { 8u };
+    static constexpr uint32_t PASS_BITS = { 4u };
+
+    // ids wider than their field are folded into it, the key then only groups them approximately
+    static uint64_t encode(DrawPass pass, uint32_t pipeline, MeshId mesh, MaterialId material, uint32_t depth)
+    {
+      mesh &= (1u << MESH_BITS) - 1u;
+      material &= (1u << MATERIAL_BITS) - 1u;
+      return (static_cast<uint64_t>(pass) << (PIPELINE_BITS + MESH_BITS + MATERIAL_BITS + DEPTH_BITS))
+        | (static_cast<uint64_t>(pipeline) << (MESH_BITS + MATERIAL_BITS + DEPTH_BITS))
+        | (static_cast<uint64_t>(mesh) << (MATERIAL_BITS + DEPTH_BITS)) | (static_cast<uint64_t>(material) << DEPTH_BITS) | depth;
+    }
+    // the bound state of a key, equal for all draws one instanced call can cover
+    static uint64_t getState(uint64_t key) { return key >> DEPTH_BITS; }
+  };
+
+  struct InstanceBatcherStats
+  {
+    uint32_t builds = { 0 };
+    uint64_t packets = { 0 };      // nodes sorted
+    uint64_t batches = { 0 };
+    uint64_t radixPasses = { 0 };
+    double sortMs = { 0.0 };       // key generation and sort
+  };
+
+  // One instanced draw: every node sharing the same mesh and material.
+  struct DrawBatch
+  {
+    MeshId mesh;
+    MaterialId material;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+  };
+
+  // Sorts scene nodes by DrawKey with a parallel radix sort and lays the per instance data of
+  // each mesh/material pair out contiguously, so each group is drawn with a single instanced call
+  // and consecutive batches share as much bound state as possible.
+  class InstanceBatcher
+  {
+  public:
+    static constexpr uint32_t INSTANCE_BINDING = { 1u };
+
+    explicit InstanceBatcher(ThreadPool& pool);
+
+    // Batches the given node indices for pass, depth buckets follow viewProjection; outputs are
+    // cleared first but keep their capacity.
+    void build(const Scene& scene, const std::vector<uint32_t>& nodeIndices, DrawPass pass, const glm::mat4& viewProjection,
+      std::vector<DrawBatch>& batches, std::vector<InstanceData>& instances);
+
+    // summed over the builds since the last resetStats()
+    const InstanceBatcherStats& getStats() const { return mStats; }
+    void resetStats() { mStats = {}; }
+
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+  private:
+    ThreadPool& mPool;
+    RadixSorter mSorter;
+    std::vector<SortItem> mSortKeys;
+    InstanceBatcherStats mStats;
+  };
+}
+
+#endif // INSTANCEBATCHER_H
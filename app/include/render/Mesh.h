@@ -0,0 +1,62 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <render/Buffer.h>
+#include <render/Device.h>
+#include <scene/MeshData.h>
+
+#include <memory>
+#include <vector>
+
+namespace rw
+{
+  // Device local copy of a MeshData, vertices are bound at binding 0.
+  class Mesh
+  {
+  public:
+    static constexpr uint32_t VERTEX_BINDING = {0u};
+
+    Mesh(Device& dev, const MeshData& data);
+    // Only allocates the buffers, their content comes from a copy recorded with recordUpload().
+    Mesh(Device& dev, uint32_t vertexCount, uint32_t indexCount);
+    ~Mesh() = default;
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    void bind(VkCommandBuffer command) const;
+    void draw(VkCommandBuffer command, uint32_t instanceCount, uint32_t firstInstance) const;
+    // Rewrites the given vertex and index ranges from data, which must have the same counts as
+    // the mesh. Both ranges go through one staging buffer and one transfer submission.
+    void updateRange(const MeshData& data, uint32_t firstVertex, uint32_t vertexCount, uint32_t firstIndex, uint32_t indexCount);
+
+    // Staging layout of recordUpload(): the vertices of data followed by its indices.
+    static VkDeviceSize getUploadSize(const MeshData& data);
+    static void writeUpload(Buffer& staging, VkDeviceSize offset, const MeshData& data);
+    // Records the copy of a writeUpload() at offset into the mesh buffers, the caller makes it
+    // visible to vertex input with a barrier.
+    void recordUpload(VkCommandBuffer command, const Buffer& staging, VkDeviceSize offset) const;
+
+    uint32_t getVertexCount() const { return mVertexCount; }
+    uint32_t getIndexCount() const { return mIndexCount; }
+    VkDeviceSize getMemorySize() const;
+
+    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+  private:
+    void createVertexBuffer(uint32_t vertexCount);
+    void createIndexBuffer(uint32_t indexCount);
+    void upload(const void* data, VkDeviceSize size, const Buffer& target);
+
+  private:
+    Device& device;
+
+    std::unique_ptr<Buffer> mVertexBuffer;
+    std::unique_ptr<Buffer> mIndexBuffer;
+    uint32_t mVertexCount = { 0 };
+    uint32_t mIndexCount = { 0 };
+  };
+}
+
+#endif // MESH_H
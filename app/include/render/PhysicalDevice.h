@@ -2,6 +2,7 @@
 #define PHYSICALDEVICE_H
 
 #include <vulkan/vulkan.h>
+#include <string>
 #include <vector>
 
 namespace rw {
@@ -24,16 +25,27 @@ public:
         return mProperties;
     }
 
-    const std::vector<VkQueueFamilyProperties> getQueueFamilyProperties() const {
+    const std::vector<VkQueueFamilyProperties>& getQueueFamilyProperties() const {
         return mQueueFamilyProperties;
     }
 
+    bool supportsExtension(const char *name) const;
+    // Size of the largest device local heap.
+    VkDeviceSize getDeviceLocalMemorySize() const;
+    // Stable identifier across runs (device UUID and driver version), empty before Vulkan 1.1.
+    const std::string& getIdentifier() const { return mIdentifier; }
+    // 64-bit atomics on storage buffers (VK_KHR_shader_atomic_int64 with shaderInt64)
+    bool supportsBufferInt64Atomics() const { return mBufferInt64Atomics; }
+
 private:
     VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
     VkPhysicalDeviceFeatures mFeatures;
     VkPhysicalDeviceProperties mProperties;
     VkPhysicalDeviceMemoryProperties mMemoryProperties;
     std::vector<VkQueueFamilyProperties> mQueueFamilyProperties;
+    std::vector<VkExtensionProperties> mExtensions;
+    std::string mIdentifier;
+    bool mBufferInt64Atomics = false;
 };
 }
 
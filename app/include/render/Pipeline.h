@@ -0,0 +1,64 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <render/Device.h>
+
+#include <string>
+#include <vector>
+// source: https://github.com/blurrypiano/littleVulkanEngine/blob/main/src/lve_pipeline.hpp
+
+namespace rw
+{
+  struct PipelineConfigInfo
+  {
+    PipelineConfigInfo() = default;
+    PipelineConfigInfo(const PipelineConfigInfo&) = delete;
+    PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
+
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    VkPipelineViewportStateCreateInfo viewportInfo;
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
+    VkPipelineRasterizationStateCreateInfo rasterizationInfo;
+    VkPipelineMultisampleStateCreateInfo multisampleInfo;
+    VkPipelineColorBlendAttachmentState colorBlendAttachment;
+    VkPipelineColorBlendStateCreateInfo colorBlendInfo;
+    VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
+    std::vector<VkDynamicState> dynamicStateEnables;
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+    VkPipelineLayout pipelineLayout = { VK_NULL_HANDLE };
+    VkRenderPass renderPass = { VK_NULL_HANDLE };
+    uint32_t subpass = { 0 };
+    VkPipelineCache pipelineCache = { VK_NULL_HANDLE };
+  };
+
+  class Pipeline
+  {
+  public:
+    Pipeline(Device& dev, const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo);
+    Pipeline(Device& dev, const std::vector<char>& vertCode, const std::vector<char>& fragCode, const PipelineConfigInfo& configInfo);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    void bind(VkCommandBuffer command);
+    VkPipeline getHandler() const { return mGraphicsPipeline; }
+
+    static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+    static std::string shaderPath(const std::string& name);
+    static std::vector<char> readFile(const std::string& path);
+
+  private:
+    void createGraphicsPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode, const PipelineConfigInfo& configInfo);
+    VkShaderModule createShaderModule(const std::vector<char>& code);
+
+  private:
+    Device& device;
+    VkPipeline mGraphicsPipeline = { VK_NULL_HANDLE };
+    VkShaderModule mVertShaderModule = { VK_NULL_HANDLE };
+    VkShaderModule mFragShaderModule = { VK_NULL_HANDLE };
+  };
+}
+
+#endif // PIPELINE_H
@@ -0,0 +1,38 @@
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include <render/Device.h>
+
+#include <string>
+#include <vector>
+
+namespace rw
+{
+  // VkPipelineCache persisted between runs. The file can be read before the device
+  // exists; data written by another driver or GPU is dropped when the cache is created.
+  class PipelineCache
+  {
+  public:
+    PipelineCache(Device& dev, const std::vector<char>& initialData);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache getHandle() const { return mCache; }
+    void save(const std::string& path) const;
+
+    static std::string defaultPath();
+    // Returns an empty blob when there is no cache on disk yet.
+    static std::vector<char> readFromDisk(const std::string& path);
+
+  private:
+    bool isCompatible(const std::vector<char>& data) const;
+
+  private:
+    Device& device;
+    VkPipelineCache mCache = { VK_NULL_HANDLE };
+  };
+}
+
+#endif // PIPELINECACHE_H
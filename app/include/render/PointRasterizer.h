@@ -0,0 +1,106 @@
+#ifndef POINTRASTERIZER_H
+#define POINTRASTERIZER_H
+
+#include <render/AsyncCompute.h>
+#include <render/Buffer.h>
+#include <render/ComputePipeline.h>
+#include <render/Device.h>
+#include <render/FrameSnapshot.h>
+#include <render/Pipeline.h>
+#include <render/ShaderCache.h>
+#include <render/SwapChain.h>
+#include <scene/PointCloud.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rw
+{
+  // Rasterizes the selected point cloud chunks on the compute queue instead of drawing point
+  // primitives. Every point is projected to its pixel and kept if it is the nearest one there,
+  // with a single 64-bit atomicMin of depth and color when the device has buffer int64 atomics,
+  // otherwise with an atomicMin of the depth followed by a second pass writing the color of the
+  // point that won. The scene pass then copies the surviving points over the screen and writes
+  // their depth, so they are depth tested against the meshes like any other surface.
+  class PointRasterizer
+  {
+  public:
+    static constexpr uint32_t WORKGROUP_SIZE = { 256u };
+    // points per workgroup, each invocation projects BATCH_SIZE / WORKGROUP_SIZE of them
+    static constexpr uint32_t BATCH_SIZE = { 2048u };
+
+    PointRasterizer(Device& dev, AsyncCompute& compute, VkRenderPass renderPass, ShaderCache& shaders, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    ~PointRasterizer();
+
+    PointRasterizer(const PointRasterizer&) = delete;
+    PointRasterizer& operator=(const PointRasterizer&) = delete;
+
+    // Uploads the points of every chunk and makes the pipelines on first use, must not overlap with
+    // a frame in flight.
+    void upload(const PointCloud& cloud);
+    // Splits the selected chunks into batches and sizes the frame's point buffer for extent;
+    // called before Renderer::submitCompute().
+    void prepare(const FrameSnapshot& snapshot, int frameIndex, VkExtent2D extent);
+    // Composites the frame's points inside the scene pass.
+    void draw(VkCommandBuffer command, int frameIndex);
+
+    bool usesInt64Atomics() const { return mInt64Atomics; }
+    uint64_t getPointCount(int frameIndex) const { return mFrames[frameIndex].pointCount; }
+    VkDeviceSize getMemorySize() const { return mPointBuffer ? mPointBuffer->getBufferSize() : 0; }
+
+    // as many points as fit into a quarter of the device local heap
+    static uint64_t getMaxPoints(const Device& device);
+    static std::vector<std::string> getShaderNames() { return { "points64.comp", "points_depth.comp", "points_color.comp", "points.frag" }; }
+
+  private:
+    // push constants of the compute passes, matches points.glsl
+    struct Dispatch
+    {
+      glm::mat4 viewProjection;
+      glm::uvec4 target; // width, height, first batch
+    };
+
+    struct FrameResources
+    {
+      std::unique_ptr<Buffer> batches; // (first point, count) per batch, host visible
+      std::unique_ptr<Buffer> target;  // color and depth bits per pixel, written by compute, read by the scene pass
+      VkDescriptorSet computeSet = { VK_NULL_HANDLE };
+      VkDescriptorSet drawSet = { VK_NULL_HANDLE };
+      std::array<VkBuffer, 3> boundBuffers = {};
+      std::vector<glm::uvec2> batchRanges;
+      Dispatch dispatch = {};
+      uint64_t pointCount = { 0 };
+    };
+
+    void createDescriptors();
+    void createPipelines();
+    void updateDescriptorSets(FrameResources& frame);
+    bool record(VkCommandBuffer command, int frameIndex);
+
+  private:
+    Device& device;
+    AsyncCompute& mCompute;
+    AsyncCompute::PassId mPassId;
+    VkRenderPass mRenderPass = { VK_NULL_HANDLE };
+    ShaderCache& mShaders;
+    VkPipelineCache mPipelineCache = { VK_NULL_HANDLE };
+    bool mInt64Atomics = { false };
+
+    VkDescriptorSetLayout mComputeSetLayout = { VK_NULL_HANDLE };
+    VkDescriptorSetLayout mDrawSetLayout = { VK_NULL_HANDLE };
+    VkDescriptorPool mDescriptorPool = { VK_NULL_HANDLE };
+    VkPipelineLayout mComputeLayout = { VK_NULL_HANDLE };
+    VkPipelineLayout mDrawLayout = { VK_NULL_HANDLE };
+    // the 64-bit pass, or the depth and color passes of the fallback
+    std::vector<std::unique_ptr<ComputePipeline>> mRasterPipelines;
+    std::unique_ptr<Pipeline> mDrawPipeline;
+
+    std::unique_ptr<Buffer> mPointBuffer;
+    std::vector<PointChunk> mChunks;
+    std::array<FrameResources, SwapChain::MAX_FRAMES_IN_FLIGHT> mFrames;
+  };
+}
+
+#endif // POINTRASTERIZER_H
@@ -0,0 +1,117 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <core/LatencyTracker.h>
+#include <core/TripleBuffer.h>
+#include <render/FrameCapture.h>
+#include <render/FrameSnapshot.h>
+#include <render/Renderer.h>
+#include <render/SceneRenderer.h>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace rw
+{
+  struct RenderThreadStats
+  {
+    LatencyStats inputLatency;
+    SceneRenderStats scene;
+    uint64_t framesPresented = { 0 };
+    double cpuFrameMs = { 0.0 };
+    double gpuFrameMs = { 0.0 };
+    double gpuBusyMs = { 0.0 };     // graphics queue
+    double computeBusyMs = { 0.0 }; // compute queue, overlaps with graphics on async capable devices
+    // dynamic resolution, scale stays 1 when it is off
+    ResolutionStats resolution;
+    VkExtent2D sceneExtent = { 0, 0 };
+    // shadow cascades redrawn and reused since the last takeStats()
+    uint64_t shadowCascadesDrawn = { 0 };
+    uint64_t shadowCascadesReused = { 0 };
+    // fragment shader invocations summed over the frames counted since the last takeStats()
+    uint64_t fragmentFrames = { 0 };
+    FragmentCounts fragments;
+    // point cloud points rasterized since the last takeStats()
+    uint64_t pointsDrawn = { 0 };
+    // frames since the last takeStats() reusing their static command buffers and recording them,
+    // and the recording time the reuses saved
+    uint64_t staticReused = { 0 };
+    uint64_t staticRecorded = { 0 };
+    double staticSavedMs = { 0.0 };
+    // per frame scratch memory, block allocations stop growing once the arenas fit a frame
+    ArenaStats frameArenas;
+  };
+
+  // Owns the thread which records and submits frames. The event/simulation thread fills
+  // snapshots with beginSnapshot()/publishSnapshot(), the render thread always draws the
+  // most recent one, so neither side ever waits for the other.
+  class RenderThread
+  {
+  public:
+    // capture (optional) receives the snapshots flagged with FrameSnapshot::capture
+    RenderThread(Renderer& renderer, SceneRenderer& sceneRenderer, FrameCapture* capture = nullptr);
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    void start();
+    void stop();
+
+    // producer side (event/simulation thread)
+    FrameSnapshot& beginSnapshot() { return mSnapshots.getWriteBuffer(); }
+    uint64_t publishSnapshot();
+    uint64_t getPublishedSequence() const { return mPublishedSequence.load(std::memory_order_acquire); }
+    uint64_t getConsumedSequence() const { return mConsumedSequence.load(std::memory_order_acquire); }
+    // Generation of the last geometry diff the renderer applied. A consumed snapshot may still be
+    // dropped before its diff was applied, so pending diffs are released by this and not by sequence.
+    uint64_t getAppliedGeometryGeneration() const { return mAppliedGeometry.load(std::memory_order_acquire); }
+
+    // True when a published snapshot could not be presented (swapchain recreated, window minimized).
+    bool takeRedrawRequest() { return mRedrawRequested.exchange(false, std::memory_order_acq_rel); }
+
+    // Timestamp of the first presented frame, 0 until then.
+    uint64_t getFirstPresentTime() const { return mFirstPresent.load(std::memory_order_acquire); }
+
+    bool hasFailed() const { return mFailed.load(std::memory_order_acquire); }
+    void rethrowIfFailed();
+
+    // Returns the stats accumulated since the previous call.
+    RenderThreadStats takeStats();
+
+  private:
+    void run();
+    void renderSnapshot(const FrameSnapshot& snapshot);
+
+  private:
+    Renderer& mRenderer;
+    SceneRenderer& mSceneRenderer;
+    FrameCapture* mCapture;
+
+    TripleBuffer<FrameSnapshot> mSnapshots;
+    uint64_t mNextSequence = { 1 };
+    std::atomic<uint64_t> mPublishedSequence{ 0 };
+    std::atomic<uint64_t> mConsumedSequence{ 0 };
+    std::atomic<uint64_t> mAppliedGeometry{ 0 };
+
+    std::thread mThread;
+    std::atomic<bool> mRunning{ false };
+    std::atomic<bool> mFailed{ false };
+    std::atomic<bool> mRedrawRequested{ false };
+    std::atomic<uint64_t> mFirstPresent{ 0 };
+    std::exception_ptr mException;
+
+    // render thread only
+    LatencyTracker mLatency;
+    uint64_t mLastInputTimestamp = { 0 };
+    uint64_t mFragmentSamples = { 0 };
+
+    std::mutex mStatsMutex;
+    RenderThreadStats mStats;
+    bool mResetStats = { false };
+  };
+}
+
+#endif // RENDERTHREAD_H
@@ -0,0 +1,103 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <Window.h>
+#include <core/LinearArena.h>
+#include <core/ResolutionController.h>
+#include <render/AsyncCompute.h>
+#include <render/Device.h>
+#include <render/FrameCapture.h>
+#include <render/GpuTimer.h>
+#include <render/ScaledRenderTarget.h>
+#include <render/ShaderCache.h>
+#include <render/SwapChain.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+// source: https://github.com/blurrypiano/littleVulkanEngine/blob/main/src/lve_renderer.hpp
+
+namespace rw
+{
+  class Renderer
+  {
+  public:
+    Renderer(Window& window, Device& dev);
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    VkRenderPass getSwapChainRenderPass() const { return mSwapChain->getRenderPass(); }
+    float getAspectRatio() const { return mSwapChain->aspectRatio(); }
+    VkExtent2D getExtent() const { return mSwapChain->getSwapChainResolution(); }
+    bool isFrameInProgress() const { return mIsFrameStarted; }
+    int getFrameIndex() const { return mCurrentFrameIdx; }
+
+    VkCommandBuffer getCurrentCommandBuffer() const { return mCommandBuffers[mCurrentFrameIdx]; }
+    GpuTimer& getGpuTimer() { return *mGpuTimer; }
+    AsyncCompute& getAsyncCompute() { return *mAsyncCompute; }
+    // Scratch memory for CPU data of the current frame, reset by beginFrame() once the frame's
+    // in-flight fence signaled, so nothing the GPU may still read from it is recycled early.
+    LinearArena& getFrameArena() { return mFrameArenas[mCurrentFrameIdx]; }
+    // used is the fullest frame, capacity and block allocations are summed over all of them
+    ArenaStats getFrameArenaStats() const;
+
+    // Returns VK_NULL_HANDLE when the swapchain had to be recreated (or the window is minimized)
+    // and the frame should be skipped. Does not call into GLFW, so it can run on a render thread.
+    VkCommandBuffer beginFrame();
+    // Submits the compute passes of the current frame, the frame's graphics submit waits
+    // for them at the vertex stages. Call between beginFrame() and endFrame().
+    void submitCompute();
+    void endFrame();
+    // With secondary command buffer contents the viewport is left to them, they don't inherit it.
+    void beginSwapChainRenderPass(VkCommandBuffer command, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    void endSwapChainRenderPass(VkCommandBuffer command);
+
+    // Draws the scene into a scaled offscreen target from now on, its scale follows the GPU frame
+    // time. The swapchain pipelines stay usable in the scene pass.
+    void enableDynamicResolution(const ResolutionOptions& options, ShaderCache& shaders, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    // null unless dynamic resolution is enabled, only for the thread recording frames
+    ResolutionController* getResolutionController() { return mResolution.get(); }
+    // Extent the current frame's scene pass covers, fixed from beginFrame() on so offscreen passes
+    // recorded before beginSceneRenderPass() can match it.
+    VkExtent2D getSceneExtent() const { return mScaledTarget ? ScaledRenderTarget::scaleExtent(getExtent(), mResolution->getScale()) : getExtent(); }
+    // Pass the scene is drawn in: the swapchain pass, or the scaled target with dynamic resolution.
+    // endSceneRenderPass() leaves the swapchain pass open, with the upsampled scene in it, for
+    // anything drawn at native resolution; close it with endSwapChainRenderPass().
+    void beginSceneRenderPass(VkCommandBuffer command, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    // the render pass beginSceneRenderPass() begins, for secondary command buffers to inherit
+    VkRenderPass getSceneRenderPass() const { return mScaledTarget ? mScaledTarget->getRenderPass() : mSwapChain->getRenderPass(); }
+    void endSceneRenderPass(VkCommandBuffer command);
+    // Copies the frame's swapchain image into a readback slot of capture. Call after
+    // endSwapChainRenderPass(), the copy is handed to the encoders once the frame completed.
+    bool captureFrame(FrameCapture& capture, const std::string& name);
+
+  private:
+    void createCommandBuffers();
+    void freeCommandBuffers();
+    bool recreateSwapChain();
+
+  private:
+    Window& mWindow;
+    Device& device;
+    std::shared_ptr<SwapChain> mSwapChain;
+    std::vector<VkCommandBuffer> mCommandBuffers;
+    std::unique_ptr<GpuTimer> mGpuTimer;
+    std::unique_ptr<AsyncCompute> mAsyncCompute;
+    VkSemaphore mComputeSemaphore = { VK_NULL_HANDLE };
+    FrameCapture* mCapture = { nullptr };
+    std::unique_ptr<ScaledRenderTarget> mScaledTarget;
+    std::unique_ptr<ResolutionController> mResolution;
+    uint64_t mGpuSamples = { 0 };
+    std::array<LinearArena, SwapChain::MAX_FRAMES_IN_FLIGHT> mFrameArenas;
+
+    uint32_t mCurrentImageIdx = { 0 };
+    int mCurrentFrameIdx = { 0 };
+    bool mIsFrameStarted = { false };
+    bool mNeedsRecreate = { false };
+  };
+}
+
+#endif // RENDERER_H
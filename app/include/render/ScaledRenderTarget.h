@@ -0,0 +1,86 @@
+#ifndef SCALEDRENDERTARGET_H
+#define SCALEDRENDERTARGET_H
+
+#include <render/Device.h>
+#include <render/Pipeline.h>
+#include <render/ShaderCache.h>
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rw
+{
+  // Offscreen color and depth target the scene is drawn into at a fraction of the output size,
+  // then stretched over the swapchain image. The images have the full output size and only the
+  // top left part is rendered, so changing the scale never reallocates. The render pass uses the
+  // swapchain formats, which keeps it compatible with the pipelines built for the swapchain pass.
+  class ScaledRenderTarget
+  {
+  public:
+    // presentPass is the pass upsample() records into
+    ScaledRenderTarget(Device& dev, VkFormat colorFormat, VkFormat depthFormat, VkRenderPass presentPass, ShaderCache& shaders,
+      VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    ~ScaledRenderTarget();
+
+    ScaledRenderTarget(const ScaledRenderTarget&) = delete;
+    ScaledRenderTarget& operator=(const ScaledRenderTarget&) = delete;
+
+    // Reallocates the images for a new output size, the device must be idle.
+    void resize(VkExtent2D extent);
+
+    void beginRenderPass(VkCommandBuffer command, float scale, const VkClearColorValue& clearColor,
+      VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    void endRenderPass(VkCommandBuffer command);
+    // Draws the last rendered part over the whole viewport of the current (swapchain) pass.
+    void upsample(VkCommandBuffer command);
+
+    VkExtent2D getExtent() const { return mExtent; }
+    VkExtent2D getRenderExtent() const { return mRenderExtent; }
+    VkRenderPass getRenderPass() const { return mRenderPass; }
+    // part of an output of the given size rendered at scale
+    static VkExtent2D scaleExtent(VkExtent2D extent, float scale);
+
+    static std::vector<std::string> getShaderNames() { return { "upsample.vert", "upsample.frag" }; }
+
+  private:
+    struct PushConstants
+    {
+      glm::vec2 uvScale;
+      glm::vec2 uvMax;
+    };
+
+    void createRenderPass();
+    void createDescriptors();
+    void createPipeline(VkRenderPass presentPass, ShaderCache& shaders, VkPipelineCache pipelineCache);
+    void createImages();
+    void destroyImages();
+
+  private:
+    Device& device;
+    VkFormat mColorFormat;
+    VkFormat mDepthFormat;
+    VkExtent2D mExtent = { 0, 0 };
+    VkExtent2D mRenderExtent = { 0, 0 };
+
+    VkRenderPass mRenderPass = { VK_NULL_HANDLE };
+    VkImage mColorImage = { VK_NULL_HANDLE };
+    VkDeviceMemory mColorMemory = { VK_NULL_HANDLE };
+    VkImageView mColorView = { VK_NULL_HANDLE };
+    VkImage mDepthImage = { VK_NULL_HANDLE };
+    VkDeviceMemory mDepthMemory = { VK_NULL_HANDLE };
+    VkImageView mDepthView = { VK_NULL_HANDLE };
+    VkFramebuffer mFramebuffer = { VK_NULL_HANDLE };
+
+    VkSampler mSampler = { VK_NULL_HANDLE };
+    VkDescriptorSetLayout mSetLayout = { VK_NULL_HANDLE };
+    VkDescriptorPool mDescriptorPool = { VK_NULL_HANDLE };
+    VkDescriptorSet mDescriptorSet = { VK_NULL_HANDLE };
+    VkPipelineLayout mPipelineLayout = { VK_NULL_HANDLE };
+    std::unique_ptr<Pipeline> mPipeline;
+  };
+}
+
+#endif // SCALEDRENDERTARGET_H
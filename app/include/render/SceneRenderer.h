@@ -0,0 +1,254 @@
+#ifndef SCENERENDERER_H
+#define SCENERENDERER_H
+
+#include <core/LinearArena.h>
+#include <render/AsyncCompute.h>
+#include <render/Buffer.h>
+#include <render/Device.h>
+#include <render/FragmentCounter.h>
+#include <render/FrameSnapshot.h>
+#include <render/InstanceBatcher.h>
+#include <render/Mesh.h>
+#include <render/Pipeline.h>
+#include <render/PointRasterizer.h>
+#include <render/ShaderCache.h>
+#include <render/ShadowMap.h>
+#include <render/SkinningPass.h>
+#include <render/StreamedGeometry.h>
+#include <render/SwapChain.h>
+#include <render/VisibilityBuffer.h>
+#include <scene/Scene.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rw
+{
+  struct SceneRenderStats
+  {
+    uint32_t drawCalls = { 0 };
+    uint32_t instances = { 0 };
+    uint32_t uniqueMeshes = { 0 };
+    VkDeviceSize geometryBytes = { 0 };
+    uint32_t skinnedDraws = { 0 };
+    uint32_t skinnedVertices = { 0 };
+    uint32_t streamedChunks = { 0 };
+    VkDeviceSize streamedBytes = { 0 };
+    uint32_t lights = { 0 };
+    uint32_t lightIndices = { 0 };
+    // shadow cascades of the last frame: cached static maps redrawn or reused as they were
+    uint32_t shadowCascades = { 0 };
+    uint32_t shadowCascadesDrawn = { 0 };
+    uint32_t shadowCascadesReused = { 0 };
+    uint32_t shadowDrawCalls = { 0 };
+    // fragment shader invocations of the last counted frame, and how many frames were counted so far
+    RenderMode renderMode = { RenderMode::Forward };
+    FragmentCounts fragments;
+    uint64_t fragmentSamples = { 0 };
+    // points of the point cloud rasterized last frame
+    uint64_t points = { 0 };
+    bool pointInt64Atomics = { false };
+    // geometry buffer binds of the last frame's batches, and those skipped because consecutive
+    // batches drew the same mesh
+    uint32_t meshBinds = { 0 };
+    uint32_t meshBindsSkipped = { 0 };
+    // static batches of the last frame: executed from pre-recorded command buffers, and whether
+    // those had to be recorded again; recordMs is what recording them took the last time
+    bool staticCommands = { false };
+    bool staticRecorded = { false };
+    double staticRecordMs = { 0.0 };
+  };
+
+  // Draws the batches of a FrameSnapshot with one instanced call per mesh/material pair,
+  // animated nodes are drawn from the vertices skinned by the compute queue. Every draw is lit by
+  // the lights of the cluster its fragments fall into, read from per frame storage buffers, and
+  // shadowed by the cascades of the key light.
+  // The snapshot's RenderMode picks how overdraw is paid for: forward shades every fragment that
+  // passes the depth test when it is drawn; the depth prepass lays down depth first and shades with
+  // an equal test; the visibility mode writes instance, normal and depth per pixel and lights each
+  // pixel once in a full screen pass. Material data is per instance, so the visibility buffer stores
+  // the normal next to the instance instead of fetching the triangle's vertices in the resolve.
+  // A point cloud is rasterized on the compute queue and composited over the shaded meshes.
+  // With FrameSnapshot::staticCommands in forward mode the batches are recorded once per frame in
+  // flight into a secondary command buffer and executed again until they, the scene pass or its
+  // extent change; the camera reaches the shaders through a per frame uniform buffer.
+  class SceneRenderer
+  {
+  public:
+    SceneRenderer(Device& dev, VkRenderPass renderPass, ShaderCache& shaders, AsyncCompute& compute, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    ~SceneRenderer();
+
+    SceneRenderer(const SceneRenderer&) = delete;
+    SceneRenderer& operator=(const SceneRenderer&) = delete;
+
+    // Uploads the unique geometry of the scene, must not overlap with draw().
+    void upload(const Scene& scene);
+    // Uploads a point cloud, replacing the previous one; must not overlap with draw() either.
+    void uploadPoints(const PointCloud& cloud);
+    // Uploads the per frame data of the snapshot and applies a pending geometry update,
+    // must run before Renderer::submitCompute(). renderExtent is the size the scene pass will have,
+    // frameArena holds the frame's temporaries.
+    void prepare(const FrameSnapshot& snapshot, int frameIndex, VkExtent2D renderExtent, LinearArena& frameArena);
+    // Copies the geometry prepare() staged into its buffers, outside of any render pass and
+    // before drawShadows().
+    void recordUploads(VkCommandBuffer command, int frameIndex);
+    // Redraws the shadow cascades whose cached static map is out of date and the moving casters,
+    // outside of any render pass and before draw().
+    void drawShadows(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex);
+    // Starts counting the frame's fragments and, in visibility mode, fills the visibility buffer; outside
+    // of any render pass, after drawShadows() and before draw(). renderExtent is the part of outputExtent
+    // the scene pass covers.
+    void drawVisibility(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex, VkExtent2D outputExtent, VkExtent2D renderExtent);
+    // How the scene pass has to be begun for draw(): secondary command buffers when the snapshot's
+    // batches are drawn from pre-recorded ones. Fragments are not counted in that case.
+    VkSubpassContents getSceneContents(const FrameSnapshot& snapshot) const;
+    // renderPass is the scene pass draw() is recorded in, needed with secondary command buffers.
+    void draw(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex, VkRenderPass renderPass = VK_NULL_HANDLE);
+    // generation of the last GeometryDiff prepare() applied, 0 before the first one
+    uint64_t getGeometryGeneration() const { return mGeometryGeneration; }
+
+    const SceneRenderStats& getStats() const { return mStats; }
+    // shaders needed by the pipelines, so they can be preloaded before the device exists
+    static std::vector<std::string> getShaderNames()
+    {
+      return { "mesh.vert", "mesh.frag", "depth.frag", "shadow.vert", "visibility.vert", "visibility.frag", "upsample.vert", "resolve.frag", "skin.comp",
+        "points64.comp", "points_depth.comp", "points_color.comp", "points.frag" };
+    }
+
+  private:
+    // pushed for the visibility pass, mesh.vert and mesh.frag read it from the frame's view buffer (std140)
+    struct PushConstants
+    {
+      glm::mat4 viewProjection;
+      glm::vec4 viewDepth; // dot with a world position gives its view depth
+      glm::uvec4 grid;     // tiles x, tiles y, slices, light count
+      glm::vec4 slicing;   // slice scale, slice bias
+    };
+
+    // read by resolve.frag
+    struct ResolvePushConstants
+    {
+      glm::mat4 inverseViewProjection;
+      glm::vec4 viewDepth;
+      glm::uvec4 grid;
+      glm::vec4 slicing; // slice scale, slice bias, size of a pixel in ndc
+    };
+
+    // read by mesh.frag, std430
+    struct ShadowData
+    {
+      glm::mat4 cascades[ShadowCascades::MAX_CASCADES];
+      glm::vec4 splits;         // view depth where each cascade ends
+      glm::vec4 lightDirection; // towards the key light
+      glm::uvec4 info;          // cascade count, dynamic layers drawn
+    };
+
+    // one persistently mapped copy per frame in flight
+    struct LightBuffers
+    {
+      std::unique_ptr<Buffer> lights;
+      std::unique_ptr<Buffer> clusters;
+      std::unique_ptr<Buffer> indices;
+      std::unique_ptr<Buffer> shadow;
+      std::unique_ptr<Buffer> view;
+      VkDescriptorSet descriptorSet = { VK_NULL_HANDLE };
+    };
+
+    // Secondary command buffers of the scene pass for one frame in flight. The batches are kept for
+    // as long as they stay valid, the rest is recorded every frame. They are tied to the render pass
+    // compatibility class of the scene pass, which only changes with the swapchain or dynamic
+    // resolution being turned on, so one set per frame is enough.
+    struct StaticCommands
+    {
+      VkCommandBuffer batches = { VK_NULL_HANDLE };
+      VkCommandBuffer dynamic = { VK_NULL_HANDLE }; // streamed chunks, skinned nodes and points
+      VkRenderPass renderPass = { VK_NULL_HANDLE };
+      VkExtent2D extent = { 0, 0 };
+      std::vector<DrawBatch> recordedBatches;
+      // cleared when a descriptor set, buffer or mesh they bind is replaced
+      bool valid = { false };
+      double recordMs = { 0.0 };
+    };
+
+    void createDescriptors();
+    void createPipelineLayout();
+    void createPipeline(VkRenderPass renderPass, ShaderCache& shaders, VkPipelineCache pipelineCache);
+    // (re)creates the map and the pipeline drawing into it, the device must be idle
+    void createShadows(uint32_t resolution);
+    // pipelines of the depth prepass and visibility modes, built with the forward one while renderPass is alive
+    void createPrepassPipelines(VkRenderPass renderPass);
+    void createVisibilityPipelines(VkRenderPass renderPass);
+    void writeVisibilityDescriptors(int frameIndex);
+    void writeDescriptors(int frameIndex);
+    void writeShadow(const FrameSnapshot& snapshot, int frameIndex);
+    void writeInstances(const std::vector<InstanceData>& instances, int frameIndex);
+    void writeView(const FrameSnapshot& snapshot, int frameIndex);
+    void writeLights(const FrameSnapshot& snapshot, int frameIndex);
+    // Grows buffer (by half again) when data does not fit, returns true if it was reallocated.
+    bool writeBuffer(std::unique_ptr<Buffer>& buffer, const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize minSize);
+    void applyGeometry(const GeometryDiff& diff);
+    static PushConstants makePushConstants(const FrameSnapshot& snapshot);
+    // shades the meshes in the snapshot's render mode
+    void drawMeshes(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex);
+    // every batch, streamed chunk and skinned node with the bound pipeline
+    void drawGeometry(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex);
+    void bindInstances(VkCommandBuffer command, int frameIndex);
+    void drawBatches(VkCommandBuffer command, const std::vector<DrawBatch>& batches);
+    // streamed chunks and skinned nodes, after bindInstances()
+    void drawMoving(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex);
+    bool usesStaticCommands(const FrameSnapshot& snapshot) const;
+    // Executes the batches from the frame's static command buffer, recording it first if it is out
+    // of date, followed by a secondary command buffer with the frame's moving geometry and points.
+    void drawStatic(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex, VkRenderPass renderPass);
+    void beginSecondary(VkCommandBuffer secondary, VkRenderPass renderPass, VkCommandBufferUsageFlags flags);
+    void invalidateStaticCommands();
+    // Binds the buffers of mesh unless bound already is it, then makes it the bound one.
+    void bindMesh(VkCommandBuffer command, const Mesh& mesh, const Mesh*& bound);
+
+  private:
+    Device& device;
+    VkDescriptorSetLayout mSetLayout = { VK_NULL_HANDLE };
+    VkDescriptorPool mDescriptorPool = { VK_NULL_HANDLE };
+    VkPipelineLayout mPipelineLayout = { VK_NULL_HANDLE };
+    std::unique_ptr<Pipeline> mPipeline;
+
+    ShaderCache& mShaders;
+    VkPipelineCache mPipelineCache = { VK_NULL_HANDLE };
+    std::unique_ptr<ShadowMap> mShadowMap;
+    VkPipelineLayout mShadowPipelineLayout = { VK_NULL_HANDLE };
+    std::unique_ptr<Pipeline> mShadowPipeline;
+
+    // depth prepass: depth only, then the mesh pipeline testing for equal depth without writing it
+    std::unique_ptr<Pipeline> mDepthPipeline;
+    std::unique_ptr<Pipeline> mDepthEqualPipeline;
+    // visibility buffer, resolved with the instance buffer of the frame
+    std::unique_ptr<VisibilityBuffer> mVisibility;
+    std::unique_ptr<Pipeline> mVisibilityPipeline;
+    VkDescriptorSetLayout mVisibilitySetLayout = { VK_NULL_HANDLE };
+    VkDescriptorPool mVisibilityPool = { VK_NULL_HANDLE };
+    std::array<VkDescriptorSet, SwapChain::MAX_FRAMES_IN_FLIGHT> mVisibilitySets = {};
+    std::array<bool, SwapChain::MAX_FRAMES_IN_FLIGHT> mVisibilityDirty = {};
+    VkPipelineLayout mResolvePipelineLayout = { VK_NULL_HANDLE };
+    std::unique_ptr<Pipeline> mResolvePipeline;
+    VkExtent2D mRenderExtent = { 0, 0 };
+    std::unique_ptr<FragmentCounter> mFragments;
+
+    std::vector<std::unique_ptr<Mesh>> mMeshes;
+    uint64_t mGeometryGeneration = { 0 };
+    std::unique_ptr<SkinningPass> mSkinning;
+    std::unique_ptr<StreamedGeometry> mStreamed;
+    std::unique_ptr<PointRasterizer> mPoints;
+    // one persistently mapped instance buffer per frame in flight
+    std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> mInstanceBuffers;
+    std::array<LightBuffers, SwapChain::MAX_FRAMES_IN_FLIGHT> mLightBuffers;
+    VkCommandPool mStaticPool = { VK_NULL_HANDLE };
+    std::array<StaticCommands, SwapChain::MAX_FRAMES_IN_FLIGHT> mStaticCommands;
+    SceneRenderStats mStats;
+  };
+}
+
+#endif // SCENERENDERER_H
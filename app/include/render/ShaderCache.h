@@ -0,0 +1,26 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rw
+{
+  // SPIR-V blobs by shader name (see Pipeline::shaderPath). Reading does not need a
+  // device, so preload() can run on a worker while the device is being created.
+  class ShaderCache
+  {
+  public:
+    void preload(const std::vector<std::string>& names);
+    // Loads the shader on a miss. The returned blob stays valid for the lifetime of the cache.
+    const std::vector<char>& get(const std::string& name);
+
+  private:
+    std::mutex mMutex;
+    std::unordered_map<std::string, std::vector<char>> mCode;
+  };
+}
+
+#endif // SHADERCACHE_H
@@ -0,0 +1,65 @@
+#ifndef SHADOWMAP_H
+#define SHADOWMAP_H
+
+#include <render/Device.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace rw
+{
+  // Depth array holding the shadow cascades of the key light. Every cascade has two layers: the
+  // static one caches the casters which rarely change and is only redrawn when its key changes,
+  // the dynamic one receives the moving casters every frame. The shading pass tests both, so the
+  // static layer never has to be copied or redrawn to composite the moving objects over it.
+  // One map is shared by the frames in flight, the render pass orders the writes after the reads
+  // of the previous frame.
+  class ShadowMap
+  {
+  public:
+    ShadowMap(Device& dev, uint32_t cascades, uint32_t resolution);
+    ~ShadowMap();
+
+    ShadowMap(const ShadowMap&) = delete;
+    ShadowMap& operator=(const ShadowMap&) = delete;
+
+    // Clears the layer and begins drawing depth into it.
+    void beginRenderPass(VkCommandBuffer command, uint32_t layer);
+    void endRenderPass(VkCommandBuffer command);
+
+    uint32_t getStaticLayer(uint32_t cascade) const { return cascade; }
+    uint32_t getDynamicLayer(uint32_t cascade) const { return mCascades + cascade; }
+    // key of the static content last drawn into the cascade, 0 if none
+    uint64_t getStaticKey(uint32_t cascade) const { return mStaticKeys[cascade]; }
+    void setStaticKey(uint32_t cascade, uint64_t key) { mStaticKeys[cascade] = key; }
+
+    uint32_t getCascadeCount() const { return mCascades; }
+    uint32_t getResolution() const { return mResolution; }
+    VkRenderPass getRenderPass() const { return mRenderPass; }
+    // every layer, for sampling with depth comparison
+    VkImageView getArrayView() const { return mArrayView; }
+    VkSampler getSampler() const { return mSampler; }
+
+  private:
+    void createRenderPass();
+    void createImage();
+    void createSampler();
+
+  private:
+    Device& device;
+    uint32_t mCascades;
+    uint32_t mResolution;
+    VkFormat mFormat = { VK_FORMAT_UNDEFINED };
+
+    VkRenderPass mRenderPass = { VK_NULL_HANDLE };
+    VkImage mImage = { VK_NULL_HANDLE };
+    VkDeviceMemory mMemory = { VK_NULL_HANDLE };
+    VkImageView mArrayView = { VK_NULL_HANDLE };
+    std::vector<VkImageView> mLayerViews;
+    std::vector<VkFramebuffer> mFramebuffers;
+    VkSampler mSampler = { VK_NULL_HANDLE };
+    std::vector<uint64_t> mStaticKeys;
+  };
+}
+
+#endif // SHADOWMAP_H
@@ -0,0 +1,115 @@
+#ifndef SKINNINGPASS_H
+#define SKINNINGPASS_H
+
+#include <render/AsyncCompute.h>
+#include <render/Buffer.h>
+#include <render/ComputePipeline.h>
+#include <render/Device.h>
+#include <render/FrameSnapshot.h>
+#include <render/ShaderCache.h>
+#include <render/SwapChain.h>
+#include <scene/Scene.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rw
+{
+  // Skins the animated nodes of a snapshot on the compute queue. Every visible node gets its own
+  // range of the frame's skinned vertex buffer, which has the Mesh vertex layout, so the graphics
+  // passes draw it like any other mesh without knowing about joints.
+  class SkinningPass
+  {
+  public:
+    static constexpr uint32_t WORKGROUP_SIZE = { 64u };
+
+    // One skinned node in the frame's vertex buffer, parallel to FrameSnapshot::skinnedDraws.
+    struct DrawRange
+    {
+      uint32_t firstIndex;
+      uint32_t indexCount;
+      int32_t vertexOffset;
+    };
+
+    SkinningPass(Device& dev, AsyncCompute& compute, ShaderCache& shaders, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+    ~SkinningPass();
+
+    SkinningPass(const SkinningPass&) = delete;
+    SkinningPass& operator=(const SkinningPass&) = delete;
+
+    // Uploads the bind pose of every skinned mesh, must not overlap with a frame in flight.
+    void upload(const Scene& scene);
+    // Writes the palettes and lays the output out; called before Renderer::submitCompute().
+    void prepare(const FrameSnapshot& snapshot, int frameIndex);
+
+    VkBuffer getVertexBuffer(int frameIndex) const;
+    VkBuffer getIndexBuffer() const { return mIndexBuffer ? mIndexBuffer->getHandler() : VK_NULL_HANDLE; }
+    const std::vector<DrawRange>& getDraws(int frameIndex) const { return mFrames[frameIndex].draws; }
+    uint32_t getVertexCount(int frameIndex) const { return mFrames[frameIndex].vertexCount; }
+    VkDeviceSize getMemorySize() const;
+
+    static std::vector<std::string> getShaderNames() { return { "skin.comp" }; }
+
+  private:
+    // matches SkinVertex in skin.comp
+    struct SkinVertex
+    {
+      glm::vec4 positionU;
+      glm::vec4 normalV;
+      glm::uvec4 joints;
+      glm::vec4 weights;
+    };
+
+    // push constants of one dispatch
+    struct Dispatch
+    {
+      uint32_t srcOffset;
+      uint32_t dstOffset;
+      uint32_t vertexCount;
+      uint32_t paletteOffset;
+    };
+
+    struct MeshRange
+    {
+      uint32_t firstVertex;
+      uint32_t vertexCount;
+      uint32_t firstIndex;
+      uint32_t indexCount;
+    };
+
+    struct FrameResources
+    {
+      std::unique_ptr<Buffer> palette;  // host visible, persistently mapped
+      std::unique_ptr<Buffer> vertices; // device local, written by compute, read by graphics
+      VkDescriptorSet descriptorSet = { VK_NULL_HANDLE };
+      std::array<VkBuffer, 3> boundBuffers = {};
+      std::vector<Dispatch> dispatches;
+      std::vector<DrawRange> draws;
+      uint32_t vertexCount = { 0 };
+    };
+
+    void createDescriptors();
+    void createPipeline(ShaderCache& shaders, VkPipelineCache pipelineCache);
+    void updateDescriptorSet(FrameResources& frame);
+    bool record(VkCommandBuffer command, int frameIndex);
+
+  private:
+    Device& device;
+    AsyncCompute& mCompute;
+    AsyncCompute::PassId mPassId;
+
+    VkDescriptorSetLayout mSetLayout = { VK_NULL_HANDLE };
+    VkDescriptorPool mDescriptorPool = { VK_NULL_HANDLE };
+    VkPipelineLayout mPipelineLayout = { VK_NULL_HANDLE };
+    std::unique_ptr<ComputePipeline> mPipeline;
+
+    std::unique_ptr<Buffer> mSourceBuffer;
+    std::unique_ptr<Buffer> mIndexBuffer;
+    std::vector<MeshRange> mMeshes;
+    std::array<FrameResources, SwapChain::MAX_FRAMES_IN_FLIGHT> mFrames;
+  };
+}
+
+#endif // SKINNINGPASS_H
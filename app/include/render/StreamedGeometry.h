@@ -0,0 +1,70 @@
+#ifndef STREAMEDGEOMETRY_H
+#define STREAMEDGEOMETRY_H
+
+#include <core/LinearArena.h>
+#include <render/Buffer.h>
+#include <render/Device.h>
+#include <render/FrameSnapshot.h>
+#include <render/Mesh.h>
+#include <render/SwapChain.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rw
+{
+  // GPU copies of streamed chunks, keyed by chunk id. Chunks are uploaded the first time a
+  // snapshot draws them and released once they have not been drawn for a while and the
+  // budget is exceeded. New chunks are written to a staging buffer of the frame slot and copied
+  // by the frame's own command buffer, the render thread never waits for a transfer.
+  class StreamedGeometry
+  {
+  public:
+    StreamedGeometry(Device& dev, VkDeviceSize budget);
+
+    StreamedGeometry(const StreamedGeometry&) = delete;
+    StreamedGeometry& operator=(const StreamedGeometry&) = delete;
+
+    // Render thread, after the frame fence was waited on.
+    void prepare(const FrameSnapshot& snapshot, int frameIndex, LinearArena& frameArena);
+    // Records the copies of the chunks prepare() added, outside of any render pass and before
+    // the first draw of the frame.
+    void recordUploads(VkCommandBuffer command, int frameIndex);
+    // Expects the mesh pipeline and the instance buffer to be bound.
+    void draw(VkCommandBuffer command, const FrameSnapshot& snapshot) const;
+
+    uint32_t getResidentCount() const { return static_cast<uint32_t>(mChunks.size()); }
+    VkDeviceSize getResidentBytes() const { return mResidentBytes; }
+
+  private:
+    struct Entry
+    {
+      std::unique_ptr<Mesh> mesh;
+      uint64_t lastUsedFrame;
+    };
+
+    struct Upload
+    {
+      const Mesh* mesh;
+      VkDeviceSize offset;
+    };
+
+    void evict(LinearArena& frameArena);
+    Buffer& reserveStaging(int frameIndex, VkDeviceSize size);
+
+  private:
+    Device& device;
+    VkDeviceSize mBudget;
+    VkDeviceSize mResidentBytes = { 0 };
+    uint64_t mFrame = { 0 };
+    std::unordered_map<uint32_t, Entry> mChunks;
+    // per frame slot, reused once its fence was waited on
+    std::array<std::unique_ptr<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> mStaging;
+    std::vector<Upload> mUploads;
+  };
+}
+
+#endif // STREAMEDGEOMETRY_H
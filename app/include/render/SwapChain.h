@@ -13,8 +13,9 @@ namespace rw
 {
   class SwapChain
   {
-    const uint32_t MAX_FRAMES_IN_FLIGHT = {2u};
   public:
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = {2u};
+
     SwapChain(Device& dev, VkExtent2D swapchainResolution);
     SwapChain(Device& dev, VkExtent2D swapchainResolution, std::shared_ptr<rw::SwapChain> previous);
     ~SwapChain();
@@ -28,11 +29,19 @@ namespace rw
     VkImageView getImageViews(int32_t frameIdx) {
       return mSwapChainImageViews[frameIdx];
     }
+    VkImage getImage(uint32_t imageIdx) const { return mSwapChainImages[imageIdx]; }
+    VkFormat getImageFormat() const { return mSwapChainImageFormat; }
+    // true when swapchain images were created with TRANSFER_SRC usage
+    bool supportsReadback() const { return mSupportsReadback; }
     VkRenderPass getRenderPass() { return mRenderPass;  }
+    size_t imageCount() const { return mSwapChainImages.size(); }
+    size_t getCurrentFrame() const { return mCurrentFrame; }
     VkSwapchainKHR getHanlder() { return mSwapChain; }
 
     VkResult acquireNextImage(uint32_t* imageIdx);
-    VkResult submitCommandBuffer(const VkCommandBuffer* commands, uint32_t* imageIdx);
+    // waitSemaphore (optional) is waited on at waitStage, e.g. for compute results read by the vertex stages
+    VkResult submitCommandBuffer(const VkCommandBuffer* commands, uint32_t* imageIdx,
+      VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = 0);
     VkFormat findDepthFormat();
 
     float aspectRatio() {
@@ -82,6 +91,7 @@ namespace rw
     VkFormat mSwapChainImageFormat;
     std::vector<VkImage> mSwapChainImages;
     std::vector<VkImageView> mSwapChainImageViews;
+    bool mSupportsReadback = { false };
 
     std::vector<VkFramebuffer> mSwapChainFramebuffers;
 
@@ -0,0 +1,62 @@
+#ifndef VISIBILITYBUFFER_H
+#define VISIBILITYBUFFER_H
+
+#include <render/Device.h>
+
+namespace rw
+{
+  // Target of the visibility pass: per pixel the instance covering it with its packed normal, and
+  // its depth, so the resolve pass shades every pixel exactly once however often it was overdrawn.
+  // Like ScaledRenderTarget the images have the full output size and only the part the scene is
+  // rendered at is drawn. One buffer is shared by the frames in flight, the render pass orders the
+  // writes after the previous frame's resolve.
+  class VisibilityBuffer
+  {
+  public:
+    // cleared value of the instance channel, pixels without geometry
+    static constexpr uint32_t NO_INSTANCE = { ~0u };
+
+    explicit VisibilityBuffer(Device& dev);
+    ~VisibilityBuffer();
+
+    VisibilityBuffer(const VisibilityBuffer&) = delete;
+    VisibilityBuffer& operator=(const VisibilityBuffer&) = delete;
+
+    // Reallocates the images for a new output size, the device must be idle.
+    void resize(VkExtent2D extent);
+
+    void beginRenderPass(VkCommandBuffer command, VkExtent2D renderExtent);
+    void endRenderPass(VkCommandBuffer command);
+
+    VkExtent2D getExtent() const { return mExtent; }
+    VkRenderPass getRenderPass() const { return mRenderPass; }
+    // instance and packed normal as two uints
+    VkImageView getVisibilityView() const { return mVisibilityView; }
+    VkImageView getDepthView() const { return mDepthView; }
+    // nearest, both images are read with texelFetch
+    VkSampler getSampler() const { return mSampler; }
+
+  private:
+    void createRenderPass();
+    void createSampler();
+    void createImages();
+    void destroyImages();
+
+  private:
+    Device& device;
+    VkFormat mDepthFormat = { VK_FORMAT_UNDEFINED };
+    VkExtent2D mExtent = { 0, 0 };
+
+    VkRenderPass mRenderPass = { VK_NULL_HANDLE };
+    VkImage mVisibilityImage = { VK_NULL_HANDLE };
+    VkDeviceMemory mVisibilityMemory = { VK_NULL_HANDLE };
+    VkImageView mVisibilityView = { VK_NULL_HANDLE };
+    VkImage mDepthImage = { VK_NULL_HANDLE };
+    VkDeviceMemory mDepthMemory = { VK_NULL_HANDLE };
+    VkImageView mDepthView = { VK_NULL_HANDLE };
+    VkFramebuffer mFramebuffer = { VK_NULL_HANDLE };
+    VkSampler mSampler = { VK_NULL_HANDLE };
+  };
+}
+
+#endif // VISIBILITYBUFFER_H
@@ -0,0 +1,67 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <scene/MeshData.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rw {
+// Rotations are stored as quaternions in a vec4 (x, y, z, w).
+struct Joint {
+    std::string name;
+    std::int32_t parent = -1;
+    glm::mat4 inverseBind {1.0f};
+    // local bind pose, used when a clip does not animate the joint
+    glm::vec3 translation {0.0f};
+    glm::vec4 rotation {0.0f, 0.0f, 0.0f, 1.0f};
+    glm::vec3 scale {1.0f};
+};
+
+// Joints are ordered so that every parent comes before its children.
+struct Skeleton {
+    std::vector<Joint> joints;
+};
+
+// Keys of one joint; all components share the key times, empty means bind pose.
+struct JointTrack {
+    std::vector<float> times;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::vec4> rotations;
+    std::vector<glm::vec3> scales;
+};
+
+struct AnimationClip {
+    std::string name;
+    float duration = 0.0f;
+    std::vector<JointTrack> tracks; // one per skeleton joint
+};
+
+// Mesh with up to four joint influences per vertex, weights sum up to one.
+struct SkinnedMeshData {
+    MeshData mesh;
+    std::vector<glm::uvec4> joints;
+    std::vector<glm::vec4> weights;
+};
+
+// Spherical interpolation of unit quaternions, evaluated with SSE2 when available.
+glm::vec4 slerp(const glm::vec4 &a, const glm::vec4 &b, float t);
+
+// Index of the key interval [i, i + 1] containing time. Playback moves forward, so the search
+// starts at hint (the previous result) and only falls back to a binary search on jumps.
+std::size_t findKey(const std::vector<float> &times, float time, std::size_t hint);
+
+glm::mat4 composeTransform(const glm::vec3 &translation, const glm::vec4 &rotation, const glm::vec3 &scale);
+
+// Samples the local transform of joints [first, last). cursors holds one key hint per joint.
+void sampleLocalPose(const Skeleton &skeleton, const AnimationClip &clip, float time, std::size_t first, std::size_t last,
+                     glm::mat4 *local, std::uint32_t *cursors);
+// Resolves the hierarchy and multiplies with the inverse bind matrices into the skinning palette.
+void buildPalette(const Skeleton &skeleton, const glm::mat4 *local, glm::mat4 *palette);
+}
+
+#endif // ANIMATION_H
@@ -0,0 +1,34 @@
+#ifndef ANIMATIONPLAYER_H
+#define ANIMATIONPLAYER_H
+
+#include <core/ThreadPool.h>
+#include <scene/Scene.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rw {
+// Samples the clips of animated nodes into skinning palettes on the simulation thread.
+// Local poses of all joints of all requested nodes are sampled in parallel, the hierarchy
+// is then resolved per node, also in parallel.
+class AnimationPlayer {
+public:
+    explicit AnimationPlayer(ThreadPool &pool) : mPool{pool} {}
+
+    // Writes the palettes of the given animated nodes back to back into palettes;
+    // paletteOffsets receives the first palette entry of each node.
+    void evaluate(const Scene &scene, const std::vector<std::uint32_t> &nodes, double time,
+                  std::vector<glm::mat4> &palettes, std::vector<std::uint32_t> &paletteOffsets);
+
+private:
+    ThreadPool &mPool;
+    std::vector<glm::mat4> mLocal;
+    // key hints of every joint of every animated node, indexed like mCursorOffsets
+    std::vector<std::uint32_t> mCursors;
+    std::vector<std::uint32_t> mCursorOffsets;
+};
+}
+
+#endif // ANIMATIONPLAYER_H
@@ -0,0 +1,45 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <scene/MeshData.h>
+
+#include <glm/glm.hpp>
+
+namespace rw {
+// Orbit camera looking at a target point.
+class Camera {
+public:
+    Camera() = default;
+
+    void setPerspective(float fovy, float aspect, float nearPlane, float farPlane);
+    void setAspectRatio(float aspect);
+    void setOrbit(const glm::vec3 &target, float distance, float yaw, float pitch);
+    void orbit(float deltaYaw, float deltaPitch);
+    void zoom(float factor);
+    void frame(const BoundingBox &bounds);
+
+    glm::vec3 getPosition() const;
+    const glm::vec3 &getTarget() const { return mTarget; }
+    float getNear() const { return mNear; }
+    float getFar() const { return mFar; }
+    float getFovy() const { return mFovy; }
+    float getAspectRatio() const { return mAspect; }
+
+    glm::mat4 getView() const;
+    glm::mat4 getProjection() const;
+    glm::mat4 getViewProjection() const { return getProjection() * getView(); }
+
+private:
+    glm::vec3 mTarget {0.0f};
+    float mDistance = 5.0f;
+    float mYaw = 0.0f;
+    float mPitch = 0.3f;
+
+    float mFovy = 0.785398f;
+    float mAspect = 16.0f / 9.0f;
+    float mNear = 0.1f;
+    float mFar = 1000.0f;
+};
+}
+
+#endif // CAMERA_H
@@ -0,0 +1,129 @@
+#ifndef CHUNKSTREAMER_H
+#define CHUNKSTREAMER_H
+
+#include <core/ThreadPool.h>
+#include <scene/Camera.h>
+#include <scene/ChunkedModel.h>
+#include <scene/Frustum.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace rw {
+struct ChunkStreamerOptions {
+    std::uint64_t cacheBytes = 2ull << 30;
+    std::size_t ioThreads = 2;
+    // a node is refined into its children while its simplification is larger than this on screen
+    float maxScreenError = 2.0f;
+    // completed reads taken over per update, bounds the GPU uploads of one frame
+    std::uint32_t maxLoadsPerUpdate = 16;
+};
+
+struct ChunkStreamerStats {
+    std::uint32_t residentChunks = 0;
+    std::uint64_t residentBytes = 0;
+    std::uint32_t pending = 0;
+    std::uint32_t inFlight = 0;
+    std::uint64_t loaded = 0;
+    std::uint64_t cancelled = 0; // dropped from the queue or aborted mid read
+    std::uint64_t evicted = 0;
+    // totals of completed reads since the model was opened
+    std::uint64_t storedBytes = 0;  // read from disk
+    std::uint64_t rawBytes = 0;     // geometry those reads turned into
+    std::uint64_t decodedBytes = 0; // produced by the decoder, compressed chunks only
+    std::uint64_t decodeNs = 0;     // summed over the I/O threads
+};
+
+struct StreamedChunk {
+    ChunkId id;
+    std::shared_ptr<const MeshData> mesh;
+};
+
+// Pages the geometry of a ChunkedModel in on demand. Every update selects the octree cut for the
+// camera and queues the missing nodes by screen space error; the queue is replaced on each update,
+// which cancels requests the camera moved away from. Reads run on a dedicated I/O pool and land in
+// a RAM cache bounded by cacheBytes, least recently used chunks are evicted first.
+class ChunkStreamer {
+public:
+    explicit ChunkStreamer(const std::string &path, const ChunkStreamerOptions &options = {});
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer &) = delete;
+    ChunkStreamer &operator=(const ChunkStreamer &) = delete;
+
+    // Called from an I/O thread whenever a chunk finished loading.
+    void setLoadedCallback(std::function<void()> callback) { mLoadedCallback = std::move(callback); }
+
+    // Simulation thread only. Fills visible with resident chunks covering the view; a node is only
+    // replaced by its children once all of them in the frustum are resident, so there are no holes.
+    void update(const Camera &camera, const Frustum &frustum, float viewportHeight, std::vector<StreamedChunk> &visible);
+
+    const BoundingBox &getBounds() const { return mNodes.front().bounds; }
+    ChunkStreamerStats getStats() const;
+
+private:
+    struct Request {
+        ChunkId id;
+        float priority;
+    };
+
+    enum LoadState : char {
+        Idle,
+        Reading,
+        Ready // waiting in mLoaded for the simulation thread
+    };
+
+    struct Loaded {
+        ChunkId id;
+        std::shared_ptr<const MeshData> mesh;
+    };
+
+    bool isResident(ChunkId id) const { return mNodes[id].isEmpty() || mResident[id] != nullptr; }
+    void select(ChunkId id, const glm::vec3 &eye, float projectionScale, const Frustum &frustum, std::vector<StreamedChunk> &visible);
+    void want(ChunkId id, float priority);
+    void touch(ChunkId id);
+    void takeLoaded();
+    void evict();
+    void pump();
+
+private:
+    std::string mPath;
+    ChunkStreamerOptions mOptions;
+    std::vector<ChunkNode> mNodes;
+
+    // simulation thread state
+    std::vector<std::shared_ptr<const MeshData>> mResident;
+    std::list<ChunkId> mLru; // most recently used first
+    std::vector<std::list<ChunkId>::iterator> mLruPosition;
+    std::uint64_t mResidentBytes = 0;
+    std::vector<Request> mWanted;
+    std::uint64_t mEvicted = 0;
+
+    // generation in which each chunk was last wanted, read by the I/O threads to abort reads
+    std::unique_ptr<std::atomic<std::uint32_t>[]> mWantedGeneration;
+    std::atomic<std::uint32_t> mGeneration {1};
+
+    mutable std::mutex mMutex;
+    std::vector<Request> mPending; // sorted by priority, highest last
+    std::vector<LoadState> mState;
+    std::vector<char> mFailed;
+    std::vector<Loaded> mLoaded;
+    std::size_t mActivePumps = 0;
+    std::uint64_t mLoadedCount = 0;
+    std::uint64_t mCancelled = 0;
+    ChunkReadStats mReadStats;
+    bool mStopping = false;
+
+    std::function<void()> mLoadedCallback;
+    // last member, so its threads are joined before the state above goes away
+    ThreadPool mIoPool;
+};
+}
+
+#endif // CHUNKSTREAMER_H
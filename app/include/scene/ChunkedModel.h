@@ -0,0 +1,73 @@
+#ifndef CHUNKEDMODEL_H
+#define CHUNKEDMODEL_H
+
+#include <scene/GeometryCodec.h>
+#include <scene/Scene.h>
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace rw {
+using ChunkId = std::uint32_t;
+
+// One octree node of a chunked model. Leaves hold the full resolution triangles of their cell,
+// inner nodes a simplified version of their whole subtree. Children of a node are stored next
+// to each other, the root is node 0.
+struct ChunkNode {
+    BoundingBox bounds;
+    float geometricError = 0.0f; // world space size of the simplification, 0 for leaves
+    std::uint32_t firstChild = 0;
+    std::uint32_t childCount = 0;
+    std::uint32_t level = 0;
+    std::uint32_t vertexCount = 0;
+    std::uint32_t indexCount = 0;
+    std::uint64_t offset = 0; // vertices followed by indices, or the GeometryCodec streams
+    std::uint64_t storedSize = 0; // bytes in the file
+    bool compressed = false;
+
+    bool isEmpty() const { return vertexCount == 0; }
+    std::uint64_t byteSize() const { return vertexCount * sizeof(Vertex) + indexCount * sizeof(std::uint32_t); }
+};
+
+struct ChunkedModelOptions {
+    std::uint32_t maxLeafTriangles = 65536;
+    std::uint32_t maxDepth = 12;
+    // cells per axis of the vertex clustering grid used for the LOD of inner nodes
+    std::uint32_t lodResolution = 64;
+    // store the node geometry with GeometryCodec, nodes which would not shrink stay raw
+    bool compress = false;
+    GeometryCodecOptions codec;
+};
+
+struct ChunkReadStats {
+    std::uint64_t storedBytes = 0;
+    std::uint64_t rawBytes = 0;
+    std::uint64_t decodedBytes = 0; // 0 for uncompressed nodes
+    std::uint64_t decodeNs = 0;
+};
+
+// Preprocessed on-disk layout (.rwoc) for models which do not fit into memory: a small node
+// table followed by the geometry of every node, so the viewer only keeps the table resident
+// and pages the geometry in (see ChunkStreamer).
+class ChunkedModel {
+public:
+    static constexpr std::uint32_t VERSION = 2;
+
+    // Bakes the node transforms of the scene and writes the octree. The source scene has to fit
+    // into memory, only the viewer side is out of core.
+    static void build(const Scene &scene, const std::string &path, const ChunkedModelOptions &options = {});
+
+    static std::vector<ChunkNode> readIndex(const std::string &path);
+    // Reads the geometry of one node in blocks and decodes it if compressed; returns false when
+    // cancelled() turned true in between.
+    static bool readChunk(std::ifstream &file, const ChunkNode &node, MeshData &mesh, const std::function<bool()> &cancelled,
+                          ChunkReadStats *stats = nullptr);
+
+    static bool isChunkedModel(const std::string &path);
+};
+}
+
+#endif // CHUNKEDMODEL_H
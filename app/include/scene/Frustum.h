@@ -0,0 +1,24 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <scene/MeshData.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace rw {
+class Frustum {
+public:
+    Frustum() = default;
+    // Extracts the planes from a Vulkan style (depth 0..1) view projection matrix.
+    explicit Frustum(const glm::mat4 &viewProjection);
+
+    bool intersects(const BoundingBox &box) const;
+
+private:
+    std::array<glm::vec4, 6> mPlanes {};
+};
+}
+
+#endif // FRUSTUM_H
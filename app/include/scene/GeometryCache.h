@@ -0,0 +1,50 @@
+#ifndef GEOMETRYCACHE_H
+#define GEOMETRYCACHE_H
+
+#include <scene/MeshData.h>
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace rw {
+using MeshId = std::uint32_t;
+constexpr MeshId INVALID_MESH = ~0u;
+
+// Stores each distinct piece of geometry once. Meshes with the same content hash and matching
+// geometry collapse into a single MeshId. Meshes sharing a hash are kept ordered by the sum of
+// their bounds extents, so a lookup only compares the few whose size is within the tolerance.
+// Copies are only recognized up to translation, which recenter() removes; rotated copies of a
+// part stay separate meshes.
+class GeometryCache {
+public:
+    GeometryCache() = default;
+
+    MeshId add(MeshData &&mesh);
+    // Returns the mesh with the same content or INVALID_MESH; hash is mesh.contentHash().
+    MeshId find(const MeshData &mesh, std::uint64_t hash) const;
+
+    const MeshData &get(MeshId id) const { return mMeshes.at(id); }
+    std::uint64_t getHash(MeshId id) const { return mHashes.at(id); }
+    const std::vector<MeshData> &getMeshes() const { return mMeshes; }
+    std::size_t size() const { return mMeshes.size(); }
+
+    std::size_t getDuplicateCount() const { return mDuplicateCount; }
+    std::size_t getDeduplicatedBytes() const { return mDeduplicatedBytes; }
+
+private:
+    std::vector<MeshData> mMeshes;
+    std::vector<std::uint64_t> mHashes;
+    struct Bucket {
+        std::multimap<float, MeshId> meshBySize;
+        float maxTolerance = 0.0f; // of the meshes in the bucket
+    };
+
+    std::unordered_map<std::uint64_t, Bucket> mBuckets;
+    std::size_t mDuplicateCount = 0;
+    std::size_t mDeduplicatedBytes = 0;
+};
+}
+
+#endif // GEOMETRYCACHE_H
@@ -0,0 +1,29 @@
+#ifndef GEOMETRYCODEC_H
+#define GEOMETRYCODEC_H
+
+#include <scene/MeshData.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rw {
+struct GeometryCodecOptions {
+    // octahedral 16 bit normals instead of three floats, the only lossy step
+    bool quantizeNormals = true;
+};
+
+// Compression for vertex and index streams. Every 32 bit attribute component and the index
+// stream are delta coded against the previous vertex/index, zigzag mapped and split into byte
+// planes; each plane is stored raw, as a constant or rANS entropy coded, whichever is smallest.
+// Decoding rebuilds the words and the running sums with SSE2 straight into the mesh arrays.
+class GeometryCodec {
+public:
+    // Appends the encoded streams of mesh to out.
+    static void encode(const MeshData &mesh, const GeometryCodecOptions &options, std::vector<std::uint8_t> &out);
+    // mesh.vertices and mesh.indices must already have the encoded sizes. Throws on corrupt data.
+    static void decode(const std::uint8_t *data, std::size_t size, MeshData &mesh);
+};
+}
+
+#endif // GEOMETRYCODEC_H
@@ -0,0 +1,40 @@
+#ifndef GEOMETRYDIFF_H
+#define GEOMETRYDIFF_H
+
+#include <scene/GeometryCache.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rw {
+// What the GPU copy of one mesh of the new scene is made from.
+struct MeshChange {
+    MeshId previous = INVALID_MESH;      // GPU mesh to keep or update, INVALID_MESH creates a new one
+    std::shared_ptr<const MeshData> data; // null when previous is kept untouched
+    // element ranges to rewrite when previous is updated in place
+    std::uint32_t firstVertex = 0;
+    std::uint32_t vertexCount = 0;
+    std::uint32_t firstIndex = 0;
+    std::uint32_t indexCount = 0;
+};
+
+// Turns the geometry of a re-imported scene into the smallest set of GPU updates: meshes found
+// by content hash anywhere in the previous scene are kept (also when their id moved), edited
+// meshes are patched in place over the range that differs when a leftover previous mesh has the
+// same vertex and index counts, everything else is uploaded. Unused previous meshes are released.
+struct GeometryDiff {
+    std::uint64_t generation = 0;
+    std::vector<MeshChange> meshes; // indexed by the MeshId of the new scene
+
+    std::uint32_t kept = 0;
+    std::uint32_t updated = 0;
+    std::uint32_t created = 0;
+    std::uint32_t removed = 0;
+    std::uint64_t uploadBytes = 0;
+
+    static GeometryDiff compute(const GeometryCache &previous, const GeometryCache &next);
+};
+}
+
+#endif // GEOMETRYDIFF_H
@@ -0,0 +1,95 @@
+#ifndef LIGHTBINNER_H
+#define LIGHTBINNER_H
+
+#include <core/ThreadPool.h>
+#include <scene/Scene.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rw {
+struct ClusterOptions {
+    std::uint32_t tilesX = 16;
+    std::uint32_t tilesY = 9;
+    std::uint32_t slices = 24;
+    // lights past this in one cluster are dropped (and counted), bounds the shading loop
+    std::uint32_t maxLightsPerCluster = 128;
+};
+
+// Froxel grid of one frame: screen tiles times depth slices spaced exponentially between the
+// near and far plane, slice = floor(log(depth) * sliceScale + sliceBias).
+struct ClusterGrid {
+    std::uint32_t tilesX = 0;
+    std::uint32_t tilesY = 0;
+    std::uint32_t slices = 0;
+    float sliceScale = 0.0f;
+    float sliceBias = 0.0f;
+
+    std::uint32_t getClusterCount() const { return tilesX * tilesY * slices; }
+};
+
+// Light as read by the shading pass (std430, four vec4).
+struct ClusterLight {
+    glm::vec4 positionRange;  // world position, range
+    glm::vec4 colorType;      // color times intensity, LightType
+    glm::vec4 directionCos;   // spot direction, cos of the outer angle
+    glm::vec4 spot;           // cos of the inner angle, unused
+};
+
+struct LightBinStats {
+    std::uint32_t lights = 0;
+    std::uint32_t binnedLights = 0; // touching at least one cluster
+    std::uint32_t litClusters = 0;
+    std::uint32_t maxPerCluster = 0;
+    std::uint32_t overflow = 0;     // assignments dropped by maxLightsPerCluster
+    std::size_t indices = 0;
+    double binMs = 0.0;
+};
+
+// Clustered light assignment on the CPU. Every light is bounded by a view space sphere, which
+// gives the range of slices and tiles it can touch; the clusters in that range are then tested
+// against the sphere, four tiles of a row at a time, with the slices split over the workers.
+// The result is a compact index list with an (offset, count) pair per cluster.
+class LightBinner {
+public:
+    explicit LightBinner(ThreadPool &pool, const ClusterOptions &options = {});
+
+    // projection must be a symmetric perspective projection with the given planes.
+    void bin(const std::vector<Light> &lights, const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane,
+             ClusterGrid &grid, std::vector<ClusterLight> &packed, std::vector<glm::uvec2> &clusters, std::vector<std::uint32_t> &indices);
+
+    const LightBinStats &getStats() const { return mStats; }
+
+private:
+    // bounding sphere of a packed light with the clusters it may touch (inclusive ranges)
+    struct Sphere {
+        glm::vec3 center; // view space, depth is -z
+        float radius;
+        std::uint32_t tileX0, tileX1, tileY0, tileY1, slice0, slice1;
+    };
+
+    struct SliceResult {
+        std::vector<std::uint32_t> spheres;    // overlapping the slice
+        std::vector<std::uint64_t> assignment; // cluster << 32 | sphere
+        std::vector<std::uint32_t> counts;     // per cluster of the slice
+        std::vector<std::uint32_t> cursor;
+        std::vector<std::uint32_t> indices;    // grouped by cluster
+        std::vector<float> minX, maxX;         // tile bounds, padded to a multiple of 4
+        std::uint32_t overflow = 0;
+    };
+
+    void binSlice(std::uint32_t slice, const glm::mat4 &projection);
+
+private:
+    ThreadPool &mPool;
+    ClusterOptions mOptions;
+    std::vector<float> mSliceDepths; // slices + 1 boundaries
+    std::vector<Sphere> mSpheres;
+    std::vector<SliceResult> mSlices;
+    LightBinStats mStats;
+};
+}
+
+#endif // LIGHTBINNER_H
@@ -0,0 +1,58 @@
+#ifndef MESHDATA_H
+#define MESHDATA_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace rw {
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+struct BoundingBox {
+    glm::vec3 min {std::numeric_limits<float>::max()};
+    glm::vec3 max {std::numeric_limits<float>::lowest()};
+
+    bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extent() const { return max - min; }
+
+    void expand(const glm::vec3 &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void expand(const BoundingBox &other) {
+        if (!other.isValid()) return;
+        expand(other.min);
+        expand(other.max);
+    }
+    BoundingBox transformed(const glm::mat4 &transform) const;
+};
+
+// CPU side geometry of a single mesh, positions are in the mesh local space.
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+    BoundingBox bounds;
+    // largest absolute coordinate the positions had before recenter(), their float noise scales with it
+    float bakedMagnitude = 0.0f;
+
+    void computeBounds();
+    // Moves the geometry so its bounds are centered at the origin and returns the applied offset.
+    glm::vec3 recenter();
+    // Largest position difference isSameGeometry() accepts, from the mesh size and bakedMagnitude.
+    float positionTolerance() const;
+    // Hash of the topology only; positions, normals and uvs carry noise and are left to isSameGeometry(),
+    // GeometryCache narrows the candidates sharing a hash down by their size first.
+    std::uint64_t contentHash() const;
+    // Compares the vertices within a tolerance that covers the float noise of baked world positions.
+    bool isSameGeometry(const MeshData &other) const;
+};
+}
+
+#endif // MESHDATA_H
@@ -0,0 +1,21 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <scene/Scene.h>
+
+#include <string>
+
+namespace rw {
+// Wavefront OBJ importer. Every object/group and material pair becomes one mesh which is
+// recentered before it enters the geometry cache, so repeated parts exported with baked
+// world positions collapse into a single mesh with many instances.
+class ObjLoader {
+public:
+    static void load(const std::string &path, Scene &scene);
+
+private:
+    static void loadMaterials(const std::string &path, Scene &scene);
+};
+}
+
+#endif // OBJLOADER_H
@@ -0,0 +1,84 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <core/ThreadPool.h>
+#include <scene/Scene.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rw {
+struct OcclusionOptions {
+    // depth buffer size, the width is rounded up to a multiple of 4 for the SIMD rows
+    std::uint32_t width = 320;
+    std::uint32_t height = 192;
+    std::uint32_t maxOccluders = 64;
+    // meshes above this are too expensive to rasterize on the CPU every frame
+    std::uint32_t maxOccluderTriangles = 4096;
+    // bounds radius over distance below which a node is too small to hide anything
+    float minOccluderSize = 0.05f;
+};
+
+struct OcclusionStats {
+    std::uint32_t occluders = 0;
+    std::uint32_t occluderTriangles = 0;
+    std::uint32_t tested = 0;
+    std::uint32_t culled = 0;
+    double rasterMs = 0.0;
+    double pyramidMs = 0.0;
+    double testMs = 0.0;
+};
+
+// CPU occlusion culling. The largest nearby simple meshes are rasterized into a low resolution
+// depth buffer, split into bands rasterized in parallel four pixels at a time; a max depth pyramid
+// built from it then rejects bounds whose nearest point lies behind every occluder they overlap.
+// Everything stays on the CPU, so results do not depend on the Vulkan implementation.
+class OcclusionCuller {
+public:
+    explicit OcclusionCuller(ThreadPool &pool, const OcclusionOptions &options = {});
+
+    // Chooses occluders among the (frustum visible) nodes and builds the depth pyramid.
+    void prepare(const Scene &scene, const std::vector<std::uint32_t> &nodes, const glm::mat4 &viewProjection, const glm::vec3 &eye);
+    // Removes the occluded nodes in place, keeping the order of the rest. Occluders are tested
+    // as well, one hidden behind another one is culled like any other node.
+    void cull(const Scene &scene, std::vector<std::uint32_t> &nodes);
+    // Animated nodes are only tested, they move too much to be occluders.
+    void cullAnimated(const Scene &scene, std::vector<std::uint32_t> &nodes);
+
+    bool isVisible(const BoundingBox &bounds) const;
+    const OcclusionStats &getStats() const { return mStats; }
+
+private:
+    struct Triangle {
+        glm::vec3 v[3]; // pixel x, pixel y, depth
+    };
+
+    struct Level {
+        std::uint32_t width;
+        std::uint32_t height;
+        std::vector<float> depth;
+    };
+
+    void selectOccluders(const Scene &scene, const std::vector<std::uint32_t> &nodes, const glm::vec3 &eye);
+    void setupTriangles(const Scene &scene);
+    void rasterizeBand(std::uint32_t rowBegin, std::uint32_t rowEnd);
+    void buildPyramid();
+    template <typename Bounds>
+    void cullNodes(const std::vector<Bounds> &all, std::vector<std::uint32_t> &nodes);
+
+private:
+    ThreadPool &mPool;
+    OcclusionOptions mOptions;
+    glm::mat4 mViewProjection {1.0f};
+
+    std::vector<std::uint32_t> mOccluders;
+    std::vector<Triangle> mTriangles;
+    std::vector<Level> mLevels; // level 0 is the rasterized depth buffer
+    std::vector<char> mVisible;
+    OcclusionStats mStats;
+};
+}
+
+#endif // OCCLUSIONCULLER_H
@@ -0,0 +1,89 @@
+#ifndef POINTCLOUD_H
+#define POINTCLOUD_H
+
+#include <scene/Camera.h>
+#include <scene/Frustum.h>
+#include <scene/MeshData.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rw {
+// One scanned point, the color is RGBA8 with red in the lowest byte (unpackUnorm4x8).
+struct PointVertex {
+    glm::vec3 position;
+    std::uint32_t color;
+};
+
+// Points of one spatial cell, stored shuffled so that every prefix is an even subsample of the cell.
+struct PointChunk {
+    BoundingBox bounds;
+    std::uint32_t firstPoint = 0;
+    std::uint32_t pointCount = 0;
+};
+
+// Prefix of a chunk selected for the frame.
+struct PointSelection {
+    std::uint32_t chunk;
+    std::uint32_t count;
+};
+
+struct PointCloudOptions {
+    std::uint32_t pointsPerChunk = 65536;
+    // points drawn per pixel a chunk covers on screen, before the budget applies
+    float density = 1.0f;
+    // the whole frame never draws more, near chunks keep their share of it
+    std::uint64_t pointBudget = 16000000;
+};
+
+struct PointCloudStats {
+    std::uint32_t chunks = 0;
+    std::uint32_t visibleChunks = 0;
+    std::uint64_t selectedPoints = 0;
+    // all points of the visible chunks, what a selection without density or budget limits would draw
+    std::uint64_t visiblePoints = 0;
+    bool budgetLimited = false;
+};
+
+// Laser scan loaded from an ASCII .xyz or .pts file and split into chunks by recursive median
+// splits. select() culls the chunks against the frustum and picks how much of each one to draw
+// from its projected size, so far away parts of a facility cost a few points instead of all of them.
+class PointCloud {
+public:
+    explicit PointCloud(const PointCloudOptions &options = {});
+
+    // Lines of x y z, optionally followed by an intensity and/or r g b in 0..255; others are skipped.
+    void load(const std::string &path);
+    // Keeps an even subsample of at most maxPoints, for devices which cannot hold the whole scan.
+    void fitTo(std::uint64_t maxPoints);
+    void select(const Camera &camera, const Frustum &frustum, float viewportHeight, std::vector<PointSelection> &selection);
+    // Scales the density and the budget of the following selections, 1 is the interactive setting.
+    void setRefinement(float refinement) { mRefinement = refinement; }
+    float getRefinement() const { return mRefinement; }
+
+    const std::vector<PointVertex> &getPoints() const { return mPoints; }
+    const std::vector<PointChunk> &getChunks() const { return mChunks; }
+    const BoundingBox &getBounds() const { return mBounds; }
+    std::uint64_t getPointCount() const { return mPoints.size(); }
+    bool isEmpty() const { return mPoints.empty(); }
+    const PointCloudStats &getStats() const { return mStats; }
+
+    static bool isPointCloud(const std::string &path);
+
+private:
+    void buildChunks();
+
+private:
+    PointCloudOptions mOptions;
+    std::vector<PointVertex> mPoints;
+    std::vector<PointChunk> mChunks;
+    BoundingBox mBounds;
+    PointCloudStats mStats;
+    float mRefinement = 1.0f;
+};
+}
+
+#endif // POINTCLOUD_H
@@ -0,0 +1,109 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <scene/Animation.h>
+#include <scene/GeometryCache.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rw {
+using MaterialId = std::uint32_t;
+using SkinnedMeshId = std::uint32_t;
+using SkeletonId = std::uint32_t;
+using ClipId = std::uint32_t;
+
+struct Material {
+    std::string name;
+    glm::vec4 baseColor {0.8f, 0.8f, 0.8f, 1.0f};
+};
+
+struct SceneNode {
+    MeshId mesh;
+    MaterialId material;
+    glm::mat4 transform {1.0f};
+    BoundingBox worldBounds;
+};
+
+enum class LightType : std::uint32_t {
+    Point,
+    Spot
+};
+
+// Punctual light in world space, its influence ends at range.
+struct Light {
+    LightType type = LightType::Point;
+    glm::vec3 position {0.0f};
+    float range = 1.0f;
+    glm::vec3 color {1.0f};
+    float intensity = 1.0f;
+    glm::vec3 direction {0.0f, -1.0f, 0.0f}; // spot only, normalized
+    float innerAngle = 0.3f;                 // spot only, half angles in radians
+    float outerAngle = 0.5f;
+};
+
+// Skinned mesh playing a clip; its pose is sampled every frame and skinned on the GPU.
+struct AnimatedNode {
+    SkinnedMeshId mesh;
+    SkeletonId skeleton;
+    ClipId clip;
+    MaterialId material;
+    glm::mat4 transform {1.0f};
+    float timeOffset = 0.0f;
+    BoundingBox worldBounds;
+};
+
+class Scene {
+public:
+    Scene();
+
+    GeometryCache &getGeometry() { return mGeometry; }
+    const GeometryCache &getGeometry() const { return mGeometry; }
+
+    // Returns the id of an already registered material with the same name.
+    MaterialId addMaterial(const Material &material);
+    MaterialId findMaterial(const std::string &name) const;
+    const Material &getMaterial(MaterialId id) const { return mMaterials.at(id); }
+    const std::vector<Material> &getMaterials() const { return mMaterials; }
+
+    void addNode(MeshId mesh, MaterialId material, const glm::mat4 &transform);
+    const std::vector<SceneNode> &getNodes() const { return mNodes; }
+
+    SkinnedMeshId addSkinnedMesh(SkinnedMeshData &&mesh);
+    SkeletonId addSkeleton(Skeleton &&skeleton);
+    ClipId addClip(AnimationClip &&clip);
+    void addAnimatedNode(SkinnedMeshId mesh, SkeletonId skeleton, ClipId clip, MaterialId material, const glm::mat4 &transform, float timeOffset = 0.0f);
+
+    const std::vector<SkinnedMeshData> &getSkinnedMeshes() const { return mSkinnedMeshes; }
+    const Skeleton &getSkeleton(SkeletonId id) const { return mSkeletons.at(id); }
+    const AnimationClip &getClip(ClipId id) const { return mClips.at(id); }
+    const std::vector<AnimatedNode> &getAnimatedNodes() const { return mAnimatedNodes; }
+    bool hasAnimation() const { return !mAnimatedNodes.empty(); }
+
+    void addLight(const Light &light) { mLights.push_back(light); }
+    const std::vector<Light> &getLights() const { return mLights; }
+
+    BoundingBox getBounds() const;
+    void clear();
+
+    static constexpr MaterialId DEFAULT_MATERIAL = 0u;
+
+private:
+    GeometryCache mGeometry;
+    std::vector<Material> mMaterials;
+    std::unordered_map<std::string, MaterialId> mMaterialByName;
+    std::vector<SceneNode> mNodes;
+
+    std::vector<SkinnedMeshData> mSkinnedMeshes;
+    std::vector<Skeleton> mSkeletons;
+    std::vector<AnimationClip> mClips;
+    std::vector<AnimatedNode> mAnimatedNodes;
+    std::vector<Light> mLights;
+};
+}
+
+#endif // SCENE_H
@@ -0,0 +1,85 @@
+#ifndef SHADOWCASCADES_H
+#define SHADOWCASCADES_H
+
+#include <scene/Camera.h>
+#include <scene/MeshData.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace rw {
+struct ShadowOptions {
+    std::uint32_t cascades = 4; // at most ShadowCascades::MAX_CASCADES
+    std::uint32_t resolution = 2048;
+    // blend between logarithmic (1) and uniform (0) split distances
+    float splitLambda = 0.5f;
+    // coverage added around the view's part of a cascade, the camera moves within it without a redraw
+    float padding = 0.2f;
+    // towards the key light
+    glm::vec3 lightDirection = glm::normalize(glm::vec3(0.4f, 1.0f, 0.6f));
+};
+
+struct ShadowCascade {
+    glm::mat4 viewProjection {1.0f}; // world to shadow map, depth 0..1
+    float splitDepth = 0.0f;          // view depth where the next cascade takes over
+    std::uint64_t key = 0;            // identifies the cached static content of the map
+    bool needsCasters = false;        // the map for key was not confirmed drawn yet
+};
+
+struct ShadowStats {
+    std::uint32_t cascades = 0;
+    std::uint64_t moved = 0;   // cascades recentered because the view left their padded area
+    std::uint64_t changed = 0; // cascades invalidated by the light, the static scene or invalidate()
+};
+
+// Plans cascaded shadow maps for the directional key light so that their static content can be
+// cached. Each cascade covers a bounding sphere of its slice of the view frustum, whose radius only
+// depends on the projection and the split distances, so it does not change while the camera orbits
+// or pans. The light space position is snapped to whole texels and kept as long as the sphere stays
+// inside the padded area; a cascade's key only changes when it moves, when the light changes or when
+// the static scene does, and its static casters only have to be drawn again then.
+class ShadowCascades {
+public:
+    static constexpr std::uint32_t MAX_CASCADES = 4;
+
+    explicit ShadowCascades(const ShadowOptions &options = {});
+
+    // staticVersion changes whenever geometry drawn into the cached maps changes.
+    void update(const Camera &camera, const BoundingBox &sceneBounds, std::uint64_t staticVersion);
+    // The static map of the cascade was drawn with key (the snapshot carrying its casters was consumed).
+    void confirm(std::uint32_t cascade, std::uint64_t key);
+    // Forgets every cached map, e.g. after a frame carrying casters was dropped.
+    void invalidate();
+    void setLightDirection(const glm::vec3 &direction);
+
+    const std::vector<ShadowCascade> &getCascades() const { return mCascades; }
+    const ShadowOptions &getOptions() const { return mOptions; }
+    const ShadowStats &getStats() const { return mStats; }
+    void resetStats();
+
+private:
+    struct Placement {
+        bool valid = false;
+        glm::vec2 center {0.0f}; // light space, snapped to texels
+        float halfSize = 0.0f;
+        float depthMin = 0.0f;
+        float depthMax = 0.0f;
+        std::uint64_t confirmed = 0;
+    };
+
+private:
+    ShadowOptions mOptions;
+    glm::vec3 mRight {1.0f, 0.0f, 0.0f}; // light space basis
+    glm::vec3 mUp {0.0f, 1.0f, 0.0f};
+    std::uint64_t mStaticVersion = 0;
+    std::uint64_t mNextKey = 0;
+    std::vector<ShadowCascade> mCascades;
+    std::array<Placement, MAX_CASCADES> mPlacements {};
+    ShadowStats mStats;
+};
+}
+
+#endif // SHADOWCASCADES_H
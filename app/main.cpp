@@ -1,12 +1,25 @@
+#include "BatchApp.h"
 #include "DemoApp.h"
 #include <Log.h>
+#include <core/StartupTimeline.h>
 
 int main(int argc, char *argv[])
 {
-    app::DemoApp demo{argc, argv};
+    rw::LoggerGuard logger;
+    // startup phases are reported relative to this point
+    rw::StartupTimeline::get();
     try
     {
-        demo.run();
+        if (app::BatchApp::isBatchMode(argc, argv))
+        {
+            app::BatchApp batch{argc, argv};
+            batch.run();
+        }
+        else
+        {
+            app::DemoApp demo{argc, argv};
+            demo.run();
+        }
     } catch(std::exception &e)
     {
         ELOG("Throw: {}", e.what());
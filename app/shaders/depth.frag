@@ -0,0 +1,6 @@
+#version 450
+
+// depth only: shadow maps and the depth prepass
+void main()
+{
+}
@@ -0,0 +1,102 @@
+// Clustered lights and the key light's shadow cascades, shared by mesh.frag and resolve.frag.
+// Descriptor set 0 of both pipelines.
+
+struct Light {
+    vec4 positionRange;
+    vec4 colorType;
+    vec4 directionCos;
+    vec4 spot;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Lights { Light lights[]; };
+layout(std430, set = 0, binding = 1) readonly buffer Clusters { uvec2 clusters[]; };
+layout(std430, set = 0, binding = 2) readonly buffer Indices { uint indices[]; };
+layout(std430, set = 0, binding = 3) readonly buffer Shadow {
+    mat4 cascades[4];
+    vec4 splits;         // view depth where each cascade ends
+    vec4 lightDirection; // towards the key light
+    uvec4 info;          // cascade count, dynamic layers drawn
+} shadow;
+// static layers first, then one dynamic layer per cascade
+layout(set = 0, binding = 4) uniform sampler2DArrayShadow shadowMap;
+
+const vec3 LIGHT_DIR = normalize(vec3(0.4, 1.0, 0.6)); // key light while shadows are off
+const uint LIGHT_SPOT = 1u;
+const uint MAX_CASCADES = 4u;
+
+// grid: tiles x, tiles y, depth slices, light count; slicing: slice = log(depth) * x + y.
+// The cluster is found from the ndc position, so it does not depend on the render resolution.
+uint clusterIndex(vec2 ndc, float depth, uvec4 grid, vec4 slicing)
+{
+    uvec2 tile = uvec2(clamp(floor((ndc * 0.5 + 0.5) * vec2(grid.xy)), vec2(0.0), vec2(grid.xy - 1u)));
+    uint slice = uint(clamp(floor(log(depth) * slicing.x + slicing.y), 0.0, float(grid.z - 1u)));
+    return (slice * grid.y + tile.y) * grid.x + tile.x;
+}
+
+// fraction of the key light reaching the position, both layers of the cascade are tested
+float keyLightVisibility(vec3 worldPosition, float depth)
+{
+    uint count = shadow.info.x;
+    if (count == 0u) return 1.0;
+
+    uint cascade = 0u;
+    while (cascade + 1u < count && depth > shadow.splits[cascade]) ++cascade;
+    if (depth > shadow.splits[count - 1u]) return 1.0;
+
+    vec3 coord = (shadow.cascades[cascade] * vec4(worldPosition, 1.0)).xyz;
+    vec2 uv = coord.xy * 0.5 + 0.5;
+    if (coord.z >= 1.0) return 1.0;
+
+    // 2x2 taps on top of the hardware 2x2 filter; single level, explicit gradients as this runs
+    // in non uniform control flow
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float visibility = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        vec2 offset = (vec2(i & 1, i >> 1) - 0.5) * texel;
+        float lit = textureGrad(shadowMap, vec4(uv + offset, float(cascade), coord.z), vec2(0.0), vec2(0.0));
+        if (shadow.info.y != 0u)
+        {
+            lit *= textureGrad(shadowMap, vec4(uv + offset, float(MAX_CASCADES + cascade), coord.z), vec2(0.0), vec2(0.0));
+        }
+        visibility += lit;
+    }
+    return visibility * 0.25;
+}
+
+vec3 shadeLight(Light light, vec3 worldPosition, vec3 normal)
+{
+    vec3 toLight = light.positionRange.xyz - worldPosition;
+    float distance2 = dot(toLight, toLight);
+    float range = light.positionRange.w;
+    if (distance2 >= range * range) return vec3(0.0);
+
+    vec3 L = toLight * inversesqrt(max(distance2, 1e-8));
+    float ratio2 = distance2 / (range * range);
+    float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+    float attenuation = window * window / (distance2 + 1.0);
+    if (uint(light.colorType.w) == LIGHT_SPOT)
+    {
+        attenuation *= smoothstep(light.directionCos.w, light.spot.x, dot(-L, light.directionCos.xyz));
+    }
+    return light.colorType.rgb * (max(dot(normal, L), 0.0) * attenuation);
+}
+
+// light reaching a surface, depth is its view depth
+vec3 lighting(vec3 worldPosition, vec3 normal, vec2 ndc, float depth, uvec4 grid, vec4 slicing)
+{
+    vec3 toKeyLight = shadow.info.x > 0u ? shadow.lightDirection.xyz : LIGHT_DIR;
+    float diffuse = max(dot(normal, toKeyLight), 0.0);
+    if (diffuse > 0.0) diffuse *= keyLightVisibility(worldPosition, depth);
+    vec3 light = vec3(0.25 + 0.75 * diffuse);
+
+    if (grid.w > 0u)
+    {
+        uvec2 range = clusters[clusterIndex(ndc, depth, grid, slicing)];
+        for (uint i = 0u; i < range.y; ++i)
+        {
+            light += shadeLight(lights[indices[range.x + i]], worldPosition, normal);
+        }
+    }
+    return light;
+}
@@ -0,0 +1,25 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec3 inWorldPosition;
+layout(location = 3) in vec4 inClipPosition;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 5) uniform View {
+    mat4 viewProjection;
+    vec4 viewDepth; // dot with a world position gives its view depth
+    uvec4 grid;     // tiles x, tiles y, depth slices, light count
+    vec4 slicing;   // slice = log(depth) * x + y
+} view;
+
+#include "lighting.glsl"
+
+void main()
+{
+    float depth = max(dot(view.viewDepth, vec4(inWorldPosition, 1.0)), 1e-4);
+    vec2 ndc = inClipPosition.xy / inClipPosition.w;
+    outColor = vec4(inColor.rgb * lighting(inWorldPosition, normalize(inNormal), ndc, depth, view.grid, view.slicing), inColor.a);
+}
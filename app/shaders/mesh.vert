@@ -0,0 +1,35 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUV;
+
+// per instance
+layout(location = 3) in mat4 instanceModel;
+layout(location = 7) in vec4 instanceColor;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) out vec3 outWorldPosition;
+layout(location = 3) out vec4 outClipPosition;
+
+// the depth prepass runs this shader in another pipeline, its depth must match bit for bit
+invariant gl_Position;
+
+// the frame's camera, read from a buffer so pre-recorded command buffers stay valid as it moves
+layout(set = 0, binding = 5) uniform View {
+    mat4 viewProjection;
+    vec4 viewDepth;
+    uvec4 grid;
+    vec4 slicing;
+} view;
+
+void main()
+{
+    vec4 worldPosition = instanceModel * vec4(inPosition, 1.0);
+    gl_Position = view.viewProjection * worldPosition;
+    outNormal = normalize(mat3(instanceModel) * inNormal);
+    outColor = instanceColor;
+    outWorldPosition = worldPosition.xyz;
+    outClipPosition = gl_Position;
+}
@@ -0,0 +1,25 @@
+#version 450
+
+layout(location = 0) out vec4 outColor;
+
+// written by the point rasterization passes on the compute queue
+layout(std430, set = 0, binding = 0) readonly buffer Target { uvec2 pixels[]; }; // color, depth bits
+
+layout(push_constant) uniform Push {
+    uvec4 target; // width, height
+} push;
+
+const uint EMPTY = 0xffffffffu;
+
+void main()
+{
+    uvec2 coord = uvec2(gl_FragCoord.xy);
+    if (any(greaterThanEqual(coord, push.target.xy))) discard;
+    uvec2 point = pixels[coord.y * push.target.x + coord.x];
+    if (point.y == EMPTY) discard;
+
+    // the scan colors are sRGB, the render target expects linear values
+    vec4 color = unpackUnorm4x8(point.x);
+    outColor = vec4(pow(color.rgb, vec3(2.2)), color.a);
+    gl_FragDepth = uintBitsToFloat(point.y);
+}
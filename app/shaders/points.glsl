@@ -0,0 +1,37 @@
+// Shared by the point rasterization passes: each workgroup projects one batch of points and
+// hands the visible ones to rasterize(), which the including shader defines after its target.
+
+layout(local_size_x = 256) in;
+
+struct Point {
+    vec3 position;
+    uint color; // RGBA8, sRGB encoded
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Points { Point points[]; };
+// first point and count of every batch
+layout(std430, set = 0, binding = 1) readonly buffer Batches { uvec2 batches[]; };
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+    uvec4 target; // width, height, batch of the first workgroup
+} push;
+
+void rasterize(uint color, uint pixel, uint depthBits);
+
+void main()
+{
+    uvec2 batch = batches[push.target.z + gl_WorkGroupID.x];
+    for (uint i = gl_LocalInvocationID.x; i < batch.y; i += gl_WorkGroupSize.x)
+    {
+        Point point = points[batch.x + i];
+        vec4 clip = push.viewProjection * vec4(point.position, 1.0);
+        if (clip.w <= 0.0) continue;
+        vec3 ndc = clip.xyz / clip.w;
+        if (any(lessThan(ndc, vec3(-1.0, -1.0, 0.0))) || any(greaterThanEqual(ndc, vec3(1.0)))) continue;
+
+        // positive floats order like their bits, so the depth compares as an unsigned integer
+        uvec2 coord = min(uvec2((ndc.xy * 0.5 + 0.5) * vec2(push.target.xy)), push.target.xy - 1u);
+        rasterize(point.color, coord.y * push.target.x + coord.x, floatBitsToUint(ndc.z));
+    }
+}
@@ -0,0 +1,52 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout(location = 0) out vec4 outColor;
+
+layout(push_constant) uniform Push {
+    mat4 inverseViewProjection;
+    vec4 viewDepth; // dot with a world position gives its view depth
+    uvec4 grid;     // tiles x, tiles y, depth slices, light count
+    vec4 slicing;   // slice = log(depth) * x + y, then the size of a pixel in ndc
+} push;
+
+#include "lighting.glsl"
+
+struct Instance {
+    mat4 model;
+    vec4 color;
+};
+
+layout(set = 1, binding = 0) uniform usampler2D visibility;
+layout(set = 1, binding = 1) uniform sampler2D depthBuffer;
+layout(std430, set = 1, binding = 2) readonly buffer Instances { Instance instances[]; };
+
+const uint NO_INSTANCE = 0xffffffffu;
+
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+// one invocation per pixel of the scene extent, whatever the overdraw of the visibility pass
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    uvec2 visible = texelFetch(visibility, pixel, 0).xy;
+    if (visible.x == NO_INSTANCE) discard;
+
+    // later passes of the scene depth test against the resolved surface
+    float clipDepth = texelFetch(depthBuffer, pixel, 0).r;
+    gl_FragDepth = clipDepth;
+
+    vec2 ndc = gl_FragCoord.xy * push.slicing.zw - 1.0;
+    vec4 world = push.inverseViewProjection * vec4(ndc, clipDepth, 1.0);
+    vec3 worldPosition = world.xyz / world.w;
+    float depth = max(dot(push.viewDepth, vec4(worldPosition, 1.0)), 1e-4);
+    vec3 normal = decodeNormal(unpackSnorm2x16(visible.y));
+
+    vec4 color = instances[visible.x].color;
+    outColor = vec4(color.rgb * lighting(worldPosition, normal, ndc, depth, push.grid, push.slicing), color.a);
+}
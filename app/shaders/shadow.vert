@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+
+// per instance
+layout(location = 3) in mat4 instanceModel;
+
+layout(push_constant) uniform Push {
+    mat4 lightViewProjection;
+} push;
+
+void main()
+{
+    gl_Position = push.lightViewProjection * instanceModel * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) in vec2 inUV;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D scene;
+
+layout(push_constant) uniform Push {
+    vec2 uvScale; // rendered part of the target
+    vec2 uvMax;   // half a texel inside it, keeps the filter off the stale texels around it
+} push;
+
+void main()
+{
+    outColor = texture(scene, min(inUV * push.uvScale, push.uvMax));
+}
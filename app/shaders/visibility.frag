@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) flat in uint inInstance;
+
+// instance, octahedral normal as two snorm16
+layout(location = 0) out uvec2 outVisibility;
+
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : folded;
+}
+
+void main()
+{
+    outVisibility = uvec2(inInstance, packSnorm2x16(encodeNormal(normalize(inNormal))));
+}
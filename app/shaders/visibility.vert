@@ -0,0 +1,24 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUV;
+
+// per instance
+layout(location = 3) in mat4 instanceModel;
+layout(location = 7) in vec4 instanceColor;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) flat out uint outInstance;
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+} push;
+
+void main()
+{
+    gl_Position = push.viewProjection * instanceModel * vec4(inPosition, 1.0);
+    outNormal = mat3(instanceModel) * inNormal;
+    // includes the draw's first instance, indexes the frame's instance buffer
+    outInstance = uint(gl_InstanceIndex);
+}
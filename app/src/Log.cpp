@@ -0,0 +1,75 @@
+#include <Log.h>
+#include <core/Clock.h>
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace rw {
+
+namespace {
+std::atomic<std::uint64_t> gSuppressed{0};
+
+spdlog::level::level_enum toSpdlogLevel(int level)
+{
+    switch (level)
+    {
+    case RW_LOG_LEVEL_DEBUG: return spdlog::level::debug;
+    case RW_LOG_LEVEL_INFO: return spdlog::level::info;
+    case RW_LOG_LEVEL_WARN: return spdlog::level::warn;
+    case RW_LOG_LEVEL_ERROR: return spdlog::level::err;
+    default: return spdlog::level::off;
+    }
+}
+} // namespace
+
+void initLogger(std::size_t queueSize)
+{
+#ifdef LOGGER_ENABLED
+    // one background thread; the queue is allocated once here and messages
+    // short enough for spdlog's inline buffer never touch the heap afterwards
+    spdlog::init_thread_pool(queueSize, 1);
+    auto logger = spdlog::create_async_nb<spdlog::sinks::stdout_color_sink_mt>("rw");
+    logger->set_level(toSpdlogLevel(RW_LOG_LEVEL));
+    // errors are usually followed by a crash or exit, so push them out right away
+    logger->flush_on(spdlog::level::err);
+    spdlog::set_default_logger(logger);
+#else
+    UNUSE(queueSize);
+#endif
+}
+
+void shutdownLogger()
+{
+#ifdef LOGGER_ENABLED
+    spdlog::shutdown();
+#endif
+}
+
+LoggerStats getLoggerStats()
+{
+    LoggerStats stats{};
+#ifdef LOGGER_ENABLED
+    if (auto pool = spdlog::thread_pool())
+    {
+        stats.overruns = pool->overrun_counter();
+    }
+#endif
+    stats.suppressed = gSuppressed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool LogRateLimiter::allow(std::uint64_t &suppressed)
+{
+    const auto now = nowNs();
+    auto next = mNextNs.load(std::memory_order_relaxed);
+    if (now < next || !mNextNs.compare_exchange_strong(next, now + mIntervalNs, std::memory_order_relaxed))
+    {
+        mSuppressed.fetch_add(1, std::memory_order_relaxed);
+        gSuppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = mSuppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace rw
@@ -1,18 +1,20 @@
 #include <Window.h>
 #include <Input.h>
 #include <Log.h>
+#include <core/Clock.h>
 #include <memory>
 
 namespace rw
 {
 
-Window::Window(const std::string &title, const std::int32_t &width, const int32_t &height) : mWindow {nullptr}, mWidth {width}, mHeight{height}, mWasResized{false}, mInput{nullptr}
+Window::Window(const std::string &title, const std::int32_t &width, const int32_t &height, bool visible) : mWindow {nullptr}, mWidth {width}, mHeight{height}, mWasResized{false}, mInput{nullptr}
 {
     glfwSetErrorCallback([](int code, const char *desc) -> void {
         LOG("GLFW {}: {}", code, desc);
     });
     glfwInit();
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
     mWindow = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
     if (!mWindow)
     {
@@ -22,6 +24,9 @@ Window::Window(const std::string &title, const std::int32_t &width, const int32_
     mInput = std::make_shared<Input>();
 
     glfwSetKeyCallback(mWindow, &Window::key_callback);
+    glfwSetMouseButtonCallback(mWindow, &Window::mouse_button_callback);
+    glfwSetCursorPosCallback(mWindow, &Window::cursor_position_callback);
+    glfwSetScrollCallback(mWindow, &Window::scroll_callback);
     glfwSetFramebufferSizeCallback(mWindow, &Window::framebuffer_size_callback);
 }
 
@@ -34,25 +39,42 @@ Window::~Window()
     glfwTerminate();
 }
 
-void Window::createSurface(VkInstance instance, VkSurfaceKHR *surface)
+void Window::createSurface(VkInstance instance, const VkAllocationCallbacks *allocator, VkSurfaceKHR *surface)
 {
-    VK_CHECK(glfwCreateWindowSurface(instance, mWindow, nullptr, surface), "Failed to create window surface");
+    VK_CHECK(glfwCreateWindowSurface(instance, mWindow, allocator, surface), "Failed to create window surface");
 }
 
 void Window::framebuffer_size_callback(GLFWwindow *win, int width, int height)
 {
     auto internalWin = reinterpret_cast<Window*>(glfwGetWindowUserPointer(win));
-    internalWin->mWidth = width;
-    internalWin->mHeight = height;
-    internalWin->mWasResized = true;
+    internalWin->mWidth.store(width, std::memory_order_release);
+    internalWin->mHeight.store(height, std::memory_order_release);
+    internalWin->mWasResized.store(true, std::memory_order_release);
 }
 
 void Window::key_callback(GLFWwindow *win, int key, int scancode, int action, int mods)
 {
     UNUSE(scancode);
-    UNUSE(mods);
     auto internalWin = reinterpret_cast<Window*>(glfwGetWindowUserPointer(win));
-    internalWin->mInput->mKeys[key] = action;
+    internalWin->mInput->pushEvent(InputEvent {InputEventType::Key, key, action, mods, 0.0, 0.0, nowNs()});
+}
+
+void Window::mouse_button_callback(GLFWwindow *win, int button, int action, int mods)
+{
+    auto internalWin = reinterpret_cast<Window*>(glfwGetWindowUserPointer(win));
+    internalWin->mInput->pushEvent(InputEvent {InputEventType::MouseButton, button, action, mods, 0.0, 0.0, nowNs()});
+}
+
+void Window::cursor_position_callback(GLFWwindow *win, double x, double y)
+{
+    auto internalWin = reinterpret_cast<Window*>(glfwGetWindowUserPointer(win));
+    internalWin->mInput->pushEvent(InputEvent {InputEventType::CursorPosition, 0, 0, 0, x, y, nowNs()});
+}
+
+void Window::scroll_callback(GLFWwindow *win, double xoffset, double yoffset)
+{
+    auto internalWin = reinterpret_cast<Window*>(glfwGetWindowUserPointer(win));
+    internalWin->mInput->pushEvent(InputEvent {InputEventType::Scroll, 0, 0, 0, xoffset, yoffset, nowNs()});
 }
 
 }
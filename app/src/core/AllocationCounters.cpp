@@ -0,0 +1,87 @@
+#include <core/AllocationCounters.h>
+#include <core/SpscRing.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace rw {
+namespace {
+struct alignas(CACHE_LINE_SIZE) TagCounter {
+    std::atomic<std::uint64_t> allocations {0};
+    std::atomic<std::uint64_t> bytes {0};
+};
+
+TagCounter sCounters[static_cast<std::size_t>(AllocationTag::Count)];
+thread_local AllocationTag tTag = AllocationTag::Other;
+
+void countAllocation(std::size_t size)
+{
+    auto &counter = sCounters[static_cast<std::size_t>(tTag)];
+    counter.allocations.fetch_add(1, std::memory_order_relaxed);
+    counter.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+} // namespace
+
+AllocationCount getAllocationCount(AllocationTag tag)
+{
+    const auto &counter = sCounters[static_cast<std::size_t>(tag)];
+    return AllocationCount{counter.allocations.load(std::memory_order_relaxed), counter.bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationTag getAllocationTag()
+{
+    return tTag;
+}
+
+const char *getAllocationTagName(AllocationTag tag)
+{
+    switch (tag)
+    {
+    case AllocationTag::Frame:
+        return "frame";
+    case AllocationTag::Render:
+        return "render";
+    case AllocationTag::Streaming:
+        return "streaming";
+    case AllocationTag::Loading:
+        return "loading";
+    default:
+        return "other";
+    }
+}
+
+AllocationScope::AllocationScope(AllocationTag tag) : mPrevious{tTag}
+{
+    tTag = tag;
+}
+
+AllocationScope::~AllocationScope()
+{
+    tTag = mPrevious;
+}
+}
+
+// The default array and nothrow forms forward to these.
+void *operator new(std::size_t size)
+{
+    rw::countAllocation(size);
+    if (size == 0) size = 1;
+    for (;;)
+    {
+        if (void *memory = std::malloc(size)) return memory;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,136 @@
+#include <core/FileWatcher.h>
+#include <Log.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace rw {
+namespace {
+constexpr int WAKE_MS = 100; // how long the thread may take to notice shutdown
+
+void addUnique(std::vector<std::filesystem::path> &paths, const std::filesystem::path &path)
+{
+    if (std::find(paths.begin(), paths.end(), path) == paths.end()) paths.push_back(path);
+}
+} // namespace
+
+FileWatcher::FileWatcher(std::vector<std::filesystem::path> files, Callback callback, std::chrono::milliseconds debounce)
+    : mCallback(std::move(callback))
+    , mDebounce(debounce)
+{
+    for (const auto &file : files)
+    {
+        std::error_code error;
+        auto path = std::filesystem::weakly_canonical(file, error);
+        addUnique(mFiles, error ? std::filesystem::absolute(file) : path);
+    }
+
+#ifdef __linux__
+    mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mFd < 0)
+    {
+        WLOG("File watching unavailable, inotify_init1 failed");
+        return;
+    }
+    for (const auto &file : mFiles)
+    {
+        const auto directory = file.parent_path();
+        if (std::any_of(mDirectories.begin(), mDirectories.end(), [&directory](const auto &watch) { return watch.second == directory; })) continue;
+        const int wd = inotify_add_watch(mFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            WLOG("Cannot watch {}", directory.string());
+            continue;
+        }
+        mDirectories.emplace_back(wd, directory);
+    }
+#else
+    for (const auto &file : mFiles)
+    {
+        std::error_code error;
+        mWriteTimes.push_back(std::filesystem::last_write_time(file, error));
+    }
+#endif
+
+    mThread = std::thread([this]() { run(); });
+}
+
+FileWatcher::~FileWatcher()
+{
+    mRunning = false;
+    if (mThread.joinable()) mThread.join();
+#ifdef __linux__
+    if (mFd >= 0) close(mFd);
+#endif
+}
+
+void FileWatcher::run()
+{
+    std::vector<std::filesystem::path> pending;
+    auto lastChange = std::chrono::steady_clock::now();
+    while (mRunning)
+    {
+        if (waitForChanges(pending))
+        {
+            lastChange = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (!pending.empty() && std::chrono::steady_clock::now() - lastChange >= mDebounce)
+        {
+            mCallback(pending);
+            pending.clear();
+        }
+    }
+}
+
+#ifdef __linux__
+bool FileWatcher::waitForChanges(std::vector<std::filesystem::path> &changed)
+{
+    pollfd descriptor {mFd, POLLIN, 0};
+    if (poll(&descriptor, 1, WAKE_MS) <= 0) return false;
+
+    alignas(inotify_event) char buffer[4096];
+    bool found = false;
+    for (;;)
+    {
+        const ssize_t length = read(mFd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0) continue;
+
+            const auto watch = std::find_if(mDirectories.begin(), mDirectories.end(), [event](const auto &entry) { return entry.first == event->wd; });
+            if (watch == mDirectories.end()) continue;
+            const auto path = watch->second / event->name;
+            if (std::find(mFiles.begin(), mFiles.end(), path) == mFiles.end()) continue;
+            addUnique(changed, path);
+            found = true;
+        }
+    }
+    return found;
+}
+#else
+bool FileWatcher::waitForChanges(std::vector<std::filesystem::path> &changed)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(WAKE_MS));
+    bool found = false;
+    for (std::size_t i = 0; i < mFiles.size(); ++i)
+    {
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(mFiles[i], error);
+        if (error || time == mWriteTimes[i]) continue;
+        mWriteTimes[i] = time;
+        addUnique(changed, mFiles[i]);
+        found = true;
+    }
+    return found;
+}
+#endif
+}
@@ -0,0 +1,51 @@
+#include <core/FrameScheduler.h>
+
+namespace rw {
+void FrameScheduler::requestRedraw(RedrawReason reason)
+{
+    const auto previous = mReasons.fetch_or(static_cast<std::uint32_t>(reason), std::memory_order_acq_rel);
+    if (previous == 0 && mWake)
+    {
+        mWake();
+    }
+}
+
+bool FrameScheduler::needsRedraw() const
+{
+    return mMode == Mode::Continuous || mAnimating || mReasons.load(std::memory_order_acquire) != 0;
+}
+
+std::uint32_t FrameScheduler::takeRedrawReasons()
+{
+    std::uint32_t reasons = mReasons.exchange(0, std::memory_order_acq_rel);
+    if (mAnimating) reasons |= static_cast<std::uint32_t>(RedrawReason::Animation);
+    return reasons;
+}
+
+bool FrameScheduler::runIdleTask()
+{
+    if (mIdleTasks.empty()) return false;
+
+    IdleTask task = std::move(mIdleTasks.front());
+    mIdleTasks.pop_front();
+    if (task())
+    {
+        // more work left, round robin with the other refinement tasks
+        mIdleTasks.push_back(std::move(task));
+    }
+    return true;
+}
+
+double FrameScheduler::getWaitTimeout(bool rendererBusy) const
+{
+    if (needsRedraw())
+    {
+        return rendererBusy ? BUSY_TIMEOUT : 0.0;
+    }
+    if (!mIdleTasks.empty())
+    {
+        return 0.0;
+    }
+    return IDLE_TIMEOUT;
+}
+}
@@ -0,0 +1,301 @@
+#include <core/ImageEncoder.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace rw {
+namespace {
+class ByteWriter {
+public:
+    void u8(std::uint8_t v) { mBytes.push_back(v); }
+    void u32be(std::uint32_t v)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8) u8(static_cast<std::uint8_t>(v >> shift));
+    }
+    void u16le(std::uint16_t v)
+    {
+        u8(static_cast<std::uint8_t>(v));
+        u8(static_cast<std::uint8_t>(v >> 8));
+    }
+    void u32le(std::uint32_t v)
+    {
+        for (int shift = 0; shift < 32; shift += 8) u8(static_cast<std::uint8_t>(v >> shift));
+    }
+    void u64le(std::uint64_t v)
+    {
+        for (int shift = 0; shift < 64; shift += 8) u8(static_cast<std::uint8_t>(v >> shift));
+    }
+    void f32le(float v)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        u32le(bits);
+    }
+    void str(const char *s) { bytes(s, std::strlen(s) + 1); }
+    void bytes(const void *data, std::size_t size)
+    {
+        const auto *p = static_cast<const std::uint8_t *>(data);
+        mBytes.insert(mBytes.end(), p, p + size);
+    }
+
+    std::vector<std::uint8_t> &get() { return mBytes; }
+
+private:
+    std::vector<std::uint8_t> mBytes;
+};
+
+std::uint64_t writeFile(const std::string &path, const std::vector<std::uint8_t> &bytes)
+{
+    std::ofstream file {path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) throw std::runtime_error("Failed to write " + path);
+    return bytes.size();
+}
+
+// pixel x of row y as r, g, b, a
+inline const std::uint8_t *pixelAt(const ImageView &image, std::uint32_t x, std::uint32_t y)
+{
+    return image.pixels + static_cast<std::size_t>(y) * image.rowPitch + static_cast<std::size_t>(x) * 4;
+}
+
+inline void loadRgba(const ImageView &image, std::uint32_t x, std::uint32_t y, std::uint8_t out[4])
+{
+    const std::uint8_t *p = pixelAt(image, x, y);
+    out[0] = image.bgra ? p[2] : p[0];
+    out[1] = p[1];
+    out[2] = image.bgra ? p[0] : p[2];
+    out[3] = p[3];
+}
+
+const std::array<std::uint32_t, 256> &crcTable()
+{
+    static const std::array<std::uint32_t, 256> table = []() {
+        std::array<std::uint32_t, 256> t {};
+        for (std::uint32_t n = 0; n < 256; ++n)
+        {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+std::uint32_t crc32(const std::uint8_t *data, std::size_t size)
+{
+    const auto &table = crcTable();
+    std::uint32_t c = 0xffffffffu;
+    for (std::size_t i = 0; i < size; ++i) c = table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+    return c ^ 0xffffffffu;
+}
+
+void pngChunk(ByteWriter &out, const char *type, const std::vector<std::uint8_t> &data)
+{
+    out.u32be(static_cast<std::uint32_t>(data.size()));
+    const std::size_t start = out.get().size();
+    out.bytes(type, 4);
+    out.bytes(data.data(), data.size());
+    out.u32be(crc32(out.get().data() + start, out.get().size() - start));
+}
+
+std::vector<std::uint8_t> encodePng(const ImageView &image)
+{
+    // filter byte 0 followed by RGB triplets, alpha of a swap chain image carries nothing
+    const std::size_t rowSize = 1 + static_cast<std::size_t>(image.width) * 3;
+    std::vector<std::uint8_t> raw(rowSize * image.height);
+    for (std::uint32_t y = 0; y < image.height; ++y)
+    {
+        std::uint8_t *row = raw.data() + y * rowSize;
+        row[0] = 0;
+        for (std::uint32_t x = 0; x < image.width; ++x)
+        {
+            std::uint8_t rgba[4];
+            loadRgba(image, x, y, rgba);
+            std::memcpy(row + 1 + x * 3, rgba, 3);
+        }
+    }
+
+    // zlib stream made of stored deflate blocks
+    ByteWriter zlib;
+    zlib.u8(0x78);
+    zlib.u8(0x01);
+    constexpr std::size_t maxBlock = 65535;
+    for (std::size_t offset = 0; offset < raw.size(); offset += maxBlock)
+    {
+        const std::size_t size = std::min(maxBlock, raw.size() - offset);
+        zlib.u8(offset + size == raw.size() ? 1 : 0); // final block flag
+        zlib.u16le(static_cast<std::uint16_t>(size));
+        zlib.u16le(static_cast<std::uint16_t>(~size));
+        zlib.bytes(raw.data() + offset, size);
+    }
+    std::uint32_t a = 1, b = 0;
+    for (std::uint8_t v : raw)
+    {
+        a = (a + v) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    zlib.u32be((b << 16) | a);
+
+    ByteWriter header;
+    header.u32be(image.width);
+    header.u32be(image.height);
+    header.u8(8); // bit depth
+    header.u8(2); // truecolor
+    header.u8(0);
+    header.u8(0);
+    header.u8(0);
+
+    ByteWriter png;
+    const std::uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    png.bytes(signature, sizeof(signature));
+    pngChunk(png, "IHDR", header.get());
+    if (image.srgb) pngChunk(png, "sRGB", {0});
+    pngChunk(png, "IDAT", zlib.get());
+    pngChunk(png, "IEND", {});
+    return std::move(png.get());
+}
+
+std::uint16_t toHalf(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint32_t sign = (bits >> 16) & 0x8000u;
+    const std::int32_t exponent = static_cast<std::int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    const std::uint32_t mantissa = bits & 0x7fffffu;
+    if (exponent <= 0) return static_cast<std::uint16_t>(sign); // colors this small are black anyway
+    if (exponent >= 31) return static_cast<std::uint16_t>(sign | 0x7c00u);
+    // round to nearest
+    std::uint32_t half = sign | (static_cast<std::uint32_t>(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000u) ++half;
+    return static_cast<std::uint16_t>(half);
+}
+
+std::vector<std::uint8_t> encodeExr(const ImageView &image)
+{
+    std::array<std::uint16_t, 256> toLinear {};
+    for (std::uint32_t i = 0; i < 256; ++i)
+    {
+        const float c = static_cast<float>(i) / 255.0f;
+        const float linear = image.srgb ? (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f)) : c;
+        toLinear[i] = toHalf(linear);
+    }
+
+    ByteWriter exr;
+    exr.u32le(20000630u); // magic
+    exr.u32le(2u);        // version 2, single part scanline
+
+    const auto attribute = [&exr](const char *name, const char *type, std::uint32_t size) {
+        exr.str(name);
+        exr.str(type);
+        exr.u32le(size);
+    };
+    // channels are stored in alphabetical order
+    const char *channels[] = {"B", "G", "R"};
+    attribute("channels", "chlist", 3 * (2 + 16) + 1);
+    for (const char *name : channels)
+    {
+        exr.str(name);
+        exr.u32le(1); // HALF
+        exr.u32le(0); // pLinear + reserved
+        exr.u32le(1); // x sampling
+        exr.u32le(1); // y sampling
+    }
+    exr.u8(0);
+    attribute("compression", "compression", 1);
+    exr.u8(0);
+    for (const char *window : {"dataWindow", "displayWindow"})
+    {
+        attribute(window, "box2i", 16);
+        exr.u32le(0);
+        exr.u32le(0);
+        exr.u32le(image.width - 1);
+        exr.u32le(image.height - 1);
+    }
+    attribute("lineOrder", "lineOrder", 1);
+    exr.u8(0);
+    attribute("pixelAspectRatio", "float", 4);
+    exr.f32le(1.0f);
+    attribute("screenWindowCenter", "v2f", 8);
+    exr.f32le(0.0f);
+    exr.f32le(0.0f);
+    attribute("screenWindowWidth", "float", 4);
+    exr.f32le(1.0f);
+    exr.u8(0); // end of header
+
+    const std::uint32_t lineBytes = image.width * 3 * 2;
+    std::uint64_t offset = exr.get().size() + static_cast<std::uint64_t>(image.height) * 8;
+    for (std::uint32_t y = 0; y < image.height; ++y)
+    {
+        exr.u64le(offset);
+        offset += 8 + lineBytes;
+    }
+    for (std::uint32_t y = 0; y < image.height; ++y)
+    {
+        exr.u32le(y);
+        exr.u32le(lineBytes);
+        for (int channel = 2; channel >= 0; --channel) // B, G, R
+        {
+            for (std::uint32_t x = 0; x < image.width; ++x)
+            {
+                std::uint8_t rgba[4];
+                loadRgba(image, x, y, rgba);
+                exr.u16le(toLinear[rgba[channel]]);
+            }
+        }
+    }
+    return std::move(exr.get());
+}
+
+std::vector<std::uint8_t> encodeRaw(const ImageView &image)
+{
+    std::vector<std::uint8_t> raw(static_cast<std::size_t>(image.width) * image.height * 4);
+    for (std::uint32_t y = 0; y < image.height; ++y)
+    {
+        for (std::uint32_t x = 0; x < image.width; ++x)
+        {
+            loadRgba(image, x, y, raw.data() + (static_cast<std::size_t>(y) * image.width + x) * 4);
+        }
+    }
+    return raw;
+}
+}
+
+bool parseImageFormat(const std::string &name, ImageFormat &format)
+{
+    if (name == "png") format = ImageFormat::Png;
+    else if (name == "exr") format = ImageFormat::Exr;
+    else if (name == "raw") format = ImageFormat::Raw;
+    else return false;
+    return true;
+}
+
+const char *getImageExtension(ImageFormat format)
+{
+    switch (format)
+    {
+    case ImageFormat::Png: return "png";
+    case ImageFormat::Exr: return "exr";
+    case ImageFormat::Raw: return "rgba";
+    }
+    return "bin";
+}
+
+std::uint64_t encodeImage(const ImageView &image, ImageFormat format, const std::string &path)
+{
+    if (!image.pixels || image.width == 0 || image.height == 0) throw std::runtime_error("Cannot encode an empty image");
+
+    switch (format)
+    {
+    case ImageFormat::Png: return writeFile(path, encodePng(image));
+    case ImageFormat::Exr: return writeFile(path, encodeExr(image));
+    case ImageFormat::Raw: return writeFile(path, encodeRaw(image));
+    }
+    return 0;
+}
+}
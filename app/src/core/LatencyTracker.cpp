@@ -0,0 +1,36 @@
+#include <core/LatencyTracker.h>
+#include <core/Clock.h>
+
+#include <algorithm>
+
+namespace rw {
+void LatencyTracker::onInputConsumed(std::uint64_t eventTimestamp)
+{
+    if (eventTimestamp == 0) return;
+    if (mPendingTimestamp == 0 || eventTimestamp < mPendingTimestamp)
+    {
+        mPendingTimestamp = eventTimestamp;
+    }
+}
+
+void LatencyTracker::onPresent(std::uint64_t presentTimestamp)
+{
+    if (mPendingTimestamp == 0) return;
+
+    const double latency = presentTimestamp > mPendingTimestamp ? nsToMs(presentTimestamp - mPendingTimestamp) : 0.0;
+    mPendingTimestamp = 0;
+
+    if (mStats.samples == 0)
+    {
+        mStats.minMs = latency;
+        mStats.maxMs = latency;
+        mTotalMs = 0.0;
+    }
+    mStats.lastMs = latency;
+    mStats.minMs = std::min(mStats.minMs, latency);
+    mStats.maxMs = std::max(mStats.maxMs, latency);
+    mTotalMs += latency;
+    mStats.samples++;
+    mStats.avgMs = mTotalMs / static_cast<double>(mStats.samples);
+}
+}
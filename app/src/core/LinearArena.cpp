@@ -0,0 +1,77 @@
+#include <core/LinearArena.h>
+
+#include <algorithm>
+
+namespace rw {
+LinearArena::LinearArena(std::size_t blockSize) : mBlockSize {std::max<std::size_t>(blockSize, 64)}
+{
+}
+
+void LinearArena::addBlock(std::size_t minSize)
+{
+    const std::size_t size = std::max(mBlockSize, minSize);
+    mBlocks.push_back(Block {std::make_unique<std::byte[]>(size), size});
+    ++mBlockAllocations;
+}
+
+void *LinearArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    for (;;)
+    {
+        if (mCurrent < mBlocks.size())
+        {
+            auto &block = mBlocks[mCurrent];
+            const auto base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+            const std::size_t offset = ((base + mOffset + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1)) - base;
+            if (offset + bytes <= block.size)
+            {
+                mOffset = offset + bytes;
+                return block.memory.get() + offset;
+            }
+            // blocks after a rewound marker are reused before a new one is added
+            if (mCurrent + 1 < mBlocks.size())
+            {
+                ++mCurrent;
+                mOffset = 0;
+                continue;
+            }
+        }
+        addBlock(bytes + alignment);
+        mCurrent = mBlocks.size() - 1;
+        mOffset = 0;
+    }
+}
+
+void LinearArena::rewind(const Marker &marker)
+{
+    mCurrent = marker.block;
+    mOffset = marker.offset;
+    if (marker.block != 0 || marker.offset != 0 || mBlocks.size() < 2) return;
+
+    // the arena is empty again, replace the chain with one block holding all of it
+    std::size_t size = 0;
+    for (const auto &block : mBlocks) size += block.size;
+    mBlocks.clear();
+    addBlock(size);
+}
+
+ArenaStats LinearArena::getStats() const
+{
+    ArenaStats stats;
+    for (std::size_t i = 0; i < mBlocks.size(); ++i)
+    {
+        stats.capacity += mBlocks[i].size;
+        if (i < mCurrent) stats.used += mBlocks[i].size;
+    }
+    stats.used += mOffset;
+    stats.blockAllocations = mBlockAllocations;
+    return stats;
+}
+
+LinearArena &getThreadArena()
+{
+    // blocks are only taken on first use, threads which never ask cost nothing
+    thread_local LinearArena arena;
+    return arena;
+}
+}
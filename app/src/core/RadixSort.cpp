@@ -0,0 +1,87 @@
+#include <core/RadixSort.h>
+
+#include <algorithm>
+
+namespace rw {
+namespace {
+constexpr std::uint32_t DIGIT_BITS = 8;
+constexpr std::uint32_t DIGITS = 64 / DIGIT_BITS;
+// smaller blocks cost more in handing them to the workers than they save
+constexpr std::size_t MIN_BLOCK = 4096;
+}
+
+RadixSorter::RadixSorter(ThreadPool &pool) : mPool {pool}
+{
+}
+
+void RadixSorter::sort(std::vector<SortItem> &items)
+{
+    mStats = {};
+    mStats.items = items.size();
+    if (items.size() < 2) return;
+
+    const std::size_t count = items.size();
+    const std::size_t blocks = std::clamp<std::size_t>(count / MIN_BLOCK, 1, mPool.getThreadCount() + 1);
+    const std::size_t blockSize = (count + blocks - 1) / blocks;
+    mStats.blocks = static_cast<std::uint32_t>(blocks);
+    mScratch.resize(count);
+    mCounts.resize(blocks);
+    mDifferences.resize(blocks);
+
+    // at most one block per thread, so every parallelFor chunk is a whole block
+    const auto forEachBlock = [&](auto &&function) {
+        mPool.parallelFor(blocks, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t block = begin; block < end; ++block)
+            {
+                function(block, block * blockSize, std::min(count, (block + 1) * blockSize));
+            }
+        });
+    };
+
+    // keys of one frame usually share their upper fields, those digits need no pass
+    const std::uint64_t first = items[0].key;
+    forEachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+        std::uint64_t differences = 0;
+        for (std::size_t i = begin; i < end; ++i) differences |= items[i].key ^ first;
+        mDifferences[block] = differences;
+    });
+    std::uint64_t differences = 0;
+    for (auto blockDifferences : mDifferences) differences |= blockDifferences;
+
+    SortItem *source = items.data();
+    SortItem *target = mScratch.data();
+    for (std::uint32_t digit = 0; digit < DIGITS; ++digit)
+    {
+        const std::uint32_t shift = digit * DIGIT_BITS;
+        if (((differences >> shift) & (BUCKETS - 1)) == 0) continue;
+
+        forEachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+            auto &counts = mCounts[block];
+            counts.fill(0);
+            for (std::size_t i = begin; i < end; ++i) ++counts[(source[i].key >> shift) & (BUCKETS - 1)];
+        });
+
+        // offsets ordered by bucket, then by block, so each bucket keeps the order of the input
+        std::uint32_t offset = 0;
+        for (std::uint32_t bucket = 0; bucket < BUCKETS; ++bucket)
+        {
+            for (auto &counts : mCounts)
+            {
+                const std::uint32_t bucketCount = counts[bucket];
+                counts[bucket] = offset;
+                offset += bucketCount;
+            }
+        }
+
+        forEachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+            auto &offsets = mCounts[block];
+            for (std::size_t i = begin; i < end; ++i) target[offsets[(source[i].key >> shift) & (BUCKETS - 1)]++] = source[i];
+        });
+        std::swap(source, target);
+        ++mStats.passes;
+    }
+
+    // swapping keeps both buffers, and their capacity, for the next call
+    if (source != items.data()) items.swap(mScratch);
+}
+}
@@ -0,0 +1,67 @@
+#include <core/ResolutionController.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rw {
+namespace {
+constexpr double SMOOTHING = 0.25; // weight of the newest sample
+} // namespace
+
+ResolutionController::ResolutionController(const ResolutionOptions &options)
+    : mOptions(options)
+{
+    mOptions.minScale = std::clamp(mOptions.minScale, QUANTUM, 1.0f);
+    mOptions.maxScale = std::clamp(mOptions.maxScale, mOptions.minScale, 1.0f);
+    mScale = mOptions.maxScale;
+    mStats.scale = mStats.minScale = mStats.maxScale = mScale;
+}
+
+float ResolutionController::update(double gpuMs)
+{
+    if (gpuMs <= 0.0) return mScale;
+
+    // the first samples after a change were still rendered at the old scale
+    if (mSettle > 0)
+    {
+        --mSettle;
+        mSmoothedMs = gpuMs;
+        return mScale;
+    }
+    mSmoothedMs = mSmoothedMs > 0.0 ? mSmoothedMs + (gpuMs - mSmoothedMs) * SMOOTHING : gpuMs;
+    mStats.smoothedMs = mSmoothedMs;
+
+    const double target = mOptions.targetMs;
+    if (mSmoothedMs > target * OVER_BUDGET)
+    {
+        // at least one step, rounding must not keep a frame that is over budget at its scale
+        setScale(std::min(mScale * static_cast<float>(std::sqrt(target / mSmoothedMs)), mScale - QUANTUM));
+    }
+    else if (mSmoothedMs < target * UNDER_BUDGET && mScale < mOptions.maxScale)
+    {
+        // aim below the budget so the next step does not immediately overshoot it
+        const float wanted = mScale * static_cast<float>(std::sqrt(target * UNDER_BUDGET / mSmoothedMs));
+        setScale(std::min(wanted, mScale + MAX_GROWTH));
+    }
+    return mScale;
+}
+
+void ResolutionController::setScale(float scale)
+{
+    scale = std::clamp(std::round(scale / QUANTUM) * QUANTUM, mOptions.minScale, mOptions.maxScale);
+    if (scale == mScale) return;
+
+    mScale = scale;
+    mSettle = SETTLE_FRAMES;
+    mStats.scale = mScale;
+    mStats.minScale = std::min(mStats.minScale, mScale);
+    mStats.maxScale = std::max(mStats.maxScale, mScale);
+    ++mStats.changes;
+}
+
+void ResolutionController::resetStats()
+{
+    mStats.minScale = mStats.maxScale = mScale;
+    mStats.changes = 0;
+}
+}
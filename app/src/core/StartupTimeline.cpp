@@ -0,0 +1,65 @@
+#include <core/StartupTimeline.h>
+#include <core/Clock.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <algorithm>
+
+namespace rw {
+StartupTimeline &StartupTimeline::get()
+{
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+StartupTimeline::StartupTimeline() : mOriginNs{nowNs()}, mMainThread{std::this_thread::get_id()}
+{
+}
+
+void StartupTimeline::record(std::string name, std::uint64_t beginNs, std::uint64_t endNs)
+{
+    std::lock_guard<std::mutex> lock{mMutex};
+    if (mPrinted) return;
+    mPhases.push_back(StartupPhaseRecord{std::move(name), beginNs, endNs, std::this_thread::get_id()});
+}
+
+void StartupTimeline::print(std::uint64_t firstFrameNs)
+{
+    std::lock_guard<std::mutex> lock{mMutex};
+    if (mPrinted) return;
+    mPrinted = true;
+
+    std::sort(mPhases.begin(), mPhases.end(), [](const auto &a, const auto &b) { return a.beginNs < b.beginNs; });
+
+    // workers are numbered in the order they show up on the timeline
+    std::vector<std::thread::id> workers;
+    auto threadLabel = [&](std::thread::id id) -> std::string {
+        if (id == mMainThread) return "main";
+        auto it = std::find(workers.begin(), workers.end(), id);
+        if (it == workers.end()) it = workers.insert(workers.end(), id);
+        return "worker " + std::to_string(std::distance(workers.begin(), it) + 1);
+    };
+
+    auto offsetMs = [this](std::uint64_t ns) { return ns > mOriginNs ? nsToMs(ns - mOriginNs) : 0.0; };
+
+    LOG("Startup timeline, first frame after {:.1f} ms:", offsetMs(firstFrameNs));
+    for (const auto &phase : mPhases)
+    {
+        LOG("\t{:8.1f} .. {:8.1f} ms {:>9} | {} ({:.1f} ms)", offsetMs(phase.beginNs), offsetMs(phase.endNs),
+            threadLabel(phase.thread), phase.name, nsToMs(phase.endNs - phase.beginNs));
+    }
+    mPhases.clear();
+}
+
+StartupPhase::StartupPhase(const char *name) : mName{name}, mBeginNs{nowNs()}
+{
+}
+
+StartupPhase::~StartupPhase()
+{
+    const std::uint64_t endNs = nowNs();
+    StartupTimeline::get().record(mName, mBeginNs, endNs);
+    // task names are not literals, the trace keeps its own copy
+    if (Tracer::isEnabled()) Tracer::get().record(Tracer::get().intern(mName), mBeginNs, endNs);
+}
+}
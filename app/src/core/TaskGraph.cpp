@@ -0,0 +1,49 @@
+#include <core/TaskGraph.h>
+#include <core/AllocationCounters.h>
+#include <core/StartupTimeline.h>
+#include <Log.h>
+
+namespace rw {
+TaskGraph::~TaskGraph()
+{
+    // tasks usually capture their owner, never let one outlive the graph
+    for (auto &task : mTasks)
+    {
+        task.wait();
+    }
+}
+
+TaskGraph::TaskId TaskGraph::add(std::string name, std::function<void()> task, std::vector<TaskId> dependencies)
+{
+    std::vector<std::shared_future<void>> waitFor;
+    for (auto id : dependencies)
+    {
+        if (id >= mTasks.size()) RT_THROW("Task " + name + " depends on an unknown task");
+        waitFor.push_back(mTasks[id]);
+    }
+
+    mTasks.push_back(std::async(std::launch::async, [name = std::move(name), task = std::move(task), waitFor = std::move(waitFor)]() {
+        for (const auto &dependency : waitFor)
+        {
+            dependency.get();
+        }
+        AllocationScope allocations{AllocationTag::Loading};
+        StartupPhase phase{name.c_str()};
+        task();
+    }).share());
+    return mTasks.size() - 1;
+}
+
+void TaskGraph::wait(TaskId id)
+{
+    mTasks.at(id).get();
+}
+
+void TaskGraph::waitAll()
+{
+    for (auto &task : mTasks)
+    {
+        task.get();
+    }
+}
+}
@@ -0,0 +1,180 @@
+#include <core/ThreadPool.h>
+#include <core/AllocationCounters.h>
+#include <core/Trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace rw {
+// Shared by the caller of parallelFor and its helpers, which may only get scheduled after all
+// chunks are taken. Whoever drops the last reference hands it back to the pool for reuse.
+struct ThreadPool::ParallelJob {
+    std::atomic<std::size_t> nextChunk {0};
+    std::atomic<std::size_t> doneChunks {0};
+    std::atomic<std::size_t> references {0};
+    std::size_t count = 0;
+    std::size_t chunkSize = 0;
+    std::size_t chunkCount = 0;
+    RangeFunction function = nullptr;
+    void *context = nullptr;
+    // the helpers count their allocations under the caller's tag
+    AllocationTag tag = AllocationTag::Other;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    void run()
+    {
+        AllocationScope allocations{tag};
+        for (std::size_t chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1))
+        {
+            try
+            {
+                TRACE_SCOPE("parallel chunk");
+                function(context, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+            } catch (...)
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                if (!error) error = std::current_exception();
+            }
+            if (doneChunks.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                done.notify_all();
+            }
+        }
+    }
+};
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        const std::size_t hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    mWorkers.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        mWorkers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    for (auto &worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        if (mTaskCount == mTasks.size())
+        {
+            std::vector<std::function<void()>> grown(std::max<std::size_t>(mTasks.size() * 2, 16));
+            for (std::size_t i = 0; i < mTaskCount; ++i)
+            {
+                grown[i] = std::move(mTasks[(mTaskHead + i) % mTasks.size()]);
+            }
+            mTasks = std::move(grown);
+            mTaskHead = 0;
+        }
+        mTasks[(mTaskHead + mTaskCount) % mTasks.size()] = std::move(task);
+        ++mTaskCount;
+    }
+    mCondition.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    Tracer::get().setThreadName("pool worker");
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock{mMutex};
+            mCondition.wait(lock, [this]() { return mStopping || mTaskCount > 0; });
+            if (mTaskCount == 0) return;
+            task = std::move(mTasks[mTaskHead]);
+            mTasks[mTaskHead] = nullptr;
+            mTaskHead = (mTaskHead + 1) % mTasks.size();
+            --mTaskCount;
+        }
+        TRACE_SCOPE("pool task");
+        task();
+    }
+}
+
+void ThreadPool::releaseJob(ParallelJob *job)
+{
+    if (job->references.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    std::lock_guard<std::mutex> lock{mMutex};
+    mFreeJobs.emplace_back(job);
+}
+
+void ThreadPool::runParallel(std::size_t count, std::size_t minChunk, RangeFunction function, void *context)
+{
+    if (count == 0) return;
+
+    const std::size_t chunkSize = std::max<std::size_t>(std::max<std::size_t>(minChunk, 1), (count + mWorkers.size()) / (mWorkers.size() + 1));
+    const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (chunkCount == 1)
+    {
+        function(context, 0, count);
+        return;
+    }
+
+    ParallelJob *job = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        if (!mFreeJobs.empty())
+        {
+            job = mFreeJobs.back().release();
+            mFreeJobs.pop_back();
+        }
+    }
+    if (job == nullptr) job = new ParallelJob();
+
+    const std::size_t helpers = std::min(mWorkers.size(), chunkCount - 1);
+    job->nextChunk.store(0);
+    job->doneChunks.store(0);
+    job->references.store(helpers + 1);
+    job->count = count;
+    job->chunkSize = chunkSize;
+    job->chunkCount = chunkCount;
+    job->function = function;
+    job->context = context;
+    job->tag = getAllocationTag();
+    job->error = nullptr;
+
+    // two pointers fit into std::function's small buffer, enqueueing a helper does not allocate
+    for (std::size_t i = 0; i < helpers; ++i)
+    {
+        enqueue([this, job]() {
+            job->run();
+            releaseJob(job);
+        });
+    }
+    job->run();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock{job->mutex};
+        job->done.wait(lock, [job, chunkCount]() { return job->doneChunks.load() == chunkCount; });
+        error = std::move(job->error);
+    }
+    releaseJob(job);
+    if (error) std::rethrow_exception(error);
+}
+}
@@ -0,0 +1,164 @@
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <fstream>
+
+namespace rw {
+namespace {
+std::string escapeJson(const char *text)
+{
+    std::string escaped;
+    for (const char *c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\') escaped += '\\';
+        escaped += static_cast<unsigned char>(*c) < 0x20 ? ' ' : *c;
+    }
+    return escaped;
+}
+} // namespace
+
+std::atomic<bool> Tracer::sEnabled {false};
+thread_local std::uint32_t Tracer::sThreadId = 0;
+thread_local Tracer::ThreadBuffer *Tracer::sThreadBuffer = nullptr;
+
+Tracer &Tracer::get()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+std::uint32_t Tracer::threadId()
+{
+    if (sThreadId == 0) sThreadId = mNextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return sThreadId;
+}
+
+Tracer::ThreadBuffer &Tracer::threadBuffer()
+{
+    if (!sThreadBuffer)
+    {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->id = threadId();
+        std::lock_guard<std::mutex> lock{mMutex};
+        sThreadBuffer = buffer.get();
+        mThreads.push_back(std::move(buffer));
+    }
+    return *sThreadBuffer;
+}
+
+void Tracer::setThreadName(const char *name)
+{
+    const std::uint32_t id = threadId();
+    std::lock_guard<std::mutex> lock{mMutex};
+    mThreadNames.emplace_back(id, name);
+}
+
+const char *Tracer::intern(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock{mMutex};
+    return mNames.insert(name).first->c_str();
+}
+
+void Tracer::record(const char *name, std::uint64_t beginNs, std::uint64_t endNs)
+{
+    // a scope still open when tracing stopped belongs to no trace
+    if (!isEnabled()) return;
+
+    auto &buffer = threadBuffer();
+    if (!buffer.events.push(TraceEvent{name, beginNs, endNs}))
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::start()
+{
+    std::lock_guard<std::mutex> lock{mMutex};
+    // drop whatever was recorded while the last trace was being stopped
+    collectLocked();
+    mEvents.clear();
+    for (auto &thread : mThreads)
+    {
+        thread->dropped.store(0, std::memory_order_relaxed);
+    }
+    sEnabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::collect()
+{
+    std::lock_guard<std::mutex> lock{mMutex};
+    collectLocked();
+}
+
+void Tracer::collectLocked()
+{
+    TraceEvent event;
+    for (auto &thread : mThreads)
+    {
+        while (thread->events.pop(event))
+        {
+            mEvents.push_back(CollectedEvent{thread->id, event});
+        }
+    }
+}
+
+TraceStats Tracer::stop(const std::string &path)
+{
+    sEnabled.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock{mMutex};
+    collectLocked();
+
+    TraceStats stats;
+    stats.events = mEvents.size();
+    std::vector<std::uint32_t> threads;
+    for (const auto &event : mEvents)
+    {
+        threads.push_back(event.thread);
+    }
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+    stats.threads = static_cast<std::uint32_t>(threads.size());
+    for (const auto &thread : mThreads)
+    {
+        stats.dropped += thread->dropped.load(std::memory_order_relaxed);
+    }
+
+    std::ofstream file{path, std::ios::trunc};
+    if (!file.is_open())
+    {
+        WLOG("Failed to write trace {}", path);
+        mEvents.clear();
+        return stats;
+    }
+
+    // timestamps are microseconds from the first event, the fraction keeps nanoseconds
+    std::uint64_t originNs = ~0ull;
+    for (const auto &event : mEvents)
+    {
+        originNs = std::min(originNs, event.event.beginNs);
+    }
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto &[id, name] : mThreadNames)
+    {
+        file << (first ? "\n" : ",\n")
+             << fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", id, escapeJson(name));
+        first = false;
+    }
+    for (const auto &[thread, event] : mEvents)
+    {
+        file << (first ? "\n" : ",\n")
+             << fmt::format("{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}", escapeJson(event.name), thread,
+                            static_cast<double>(event.beginNs - originNs) / 1.0e3, static_cast<double>(event.endNs - event.beginNs) / 1.0e3);
+        first = false;
+    }
+    file << "\n]}\n";
+
+    mEvents.clear();
+    mEvents.shrink_to_fit();
+    return stats;
+}
+}
@@ -0,0 +1,106 @@
+#include <render/AsyncCompute.h>
+#include <render/CommandTrace.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace rw
+{
+  AsyncCompute::AsyncCompute(Device& dev, uint32_t frameCount) : device{ dev }
+  {
+    mCommandBuffers.resize(frameCount);
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = device.getComputeCommandPool();
+    allocInfo.commandBufferCount = frameCount;
+    VK_CHECK(vkAllocateCommandBuffers(device.getDevice(), &allocInfo, mCommandBuffers.data()), "Failed to allocate compute command buffers");
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    mFinishedSemaphores.resize(frameCount);
+    mFences.resize(frameCount);
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+      VK_CHECK(vkCreateSemaphore(device.getDevice(), &semaphoreInfo, device.getAllocator(), &mFinishedSemaphores[i]), "Failed to create compute semaphore");
+      VK_CHECK(vkCreateFence(device.getDevice(), &fenceInfo, device.getAllocator(), &mFences[i]), "Failed to create compute fence");
+    }
+
+    mGpuTimer = std::make_unique<GpuTimer>(device, frameCount, device.findQueueFamilies().computeFamily.value());
+  }
+
+  AsyncCompute::~AsyncCompute()
+  {
+    vkWaitForFences(device.getDevice(), static_cast<uint32_t>(mFences.size()), mFences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+    mGpuTimer.reset();
+    for (size_t i = 0; i < mFences.size(); ++i)
+    {
+      vkDestroyFence(device.getDevice(), mFences[i], device.getAllocator());
+      vkDestroySemaphore(device.getDevice(), mFinishedSemaphores[i], device.getAllocator());
+    }
+    vkFreeCommandBuffers(device.getDevice(), device.getComputeCommandPool(), static_cast<uint32_t>(mCommandBuffers.size()), mCommandBuffers.data());
+  }
+
+  AsyncCompute::PassId AsyncCompute::addPass(ComputePass pass)
+  {
+    mPasses.push_back(Pass{ mNextPassId, std::move(pass) });
+    return mNextPassId++;
+  }
+
+  void AsyncCompute::removePass(PassId id)
+  {
+    mPasses.erase(std::remove_if(mPasses.begin(), mPasses.end(), [id](const Pass& pass) { return pass.id == id; }), mPasses.end());
+  }
+
+  VkSemaphore AsyncCompute::submit(int frameIndex)
+  {
+    if (mPasses.empty()) return VK_NULL_HANDLE;
+
+    // the graphics submit of this slot already waited on the semaphore once its frame fence
+    // signaled, only the command buffer itself may still be in flight
+    {
+      TRACE_SCOPE("compute fence wait");
+      vkWaitForFences(device.getDevice(), 1, &mFences[frameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+
+    auto command = mCommandBuffers[frameIndex];
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(command, &beginInfo), "Failed to begin compute command buffer");
+    mGpuTimer->begin(command, frameIndex);
+
+    bool recorded = false;
+    {
+      TRACE_COMMANDS(device, command, "async compute");
+      for (auto& pass : mPasses)
+      {
+        recorded |= pass.record(command, frameIndex);
+      }
+    }
+
+    mGpuTimer->end(command, frameIndex);
+    VK_CHECK(vkEndCommandBuffer(command), "Failed to record compute command buffer");
+    if (!recorded)
+    {
+      mGpuTimer->discard(frameIndex);
+      return VK_NULL_HANDLE;
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &command;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &mFinishedSemaphores[frameIndex];
+
+    vkResetFences(device.getDevice(), 1, &mFences[frameIndex]);
+    VK_CHECK(vkQueueSubmit(device.getComputeQueue(), 1, &submitInfo, mFences[frameIndex]), "Failed to submit compute command buffer");
+    return mFinishedSemaphores[frameIndex];
+  }
+}
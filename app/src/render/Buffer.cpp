@@ -1,6 +1,8 @@
 #include <render/Buffer.h>
 #include <Log.h>
 
+#include <cstring>
+
 namespace rw
 {
   VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment) {
@@ -10,29 +12,84 @@ namespace rw
     return instanceSize;
   }
 
-  Buffer::Buffer(Device& dev, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment) : device{ dev }, mBufferSize{ bufferSize }, mUsageFlags { usageFlags }, mMemoryPropertyFlags{ memoryPropertyFlags }
+  Buffer::Buffer(Device& dev, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment,
+    bool sharedWithCompute) : device{ dev }, mBufferSize{ bufferSize }, mUsageFlags { usageFlags }, mMemoryPropertyFlags{ memoryPropertyFlags }
   {
     mAlignmentSize = getAlignment(bufferSize, minOffsetAlignment);
-    device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, mBuffer, mMemoryDevice);
+    device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, mBuffer, mMemoryDevice, sharedWithCompute);
   }
 
   Buffer::~Buffer()
   {
-
-    vkDestroyBuffer(device.getDevice(), mBuffer, nullptr);
-    vkFreeMemory(device.getDevice(), mMemoryDevice, nullptr);
+    unmap();
+    vkDestroyBuffer(device.getDevice(), mBuffer, device.getAllocator());
+    vkFreeMemory(device.getDevice(), mMemoryDevice, device.getAllocator());
   }
 
   void Buffer::update(const std::vector<uint8_t>& data)
   {
-    // map memory
+    const bool wasMapped = mapped != nullptr;
+    if (!wasMapped)
+    {
+      VK_CHECK(map(), "Failed to map buffer memory");
+    }
 
-    // copy memory
+    writeToBuffer(data.data(), static_cast<VkDeviceSize>(data.size()));
+    flush();
 
-    // flush memory
+    if (!wasMapped)
+    {
+      unmap();
+    }
+  }
 
-    // unmap memory
+  VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset)
+  {
+    if (mapped) return VK_SUCCESS;
+    return vkMapMemory(device.getDevice(), mMemoryDevice, offset, size, 0, &mapped);
   }
 
+  void Buffer::unmap()
+  {
+    if (mapped)
+    {
+      vkUnmapMemory(device.getDevice(), mMemoryDevice);
+      mapped = nullptr;
+    }
+  }
+
+  void Buffer::writeToBuffer(const void* data, VkDeviceSize size, VkDeviceSize offset)
+  {
+    if (!mapped) RT_THROW("Cannot write to unmapped buffer");
 
-}
\ No newline at end of file
+    if (size == VK_WHOLE_SIZE)
+    {
+      size = mBufferSize - offset;
+    }
+    std::memcpy(static_cast<char*>(mapped) + offset, data, static_cast<size_t>(size));
+  }
+
+  VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset)
+  {
+    if (mMemoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return VK_SUCCESS;
+
+    VkMappedMemoryRange mappedRange = {};
+    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mappedRange.memory = mMemoryDevice;
+    mappedRange.offset = offset;
+    mappedRange.size = size;
+    return vkFlushMappedMemoryRanges(device.getDevice(), 1, &mappedRange);
+  }
+
+  VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset)
+  {
+    if (mMemoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return VK_SUCCESS;
+
+    VkMappedMemoryRange mappedRange = {};
+    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mappedRange.memory = mMemoryDevice;
+    mappedRange.offset = offset;
+    mappedRange.size = size;
+    return vkInvalidateMappedMemoryRanges(device.getDevice(), 1, &mappedRange);
+  }
+}
@@ -0,0 +1,39 @@
+#include <render/ComputePipeline.h>
+#include <Log.h>
+
+namespace rw
+{
+  ComputePipeline::ComputePipeline(Device& dev, const std::vector<char>& code, VkPipelineLayout layout, VkPipelineCache pipelineCache) : device{ dev }
+  {
+    if (layout == VK_NULL_HANDLE) RT_THROW("Cannot create compute pipeline: no pipeline layout provided");
+
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = code.size();
+    moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    VK_CHECK(vkCreateShaderModule(device.getDevice(), &moduleInfo, device.getAllocator(), &mShaderModule), "Failed to create shader module");
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = mShaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = layout;
+    pipelineInfo.basePipelineIndex = -1;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    VK_CHECK(vkCreateComputePipelines(device.getDevice(), pipelineCache, 1, &pipelineInfo, device.getAllocator(), &mPipeline), "Failed to create compute pipeline");
+  }
+
+  ComputePipeline::~ComputePipeline()
+  {
+    vkDestroyShaderModule(device.getDevice(), mShaderModule, device.getAllocator());
+    vkDestroyPipeline(device.getDevice(), mPipeline, device.getAllocator());
+  }
+
+  void ComputePipeline::bind(VkCommandBuffer command)
+  {
+    vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+  }
+}
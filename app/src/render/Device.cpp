@@ -1,7 +1,10 @@
 #include <render/Device.h>
 #include <Log.h>
+#include <core/StartupTimeline.h>
+#include <core/Trace.h>
 
 #include <algorithm>
+#include <cstring>
 #include <set>
 
 const std::vector<const char*> deviceExtensions = {
@@ -9,23 +12,38 @@ const std::vector<const char*> deviceExtensions = {
 };
 
 namespace rw {
-  Device::Device(Window& window)
+  Device::Device(Window& window, const DeviceSelectionOptions& selection)
     : mWindow{ window }
   {
-    createInstance();
-    createSurface();
-    getPhysicalDevices();
-    pickPhysicalDevice();
-    createLogicalDevice();
-    createCommandPool();
+    {
+      StartupPhase phase{ "vulkan instance" };
+      createInstance();
+    }
+    {
+      StartupPhase phase{ "surface" };
+      createSurface();
+    }
+    {
+      StartupPhase phase{ "physical device" };
+      getPhysicalDevices();
+      pickPhysicalDevice(selection);
+      queryQueueFamilies();
+      querySurfaceSupport();
+    }
+    {
+      StartupPhase phase{ "logical device" };
+      createLogicalDevice();
+      createCommandPool();
+    }
   }
 
   Device::~Device()
   {
-    vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
-    vkDestroyDevice(mDevice, nullptr);
-    vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
-    vkDestroyInstance(mInstance, nullptr);
+    vkDestroyCommandPool(mDevice, mComputeCommandPool, getAllocator());
+    vkDestroyCommandPool(mDevice, mCommandPool, getAllocator());
+    vkDestroyDevice(mDevice, getAllocator());
+    vkDestroySurfaceKHR(mInstance, mSurface, getAllocator());
+    vkDestroyInstance(mInstance, getAllocator());
   }
 
   void Device::createInstance()
@@ -36,19 +54,36 @@ namespace rw {
     appInfo.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
     appInfo.pEngineName = "rw_model_viewer_engine";
     appInfo.engineVersion = VK_MAKE_VERSION(0, 1, 0);
-    appInfo.apiVersion = VK_VERSION_1_1;
+    appInfo.apiVersion = VK_API_VERSION_1_1;
 
     VkInstanceCreateInfo instanceInfo = {};
     instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     instanceInfo.pApplicationInfo = &appInfo;
     auto extensions = requiredExtensions();
+    // command buffer labels for the trace markers and frame debuggers, when the loader or a layer offers them
+    const bool debugUtils = supportsInstanceExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    if (debugUtils)
+    {
+      extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    }
     instanceInfo.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
     instanceInfo.ppEnabledExtensionNames = extensions.data();
     instanceInfo.enabledLayerCount = 0;
     instanceInfo.ppEnabledLayerNames = nullptr;
     instanceInfo.pNext = nullptr;
 
-    VK_CHECK(vkCreateInstance(&instanceInfo, nullptr, &mInstance), "Failed to create instance");
+    VK_CHECK(vkCreateInstance(&instanceInfo, getAllocator(), &mInstance), "Failed to create instance");
+
+    if (debugUtils)
+    {
+      mCmdBeginLabel = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(vkGetInstanceProcAddr(mInstance, "vkCmdBeginDebugUtilsLabelEXT"));
+      mCmdEndLabel = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(vkGetInstanceProcAddr(mInstance, "vkCmdEndDebugUtilsLabelEXT"));
+      if (!mCmdBeginLabel || !mCmdEndLabel)
+      {
+        mCmdBeginLabel = nullptr;
+        mCmdEndLabel = nullptr;
+      }
+    }
 
     LOG("Extensions number {}", extensions.size());
     for (auto& ext : extensions)
@@ -66,49 +101,39 @@ namespace rw {
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(mInstance, &deviceCount, devices.data());
 
-    int i = 0;
     for (auto& gpu : devices) {
-      PhysicalDevice phyDev(gpu);
-      gpus.insert(std::make_pair(phyDev.getProperties().deviceType, phyDev));
+      mGpus.emplace_back(gpu);
     }
   }
 
-  void Device::pickPhysicalDevice()
+  void Device::pickPhysicalDevice(const DeviceSelectionOptions& selection)
   {
-    auto dedicatedGPU = gpus.find(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU);
-    if (dedicatedGPU != gpus.end()) {
-      mPhysicalDevice = dedicatedGPU->second;
-      LOG("Choosen {} GPU", mPhysicalDevice.getProperties().deviceName);
-      return;
-    }
-    dedicatedGPU = gpus.find(VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU);
-    if (dedicatedGPU != gpus.end()) {
-      mPhysicalDevice = dedicatedGPU->second;
-      LOG("Choosen {} GPU", mPhysicalDevice.getProperties().deviceName);
-      return;
-    }
-
-    RT_THROW("Cannot find suitable GPU");
+    DeviceSelector selector{ mSurface, deviceExtensions, selection, getAllocator() };
+    mPhysicalDevice = mGpus[selector.select(mGpus)];
+    LOG("Choosen {} GPU", mPhysicalDevice.getProperties().deviceName);
   }
 
-  void Device::createSurface() { mWindow.createSurface(mInstance, &mSurface); }
+  void Device::createSurface() { mWindow.createSurface(mInstance, getAllocator(), &mSurface); }
 
   void Device::createCommandPool()
   {
-    QueueFamilyIndices indices = findQueueFamilies();
+    const QueueFamilyIndices& indices = mQueueFamilyIndices;
     VkCommandPoolCreateInfo commandPoolInfo = {};
     commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     commandPoolInfo.queueFamilyIndex = indices.graphicsFamily.value();
     commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    VK_CHECK(vkCreateCommandPool(mDevice, &commandPoolInfo, nullptr, &mCommandPool), "Failed to create command pool");
+    VK_CHECK(vkCreateCommandPool(mDevice, &commandPoolInfo, getAllocator(), &mCommandPool), "Failed to create command pool");
+
+    commandPoolInfo.queueFamilyIndex = indices.computeFamily.value();
+    VK_CHECK(vkCreateCommandPool(mDevice, &commandPoolInfo, getAllocator(), &mComputeCommandPool), "Failed to create compute command pool");
   }
 
   void Device::createLogicalDevice()
   {
-    QueueFamilyIndices indices = findQueueFamilies();
+    const QueueFamilyIndices& indices = mQueueFamilyIndices;
 
     std::vector<VkDeviceQueueCreateInfo> queues;
-    std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+    std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.computeFamily.value() };
     float prio = 1.0f;
 
     for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -125,30 +150,45 @@ namespace rw {
 
     VkPhysicalDeviceFeatures requestedFeatures = {};
     requestedFeatures.samplerAnisotropy = VK_TRUE;
+    // optional, the fragment counters are simply off without it
+    requestedFeatures.pipelineStatisticsQuery = mPhysicalDevice.getFeatures().pipelineStatisticsQuery;
+    // optional, the point rasterizer falls back to separate depth and color passes without it
+    std::vector<const char*> extensions = deviceExtensions;
+    VkPhysicalDeviceShaderAtomicInt64FeaturesKHR atomicFeatures = {};
+    atomicFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES_KHR;
+    if (mPhysicalDevice.supportsBufferInt64Atomics())
+    {
+      requestedFeatures.shaderInt64 = VK_TRUE;
+      atomicFeatures.shaderBufferInt64Atomics = VK_TRUE;
+      extensions.push_back(VK_KHR_SHADER_ATOMIC_INT64_EXTENSION_NAME);
+      mBufferInt64Atomics = true;
+    }
+    mEnabledFeatures = requestedFeatures;
 
     VkDeviceCreateInfo deviceInfo = {};
     deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceInfo.pNext = VK_NULL_HANDLE;
+    deviceInfo.pNext = mBufferInt64Atomics ? &atomicFeatures : VK_NULL_HANDLE;
 
     deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queues.size());
     deviceInfo.pQueueCreateInfos = queues.data();
 
     deviceInfo.pEnabledFeatures = &requestedFeatures;
 
-    deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    deviceInfo.ppEnabledExtensionNames = extensions.data();
 
     deviceInfo.enabledLayerCount = 0;
 
-    VK_CHECK(vkCreateDevice(mPhysicalDevice.getPhysicalDevice(), &deviceInfo, nullptr, &mDevice), "Failed to create logical device");
+    VK_CHECK(vkCreateDevice(mPhysicalDevice.getPhysicalDevice(), &deviceInfo, getAllocator(), &mDevice), "Failed to create logical device");
 
     vkGetDeviceQueue(mDevice, indices.graphicsFamily.value(), 0, &mGraphicsQueue);
     vkGetDeviceQueue(mDevice, indices.presentFamily.value(), 0, &mPresentQueue);
+    vkGetDeviceQueue(mDevice, indices.computeFamily.value(), 0, &mComputeQueue);
   }
 
   void Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
   {
-    VK_CHECK(vkCreateImage(mDevice, &imageInfo, nullptr, &image), "Failed to create image");
+    VK_CHECK(vkCreateImage(mDevice, &imageInfo, getAllocator(), &image), "Failed to create image");
 
     VkMemoryRequirements memReq;
     vkGetImageMemoryRequirements(mDevice, image, &memReq);
@@ -158,7 +198,7 @@ namespace rw {
     allocInfo.allocationSize = memReq.size;
     allocInfo.memoryTypeIndex = findMemoryType(memReq.memoryTypeBits, properties);
 
-    VK_CHECK(vkAllocateMemory(mDevice, &allocInfo, nullptr, &imageMemory), "Failed to allocate image memory");
+    VK_CHECK(vkAllocateMemory(mDevice, &allocInfo, getAllocator(), &imageMemory), "Failed to allocate image memory");
     VK_CHECK(vkBindImageMemory(mDevice, image, imageMemory, VkDeviceSize(0)), "Failed to bind image with image memory");
   }
 
@@ -191,19 +231,31 @@ namespace rw {
     submitInfo.pCommandBuffers = &command;
 
     vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(mGraphicsQueue);
+    {
+      TRACE_SCOPE("single time command wait");
+      vkQueueWaitIdle(mGraphicsQueue);
+    }
     vkFreeCommandBuffers(mDevice, mCommandPool, 1, &command);
   }
 
-  void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+  void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+    bool sharedWithCompute)
   {
+    const uint32_t families[] = { mQueueFamilyIndices.graphicsFamily.value(), mQueueFamilyIndices.computeFamily.value() };
+
     VkBufferCreateInfo bufferInfo = {};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (sharedWithCompute && hasAsyncCompute())
+    {
+      bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      bufferInfo.queueFamilyIndexCount = 2;
+      bufferInfo.pQueueFamilyIndices = families;
+    }
 
-    VK_CHECK(vkCreateBuffer(mDevice, &bufferInfo, nullptr, &buffer), "failed to create buffer!");
+    VK_CHECK(vkCreateBuffer(mDevice, &bufferInfo, getAllocator(), &buffer), "failed to create buffer!");
 
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(mDevice, buffer, &memRequirements);
@@ -213,11 +265,24 @@ namespace rw {
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-    VK_CHECK(vkAllocateMemory(mDevice, &allocInfo, nullptr, &bufferMemory), "failed to allocate vertex buffer memory!");
+    VK_CHECK(vkAllocateMemory(mDevice, &allocInfo, getAllocator(), &bufferMemory), "failed to allocate vertex buffer memory!");
 
     vkBindBufferMemory(mDevice, buffer, bufferMemory, 0);
   }
 
+  void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+  {
+    VkCommandBuffer command = beginSingleTimeCommand();
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = 0;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(command, srcBuffer, dstBuffer, 1, &copyRegion);
+
+    endSingleTimeCommand(command);
+  }
+
   std::vector<const char*> Device::requiredExtensions()
   {
     std::uint32_t count = 0;
@@ -227,61 +292,98 @@ namespace rw {
     return extensions;
   }
 
-  QueueFamilyIndices Device::findQueueFamilies()
+  bool Device::supportsInstanceExtension(const char* name)
+  {
+    std::uint32_t count = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> available(count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+    return std::any_of(available.begin(), available.end(), [name](const auto& ext) { return std::strcmp(ext.extensionName, name) == 0; });
+  }
+
+  void Device::beginLabel(VkCommandBuffer command, const char* name) const
   {
-    // get graphics and present queue index
+    VkDebugUtilsLabelEXT label = {};
+    label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pLabelName = name;
+    mCmdBeginLabel(command, &label);
+  }
+
+  void Device::endLabel(VkCommandBuffer command) const
+  {
+    mCmdEndLabel(command);
+  }
+
+  void Device::queryQueueFamilies()
+  {
+    // get graphics, present and compute queue index
     QueueFamilyIndices indices;
-    int i = 0;
-    for (const auto& queue : mPhysicalDevice.getQueueFamilyProperties())
+    const auto& families = mPhysicalDevice.getQueueFamilyProperties();
+    for (uint32_t i = 0; i < families.size(); ++i)
     {
-      if (queue.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+      const auto& queue = families[i];
+      if ((queue.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !indices.graphicsFamily.has_value())
       {
         indices.graphicsFamily = i;
       }
 
+      // a family without graphics runs next to the graphics queue instead of being time sliced with it
+      if ((queue.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queue.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !indices.computeFamily.has_value())
+      {
+        indices.computeFamily = i;
+      }
+
       VkBool32 isPresentSupport = VK_FALSE;
       vkGetPhysicalDeviceSurfaceSupportKHR(mPhysicalDevice.getPhysicalDevice(), i, mSurface, &isPresentSupport);
-      if (isPresentSupport)
+      if (isPresentSupport && (!indices.presentFamily.has_value() || indices.presentFamily != indices.graphicsFamily))
       {
         indices.presentFamily = i;
       }
+    }
 
-      if (indices.isComplete())
-        break;
-
-      i++;
+    // graphics queues always support compute
+    if (!indices.computeFamily.has_value())
+    {
+      indices.computeFamily = indices.graphicsFamily;
     }
-    return indices;
+
+    if (!indices.isComplete()) RT_THROW("Failed to find graphics and present queue families");
+    mQueueFamilyIndices = indices;
+    LOG("Queue families: graphics {}, present {}, compute {}{}", indices.graphicsFamily.value(), indices.presentFamily.value(),
+      indices.computeFamily.value(), hasAsyncCompute() ? " (async)" : " (shared with graphics)");
   }
 
-  SwapChainSupportDetails Device::getSwapChainSupport()
+  void Device::querySurfaceSupport()
   {
-    SwapChainSupportDetails result;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &result.capabilities);
-
     uint32_t formatCount = 0u;
     vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &formatCount, nullptr);
 
     if (formatCount == 0) RT_THROW("Failed to find any supported surface format");
 
-    result.formats.resize(formatCount);
-    vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &formatCount, result.formats.data());
+    mSurfaceFormats.resize(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &formatCount, mSurfaceFormats.data());
 
     uint32_t presentModeCount = 0u;
     vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &presentModeCount, nullptr);
 
     if (presentModeCount == 0) RT_THROW("Failed to find any present mode");
 
-    result.presentModes.resize(presentModeCount);
-    vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &presentModeCount, result.presentModes.data());
+    mPresentModes.resize(presentModeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &presentModeCount, mPresentModes.data());
+  }
 
+  SwapChainSupportDetails Device::getSwapChainSupport() const
+  {
+    SwapChainSupportDetails result;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice.getPhysicalDevice(), mSurface, &result.capabilities);
+    result.formats = mSurfaceFormats;
+    result.presentModes = mPresentModes;
     return result;
   }
 
-  uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+  uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
   {
-    VkPhysicalDeviceMemoryProperties memProp;
-    vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice.getPhysicalDevice(), &memProp);
+    const auto& memProp = mPhysicalDevice.getMemoryProperties();
 
     for (uint32_t i = 0u; i < memProp.memoryTypeCount; ++i)
     {
@@ -302,12 +404,12 @@ namespace rw {
 
       if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
       {
-        LOG("Choosen image format {}", format); // TODO: add string formmat converter
+        DLOG("Choosen image format {}", format); // TODO: add string formmat converter
         return format;
       }
       else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
       {
-        LOG("Choosen image format {}", format);
+        DLOG("Choosen image format {}", format);
         return format;
       }
     }
@@ -0,0 +1,401 @@
+#include <render/DeviceSelector.h>
+#include <core/Clock.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+#ifndef RW_SHADER_DIR
+#define RW_SHADER_DIR "shaders"
+#endif
+
+namespace rw
+{
+  namespace
+  {
+    constexpr double BANDWIDTH_WEIGHT = 50.0; // score per GB/s, a measurement outweighs the device type
+    constexpr VkDeviceSize PROBE_SIZE = 64ull << 20;
+    constexpr uint32_t PROBE_COPIES = 8;
+
+    const char* typeName(VkPhysicalDeviceType type)
+    {
+      switch (type)
+      {
+      case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+      case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+      case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+      case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+      default: return "other";
+      }
+    }
+
+    std::string toLower(std::string text)
+    {
+      std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      return text;
+    }
+
+    // handles of the calibration run, released on every exit path
+    struct ProbeResources
+    {
+      VkDevice device = { VK_NULL_HANDLE };
+      VkCommandPool commandPool = { VK_NULL_HANDLE };
+      VkFence fence = { VK_NULL_HANDLE };
+      VkBuffer buffers[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+      VkDeviceMemory memory[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+      const VkAllocationCallbacks* allocator = { nullptr };
+
+      ~ProbeResources()
+      {
+        if (device == VK_NULL_HANDLE) return;
+        vkDeviceWaitIdle(device);
+        for (int i = 0; i < 2; ++i)
+        {
+          vkDestroyBuffer(device, buffers[i], allocator);
+          vkFreeMemory(device, memory[i], allocator);
+        }
+        vkDestroyFence(device, fence, allocator);
+        vkDestroyCommandPool(device, commandPool, allocator);
+        vkDestroyDevice(device, allocator);
+      }
+    };
+  }
+
+  DeviceSelector::DeviceSelector(VkSurfaceKHR surface, const std::vector<const char*>& requiredExtensions, const DeviceSelectionOptions& options,
+    const VkAllocationCallbacks* allocator)
+    : mSurface{ surface }, mRequiredExtensions{ requiredExtensions }, mOptions{ options }, mAllocator{ allocator }
+  {
+  }
+
+  std::string DeviceSelector::calibrationCachePath()
+  {
+    return std::string(RW_SHADER_DIR) + "/device_calibration.txt";
+  }
+
+  uint32_t DeviceSelector::select(const std::vector<PhysicalDevice>& devices)
+  {
+    loadCalibration();
+
+    bool measured = false;
+    std::vector<DeviceCandidate> candidates;
+    for (uint32_t i = 0; i < devices.size(); ++i)
+    {
+      auto candidate = evaluate(devices[i], i);
+      const auto& id = devices[i].getIdentifier();
+      if (candidate.suitable && !id.empty())
+      {
+        auto cached = mCalibration.find(id);
+        if (cached != mCalibration.end())
+        {
+          candidate.bandwidthGBs = cached->second;
+        }
+        else if (mOptions.calibrate)
+        {
+          candidate.bandwidthGBs = measureBandwidth(devices[i], mAllocator);
+          if (candidate.bandwidthGBs > 0.0)
+          {
+            mCalibration[id] = candidate.bandwidthGBs;
+            measured = true;
+          }
+        }
+        candidate.score += candidate.bandwidthGBs * BANDWIDTH_WEIGHT;
+      }
+      candidates.push_back(candidate);
+    }
+    if (measured) saveCalibration();
+
+    for (const auto& candidate : candidates)
+    {
+      const auto& props = devices[candidate.index].getProperties();
+      if (candidate.suitable)
+      {
+        LOG("\t[{}] {} ({}, {} MiB device local): score {:.0f}{}", candidate.index, props.deviceName, typeName(props.deviceType),
+          devices[candidate.index].getDeviceLocalMemorySize() >> 20, candidate.score,
+          candidate.bandwidthGBs > 0.0 ? fmt::format(", {:.1f} GB/s", candidate.bandwidthGBs) : std::string{});
+      }
+      else
+      {
+        LOG("\t[{}] {} ({}): not usable, {}", candidate.index, props.deviceName, typeName(props.deviceType), candidate.rejectReason);
+      }
+    }
+
+    const int preferred = findPreferred(devices);
+    if (preferred >= 0)
+    {
+      if (candidates[preferred].suitable) return static_cast<uint32_t>(preferred);
+      WLOG("Requested GPU {} is not usable ({}), falling back to the best scoring one", preferred, candidates[preferred].rejectReason);
+    }
+    else if (!mOptions.preferred.empty())
+    {
+      WLOG("No GPU matches \"{}\", falling back to the best scoring one", mOptions.preferred);
+    }
+
+    const DeviceCandidate* best = nullptr;
+    for (const auto& candidate : candidates)
+    {
+      if (candidate.suitable && (!best || candidate.score > best->score)) best = &candidate;
+    }
+    if (!best) RT_THROW("Cannot find suitable GPU");
+    return best->index;
+  }
+
+  DeviceCandidate DeviceSelector::evaluate(const PhysicalDevice& device, uint32_t index) const
+  {
+    DeviceCandidate candidate;
+    candidate.index = index;
+
+    bool hasGraphics = false;
+    bool hasPresent = false;
+    const auto& families = device.getQueueFamilyProperties();
+    for (uint32_t i = 0; i < families.size(); ++i)
+    {
+      hasGraphics |= (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+      VkBool32 presentSupport = VK_FALSE;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device.getPhysicalDevice(), i, mSurface, &presentSupport);
+      hasPresent |= presentSupport == VK_TRUE;
+    }
+    if (!hasGraphics || !hasPresent)
+    {
+      candidate.rejectReason = !hasGraphics ? "no graphics queue" : "cannot present to the window";
+      return candidate;
+    }
+
+    for (const char* extension : mRequiredExtensions)
+    {
+      if (!device.supportsExtension(extension))
+      {
+        candidate.rejectReason = std::string("missing ") + extension;
+        return candidate;
+      }
+    }
+
+    if (!device.getFeatures().samplerAnisotropy)
+    {
+      candidate.rejectReason = "no sampler anisotropy";
+      return candidate;
+    }
+
+    uint32_t formatCount = 0;
+    uint32_t presentModeCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device.getPhysicalDevice(), mSurface, &formatCount, nullptr);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device.getPhysicalDevice(), mSurface, &presentModeCount, nullptr);
+    if (formatCount == 0 || presentModeCount == 0)
+    {
+      candidate.rejectReason = "no surface format or present mode";
+      return candidate;
+    }
+
+    candidate.suitable = true;
+    candidate.score = staticScore(device);
+    return candidate;
+  }
+
+  double DeviceSelector::staticScore(const PhysicalDevice& device) const
+  {
+    const auto& props = device.getProperties();
+    double score = 0.0;
+    switch (props.deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 3000.0; break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 2000.0; break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 1500.0; break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU: break; // last resort
+    default: score += 1000.0; break;
+    }
+
+    const double deviceLocalGiB = static_cast<double>(device.getDeviceLocalMemorySize()) / static_cast<double>(1ull << 30);
+    score += std::min(deviceLocalGiB, 32.0) * 50.0;
+
+    // dedicated queues allow async compute and transfers next to rendering
+    bool asyncCompute = false;
+    bool dedicatedTransfer = false;
+    for (const auto& family : device.getQueueFamilyProperties())
+    {
+      const bool graphics = (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+      const bool compute = (family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+      asyncCompute |= compute && !graphics;
+      dedicatedTransfer |= (family.queueFlags & VK_QUEUE_TRANSFER_BIT) != 0 && !graphics && !compute;
+    }
+    if (asyncCompute) score += 100.0;
+    if (dedicatedTransfer) score += 50.0;
+
+    const auto& features = device.getFeatures();
+    if (features.multiDrawIndirect) score += 25.0;
+    if (features.drawIndirectFirstInstance) score += 25.0;
+
+    score += static_cast<double>(props.limits.maxImageDimension2D) / 1024.0;
+    return score;
+  }
+
+  int DeviceSelector::findPreferred(const std::vector<PhysicalDevice>& devices) const
+  {
+    const auto& preferred = mOptions.preferred;
+    if (preferred.empty()) return -1;
+
+    if (std::all_of(preferred.begin(), preferred.end(), [](unsigned char c) { return std::isdigit(c); }))
+    {
+      const auto index = std::stoul(preferred);
+      return index < devices.size() ? static_cast<int>(index) : -1;
+    }
+
+    const auto needle = toLower(preferred);
+    for (uint32_t i = 0; i < devices.size(); ++i)
+    {
+      if (toLower(devices[i].getProperties().deviceName).find(needle) != std::string::npos) return static_cast<int>(i);
+    }
+    return -1;
+  }
+
+  double DeviceSelector::measureBandwidth(const PhysicalDevice& device, const VkAllocationCallbacks* allocator)
+  {
+    const auto& families = device.getQueueFamilyProperties();
+    uint32_t family = static_cast<uint32_t>(families.size());
+    for (uint32_t i = 0; i < families.size(); ++i)
+    {
+      if (families[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT))
+      {
+        family = i;
+        break;
+      }
+    }
+    if (family == families.size()) return 0.0;
+
+    ProbeResources probe;
+    probe.allocator = allocator;
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = family;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    if (vkCreateDevice(device.getPhysicalDevice(), &deviceInfo, probe.allocator, &probe.device) != VK_SUCCESS) return 0.0;
+
+    VkQueue queue;
+    vkGetDeviceQueue(probe.device, family, 0, &queue);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = family;
+    if (vkCreateCommandPool(probe.device, &poolInfo, probe.allocator, &probe.commandPool) != VK_SUCCESS) return 0.0;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(probe.device, &fenceInfo, probe.allocator, &probe.fence) != VK_SUCCESS) return 0.0;
+
+    const auto& memProps = device.getMemoryProperties();
+    for (int i = 0; i < 2; ++i)
+    {
+      VkBufferCreateInfo bufferInfo = {};
+      bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      bufferInfo.size = PROBE_SIZE;
+      bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+      bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      if (vkCreateBuffer(probe.device, &bufferInfo, probe.allocator, &probe.buffers[i]) != VK_SUCCESS) return 0.0;
+
+      VkMemoryRequirements memReq;
+      vkGetBufferMemoryRequirements(probe.device, probe.buffers[i], &memReq);
+      uint32_t memoryType = memProps.memoryTypeCount;
+      for (uint32_t type = 0; type < memProps.memoryTypeCount; ++type)
+      {
+        if ((memReq.memoryTypeBits & (1u << type)) && (memProps.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+        {
+          memoryType = type;
+          break;
+        }
+      }
+      if (memoryType == memProps.memoryTypeCount) return 0.0;
+
+      VkMemoryAllocateInfo allocInfo = {};
+      allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+      allocInfo.allocationSize = memReq.size;
+      allocInfo.memoryTypeIndex = memoryType;
+      if (vkAllocateMemory(probe.device, &allocInfo, probe.allocator, &probe.memory[i]) != VK_SUCCESS) return 0.0;
+      vkBindBufferMemory(probe.device, probe.buffers[i], probe.memory[i], 0);
+    }
+
+    VkCommandBufferAllocateInfo cmdAllocInfo = {};
+    cmdAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdAllocInfo.commandBufferCount = 1;
+    cmdAllocInfo.commandPool = probe.commandPool;
+    VkCommandBuffer command;
+    if (vkAllocateCommandBuffers(probe.device, &cmdAllocInfo, &command) != VK_SUCCESS) return 0.0;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(command, &beginInfo);
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    VkBufferCopy region = {};
+    region.size = PROBE_SIZE;
+    vkCmdFillBuffer(command, probe.buffers[0], 0, VK_WHOLE_SIZE, 0x5a5a5a5au);
+    for (uint32_t i = 0; i < PROBE_COPIES; ++i)
+    {
+      vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+      vkCmdCopyBuffer(command, probe.buffers[i % 2], probe.buffers[(i + 1) % 2], 1, &region);
+    }
+    vkEndCommandBuffer(command);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &command;
+
+    // the first run warms up clocks and page tables, the second one is measured
+    double seconds = 0.0;
+    for (int run = 0; run < 2; ++run)
+    {
+      const uint64_t start = nowNs();
+      if (vkQueueSubmit(queue, 1, &submitInfo, probe.fence) != VK_SUCCESS) return 0.0;
+      if (vkWaitForFences(probe.device, 1, &probe.fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) return 0.0;
+      seconds = static_cast<double>(nowNs() - start) / 1.0e9;
+      vkResetFences(probe.device, 1, &probe.fence);
+    }
+    if (seconds <= 0.0) return 0.0;
+
+    // the fill writes the buffer once, every copy reads and writes it
+    const double bytes = static_cast<double>(PROBE_SIZE) * (1.0 + 2.0 * PROBE_COPIES);
+    return bytes / seconds / 1.0e9;
+  }
+
+  void DeviceSelector::loadCalibration()
+  {
+    std::ifstream file{ calibrationCachePath() };
+    std::string line;
+    while (std::getline(file, line))
+    {
+      std::istringstream stream{ line };
+      std::string id;
+      double bandwidth = 0.0;
+      if (stream >> id >> bandwidth && bandwidth > 0.0)
+      {
+        mCalibration[id] = bandwidth;
+      }
+    }
+  }
+
+  void DeviceSelector::saveCalibration() const
+  {
+    std::ofstream file{ calibrationCachePath(), std::ios::trunc };
+    if (!file.is_open())
+    {
+      WLOG("Failed to write device calibration {}", calibrationCachePath());
+      return;
+    }
+    for (const auto& [id, bandwidth] : mCalibration)
+    {
+      file << id << ' ' << bandwidth << '\n';
+    }
+  }
+}
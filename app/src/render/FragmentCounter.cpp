@@ -0,0 +1,78 @@
+#include <render/FragmentCounter.h>
+#include <Log.h>
+
+namespace rw
+{
+  FragmentCounter::FragmentCounter(Device& dev, uint32_t frameCount) : device{ dev }, mSlots(frameCount)
+  {
+    if (!device.getEnabledFeatures().pipelineStatisticsQuery)
+    {
+      WLOG("Pipeline statistics queries are not supported, shaded fragments are not counted");
+      return;
+    }
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    queryPoolInfo.queryCount = frameCount * PASS_COUNT;
+    queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+    VK_CHECK(vkCreateQueryPool(device.getDevice(), &queryPoolInfo, device.getAllocator(), &mQueryPool), "Failed to create pipeline statistics query pool");
+  }
+
+  FragmentCounter::~FragmentCounter()
+  {
+    if (mQueryPool != VK_NULL_HANDLE)
+    {
+      vkDestroyQueryPool(device.getDevice(), mQueryPool, device.getAllocator());
+    }
+  }
+
+  void FragmentCounter::collect(uint32_t frameIndex)
+  {
+    auto& slot = mSlots[frameIndex];
+    if (!slot.pending) return;
+    slot.pending = false;
+
+    FragmentCounts counts;
+    counts.pixels = slot.pixels;
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+      if ((slot.passes & (1u << pass)) == 0) continue;
+
+      uint64_t invocations = 0;
+      auto result = vkGetQueryPoolResults(device.getDevice(), mQueryPool, frameIndex * PASS_COUNT + pass, 1, sizeof(invocations), &invocations,
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+      if (result != VK_SUCCESS) return;
+      (pass == PREPASS ? counts.prepass : counts.shading) = invocations;
+    }
+    mLast = counts;
+    ++mSampleCount;
+  }
+
+  void FragmentCounter::reset(VkCommandBuffer command, uint32_t frameIndex, VkExtent2D extent)
+  {
+    if (!isSupported()) return;
+
+    collect(frameIndex);
+    vkCmdResetQueryPool(command, mQueryPool, frameIndex * PASS_COUNT, PASS_COUNT);
+    auto& slot = mSlots[frameIndex];
+    slot.pending = true;
+    slot.passes = 0;
+    slot.pixels = static_cast<uint64_t>(extent.width) * extent.height;
+  }
+
+  void FragmentCounter::begin(VkCommandBuffer command, uint32_t frameIndex, Pass pass)
+  {
+    if (!isSupported()) return;
+
+    vkCmdBeginQuery(command, mQueryPool, frameIndex * PASS_COUNT + pass, 0);
+    mSlots[frameIndex].passes |= 1u << pass;
+  }
+
+  void FragmentCounter::end(VkCommandBuffer command, uint32_t frameIndex, Pass pass)
+  {
+    if (!isSupported()) return;
+
+    vkCmdEndQuery(command, mQueryPool, frameIndex * PASS_COUNT + pass);
+  }
+}
@@ -0,0 +1,284 @@
+#include <render/FrameCapture.h>
+#include <core/Clock.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+namespace rw
+{
+  namespace
+  {
+    // the encoders only understand 8 bit RGBA/BGRA
+    bool describeFormat(VkFormat format, bool& bgra, bool& srgb)
+    {
+      switch (format)
+      {
+      case VK_FORMAT_B8G8R8A8_UNORM: bgra = true; srgb = false; return true;
+      case VK_FORMAT_B8G8R8A8_SRGB: bgra = true; srgb = true; return true;
+      case VK_FORMAT_R8G8B8A8_UNORM: bgra = false; srgb = false; return true;
+      case VK_FORMAT_R8G8B8A8_SRGB: bgra = false; srgb = true; return true;
+      default: return false;
+      }
+    }
+
+    bool hasMemoryType(const VkPhysicalDeviceMemoryProperties& properties, VkMemoryPropertyFlags flags)
+    {
+      for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+      {
+        if ((properties.memoryTypes[i].propertyFlags & flags) == flags) return true;
+      }
+      return false;
+    }
+  }
+
+  FrameCapture::FrameCapture(Device& dev, const CaptureOptions& options) : device{ dev }, mOptions{ options }
+  {
+    mOptions.slots = std::max(mOptions.slots, 1u);
+
+    // the CPU reads every byte of the image, cached memory makes that several times faster
+    const auto& memoryProperties = device.getCurrentPhysicalDevice().getMemoryProperties();
+    mMemoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    if (!hasMemoryType(memoryProperties, mMemoryFlags))
+    {
+      mMemoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    mSlots.reserve(mOptions.slots);
+    for (uint32_t i = 0; i < mOptions.slots; ++i)
+    {
+      auto slot = std::make_unique<Slot>();
+      VK_CHECK(vkCreateFence(device.getDevice(), &fenceInfo, device.getAllocator(), &slot->fence), "Failed to create capture fence");
+      mSlots.push_back(std::move(slot));
+    }
+
+    uint32_t threads = mOptions.encoderThreads;
+    if (threads == 0)
+    {
+      threads = std::max(std::thread::hardware_concurrency() / 2, 1u);
+    }
+    mEncoders = std::make_unique<ThreadPool>(threads);
+    LOG("Frame capture: {} slots, {} encoder thread(s), writing {} files to {}", mOptions.slots, threads,
+      getImageExtension(mOptions.format), mOptions.directory);
+  }
+
+  FrameCapture::~FrameCapture()
+  {
+    flush();
+    mEncoders.reset();
+
+    for (auto& slot : mSlots)
+    {
+      vkDestroyFence(device.getDevice(), slot->fence, device.getAllocator());
+    }
+  }
+
+  bool FrameCapture::record(VkCommandBuffer command, VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout, const std::string& name)
+  {
+    if (mRecorded != nullptr) RT_THROW("A capture was already recorded for this frame");
+
+    bool bgra = false;
+    bool srgb = false;
+    if (!describeFormat(format, bgra, srgb))
+    {
+      WLOG_EVERY_MS(5000, "Frame capture: unsupported image format {}", static_cast<int>(format));
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    Slot* slot = nullptr;
+    for (auto& candidate : mSlots)
+    {
+      if (candidate->state.load(std::memory_order_acquire) == SlotState::Free)
+      {
+        slot = candidate.get();
+        break;
+      }
+    }
+    if (slot == nullptr)
+    {
+      mDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    if (!slot->buffer || slot->buffer->getBufferSize() < size)
+    {
+      // a free slot is not used by the GPU or an encoder, so it can be resized on the spot
+      slot->buffer.reset();
+      slot->buffer = std::make_unique<Buffer>(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, mMemoryFlags);
+      VK_CHECK(slot->buffer->map(), "Failed to map capture buffer");
+    }
+
+    VkImageMemoryBarrier toTransfer = {};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = layout;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(command, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->buffer->getHandler(), 1, &region);
+
+    VkImageMemoryBarrier restore = toTransfer;
+    restore.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    restore.dstAccessMask = 0;
+    restore.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    restore.newLayout = layout;
+
+    VkBufferMemoryBarrier toHost = {};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = slot->buffer->getHandler();
+    toHost.offset = 0;
+    toHost.size = size;
+    vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+      0, nullptr, 1, &toHost, 1, &restore);
+
+    slot->image.pixels = static_cast<const uint8_t*>(slot->buffer->getMappedMemory());
+    slot->image.width = extent.width;
+    slot->image.height = extent.height;
+    slot->image.rowPitch = extent.width * 4;
+    slot->image.bgra = bgra;
+    slot->image.srgb = srgb;
+    slot->name = name;
+    slot->state.store(SlotState::Recorded, std::memory_order_release);
+    mRecorded = slot;
+    return true;
+  }
+
+  void FrameCapture::submit(VkQueue queue)
+  {
+    if (mRecorded == nullptr) return;
+
+    // an empty submit signals its fence once all work submitted to the queue before it is complete
+    VK_CHECK(vkResetFences(device.getDevice(), 1, &mRecorded->fence), "Failed to reset capture fence");
+    VK_CHECK(vkQueueSubmit(queue, 0, nullptr, mRecorded->fence), "Failed to submit capture fence");
+    mRecorded->state.store(SlotState::Submitted, std::memory_order_release);
+    mRecorded = nullptr;
+    mCaptured.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void FrameCapture::discard()
+  {
+    if (mRecorded == nullptr) return;
+    mRecorded->state.store(SlotState::Free, std::memory_order_release);
+    mRecorded = nullptr;
+  }
+
+  void FrameCapture::poll()
+  {
+    for (auto& slot : mSlots)
+    {
+      if (slot->state.load(std::memory_order_acquire) != SlotState::Submitted) continue;
+      if (vkGetFenceStatus(device.getDevice(), slot->fence) != VK_SUCCESS) continue;
+
+      // render and main thread may both poll, only one of them gets to hand the slot over
+      auto expected = SlotState::Submitted;
+      if (!slot->state.compare_exchange_strong(expected, SlotState::Encoding, std::memory_order_acq_rel)) continue;
+
+      Slot* encoding = slot.get();
+      mEncoders->submit([this, encoding]() { encode(*encoding); });
+    }
+  }
+
+  void FrameCapture::waitForFreeSlot()
+  {
+    for (;;)
+    {
+      poll();
+      for (const auto& slot : mSlots)
+      {
+        if (slot->state.load(std::memory_order_acquire) == SlotState::Free) return;
+      }
+      // slots come back from the GPU or an encoder within a frame or so
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  void FrameCapture::flush()
+  {
+    // anything still recorded never reached the queue
+    discard();
+    for (auto& slot : mSlots)
+    {
+      if (slot->state.load(std::memory_order_acquire) == SlotState::Submitted)
+      {
+        vkWaitForFences(device.getDevice(), 1, &slot->fence, VK_TRUE, UINT64_MAX);
+      }
+    }
+    poll();
+    for (const auto& slot : mSlots)
+    {
+      while (slot->state.load(std::memory_order_acquire) != SlotState::Free)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+  }
+
+  void FrameCapture::encode(Slot& slot)
+  {
+    TRACE_SCOPE("encode capture");
+    const uint64_t start = nowNs();
+    try
+    {
+      std::call_once(mDirectoryCreated, [this]() { std::filesystem::create_directories(mOptions.directory); });
+      slot.buffer->invalidate();
+      const auto path = (std::filesystem::path{ mOptions.directory } / (slot.name + "." + getImageExtension(mOptions.format))).string();
+      mBytes.fetch_add(encodeImage(slot.image, mOptions.format, path), std::memory_order_relaxed);
+      mEncoded.fetch_add(1, std::memory_order_relaxed);
+    }
+    catch (const std::exception& e)
+    {
+      ELOG_EVERY_MS(5000, "Frame capture: {}", e.what());
+      mFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+    mEncodeNs.fetch_add(nowNs() - start, std::memory_order_relaxed);
+    slot.state.store(SlotState::Free, std::memory_order_release);
+  }
+
+  std::string FrameCapture::getFrameName(uint64_t frameNumber)
+  {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06llu", static_cast<unsigned long long>(frameNumber));
+    return name;
+  }
+
+  CaptureStats FrameCapture::takeStats()
+  {
+    CaptureStats stats;
+    stats.captured = mCaptured.exchange(0, std::memory_order_relaxed);
+    stats.encoded = mEncoded.exchange(0, std::memory_order_relaxed);
+    stats.dropped = mDropped.exchange(0, std::memory_order_relaxed);
+    stats.failed = mFailed.exchange(0, std::memory_order_relaxed);
+    stats.bytes = mBytes.exchange(0, std::memory_order_relaxed);
+    stats.encodeMs = nsToMs(mEncodeNs.exchange(0, std::memory_order_relaxed));
+    for (const auto& slot : mSlots)
+    {
+      if (slot->state.load(std::memory_order_relaxed) != SlotState::Free) stats.queueDepth++;
+    }
+    return stats;
+  }
+}
@@ -0,0 +1,76 @@
+#include <render/GpuTimer.h>
+#include <Log.h>
+
+#include <array>
+
+namespace rw
+{
+  GpuTimer::GpuTimer(Device& dev, uint32_t frameCount, uint32_t queueFamily) : device{ dev }, mPending(frameCount, false)
+  {
+    const auto& physicalDevice = device.getCurrentPhysicalDevice();
+    const auto& limits = physicalDevice.getProperties().limits;
+    const auto& queueFamilies = physicalDevice.getQueueFamilyProperties();
+    const uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+    if (validBits == 0 || limits.timestampPeriod <= 0.0f)
+    {
+      WLOG("GPU timestamps are not supported on queue family {}", queueFamily);
+      return;
+    }
+
+    mTimestampPeriodNs = limits.timestampPeriod;
+    mTimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = frameCount * 2;
+    VK_CHECK(vkCreateQueryPool(device.getDevice(), &queryPoolInfo, device.getAllocator(), &mQueryPool), "Failed to create timestamp query pool");
+  }
+
+  GpuTimer::~GpuTimer()
+  {
+    if (mQueryPool != VK_NULL_HANDLE)
+    {
+      vkDestroyQueryPool(device.getDevice(), mQueryPool, device.getAllocator());
+    }
+  }
+
+  void GpuTimer::collect(uint32_t frameIndex)
+  {
+    if (!mPending[frameIndex]) return;
+
+    std::array<uint64_t, 2> timestamps = {};
+    auto result = vkGetQueryPoolResults(device.getDevice(), mQueryPool, frameIndex * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    mPending[frameIndex] = false;
+    if (result != VK_SUCCESS) return;
+
+    const uint64_t ticks = (timestamps[1] - timestamps[0]) & mTimestampMask;
+    mLastFrameMs = static_cast<double>(ticks) * mTimestampPeriodNs / 1.0e6;
+    mBusyMs += mLastFrameMs;
+    ++mSampleCount;
+  }
+
+  void GpuTimer::begin(VkCommandBuffer command, uint32_t frameIndex)
+  {
+    if (!isSupported()) return;
+
+    collect(frameIndex);
+    vkCmdResetQueryPool(command, mQueryPool, frameIndex * 2, 2);
+    vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, frameIndex * 2);
+  }
+
+  void GpuTimer::end(VkCommandBuffer command, uint32_t frameIndex)
+  {
+    if (!isSupported()) return;
+
+    vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, frameIndex * 2 + 1);
+    mPending[frameIndex] = true;
+  }
+
+  double GpuTimer::takeBusyMs()
+  {
+    double busy = mBusyMs;
+    mBusyMs = 0.0;
+    return busy;
+  }
+}
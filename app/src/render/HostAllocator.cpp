@@ -0,0 +1,160 @@
+#include <render/HostAllocator.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace rw
+{
+  namespace
+  {
+    // stored right in front of every allocation handed to the driver
+    struct AllocationHeader
+    {
+      void* block;
+      size_t size;
+      uint32_t scope;
+    };
+  }
+
+  uint64_t HostAllocatorStats::getBytes() const
+  {
+    uint64_t bytes = 0;
+    for (const auto& scope : scopes) bytes += scope.bytes;
+    return bytes;
+  }
+
+  uint64_t HostAllocatorStats::getAllocations() const
+  {
+    uint64_t allocations = 0;
+    for (const auto& scope : scopes) allocations += scope.allocations;
+    return allocations;
+  }
+
+  uint64_t HostAllocatorStats::getTotalAllocations() const
+  {
+    uint64_t allocations = 0;
+    for (const auto& scope : scopes) allocations += scope.totalAllocations;
+    return allocations;
+  }
+
+  uint64_t HostAllocatorStats::getInternalBytes() const
+  {
+    uint64_t bytes = 0;
+    for (const auto& scope : scopes) bytes += scope.internalBytes;
+    return bytes;
+  }
+
+  HostAllocator::HostAllocator()
+  {
+    mCallbacks.pUserData = this;
+    mCallbacks.pfnAllocation = &HostAllocator::allocateCallback;
+    mCallbacks.pfnReallocation = &HostAllocator::reallocateCallback;
+    mCallbacks.pfnFree = &HostAllocator::freeCallback;
+    mCallbacks.pfnInternalAllocation = &HostAllocator::internalAllocationCallback;
+    mCallbacks.pfnInternalFree = &HostAllocator::internalFreeCallback;
+  }
+
+  HostAllocatorStats HostAllocator::getStats() const
+  {
+    HostAllocatorStats stats;
+    for (uint32_t i = 0; i < HostAllocatorStats::SCOPE_COUNT; ++i)
+    {
+      const auto& counters = mScopes[i];
+      auto& scope = stats.scopes[i];
+      scope.bytes = counters.bytes.load(std::memory_order_relaxed);
+      scope.allocations = counters.allocations.load(std::memory_order_relaxed);
+      scope.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+      scope.totalAllocations = counters.totalAllocations.load(std::memory_order_relaxed);
+      scope.internalBytes = counters.internalBytes.load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+  const char* HostAllocator::getScopeName(uint32_t scope)
+  {
+    static const char* names[HostAllocatorStats::SCOPE_COUNT] = { "command", "object", "cache", "device", "instance" };
+    return scope < HostAllocatorStats::SCOPE_COUNT ? names[scope] : "unknown";
+  }
+
+  HostAllocator::Counters& HostAllocator::getCounters(VkSystemAllocationScope scope)
+  {
+    return mScopes[std::min<uint32_t>(static_cast<uint32_t>(scope), HostAllocatorStats::SCOPE_COUNT - 1)];
+  }
+
+  void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+  {
+    if (size == 0) return nullptr;
+
+    // alignment is a power of two, leave room to move the pointer up to it behind the header
+    alignment = std::max(alignment, alignof(AllocationHeader));
+    void* block = std::malloc(size + sizeof(AllocationHeader) + alignment - 1);
+    if (block == nullptr) return nullptr;
+
+    const uintptr_t start = reinterpret_cast<uintptr_t>(block) + sizeof(AllocationHeader);
+    auto* memory = reinterpret_cast<void*>((start + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    auto* header = static_cast<AllocationHeader*>(memory) - 1;
+    header->block = block;
+    header->size = size;
+    header->scope = static_cast<uint32_t>(scope);
+
+    auto& counters = getCounters(scope);
+    const uint64_t bytes = counters.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+    while (bytes > peak && !counters.peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+    {
+    }
+    return memory;
+  }
+
+  void HostAllocator::free(void* memory)
+  {
+    if (memory == nullptr) return;
+
+    const auto* header = static_cast<AllocationHeader*>(memory) - 1;
+    auto& counters = getCounters(static_cast<VkSystemAllocationScope>(header->scope));
+    counters.bytes.fetch_sub(header->size, std::memory_order_relaxed);
+    counters.allocations.fetch_sub(1, std::memory_order_relaxed);
+    std::free(header->block);
+  }
+
+  void* HostAllocator::allocateCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+  {
+    return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+  }
+
+  void* HostAllocator::reallocateCallback(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+  {
+    auto* allocator = static_cast<HostAllocator*>(userData);
+    if (original == nullptr) return allocator->allocate(size, alignment, scope);
+    if (size == 0)
+    {
+      allocator->free(original);
+      return nullptr;
+    }
+
+    // the original stays valid when the new block cannot be allocated
+    void* memory = allocator->allocate(size, alignment, scope);
+    if (memory == nullptr) return nullptr;
+    std::memcpy(memory, original, std::min(size, (static_cast<AllocationHeader*>(original) - 1)->size));
+    allocator->free(original);
+    return memory;
+  }
+
+  void HostAllocator::freeCallback(void* userData, void* memory)
+  {
+    static_cast<HostAllocator*>(userData)->free(memory);
+  }
+
+  void HostAllocator::internalAllocationCallback(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+  {
+    static_cast<HostAllocator*>(userData)->getCounters(scope).internalBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  void HostAllocator::internalFreeCallback(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+  {
+    static_cast<HostAllocator*>(userData)->getCounters(scope).internalBytes.fetch_sub(size, std::memory_order_relaxed);
+  }
+}
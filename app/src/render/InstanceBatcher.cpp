@@ -0,0 +1,100 @@
+#include <render/InstanceBatcher.h>
+#include <core/Clock.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace rw
+{
+  namespace
+  {
+    constexpr uint32_t DEPTH_BUCKETS = { 1u << DrawKey::DEPTH_BITS };
+    // nodes per parallelFor chunk while computing keys
+    constexpr size_t KEY_CHUNK = { 4096 };
+
+    // Perspective views bucket the clip w, the view depth, logarithmically: 128 buckets per
+    // octave from 1/256 on. Orthographic ones (shadow cascades) have w = 1 and bucket their
+    // linear clip z instead.
+    uint32_t depthBucket(const glm::vec4& clip, bool perspective)
+    {
+      float bucket = 0.0f;
+      if (perspective)
+      {
+        if (clip.w <= 0.0f) return 0;
+        bucket = (std::log2(clip.w) + 8.0f) * 128.0f;
+      }
+      else
+      {
+        bucket = clip.z * static_cast<float>(DEPTH_BUCKETS);
+      }
+      return static_cast<uint32_t>(std::clamp(bucket, 0.0f, static_cast<float>(DEPTH_BUCKETS - 1)));
+    }
+  }
+
+  InstanceBatcher::InstanceBatcher(ThreadPool& pool) : mPool{ pool }, mSorter{ pool }
+  {
+  }
+
+  void InstanceBatcher::build(const Scene& scene, const std::vector<uint32_t>& nodeIndices, DrawPass pass, const glm::mat4& viewProjection,
+    std::vector<DrawBatch>& batches, std::vector<InstanceData>& instances)
+  {
+    const auto& nodes = scene.getNodes();
+    const uint64_t start = nowNs();
+    // the projection of an orthographic view leaves w at 1 for every point
+    const bool perspective = viewProjection[0][3] != 0.0f || viewProjection[1][3] != 0.0f || viewProjection[2][3] != 0.0f;
+
+    mSortKeys.resize(nodeIndices.size());
+    mPool.parallelFor(nodeIndices.size(), KEY_CHUNK, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i)
+      {
+        const auto& node = nodes[nodeIndices[i]];
+        const uint32_t depth = depthBucket(viewProjection * glm::vec4(node.worldBounds.center(), 1.0f), perspective);
+        mSortKeys[i] = SortItem{ DrawKey::encode(pass, 0, node.mesh, node.material, depth), nodeIndices[i] };
+      }
+    });
+    mSorter.sort(mSortKeys);
+    mStats.sortMs += nsToMs(nowNs() - start);
+
+    batches.clear();
+    instances.clear();
+    instances.reserve(nodeIndices.size());
+    // ids past the key fields share folded keys and may interleave, so batches split on the real ids
+    for (const auto& item : mSortKeys)
+    {
+      const auto& node = nodes[item.index];
+      if (batches.empty() || batches.back().mesh != node.mesh || batches.back().material != node.material)
+      {
+        batches.push_back(DrawBatch{ node.mesh, node.material, static_cast<uint32_t>(instances.size()), 0u });
+      }
+      batches.back().instanceCount++;
+      instances.push_back(InstanceData{ node.transform, scene.getMaterial(node.material).baseColor });
+    }
+
+    mStats.builds++;
+    mStats.packets += mSortKeys.size();
+    mStats.batches += batches.size();
+    mStats.radixPasses += mSorter.getStats().passes;
+  }
+
+  std::vector<VkVertexInputBindingDescription> InstanceBatcher::getBindingDescriptions()
+  {
+    std::vector<VkVertexInputBindingDescription> bindings(1);
+    bindings[0].binding = INSTANCE_BINDING;
+    bindings[0].stride = sizeof(InstanceData);
+    bindings[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    return bindings;
+  }
+
+  std::vector<VkVertexInputAttributeDescription> InstanceBatcher::getAttributeDescriptions()
+  {
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    // a mat4 attribute occupies four consecutive vec4 locations
+    for (uint32_t column = 0; column < 4; ++column)
+    {
+      attributes.push_back({ 3 + column, INSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(InstanceData, model) + sizeof(glm::vec4) * column) });
+    }
+    attributes.push_back({ 7, INSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(InstanceData, color) });
+    return attributes;
+  }
+}
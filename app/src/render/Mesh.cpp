@@ -0,0 +1,153 @@
+#include <render/Mesh.h>
+#include <Log.h>
+
+#include <cstddef>
+
+namespace rw
+{
+  Mesh::Mesh(Device& dev, const MeshData& data)
+    : Mesh{ dev, static_cast<uint32_t>(data.vertices.size()), static_cast<uint32_t>(data.indices.size()) }
+  {
+    upload(data.vertices.data(), sizeof(Vertex) * mVertexCount, *mVertexBuffer);
+    if (mIndexBuffer) upload(data.indices.data(), sizeof(uint32_t) * mIndexCount, *mIndexBuffer);
+  }
+
+  Mesh::Mesh(Device& dev, uint32_t vertexCount, uint32_t indexCount) : device{ dev }
+  {
+    createVertexBuffer(vertexCount);
+    createIndexBuffer(indexCount);
+  }
+
+  void Mesh::createVertexBuffer(uint32_t vertexCount)
+  {
+    mVertexCount = vertexCount;
+    if (mVertexCount < 3) RT_THROW("Mesh requires at least 3 vertices");
+
+    VkDeviceSize bufferSize = sizeof(Vertex) * mVertexCount;
+    mVertexBuffer = std::make_unique<Buffer>(device, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+  void Mesh::createIndexBuffer(uint32_t indexCount)
+  {
+    mIndexCount = indexCount;
+    if (mIndexCount == 0) return;
+
+    VkDeviceSize bufferSize = sizeof(uint32_t) * mIndexCount;
+    mIndexBuffer = std::make_unique<Buffer>(device, bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+  void Mesh::upload(const void* data, VkDeviceSize size, const Buffer& target)
+  {
+    Buffer staging{ device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    VK_CHECK(staging.map(), "Failed to map mesh staging buffer");
+    staging.writeToBuffer(data, size);
+    device.copyBuffer(staging.getHandler(), target.getHandler(), size);
+  }
+
+  VkDeviceSize Mesh::getUploadSize(const MeshData& data)
+  {
+    return sizeof(Vertex) * data.vertices.size() + sizeof(uint32_t) * data.indices.size();
+  }
+
+  void Mesh::writeUpload(Buffer& staging, VkDeviceSize offset, const MeshData& data)
+  {
+    const VkDeviceSize vertexBytes = sizeof(Vertex) * data.vertices.size();
+    staging.writeToBuffer(data.vertices.data(), vertexBytes, offset);
+    if (!data.indices.empty()) staging.writeToBuffer(data.indices.data(), sizeof(uint32_t) * data.indices.size(), offset + vertexBytes);
+  }
+
+  void Mesh::recordUpload(VkCommandBuffer command, const Buffer& staging, VkDeviceSize offset) const
+  {
+    VkBufferCopy region = {};
+    region.srcOffset = offset;
+    region.size = sizeof(Vertex) * mVertexCount;
+    vkCmdCopyBuffer(command, staging.getHandler(), mVertexBuffer->getHandler(), 1, &region);
+    if (mIndexBuffer)
+    {
+      region.srcOffset = offset + sizeof(Vertex) * mVertexCount;
+      region.size = sizeof(uint32_t) * mIndexCount;
+      vkCmdCopyBuffer(command, staging.getHandler(), mIndexBuffer->getHandler(), 1, &region);
+    }
+  }
+
+  void Mesh::updateRange(const MeshData& data, uint32_t firstVertex, uint32_t vertexCount, uint32_t firstIndex, uint32_t indexCount)
+  {
+    if (data.vertices.size() != mVertexCount || data.indices.size() != mIndexCount) RT_THROW("Mesh update must keep the vertex and index counts");
+    if (firstVertex + vertexCount > mVertexCount || firstIndex + indexCount > mIndexCount) RT_THROW("Mesh update range out of bounds");
+
+    const VkDeviceSize vertexBytes = sizeof(Vertex) * vertexCount;
+    const VkDeviceSize indexBytes = sizeof(uint32_t) * indexCount;
+    if (vertexBytes + indexBytes == 0) return;
+
+    Buffer staging{ device, vertexBytes + indexBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    VK_CHECK(staging.map(), "Failed to map mesh update staging buffer");
+    if (vertexBytes > 0) staging.writeToBuffer(data.vertices.data() + firstVertex, vertexBytes, 0);
+    if (indexBytes > 0) staging.writeToBuffer(data.indices.data() + firstIndex, indexBytes, vertexBytes);
+
+    VkCommandBuffer command = device.beginSingleTimeCommand();
+    if (vertexBytes > 0)
+    {
+      VkBufferCopy region = {};
+      region.srcOffset = 0;
+      region.dstOffset = sizeof(Vertex) * firstVertex;
+      region.size = vertexBytes;
+      vkCmdCopyBuffer(command, staging.getHandler(), mVertexBuffer->getHandler(), 1, &region);
+    }
+    if (indexBytes > 0)
+    {
+      VkBufferCopy region = {};
+      region.srcOffset = vertexBytes;
+      region.dstOffset = sizeof(uint32_t) * firstIndex;
+      region.size = indexBytes;
+      vkCmdCopyBuffer(command, staging.getHandler(), mIndexBuffer->getHandler(), 1, &region);
+    }
+    device.endSingleTimeCommand(command);
+  }
+
+  void Mesh::bind(VkCommandBuffer command) const
+  {
+    VkBuffer buffers[] = { mVertexBuffer->getHandler() };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command, VERTEX_BINDING, 1, buffers, offsets);
+
+    if (mIndexBuffer)
+    {
+      vkCmdBindIndexBuffer(command, mIndexBuffer->getHandler(), 0, VK_INDEX_TYPE_UINT32);
+    }
+  }
+
+  void Mesh::draw(VkCommandBuffer command, uint32_t instanceCount, uint32_t firstInstance) const
+  {
+    if (mIndexBuffer)
+    {
+      vkCmdDrawIndexed(command, mIndexCount, instanceCount, 0, 0, firstInstance);
+    }
+    else
+    {
+      vkCmdDraw(command, mVertexCount, instanceCount, 0, firstInstance);
+    }
+  }
+
+  VkDeviceSize Mesh::getMemorySize() const
+  {
+    return mVertexBuffer->getBufferSize() + (mIndexBuffer ? mIndexBuffer->getBufferSize() : 0);
+  }
+
+  std::vector<VkVertexInputBindingDescription> Mesh::getBindingDescriptions()
+  {
+    std::vector<VkVertexInputBindingDescription> bindings(1);
+    bindings[0].binding = VERTEX_BINDING;
+    bindings[0].stride = sizeof(Vertex);
+    bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return bindings;
+  }
+
+  std::vector<VkVertexInputAttributeDescription> Mesh::getAttributeDescriptions()
+  {
+    return {
+      { 0, VERTEX_BINDING, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) },
+      { 1, VERTEX_BINDING, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) },
+      { 2, VERTEX_BINDING, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) },
+    };
+  }
+}
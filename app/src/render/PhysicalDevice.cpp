@@ -1,6 +1,9 @@
 #include <render/PhysicalDevice.h>
 #include <Log.h>
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 namespace rw {
 PhysicalDevice::PhysicalDevice(VkPhysicalDevice physicalDevice)
@@ -9,11 +12,63 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice physicalDevice)
     vkGetPhysicalDeviceFeatures(physicalDevice, &mFeatures);
     vkGetPhysicalDeviceProperties(physicalDevice, &mProperties);
     vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
-    LOG("GPU: {}", mProperties.deviceName);
-    LOG("\t Vulkan version: {}.{}.{}", VK_VERSION_MAJOR(mProperties.apiVersion), VK_VERSION_MINOR(mProperties.apiVersion), VK_VERSION_PATCH(mProperties.apiVersion));
+    DLOG("GPU: {}", mProperties.deviceName);
+    DLOG("\t Vulkan version: {}.{}.{}", VK_VERSION_MAJOR(mProperties.apiVersion), VK_VERSION_MINOR(mProperties.apiVersion), VK_VERSION_PATCH(mProperties.apiVersion));
     std::uint32_t queueCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, nullptr);
     mQueueFamilyProperties.resize(queueCount);
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueCount, mQueueFamilyProperties.data());
+
+    std::uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    mExtensions.resize(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, mExtensions.data());
+
+    if (mProperties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        VkPhysicalDeviceIDProperties idProperties = {};
+        idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &idProperties;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        char hex[3];
+        for (auto byte : idProperties.deviceUUID)
+        {
+            std::snprintf(hex, sizeof(hex), "%02x", byte);
+            mIdentifier += hex;
+        }
+        mIdentifier += "-" + std::to_string(mProperties.driverVersion);
+
+        if (mFeatures.shaderInt64 && supportsExtension(VK_KHR_SHADER_ATOMIC_INT64_EXTENSION_NAME))
+        {
+            VkPhysicalDeviceShaderAtomicInt64FeaturesKHR atomicFeatures = {};
+            atomicFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES_KHR;
+            VkPhysicalDeviceFeatures2 features2 = {};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &atomicFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+            mBufferInt64Atomics = atomicFeatures.shaderBufferInt64Atomics == VK_TRUE;
+        }
+    }
+}
+
+bool PhysicalDevice::supportsExtension(const char *name) const
+{
+    return std::any_of(mExtensions.begin(), mExtensions.end(), [name](const auto &ext) { return std::strcmp(ext.extensionName, name) == 0; });
+}
+
+VkDeviceSize PhysicalDevice::getDeviceLocalMemorySize() const
+{
+    VkDeviceSize size = 0;
+    for (std::uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i)
+    {
+        if (mMemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            size = std::max(size, mMemoryProperties.memoryHeaps[i].size);
+        }
+    }
+    return size;
 }
 }
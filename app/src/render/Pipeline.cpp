@@ -0,0 +1,169 @@
+#include <render/Pipeline.h>
+#include <Log.h>
+
+#include <fstream>
+
+#ifndef RW_SHADER_DIR
+#define RW_SHADER_DIR "shaders"
+#endif
+
+namespace rw
+{
+  Pipeline::Pipeline(Device& dev, const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo) : device{ dev }
+  {
+    createGraphicsPipeline(readFile(vertPath), readFile(fragPath), configInfo);
+  }
+
+  Pipeline::Pipeline(Device& dev, const std::vector<char>& vertCode, const std::vector<char>& fragCode, const PipelineConfigInfo& configInfo) : device{ dev }
+  {
+    createGraphicsPipeline(vertCode, fragCode, configInfo);
+  }
+
+  Pipeline::~Pipeline()
+  {
+    vkDestroyShaderModule(device.getDevice(), mVertShaderModule, device.getAllocator());
+    vkDestroyShaderModule(device.getDevice(), mFragShaderModule, device.getAllocator());
+    vkDestroyPipeline(device.getDevice(), mGraphicsPipeline, device.getAllocator());
+  }
+
+  std::string Pipeline::shaderPath(const std::string& name)
+  {
+    return std::string(RW_SHADER_DIR) + "/" + name + ".spv";
+  }
+
+  std::vector<char> Pipeline::readFile(const std::string& path)
+  {
+    std::ifstream file{ path, std::ios::ate | std::ios::binary };
+    if (!file.is_open())
+    {
+      RT_THROW("Failed to open file: " + path);
+    }
+
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    std::vector<char> buffer(fileSize);
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+    return buffer;
+  }
+
+  void Pipeline::createGraphicsPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode, const PipelineConfigInfo& configInfo)
+  {
+    if (configInfo.pipelineLayout == VK_NULL_HANDLE) RT_THROW("Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
+    if (configInfo.renderPass == VK_NULL_HANDLE) RT_THROW("Cannot create graphics pipeline: no renderPass provided in configInfo");
+
+    mVertShaderModule = createShaderModule(vertCode);
+    mFragShaderModule = createShaderModule(fragCode);
+
+    VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = mVertShaderModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = mFragShaderModule;
+    shaderStages[1].pName = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(configInfo.attributeDescriptions.size());
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions = configInfo.attributeDescriptions.data();
+    vertexInputInfo.pVertexBindingDescriptions = configInfo.bindingDescriptions.data();
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
+    pipelineInfo.pViewportState = &configInfo.viewportInfo;
+    pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
+    pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+    pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+    pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
+    pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+
+    pipelineInfo.layout = configInfo.pipelineLayout;
+    pipelineInfo.renderPass = configInfo.renderPass;
+    pipelineInfo.subpass = configInfo.subpass;
+
+    pipelineInfo.basePipelineIndex = -1;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    VK_CHECK(vkCreateGraphicsPipelines(device.getDevice(), configInfo.pipelineCache, 1, &pipelineInfo, device.getAllocator(), &mGraphicsPipeline), "Failed to create graphics pipeline");
+  }
+
+  VkShaderModule Pipeline::createShaderModule(const std::vector<char>& code)
+  {
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule shaderModule;
+    VK_CHECK(vkCreateShaderModule(device.getDevice(), &createInfo, device.getAllocator(), &shaderModule), "Failed to create shader module");
+    return shaderModule;
+  }
+
+  void Pipeline::bind(VkCommandBuffer command)
+  {
+    vkCmdBindPipeline(command, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+  }
+
+  void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
+  {
+    configInfo.inputAssemblyInfo = {};
+    configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    configInfo.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+
+    configInfo.viewportInfo = {};
+    configInfo.viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    configInfo.viewportInfo.viewportCount = 1;
+    configInfo.viewportInfo.pViewports = nullptr;
+    configInfo.viewportInfo.scissorCount = 1;
+    configInfo.viewportInfo.pScissors = nullptr;
+
+    configInfo.rasterizationInfo = {};
+    configInfo.rasterizationInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    configInfo.rasterizationInfo.depthClampEnable = VK_FALSE;
+    configInfo.rasterizationInfo.rasterizerDiscardEnable = VK_FALSE;
+    configInfo.rasterizationInfo.polygonMode = VK_POLYGON_MODE_FILL;
+    configInfo.rasterizationInfo.lineWidth = 1.0f;
+    configInfo.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+    configInfo.rasterizationInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    configInfo.rasterizationInfo.depthBiasEnable = VK_FALSE;
+
+    configInfo.multisampleInfo = {};
+    configInfo.multisampleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    configInfo.multisampleInfo.sampleShadingEnable = VK_FALSE;
+    configInfo.multisampleInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    configInfo.multisampleInfo.minSampleShading = 1.0f;
+
+    configInfo.colorBlendAttachment = {};
+    configInfo.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    configInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+
+    configInfo.colorBlendInfo = {};
+    configInfo.colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    configInfo.colorBlendInfo.logicOpEnable = VK_FALSE;
+    configInfo.colorBlendInfo.logicOp = VK_LOGIC_OP_COPY;
+    configInfo.colorBlendInfo.attachmentCount = 1;
+    configInfo.colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+
+    configInfo.depthStencilInfo = {};
+    configInfo.depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    configInfo.depthStencilInfo.depthTestEnable = VK_TRUE;
+    configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
+    configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+    configInfo.depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
+    configInfo.depthStencilInfo.stencilTestEnable = VK_FALSE;
+
+    configInfo.dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    configInfo.dynamicStateInfo = {};
+    configInfo.dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+    configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+  }
+}
@@ -0,0 +1,86 @@
+#include <render/PipelineCache.h>
+#include <Log.h>
+
+#include <cstring>
+#include <fstream>
+
+#ifndef RW_SHADER_DIR
+#define RW_SHADER_DIR "shaders"
+#endif
+
+namespace rw
+{
+  PipelineCache::PipelineCache(Device& dev, const std::vector<char>& initialData) : device{ dev }
+  {
+    const bool useData = !initialData.empty() && isCompatible(initialData);
+    if (!initialData.empty() && !useData)
+    {
+      LOG("Pipeline cache on disk was created by another device or driver, starting empty");
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = useData ? initialData.size() : 0;
+    cacheInfo.pInitialData = useData ? initialData.data() : nullptr;
+    VK_CHECK(vkCreatePipelineCache(device.getDevice(), &cacheInfo, device.getAllocator(), &mCache), "Failed to create pipeline cache");
+  }
+
+  PipelineCache::~PipelineCache()
+  {
+    vkDestroyPipelineCache(device.getDevice(), mCache, device.getAllocator());
+  }
+
+  std::string PipelineCache::defaultPath()
+  {
+    return std::string(RW_SHADER_DIR) + "/pipeline_cache.bin";
+  }
+
+  std::vector<char> PipelineCache::readFromDisk(const std::string& path)
+  {
+    std::ifstream file{ path, std::ios::ate | std::ios::binary };
+    if (!file.is_open()) return {};
+
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+    return data;
+  }
+
+  void PipelineCache::save(const std::string& path) const
+  {
+    size_t size = 0;
+    VK_CHECK(vkGetPipelineCacheData(device.getDevice(), mCache, &size, nullptr), "Failed to query pipeline cache size");
+    std::vector<char> data(size);
+    VK_CHECK(vkGetPipelineCacheData(device.getDevice(), mCache, &size, data.data()), "Failed to read pipeline cache");
+
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    if (!file.is_open())
+    {
+      WLOG("Failed to write pipeline cache {}", path);
+      return;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(size));
+  }
+
+  bool PipelineCache::isCompatible(const std::vector<char>& data) const
+  {
+    // header layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+    struct Header
+    {
+      uint32_t length;
+      uint32_t version;
+      uint32_t vendorID;
+      uint32_t deviceID;
+      uint8_t uuid[VK_UUID_SIZE];
+    };
+    if (data.size() < sizeof(Header)) return false;
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(Header));
+    const auto& props = device.getCurrentPhysicalDevice().getProperties();
+    return header.version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+      header.vendorID == props.vendorID &&
+      header.deviceID == props.deviceID &&
+      std::memcmp(header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  }
+}
@@ -0,0 +1,293 @@
+#include <render/PointRasterizer.h>
+#include <Log.h>
+
+#include <algorithm>
+
+namespace rw
+{
+  namespace
+  {
+    // host visible staging is reused for every slice of a large scan
+    constexpr VkDeviceSize UPLOAD_SLICE = { 64ull << 20 };
+
+    void computeBarrier(VkCommandBuffer command, VkBuffer buffer, VkAccessFlags srcAccess, VkPipelineStageFlags srcStage)
+    {
+      VkBufferMemoryBarrier barrier = {};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = srcAccess;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.buffer = buffer;
+      barrier.offset = 0;
+      barrier.size = VK_WHOLE_SIZE;
+      vkCmdPipelineBarrier(command, srcStage, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+  }
+
+  PointRasterizer::PointRasterizer(Device& dev, AsyncCompute& compute, VkRenderPass renderPass, ShaderCache& shaders, VkPipelineCache pipelineCache)
+    : device{ dev }, mCompute{ compute }, mRenderPass{ renderPass }, mShaders{ shaders }, mPipelineCache{ pipelineCache },
+    mInt64Atomics{ dev.hasBufferInt64Atomics() }
+  {
+    createDescriptors();
+    mPassId = mCompute.addPass([this](VkCommandBuffer command, int frameIndex) { return record(command, frameIndex); });
+  }
+
+  PointRasterizer::~PointRasterizer()
+  {
+    mCompute.removePass(mPassId);
+    vkDeviceWaitIdle(device.getDevice());
+    mRasterPipelines.clear();
+    mDrawPipeline.reset();
+    vkDestroyPipelineLayout(device.getDevice(), mDrawLayout, device.getAllocator());
+    vkDestroyPipelineLayout(device.getDevice(), mComputeLayout, device.getAllocator());
+    vkDestroyDescriptorPool(device.getDevice(), mDescriptorPool, device.getAllocator());
+    vkDestroyDescriptorSetLayout(device.getDevice(), mDrawSetLayout, device.getAllocator());
+    vkDestroyDescriptorSetLayout(device.getDevice(), mComputeSetLayout, device.getAllocator());
+  }
+
+  uint64_t PointRasterizer::getMaxPoints(const Device& device)
+  {
+    return device.getCurrentPhysicalDevice().getDeviceLocalMemorySize() / 4 / sizeof(PointVertex);
+  }
+
+  void PointRasterizer::createDescriptors()
+  {
+    // points, batches and the frame's target for compute; only the target for the scene pass
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CHECK(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mComputeSetLayout), "Failed to create point descriptor set layout");
+
+    VkDescriptorSetLayoutBinding drawBinding = bindings[0];
+    drawBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &drawBinding;
+    VK_CHECK(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mDrawSetLayout), "Failed to create point descriptor set layout");
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>((bindings.size() + 1) * mFrames.size());
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(2 * mFrames.size());
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK(vkCreateDescriptorPool(device.getDevice(), &poolInfo, device.getAllocator(), &mDescriptorPool), "Failed to create point descriptor pool");
+
+    std::array<VkDescriptorSetLayout, 2 * SwapChain::MAX_FRAMES_IN_FLIGHT> layouts;
+    for (size_t i = 0; i < layouts.size(); ++i) layouts[i] = i % 2 == 0 ? mComputeSetLayout : mDrawSetLayout;
+    std::array<VkDescriptorSet, 2 * SwapChain::MAX_FRAMES_IN_FLIGHT> sets = {};
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mDescriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    allocInfo.pSetLayouts = layouts.data();
+    VK_CHECK(vkAllocateDescriptorSets(device.getDevice(), &allocInfo, sets.data()), "Failed to allocate point descriptor sets");
+    for (size_t i = 0; i < mFrames.size(); ++i)
+    {
+      mFrames[i].computeSet = sets[2 * i];
+      mFrames[i].drawSet = sets[2 * i + 1];
+    }
+  }
+
+  void PointRasterizer::createPipelines()
+  {
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(Dispatch);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &mComputeSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mComputeLayout), "Failed to create point pipeline layout");
+
+    if (mInt64Atomics)
+    {
+      mRasterPipelines.push_back(std::make_unique<ComputePipeline>(device, mShaders.get("points64.comp"), mComputeLayout, mPipelineCache));
+    }
+    else
+    {
+      mRasterPipelines.push_back(std::make_unique<ComputePipeline>(device, mShaders.get("points_depth.comp"), mComputeLayout, mPipelineCache));
+      mRasterPipelines.push_back(std::make_unique<ComputePipeline>(device, mShaders.get("points_color.comp"), mComputeLayout, mPipelineCache));
+    }
+
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.size = sizeof(glm::uvec4);
+    layoutInfo.pSetLayouts = &mDrawSetLayout;
+    VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mDrawLayout), "Failed to create point pipeline layout");
+
+    // full screen triangle writing the depth of the points, so they are tested against the meshes
+    PipelineConfigInfo config;
+    Pipeline::defaultPipelineConfigInfo(config);
+    config.renderPass = mRenderPass;
+    config.pipelineLayout = mDrawLayout;
+    config.pipelineCache = mPipelineCache;
+    mDrawPipeline = std::make_unique<Pipeline>(device, mShaders.get("upsample.vert"), mShaders.get("points.frag"), config);
+  }
+
+  void PointRasterizer::upload(const PointCloud& cloud)
+  {
+    vkDeviceWaitIdle(device.getDevice());
+    mPointBuffer.reset();
+    mChunks.clear();
+    for (auto& frame : mFrames)
+    {
+      frame.batchRanges.clear();
+      frame.boundBuffers = {};
+    }
+    if (cloud.isEmpty()) return;
+    if (mRasterPipelines.empty()) createPipelines();
+
+    const auto& points = cloud.getPoints();
+    const VkDeviceSize bytes = sizeof(PointVertex) * points.size();
+    // copied on the graphics queue, read on the compute queue
+    mPointBuffer = std::make_unique<Buffer>(device, bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, true);
+
+    const VkDeviceSize slice = std::min(bytes, UPLOAD_SLICE);
+    Buffer staging{ device, slice, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    VK_CHECK(staging.map(), "Failed to map point staging buffer");
+    const auto* data = reinterpret_cast<const char*>(points.data());
+    for (VkDeviceSize offset = 0; offset < bytes; offset += slice)
+    {
+      VkBufferCopy region = {};
+      region.srcOffset = 0;
+      region.dstOffset = offset;
+      region.size = std::min(slice, bytes - offset);
+      staging.writeToBuffer(data + offset, region.size);
+
+      VkCommandBuffer command = device.beginSingleTimeCommand();
+      vkCmdCopyBuffer(command, staging.getHandler(), mPointBuffer->getHandler(), 1, &region);
+      device.endSingleTimeCommand(command);
+    }
+    mChunks = cloud.getChunks();
+
+    LOG("Point upload: {} point(s) in {} chunk(s), {} MiB, {}", points.size(), mChunks.size(), bytes >> 20,
+      mInt64Atomics ? "64-bit atomics" : "separate depth and color passes");
+  }
+
+  void PointRasterizer::prepare(const FrameSnapshot& snapshot, int frameIndex, VkExtent2D extent)
+  {
+    auto& frame = mFrames[frameIndex];
+    frame.batchRanges.clear();
+    frame.pointCount = 0;
+    if (snapshot.pointDraws.empty() || !mPointBuffer || extent.width == 0 || extent.height == 0) return;
+
+    for (const auto& draw : snapshot.pointDraws)
+    {
+      if (draw.chunk >= mChunks.size()) continue;
+      const auto& chunk = mChunks[draw.chunk];
+      const uint32_t count = std::min(draw.count, chunk.pointCount);
+      for (uint32_t offset = 0; offset < count; offset += BATCH_SIZE)
+      {
+        frame.batchRanges.emplace_back(chunk.firstPoint + offset, std::min(BATCH_SIZE, count - offset));
+      }
+      frame.pointCount += count;
+    }
+    if (frame.batchRanges.empty()) return;
+
+    // the batch list grows by half again, like the instance buffers; the target follows the scene extent
+    VkDeviceSize batchBytes = sizeof(glm::uvec2) * frame.batchRanges.size();
+    if (!frame.batches || frame.batches->getBufferSize() < batchBytes)
+    {
+      VkDeviceSize bufferSize = std::max<VkDeviceSize>(batchBytes + batchBytes / 2, sizeof(glm::uvec2) * 1024);
+      frame.batches = std::make_unique<Buffer>(device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      VK_CHECK(frame.batches->map(), "Failed to map point batch buffer");
+    }
+    frame.batches->writeToBuffer(frame.batchRanges.data(), batchBytes);
+
+    VkDeviceSize targetBytes = sizeof(glm::uvec2) * extent.width * extent.height;
+    if (!frame.target || frame.target->getBufferSize() < targetBytes)
+    {
+      frame.target = std::make_unique<Buffer>(device, targetBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, true);
+    }
+
+    frame.dispatch = Dispatch{ snapshot.viewProjection, glm::uvec4(extent.width, extent.height, 0, 0) };
+    updateDescriptorSets(frame);
+  }
+
+  void PointRasterizer::updateDescriptorSets(FrameResources& frame)
+  {
+    std::array<VkBuffer, 3> buffers = { mPointBuffer->getHandler(), frame.batches->getHandler(), frame.target->getHandler() };
+    if (buffers == frame.boundBuffers) return;
+
+    // the frame fence has signaled by now, so the sets are not in use by the GPU
+    std::array<VkDescriptorBufferInfo, 3> infos = {};
+    std::array<VkWriteDescriptorSet, 4> writes = {};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+      const uint32_t buffer = std::min(i, 2u);
+      infos[buffer].buffer = buffers[buffer];
+      infos[buffer].offset = 0;
+      infos[buffer].range = VK_WHOLE_SIZE;
+
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = i < 3 ? frame.computeSet : frame.drawSet;
+      writes[i].dstBinding = i < 3 ? i : 0;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[i].pBufferInfo = &infos[buffer];
+    }
+    vkUpdateDescriptorSets(device.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    frame.boundBuffers = buffers;
+  }
+
+  bool PointRasterizer::record(VkCommandBuffer command, int frameIndex)
+  {
+    auto& frame = mFrames[frameIndex];
+    if (frame.batchRanges.empty()) return false;
+
+    // all bits set is farther than any depth, and no color
+    const VkBuffer target = frame.target->getHandler();
+    vkCmdFillBuffer(command, target, 0, sizeof(glm::uvec2) * frame.dispatch.target.x * frame.dispatch.target.y, 0xffffffffu);
+    computeBarrier(command, target, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_COMPUTE, mComputeLayout, 0, 1, &frame.computeSet, 0, nullptr);
+    const auto batchCount = static_cast<uint32_t>(frame.batchRanges.size());
+    const uint32_t maxGroups = device.getCurrentPhysicalDevice().getProperties().limits.maxComputeWorkGroupCount[0];
+    for (size_t pass = 0; pass < mRasterPipelines.size(); ++pass)
+    {
+      // the color pass of the fallback compares against the final depth of every pixel
+      if (pass > 0) computeBarrier(command, target, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+      mRasterPipelines[pass]->bind(command);
+      for (uint32_t first = 0; first < batchCount; first += maxGroups)
+      {
+        frame.dispatch.target.z = first;
+        vkCmdPushConstants(command, mComputeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Dispatch), &frame.dispatch);
+        vkCmdDispatch(command, std::min(maxGroups, batchCount - first), 1, 1);
+      }
+    }
+    // the finished semaphore of AsyncCompute makes the writes visible to the scene pass
+    return true;
+  }
+
+  void PointRasterizer::draw(VkCommandBuffer command, int frameIndex)
+  {
+    const auto& frame = mFrames[frameIndex];
+    if (frame.batchRanges.empty()) return;
+
+    mDrawPipeline->bind(command);
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, mDrawLayout, 0, 1, &frame.drawSet, 0, nullptr);
+    vkCmdPushConstants(command, mDrawLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(glm::uvec4), &frame.dispatch.target);
+    vkCmdDraw(command, 3, 1, 0, 0);
+  }
+}
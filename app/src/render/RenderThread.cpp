@@ -0,0 +1,205 @@
+#include <render/RenderThread.h>
+#include <core/AllocationCounters.h>
+#include <core/Clock.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+namespace rw
+{
+  RenderThread::RenderThread(Renderer& renderer, SceneRenderer& sceneRenderer, FrameCapture* capture) : mRenderer{ renderer },
+    mSceneRenderer{ sceneRenderer }, mCapture{ capture }
+  {
+  }
+
+  RenderThread::~RenderThread()
+  {
+    stop();
+  }
+
+  void RenderThread::start()
+  {
+    if (mRunning.exchange(true)) return;
+    mThread = std::thread([this]() { run(); });
+  }
+
+  void RenderThread::stop()
+  {
+    if (!mRunning.exchange(false)) return;
+
+    // bump the sequence so a render thread waiting for a snapshot wakes up and sees the stop
+    mPublishedSequence.fetch_add(1, std::memory_order_release);
+    mPublishedSequence.notify_all();
+    if (mThread.joinable())
+    {
+      mThread.join();
+    }
+  }
+
+  uint64_t RenderThread::publishSnapshot()
+  {
+    const uint64_t sequence = mNextSequence++;
+    mSnapshots.getWriteBuffer().sequence = sequence;
+    mSnapshots.publish();
+    mPublishedSequence.store(sequence, std::memory_order_release);
+    mPublishedSequence.notify_one();
+    return sequence;
+  }
+
+  void RenderThread::rethrowIfFailed()
+  {
+    if (mFailed.load(std::memory_order_acquire) && mException)
+    {
+      auto exception = mException;
+      mException = nullptr;
+      std::rethrow_exception(exception);
+    }
+  }
+
+  RenderThreadStats RenderThread::takeStats()
+  {
+    std::lock_guard<std::mutex> lock{ mStatsMutex };
+    RenderThreadStats stats = mStats;
+    mStats.inputLatency = {};
+    mStats.framesPresented = 0;
+    mStats.gpuBusyMs = 0.0;
+    mStats.computeBusyMs = 0.0;
+    mStats.shadowCascadesDrawn = 0;
+    mStats.shadowCascadesReused = 0;
+    mStats.fragmentFrames = 0;
+    mStats.fragments = {};
+    mStats.pointsDrawn = 0;
+    mStats.staticReused = 0;
+    mStats.staticRecorded = 0;
+    mStats.staticSavedMs = 0.0;
+    mResetStats = true;
+    return stats;
+  }
+
+  void RenderThread::run()
+  {
+    Tracer::get().setThreadName("render");
+    AllocationScope allocations{ AllocationTag::Render };
+    try
+    {
+      uint64_t seen = 0;
+      while (mRunning.load(std::memory_order_acquire))
+      {
+        // sleep until the simulation thread publishes something newer than what we drew
+        mPublishedSequence.wait(seen, std::memory_order_acquire);
+        seen = mPublishedSequence.load(std::memory_order_acquire);
+        if (!mRunning.load(std::memory_order_acquire)) break;
+
+        if (!mSnapshots.fetch()) continue;
+
+        const FrameSnapshot& snapshot = mSnapshots.getReadBuffer();
+        mConsumedSequence.store(snapshot.sequence, std::memory_order_release);
+        renderSnapshot(snapshot);
+      }
+    }
+    catch (std::exception& e)
+    {
+      ELOG("Render thread: {}", e.what());
+      mException = std::current_exception();
+      mFailed.store(true, std::memory_order_release);
+    }
+  }
+
+  void RenderThread::renderSnapshot(const FrameSnapshot& snapshot)
+  {
+    // the same input may be carried by several snapshots until one of them is consumed
+    if (snapshot.inputTimestamp != 0 && snapshot.inputTimestamp != mLastInputTimestamp)
+    {
+      mLatency.onInputConsumed(snapshot.inputTimestamp);
+      mLastInputTimestamp = snapshot.inputTimestamp;
+    }
+
+    TRACE_SCOPE("render frame");
+    const uint64_t frameStart = nowNs();
+    if (mCapture != nullptr)
+    {
+      mCapture->poll();
+    }
+    VkCommandBuffer command = VK_NULL_HANDLE;
+    {
+      TRACE_SCOPE("begin frame");
+      command = mRenderer.beginFrame();
+    }
+    if (!command)
+    {
+      mRedrawRequested.store(true, std::memory_order_release);
+      return;
+    }
+
+    const int frameIndex = mRenderer.getFrameIndex();
+    {
+      TRACE_SCOPE("prepare");
+      mSceneRenderer.prepare(snapshot, frameIndex, mRenderer.getSceneExtent(), mRenderer.getFrameArena());
+      mAppliedGeometry.store(mSceneRenderer.getGeometryGeneration(), std::memory_order_release);
+      mRenderer.submitCompute();
+    }
+    mSceneRenderer.recordUploads(command, frameIndex);
+    mSceneRenderer.drawShadows(command, snapshot, frameIndex);
+    mSceneRenderer.drawVisibility(command, snapshot, frameIndex, mRenderer.getExtent(), mRenderer.getSceneExtent());
+    mRenderer.beginSceneRenderPass(command, mSceneRenderer.getSceneContents(snapshot));
+    mSceneRenderer.draw(command, snapshot, frameIndex, mRenderer.getSceneRenderPass());
+    mRenderer.endSceneRenderPass(command);
+    mRenderer.endSwapChainRenderPass(command);
+    if (snapshot.capture && mCapture != nullptr)
+    {
+      mRenderer.captureFrame(*mCapture, FrameCapture::getFrameName(snapshot.sequence));
+    }
+    {
+      TRACE_SCOPE("end frame");
+      mRenderer.endFrame();
+    }
+
+    const uint64_t presented = nowNs();
+    if (mFirstPresent.load(std::memory_order_relaxed) == 0)
+    {
+      mFirstPresent.store(presented, std::memory_order_release);
+    }
+
+    std::lock_guard<std::mutex> lock{ mStatsMutex };
+    auto* resolution = mRenderer.getResolutionController();
+    if (mResetStats)
+    {
+      mLatency.resetStats();
+      if (resolution != nullptr) resolution->resetStats();
+      mResetStats = false;
+    }
+    mLatency.onPresent(presented);
+    mStats.inputLatency = mLatency.getStats();
+    mStats.scene = mSceneRenderer.getStats();
+    mStats.framesPresented++;
+    mStats.shadowCascadesDrawn += mStats.scene.shadowCascadesDrawn;
+    mStats.shadowCascadesReused += mStats.scene.shadowCascadesReused;
+    mStats.pointsDrawn += mStats.scene.points;
+    if (mStats.scene.staticCommands)
+    {
+      if (mStats.scene.staticRecorded)
+      {
+        mStats.staticRecorded++;
+      }
+      else
+      {
+        mStats.staticReused++;
+        mStats.staticSavedMs += mStats.scene.staticRecordMs;
+      }
+    }
+    if (mStats.scene.fragmentSamples != mFragmentSamples)
+    {
+      mFragmentSamples = mStats.scene.fragmentSamples;
+      mStats.fragmentFrames++;
+      mStats.fragments.prepass += mStats.scene.fragments.prepass;
+      mStats.fragments.shading += mStats.scene.fragments.shading;
+      mStats.fragments.pixels += mStats.scene.fragments.pixels;
+    }
+    mStats.cpuFrameMs = nsToMs(presented - frameStart);
+    mStats.gpuFrameMs = mRenderer.getGpuTimer().getLastFrameMs();
+    mStats.gpuBusyMs += mRenderer.getGpuTimer().takeBusyMs();
+    mStats.computeBusyMs += mRenderer.getAsyncCompute().getGpuTimer().takeBusyMs();
+    if (resolution != nullptr) mStats.resolution = resolution->getStats();
+    mStats.sceneExtent = mRenderer.getSceneExtent();
+    mStats.frameArenas = mRenderer.getFrameArenaStats();
+  }
+}
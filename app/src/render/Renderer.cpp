@@ -0,0 +1,253 @@
+#include <render/Renderer.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <array>
+
+namespace rw
+{
+  namespace
+  {
+    constexpr VkClearColorValue CLEAR_COLOR = { { 0.12f, 0.12f, 0.14f, 1.0f } };
+  }
+
+  Renderer::Renderer(Window& window, Device& dev) : mWindow{ window }, device{ dev }
+  {
+    if (!recreateSwapChain()) RT_THROW("Cannot create swap chain for an empty window");
+    createCommandBuffers();
+    mGpuTimer = std::make_unique<GpuTimer>(device, SwapChain::MAX_FRAMES_IN_FLIGHT, device.findQueueFamilies().graphicsFamily.value());
+    mAsyncCompute = std::make_unique<AsyncCompute>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+  }
+
+  Renderer::~Renderer()
+  {
+    mAsyncCompute.reset();
+    mScaledTarget.reset();
+    freeCommandBuffers();
+  }
+
+  bool Renderer::recreateSwapChain()
+  {
+    auto extent = mWindow.size();
+    if (extent.x == 0 || extent.y == 0)
+    {
+      // minimized window, try again on the next frame
+      mNeedsRecreate = true;
+      return false;
+    }
+    mNeedsRecreate = false;
+    vkDeviceWaitIdle(device.getDevice());
+
+    VkExtent2D resolution = { static_cast<uint32_t>(extent.x), static_cast<uint32_t>(extent.y) };
+    if (mSwapChain == nullptr)
+    {
+      mSwapChain = std::make_shared<SwapChain>(device, resolution);
+    }
+    else
+    {
+      std::shared_ptr<SwapChain> oldSwapChain = std::move(mSwapChain);
+      mSwapChain = std::make_shared<SwapChain>(device, resolution, oldSwapChain);
+      if (!oldSwapChain->compareSwapFormats(*mSwapChain))
+      {
+        RT_THROW("Swap chain image or depth format has changed");
+      }
+    }
+    if (mScaledTarget) mScaledTarget->resize(resolution);
+    return true;
+  }
+
+  void Renderer::createCommandBuffers()
+  {
+    mCommandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = device.getCommandPool();
+    allocInfo.commandBufferCount = static_cast<uint32_t>(mCommandBuffers.size());
+
+    VK_CHECK(vkAllocateCommandBuffers(device.getDevice(), &allocInfo, mCommandBuffers.data()), "Failed to allocate command buffers");
+  }
+
+  void Renderer::freeCommandBuffers()
+  {
+    vkFreeCommandBuffers(device.getDevice(), device.getCommandPool(), static_cast<uint32_t>(mCommandBuffers.size()), mCommandBuffers.data());
+    mCommandBuffers.clear();
+  }
+
+  VkCommandBuffer Renderer::beginFrame()
+  {
+    if (mIsFrameStarted) RT_THROW("Can't call beginFrame while already in progress");
+    if (mNeedsRecreate && !recreateSwapChain()) return VK_NULL_HANDLE;
+
+    auto result = mSwapChain->acquireNextImage(&mCurrentImageIdx);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+      recreateSwapChain();
+      return VK_NULL_HANDLE;
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    {
+      RT_THROW("Failed to acquire swap chain image");
+    }
+
+    mIsFrameStarted = true;
+    // acquireNextImage() waited for the fence of this frame slot
+    mFrameArenas[mCurrentFrameIdx].reset();
+
+    auto command = getCurrentCommandBuffer();
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VK_CHECK(vkBeginCommandBuffer(command, &beginInfo), "Failed to begin recording command buffer");
+    mGpuTimer->begin(command, mCurrentFrameIdx);
+    if (mResolution && mGpuTimer->getSampleCount() != mGpuSamples)
+    {
+      mGpuSamples = mGpuTimer->getSampleCount();
+      mResolution->update(mGpuTimer->getLastFrameMs());
+    }
+    return command;
+  }
+
+  ArenaStats Renderer::getFrameArenaStats() const
+  {
+    ArenaStats stats;
+    for (const auto& arena : mFrameArenas)
+    {
+      const auto frame = arena.getStats();
+      stats.used = std::max(stats.used, frame.used);
+      stats.capacity += frame.capacity;
+      stats.blockAllocations += frame.blockAllocations;
+    }
+    return stats;
+  }
+
+  void Renderer::submitCompute()
+  {
+    if (!mIsFrameStarted) RT_THROW("Can't call submitCompute if frame is not in progress");
+    if (mComputeSemaphore != VK_NULL_HANDLE) RT_THROW("Compute work was already submitted for this frame");
+    mComputeSemaphore = mAsyncCompute->submit(mCurrentFrameIdx);
+  }
+
+  void Renderer::endFrame()
+  {
+    if (!mIsFrameStarted) RT_THROW("Can't call endFrame while frame is not in progress");
+
+    auto command = getCurrentCommandBuffer();
+    mGpuTimer->end(command, mCurrentFrameIdx);
+    VK_CHECK(vkEndCommandBuffer(command), "Failed to record command buffer");
+
+    // compute results are only consumed by the vertex stages, earlier work does not wait
+    auto result = mSwapChain->submitCommandBuffer(&command, &mCurrentImageIdx, mComputeSemaphore,
+      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+    mComputeSemaphore = VK_NULL_HANDLE;
+    if (mCapture != nullptr)
+    {
+      mCapture->submit(device.getGraphicsQueue());
+      mCapture = nullptr;
+    }
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || mWindow.wasResized())
+    {
+      mWindow.resetSizeState();
+      recreateSwapChain();
+    }
+    else if (result != VK_SUCCESS)
+    {
+      RT_THROW("Failed to present swap chain image");
+    }
+
+    mIsFrameStarted = false;
+    mCurrentFrameIdx = (mCurrentFrameIdx + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+  }
+
+  void Renderer::beginSwapChainRenderPass(VkCommandBuffer command, VkSubpassContents contents)
+  {
+    if (!mIsFrameStarted) RT_THROW("Can't call beginSwapChainRenderPass if frame is not in progress");
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = mSwapChain->getRenderPass();
+    renderPassInfo.framebuffer = mSwapChain->getFrameBuffer(mCurrentImageIdx);
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = mSwapChain->getSwapChainResolution();
+
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color = CLEAR_COLOR;
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(command, &renderPassInfo, contents);
+    if (contents != VK_SUBPASS_CONTENTS_INLINE) return;
+
+    VkExtent2D extent = mSwapChain->getSwapChainResolution();
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{ { 0, 0 }, extent };
+    vkCmdSetViewport(command, 0, 1, &viewport);
+    vkCmdSetScissor(command, 0, 1, &scissor);
+  }
+
+  void Renderer::endSwapChainRenderPass(VkCommandBuffer command)
+  {
+    if (!mIsFrameStarted) RT_THROW("Can't call endSwapChainRenderPass if frame is not in progress");
+    vkCmdEndRenderPass(command);
+  }
+
+  void Renderer::enableDynamicResolution(const ResolutionOptions& options, ShaderCache& shaders, VkPipelineCache pipelineCache)
+  {
+    if (!mGpuTimer->isSupported())
+    {
+      WLOG("Dynamic resolution needs GPU timestamps, which this queue does not support");
+      return;
+    }
+    mScaledTarget = std::make_unique<ScaledRenderTarget>(device, mSwapChain->getImageFormat(), mSwapChain->findDepthFormat(),
+      mSwapChain->getRenderPass(), shaders, pipelineCache);
+    mScaledTarget->resize(mSwapChain->getSwapChainResolution());
+    mResolution = std::make_unique<ResolutionController>(options);
+    LOG("Dynamic resolution: {:.1f} ms GPU budget, scale {:.2f} to {:.2f}", mResolution->getOptions().targetMs,
+      mResolution->getOptions().minScale, mResolution->getOptions().maxScale);
+  }
+
+  void Renderer::beginSceneRenderPass(VkCommandBuffer command, VkSubpassContents contents)
+  {
+    if (!mScaledTarget)
+    {
+      beginSwapChainRenderPass(command, contents);
+      return;
+    }
+    if (!mIsFrameStarted) RT_THROW("Can't call beginSceneRenderPass if frame is not in progress");
+    mScaledTarget->beginRenderPass(command, mResolution->getScale(), CLEAR_COLOR, contents);
+  }
+
+  void Renderer::endSceneRenderPass(VkCommandBuffer command)
+  {
+    if (!mScaledTarget) return;
+
+    mScaledTarget->endRenderPass(command);
+    beginSwapChainRenderPass(command);
+    mScaledTarget->upsample(command);
+  }
+
+  bool Renderer::captureFrame(FrameCapture& capture, const std::string& name)
+  {
+    if (!mIsFrameStarted) RT_THROW("Can't call captureFrame if frame is not in progress");
+    if (!mSwapChain->supportsReadback())
+    {
+      WLOG_EVERY_MS(5000, "Swap chain images can't be read back on this surface, frame capture is unavailable");
+      return false;
+    }
+
+    if (!capture.record(getCurrentCommandBuffer(), mSwapChain->getImage(mCurrentImageIdx), mSwapChain->getImageFormat(),
+      mSwapChain->getSwapChainResolution(), VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, name))
+    {
+      return false;
+    }
+    mCapture = &capture;
+    return true;
+  }
+}
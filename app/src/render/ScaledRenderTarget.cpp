@@ -0,0 +1,303 @@
+#include <render/ScaledRenderTarget.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace rw
+{
+  ScaledRenderTarget::ScaledRenderTarget(Device& dev, VkFormat colorFormat, VkFormat depthFormat, VkRenderPass presentPass, ShaderCache& shaders,
+    VkPipelineCache pipelineCache) : device{ dev }, mColorFormat{ colorFormat }, mDepthFormat{ depthFormat }
+  {
+    createRenderPass();
+    createDescriptors();
+    createPipeline(presentPass, shaders, pipelineCache);
+  }
+
+  ScaledRenderTarget::~ScaledRenderTarget()
+  {
+    destroyImages();
+    mPipeline.reset();
+    vkDestroyPipelineLayout(device.getDevice(), mPipelineLayout, device.getAllocator());
+    vkDestroyDescriptorPool(device.getDevice(), mDescriptorPool, device.getAllocator());
+    vkDestroyDescriptorSetLayout(device.getDevice(), mSetLayout, device.getAllocator());
+    vkDestroySampler(device.getDevice(), mSampler, device.getAllocator());
+    vkDestroyRenderPass(device.getDevice(), mRenderPass, device.getAllocator());
+  }
+
+  void ScaledRenderTarget::createRenderPass()
+  {
+    VkAttachmentDescription colorAttachment = {};
+    colorAttachment.format = mColorFormat;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkAttachmentDescription depthAttachment = {};
+    depthAttachment.format = mDepthFormat;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference colorAttachmentRef = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depthAttachmentRef = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    // one target is shared by the frames in flight: wait for the previous frame's upsample and
+    // depth writes, and make the color visible to this frame's upsample
+    std::array<VkSubpassDependency, 2> dependencies = {};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    VK_CHECK(vkCreateRenderPass(device.getDevice(), &renderPassInfo, device.getAllocator(), &mRenderPass), "Failed to create scaled render pass");
+  }
+
+  void ScaledRenderTarget::createDescriptors()
+  {
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    VK_CHECK(vkCreateSampler(device.getDevice(), &samplerInfo, device.getAllocator(), &mSampler), "Failed to create upsample sampler");
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    VK_CHECK(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mSetLayout), "Failed to create upsample descriptor set layout");
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK(vkCreateDescriptorPool(device.getDevice(), &poolInfo, device.getAllocator(), &mDescriptorPool), "Failed to create upsample descriptor pool");
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mDescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &mSetLayout;
+    VK_CHECK(vkAllocateDescriptorSets(device.getDevice(), &allocInfo, &mDescriptorSet), "Failed to allocate upsample descriptor set");
+  }
+
+  void ScaledRenderTarget::createPipeline(VkRenderPass presentPass, ShaderCache& shaders, VkPipelineCache pipelineCache)
+  {
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &mSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mPipelineLayout), "Failed to create upsample pipeline layout");
+
+    // full screen triangle generated in the vertex shader, no vertex input and no depth
+    PipelineConfigInfo config;
+    Pipeline::defaultPipelineConfigInfo(config);
+    config.depthStencilInfo.depthTestEnable = VK_FALSE;
+    config.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    config.renderPass = presentPass;
+    config.pipelineLayout = mPipelineLayout;
+    config.pipelineCache = pipelineCache;
+
+    mPipeline = std::make_unique<Pipeline>(device, shaders.get("upsample.vert"), shaders.get("upsample.frag"), config);
+  }
+
+  void ScaledRenderTarget::resize(VkExtent2D extent)
+  {
+    if (extent.width == mExtent.width && extent.height == mExtent.height) return;
+
+    destroyImages();
+    mExtent = extent;
+    mRenderExtent = extent;
+    if (extent.width == 0 || extent.height == 0) return;
+    createImages();
+  }
+
+  void ScaledRenderTarget::createImages()
+  {
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { mExtent.width, mExtent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    imageInfo.format = mColorFormat;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mColorImage, mColorMemory);
+
+    imageInfo.format = mDepthFormat;
+    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mDepthImage, mDepthMemory);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    viewInfo.image = mColorImage;
+    viewInfo.format = mColorFormat;
+    VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocator(), &mColorView), "Failed to create scaled color view");
+
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    viewInfo.image = mDepthImage;
+    viewInfo.format = mDepthFormat;
+    VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocator(), &mDepthView), "Failed to create scaled depth view");
+
+    std::array<VkImageView, 2> attachments = { mColorView, mDepthView };
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = mRenderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebufferInfo.pAttachments = attachments.data();
+    framebufferInfo.width = mExtent.width;
+    framebufferInfo.height = mExtent.height;
+    framebufferInfo.layers = 1;
+    VK_CHECK(vkCreateFramebuffer(device.getDevice(), &framebufferInfo, device.getAllocator(), &mFramebuffer), "Failed to create scaled framebuffer");
+
+    VkDescriptorImageInfo imageDescriptor = {};
+    imageDescriptor.sampler = mSampler;
+    imageDescriptor.imageView = mColorView;
+    imageDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = mDescriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageDescriptor;
+    vkUpdateDescriptorSets(device.getDevice(), 1, &write, 0, nullptr);
+  }
+
+  void ScaledRenderTarget::destroyImages()
+  {
+    VkDevice handle = device.getDevice();
+    vkDestroyFramebuffer(handle, mFramebuffer, device.getAllocator());
+    vkDestroyImageView(handle, mColorView, device.getAllocator());
+    vkDestroyImageView(handle, mDepthView, device.getAllocator());
+    vkDestroyImage(handle, mColorImage, device.getAllocator());
+    vkDestroyImage(handle, mDepthImage, device.getAllocator());
+    vkFreeMemory(handle, mColorMemory, device.getAllocator());
+    vkFreeMemory(handle, mDepthMemory, device.getAllocator());
+    mFramebuffer = VK_NULL_HANDLE;
+    mColorView = mDepthView = VK_NULL_HANDLE;
+    mColorImage = mDepthImage = VK_NULL_HANDLE;
+    mColorMemory = mDepthMemory = VK_NULL_HANDLE;
+  }
+
+  VkExtent2D ScaledRenderTarget::scaleExtent(VkExtent2D extent, float scale)
+  {
+    const auto scaled = [scale](uint32_t size) {
+      return std::clamp(static_cast<uint32_t>(std::lround(size * scale)), 1u, size);
+    };
+    return { scaled(extent.width), scaled(extent.height) };
+  }
+
+  void ScaledRenderTarget::beginRenderPass(VkCommandBuffer command, float scale, const VkClearColorValue& clearColor, VkSubpassContents contents)
+  {
+    if (mFramebuffer == VK_NULL_HANDLE) RT_THROW("Scaled render target has no size");
+
+    mRenderExtent = scaleExtent(mExtent, scale);
+
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color = clearColor;
+    clearValues[1].depthStencil = { 1.0f, 0 };
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = mRenderPass;
+    renderPassInfo.framebuffer = mFramebuffer;
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = mRenderExtent;
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+    vkCmdBeginRenderPass(command, &renderPassInfo, contents);
+    // secondary command buffers set their own
+    if (contents != VK_SUBPASS_CONTENTS_INLINE) return;
+
+    VkViewport viewport = {};
+    viewport.width = static_cast<float>(mRenderExtent.width);
+    viewport.height = static_cast<float>(mRenderExtent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{ { 0, 0 }, mRenderExtent };
+    vkCmdSetViewport(command, 0, 1, &viewport);
+    vkCmdSetScissor(command, 0, 1, &scissor);
+  }
+
+  void ScaledRenderTarget::endRenderPass(VkCommandBuffer command)
+  {
+    vkCmdEndRenderPass(command);
+  }
+
+  void ScaledRenderTarget::upsample(VkCommandBuffer command)
+  {
+    const glm::vec2 size{ static_cast<float>(mExtent.width), static_cast<float>(mExtent.height) };
+    const glm::vec2 rendered{ static_cast<float>(mRenderExtent.width), static_cast<float>(mRenderExtent.height) };
+    PushConstants push{ rendered / size, (rendered - 0.5f) / size };
+
+    mPipeline->bind(command);
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mDescriptorSet, 0, nullptr);
+    vkCmdPushConstants(command, mPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &push);
+    vkCmdDraw(command, 3, 1, 0, 0);
+  }
+}
@@ -0,0 +1,823 @@
+#include <render/SceneRenderer.h>
+#include <render/CommandTrace.h>
+#include <core/Clock.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <algorithm>
+
+namespace rw
+{
+  SceneRenderer::SceneRenderer(Device& dev, VkRenderPass renderPass, ShaderCache& shaders, AsyncCompute& compute, VkPipelineCache pipelineCache)
+    : device{ dev }, mShaders{ shaders }, mPipelineCache{ pipelineCache }
+  {
+    // the map is sampled by the mesh pipeline even while shadows are off, resized by the first snapshot with shadows
+    mShadowMap = std::make_unique<ShadowMap>(device, ShadowCascades::MAX_CASCADES, 1);
+    createDescriptors();
+    createPipelineLayout();
+    createPipeline(renderPass, shaders, pipelineCache);
+    // renderPass only lives until the swap chain is recreated, every pipeline using it is built now
+    createPrepassPipelines(renderPass);
+    createVisibilityPipelines(renderPass);
+    mSkinning = std::make_unique<SkinningPass>(device, compute, shaders, pipelineCache);
+    // leave the other half of video memory to the swap chain and the resident scene
+    mStreamed = std::make_unique<StreamedGeometry>(device, device.getCurrentPhysicalDevice().getDeviceLocalMemorySize() / 2);
+    mFragments = std::make_unique<FragmentCounter>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+    mPoints = std::make_unique<PointRasterizer>(device, compute, renderPass, shaders, pipelineCache);
+
+    // only the render thread records into it
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device.findQueueFamilies().graphicsFamily.value();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    VK_CHECK(vkCreateCommandPool(device.getDevice(), &poolInfo, device.getAllocator(), &mStaticPool), "Failed to create static command pool");
+  }
+
+  SceneRenderer::~SceneRenderer()
+  {
+    // frees the static command buffers with it
+    vkDestroyCommandPool(device.getDevice(), mStaticPool, device.getAllocator());
+    mSkinning.reset();
+    mStreamed.reset();
+    mPoints.reset();
+    mFragments.reset();
+    mShadowPipeline.reset();
+    mShadowMap.reset();
+    mDepthPipeline.reset();
+    mDepthEqualPipeline.reset();
+    mVisibilityPipeline.reset();
+    mResolvePipeline.reset();
+    mVisibility.reset();
+    vkDestroyPipelineLayout(device.getDevice(), mResolvePipelineLayout, device.getAllocator());
+    vkDestroyDescriptorPool(device.getDevice(), mVisibilityPool, device.getAllocator());
+    vkDestroyDescriptorSetLayout(device.getDevice(), mVisibilitySetLayout, device.getAllocator());
+    vkDestroyPipelineLayout(device.getDevice(), mShadowPipelineLayout, device.getAllocator());
+    vkDestroyPipelineLayout(device.getDevice(), mPipelineLayout, device.getAllocator());
+    vkDestroyDescriptorPool(device.getDevice(), mDescriptorPool, device.getAllocator());
+    vkDestroyDescriptorSetLayout(device.getDevice(), mSetLayout, device.getAllocator());
+  }
+
+  void SceneRenderer::createDescriptors()
+  {
+    // lights, per cluster ranges, light indices, shadow cascades, the shadow map and the camera
+    std::array<VkDescriptorSetLayoutBinding, 6> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = i < 4 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[5].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CHECK(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mSetLayout), "Failed to create light descriptor set layout");
+
+    std::array<VkDescriptorPoolSize, 3> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = static_cast<uint32_t>(4 * mLightBuffers.size());
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = static_cast<uint32_t>(mLightBuffers.size());
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[2].descriptorCount = static_cast<uint32_t>(mLightBuffers.size());
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(mLightBuffers.size());
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    VK_CHECK(vkCreateDescriptorPool(device.getDevice(), &poolInfo, device.getAllocator(), &mDescriptorPool), "Failed to create light descriptor pool");
+
+    std::array<VkDescriptorSetLayout, SwapChain::MAX_FRAMES_IN_FLIGHT> layouts;
+    layouts.fill(mSetLayout);
+    std::array<VkDescriptorSet, SwapChain::MAX_FRAMES_IN_FLIGHT> sets = {};
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mDescriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    allocInfo.pSetLayouts = layouts.data();
+    VK_CHECK(vkAllocateDescriptorSets(device.getDevice(), &allocInfo, sets.data()), "Failed to allocate light descriptor sets");
+
+    // small initial buffers, so the sets are valid before the first frame with lights
+    for (size_t i = 0; i < mLightBuffers.size(); ++i)
+    {
+      writeBuffer(mLightBuffers[i].shadow, nullptr, 0, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(ShadowData));
+      writeBuffer(mLightBuffers[i].view, nullptr, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(PushConstants));
+      writeShadow(FrameSnapshot{}, static_cast<int>(i));
+      writeLights(FrameSnapshot{}, static_cast<int>(i));
+      mLightBuffers[i].descriptorSet = sets[i];
+      writeDescriptors(static_cast<int>(i));
+    }
+  }
+
+  void SceneRenderer::writeDescriptors(int frameIndex)
+  {
+    auto& frame = mLightBuffers[frameIndex];
+    std::array<VkDescriptorBufferInfo, 4> buffers = {};
+    buffers[0] = { frame.lights->getHandler(), 0, VK_WHOLE_SIZE };
+    buffers[1] = { frame.clusters->getHandler(), 0, VK_WHOLE_SIZE };
+    buffers[2] = { frame.indices->getHandler(), 0, VK_WHOLE_SIZE };
+    buffers[3] = { frame.shadow->getHandler(), 0, VK_WHOLE_SIZE };
+    VkDescriptorImageInfo image = { mShadowMap->getSampler(), mShadowMap->getArrayView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkDescriptorBufferInfo view = { frame.view->getHandler(), 0, sizeof(PushConstants) };
+
+    std::array<VkWriteDescriptorSet, 6> writes = {};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = frame.descriptorSet;
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      if (i < buffers.size())
+      {
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffers[i];
+      }
+      else if (i == buffers.size())
+      {
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[i].pImageInfo = &image;
+      }
+      else
+      {
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[i].pBufferInfo = &view;
+      }
+    }
+    vkUpdateDescriptorSets(device.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    // updating a set invalidates the command buffers it is bound in
+    mStaticCommands[frameIndex].valid = false;
+  }
+
+  void SceneRenderer::createPipelineLayout()
+  {
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &mSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mPipelineLayout), "Failed to create pipeline layout");
+  }
+
+  void SceneRenderer::createPipeline(VkRenderPass renderPass, ShaderCache& shaders, VkPipelineCache pipelineCache)
+  {
+    PipelineConfigInfo config;
+    Pipeline::defaultPipelineConfigInfo(config);
+    config.bindingDescriptions = Mesh::getBindingDescriptions();
+    config.attributeDescriptions = Mesh::getAttributeDescriptions();
+    for (const auto& binding : InstanceBatcher::getBindingDescriptions()) config.bindingDescriptions.push_back(binding);
+    for (const auto& attribute : InstanceBatcher::getAttributeDescriptions()) config.attributeDescriptions.push_back(attribute);
+    config.renderPass = renderPass;
+    config.pipelineLayout = mPipelineLayout;
+    config.pipelineCache = pipelineCache;
+
+    mPipeline = std::make_unique<Pipeline>(device, shaders.get("mesh.vert"), shaders.get("mesh.frag"), config);
+  }
+
+  void SceneRenderer::createShadows(uint32_t resolution)
+  {
+    mShadowPipeline.reset();
+    mShadowMap = std::make_unique<ShadowMap>(device, ShadowCascades::MAX_CASCADES, resolution);
+    for (size_t i = 0; i < mLightBuffers.size(); ++i) writeDescriptors(static_cast<int>(i));
+
+    if (mShadowPipelineLayout == VK_NULL_HANDLE)
+    {
+      VkPushConstantRange pushConstantRange = {};
+      pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+      pushConstantRange.offset = 0;
+      pushConstantRange.size = sizeof(glm::mat4);
+
+      VkPipelineLayoutCreateInfo layoutInfo = {};
+      layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+      layoutInfo.pushConstantRangeCount = 1;
+      layoutInfo.pPushConstantRanges = &pushConstantRange;
+      VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mShadowPipelineLayout), "Failed to create shadow pipeline layout");
+    }
+
+    // depth only, same vertex layout as the mesh pipeline; slope scaled bias against acne
+    PipelineConfigInfo config;
+    Pipeline::defaultPipelineConfigInfo(config);
+    config.bindingDescriptions = Mesh::getBindingDescriptions();
+    config.attributeDescriptions = Mesh::getAttributeDescriptions();
+    for (const auto& binding : InstanceBatcher::getBindingDescriptions()) config.bindingDescriptions.push_back(binding);
+    for (const auto& attribute : InstanceBatcher::getAttributeDescriptions()) config.attributeDescriptions.push_back(attribute);
+    config.colorBlendInfo.attachmentCount = 0;
+    config.colorBlendInfo.pAttachments = nullptr;
+    config.rasterizationInfo.depthBiasEnable = VK_TRUE;
+    config.rasterizationInfo.depthBiasConstantFactor = 1.25f;
+    config.rasterizationInfo.depthBiasSlopeFactor = 1.75f;
+    config.renderPass = mShadowMap->getRenderPass();
+    config.pipelineLayout = mShadowPipelineLayout;
+    config.pipelineCache = mPipelineCache;
+
+    mShadowPipeline = std::make_unique<Pipeline>(device, mShaders.get("shadow.vert"), mShaders.get("depth.frag"), config);
+  }
+
+  void SceneRenderer::createPrepassPipelines(VkRenderPass renderPass)
+  {
+    PipelineConfigInfo config;
+    Pipeline::defaultPipelineConfigInfo(config);
+    config.bindingDescriptions = Mesh::getBindingDescriptions();
+    config.attributeDescriptions = Mesh::getAttributeDescriptions();
+    for (const auto& binding : InstanceBatcher::getBindingDescriptions()) config.bindingDescriptions.push_back(binding);
+    for (const auto& attribute : InstanceBatcher::getAttributeDescriptions()) config.attributeDescriptions.push_back(attribute);
+    config.renderPass = renderPass;
+    config.pipelineLayout = mPipelineLayout;
+    config.pipelineCache = mPipelineCache;
+
+    // same vertex shader as the shading pipeline, whose invariant position reproduces the depth exactly
+    config.colorBlendAttachment.colorWriteMask = 0;
+    mDepthPipeline = std::make_unique<Pipeline>(device, mShaders.get("mesh.vert"), mShaders.get("depth.frag"), config);
+
+    config.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    config.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    config.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+    mDepthEqualPipeline = std::make_unique<Pipeline>(device, mShaders.get("mesh.vert"), mShaders.get("mesh.frag"), config);
+  }
+
+  void SceneRenderer::createVisibilityPipelines(VkRenderPass renderPass)
+  {
+    mVisibility = std::make_unique<VisibilityBuffer>(device);
+
+    // visibility and depth of the pixel, instance colors
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CHECK(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mVisibilitySetLayout), "Failed to create resolve descriptor set layout");
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = static_cast<uint32_t>(2 * mVisibilitySets.size());
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = static_cast<uint32_t>(mVisibilitySets.size());
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(mVisibilitySets.size());
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    VK_CHECK(vkCreateDescriptorPool(device.getDevice(), &poolInfo, device.getAllocator(), &mVisibilityPool), "Failed to create resolve descriptor pool");
+
+    std::array<VkDescriptorSetLayout, SwapChain::MAX_FRAMES_IN_FLIGHT> layouts;
+    layouts.fill(mVisibilitySetLayout);
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mVisibilityPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    allocInfo.pSetLayouts = layouts.data();
+    VK_CHECK(vkAllocateDescriptorSets(device.getDevice(), &allocInfo, mVisibilitySets.data()), "Failed to allocate resolve descriptor sets");
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ResolvePushConstants);
+
+    // the light set of the mesh pipeline, then the visibility set
+    std::array<VkDescriptorSetLayout, 2> setLayouts = { mSetLayout, mVisibilitySetLayout };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &pipelineLayoutInfo, device.getAllocator(), &mResolvePipelineLayout), "Failed to create resolve pipeline layout");
+
+    // ids and normals with the mesh vertex layout and push constants
+    PipelineConfigInfo config;
+    Pipeline::defaultPipelineConfigInfo(config);
+    config.bindingDescriptions = Mesh::getBindingDescriptions();
+    config.attributeDescriptions = Mesh::getAttributeDescriptions();
+    for (const auto& binding : InstanceBatcher::getBindingDescriptions()) config.bindingDescriptions.push_back(binding);
+    for (const auto& attribute : InstanceBatcher::getAttributeDescriptions()) config.attributeDescriptions.push_back(attribute);
+    config.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT;
+    config.renderPass = mVisibility->getRenderPass();
+    config.pipelineLayout = mPipelineLayout;
+    config.pipelineCache = mPipelineCache;
+    mVisibilityPipeline = std::make_unique<Pipeline>(device, mShaders.get("visibility.vert"), mShaders.get("visibility.frag"), config);
+
+    // full screen triangle in the scene pass; writes the resolved depth, so later draws still test against it
+    PipelineConfigInfo resolveConfig;
+    Pipeline::defaultPipelineConfigInfo(resolveConfig);
+    resolveConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+    resolveConfig.renderPass = renderPass;
+    resolveConfig.pipelineLayout = mResolvePipelineLayout;
+    resolveConfig.pipelineCache = mPipelineCache;
+    mResolvePipeline = std::make_unique<Pipeline>(device, mShaders.get("upsample.vert"), mShaders.get("resolve.frag"), resolveConfig);
+  }
+
+  void SceneRenderer::writeVisibilityDescriptors(int frameIndex)
+  {
+    std::array<VkDescriptorImageInfo, 2> images = {};
+    images[0] = { mVisibility->getSampler(), mVisibility->getVisibilityView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    images[1] = { mVisibility->getSampler(), mVisibility->getDepthView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkDescriptorBufferInfo instances = { mInstanceBuffers[frameIndex]->getHandler(), 0, VK_WHOLE_SIZE };
+
+    std::array<VkWriteDescriptorSet, 3> writes = {};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = mVisibilitySets[frameIndex];
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      if (i < images.size())
+      {
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[i].pImageInfo = &images[i];
+      }
+      else
+      {
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &instances;
+      }
+    }
+    vkUpdateDescriptorSets(device.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    mVisibilityDirty[frameIndex] = false;
+  }
+
+  void SceneRenderer::upload(const Scene& scene)
+  {
+    vkDeviceWaitIdle(device.getDevice());
+    invalidateStaticCommands();
+    mMeshes.clear();
+    mStats = {};
+
+    for (const auto& meshData : scene.getGeometry().getMeshes())
+    {
+      mMeshes.push_back(std::make_unique<Mesh>(device, meshData));
+      mStats.geometryBytes += mMeshes.back()->getMemorySize();
+    }
+
+    mSkinning->upload(scene);
+    mStats.geometryBytes += mSkinning->getMemorySize();
+
+    mStats.uniqueMeshes = static_cast<uint32_t>(mMeshes.size());
+    LOG("Scene upload: {} node(s) sharing {} unique mesh(es), {} KiB of geometry",
+        scene.getNodes().size(), mStats.uniqueMeshes, mStats.geometryBytes / 1024);
+  }
+
+  bool SceneRenderer::writeBuffer(std::unique_ptr<Buffer>& buffer, const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize minSize)
+  {
+    bool reallocated = false;
+    if (!buffer || buffer->getBufferSize() < size)
+    {
+      // grow by half again so a slowly growing visible set does not reallocate every frame
+      VkDeviceSize bufferSize = std::max<VkDeviceSize>(size + size / 2, minSize);
+      buffer = std::make_unique<Buffer>(device, bufferSize, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      VK_CHECK(buffer->map(), "Failed to map per frame buffer");
+      reallocated = true;
+    }
+    if (size > 0) buffer->writeToBuffer(data, size);
+    return reallocated;
+  }
+
+  void SceneRenderer::writeInstances(const std::vector<InstanceData>& instances, int frameIndex)
+  {
+    // also read by the visibility resolve, whose set has to follow a reallocation
+    if (writeBuffer(mInstanceBuffers[frameIndex], instances.data(), sizeof(InstanceData) * instances.size(),
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(InstanceData) * 1024))
+    {
+      mVisibilityDirty[frameIndex] = true;
+      mStaticCommands[frameIndex].valid = false;
+    }
+  }
+
+  void SceneRenderer::writeView(const FrameSnapshot& snapshot, int frameIndex)
+  {
+    const PushConstants view = makePushConstants(snapshot);
+    mLightBuffers[frameIndex].view->writeToBuffer(&view, sizeof(PushConstants));
+  }
+
+  void SceneRenderer::writeLights(const FrameSnapshot& snapshot, int frameIndex)
+  {
+    auto& frame = mLightBuffers[frameIndex];
+    bool reallocated = writeBuffer(frame.lights, snapshot.lights.data(), sizeof(ClusterLight) * snapshot.lights.size(),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(ClusterLight) * 256);
+    reallocated |= writeBuffer(frame.clusters, snapshot.lightClusters.data(), sizeof(glm::uvec2) * snapshot.lightClusters.size(),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(glm::uvec2) * 16 * 9 * 24);
+    reallocated |= writeBuffer(frame.indices, snapshot.lightIndices.data(), sizeof(uint32_t) * snapshot.lightIndices.size(),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(uint32_t) * 4096);
+    // the frame's previous submission has completed, its set can be rewritten
+    if (reallocated && frame.descriptorSet != VK_NULL_HANDLE) writeDescriptors(frameIndex);
+  }
+
+  void SceneRenderer::writeShadow(const FrameSnapshot& snapshot, int frameIndex)
+  {
+    ShadowData data = {};
+    const auto count = static_cast<uint32_t>(std::min<size_t>(snapshot.shadowCascades.size(), ShadowCascades::MAX_CASCADES));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      data.cascades[i] = snapshot.shadowCascades[i].viewProjection;
+      data.splits[i] = snapshot.shadowCascades[i].splitDepth;
+    }
+    data.lightDirection = glm::vec4(snapshot.lightDirection, 0.0f);
+    data.info = glm::uvec4(count, snapshot.skinnedDraws.empty() ? 0u : 1u, 0u, 0u);
+    mLightBuffers[frameIndex].shadow->writeToBuffer(&data, sizeof(ShadowData));
+  }
+
+  void SceneRenderer::applyGeometry(const GeometryDiff& diff)
+  {
+    // kept and patched meshes may still be read by frames in flight
+    vkDeviceWaitIdle(device.getDevice());
+    invalidateStaticCommands();
+
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    meshes.reserve(diff.meshes.size());
+    for (const auto& change : diff.meshes)
+    {
+      if (change.previous == INVALID_MESH)
+      {
+        meshes.push_back(std::make_unique<Mesh>(device, *change.data));
+        continue;
+      }
+      auto& mesh = mMeshes.at(change.previous);
+      if (change.data) mesh->updateRange(*change.data, change.firstVertex, change.vertexCount, change.firstIndex, change.indexCount);
+      meshes.push_back(std::move(mesh));
+    }
+    // whatever was not moved over is no longer referenced by the scene
+    mMeshes = std::move(meshes);
+    mGeometryGeneration = diff.generation;
+
+    mStats.geometryBytes = mSkinning->getMemorySize();
+    for (const auto& mesh : mMeshes) mStats.geometryBytes += mesh->getMemorySize();
+    mStats.uniqueMeshes = static_cast<uint32_t>(mMeshes.size());
+  }
+
+  void SceneRenderer::uploadPoints(const PointCloud& cloud)
+  {
+    mPoints->upload(cloud);
+  }
+
+  void SceneRenderer::prepare(const FrameSnapshot& snapshot, int frameIndex, VkExtent2D renderExtent, LinearArena& frameArena)
+  {
+    mStats.meshBinds = 0;
+    mStats.meshBindsSkipped = 0;
+    if (snapshot.geometry && snapshot.geometry->generation > mGeometryGeneration) applyGeometry(*snapshot.geometry);
+    if (!snapshot.instances.empty()) writeInstances(snapshot.instances, frameIndex);
+    if (!snapshot.lights.empty()) writeLights(snapshot, frameIndex);
+    if (!snapshot.shadowCascades.empty() && (!mShadowPipeline || snapshot.shadowResolution != mShadowMap->getResolution()))
+    {
+      // the map is shared by the frames in flight
+      vkDeviceWaitIdle(device.getDevice());
+      createShadows(snapshot.shadowResolution);
+    }
+    writeShadow(snapshot, frameIndex);
+    writeView(snapshot, frameIndex);
+    mSkinning->prepare(snapshot, frameIndex);
+    mStreamed->prepare(snapshot, frameIndex, frameArena);
+    mPoints->prepare(snapshot, frameIndex, renderExtent);
+  }
+
+  void SceneRenderer::recordUploads(VkCommandBuffer command, int frameIndex)
+  {
+    mStreamed->recordUploads(command, frameIndex);
+  }
+
+  void SceneRenderer::drawShadows(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex)
+  {
+    TRACE_COMMANDS(device, command, "shadows");
+    mStats.shadowCascades = static_cast<uint32_t>(snapshot.shadowCascades.size());
+    mStats.shadowCascadesDrawn = 0;
+    mStats.shadowCascadesReused = 0;
+    mStats.shadowDrawCalls = 0;
+    if (snapshot.shadowCascades.empty() || snapshot.instances.empty()) return;
+
+    mShadowPipeline->bind(command);
+    VkBuffer instanceBuffers[] = { mInstanceBuffers[frameIndex]->getHandler() };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command, InstanceBatcher::INSTANCE_BINDING, 1, instanceBuffers, offsets);
+
+    const auto& skinnedDraws = mSkinning->getDraws(frameIndex);
+    for (uint32_t cascade = 0; cascade < mStats.shadowCascades; ++cascade)
+    {
+      const auto& shadow = snapshot.shadowCascades[cascade];
+      if (mShadowMap->getStaticKey(cascade) == shadow.key)
+      {
+        ++mStats.shadowCascadesReused;
+      }
+      else if (shadow.hasCasters)
+      {
+        mShadowMap->beginRenderPass(command, mShadowMap->getStaticLayer(cascade));
+        vkCmdPushConstants(command, mShadowPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &shadow.viewProjection);
+        const Mesh* bound = nullptr;
+        for (uint32_t i = shadow.firstBatch; i < shadow.firstBatch + shadow.batchCount; ++i)
+        {
+          const auto& batch = snapshot.shadowBatches[i];
+          const auto& mesh = mMeshes[batch.mesh];
+          bindMesh(command, *mesh, bound);
+          mesh->draw(command, batch.instanceCount, batch.firstInstance);
+        }
+        mStreamed->draw(command, snapshot);
+        mShadowMap->endRenderPass(command);
+        mShadowMap->setStaticKey(cascade, shadow.key);
+        mStats.shadowDrawCalls += shadow.batchCount + static_cast<uint32_t>(snapshot.streamedDraws.size());
+        ++mStats.shadowCascadesDrawn;
+      }
+
+      // moving casters are drawn every frame into the cascade's second layer
+      if (skinnedDraws.empty()) continue;
+      mShadowMap->beginRenderPass(command, mShadowMap->getDynamicLayer(cascade));
+      vkCmdPushConstants(command, mShadowPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &shadow.viewProjection);
+      VkBuffer skinnedBuffers[] = { mSkinning->getVertexBuffer(frameIndex) };
+      vkCmdBindVertexBuffers(command, Mesh::VERTEX_BINDING, 1, skinnedBuffers, offsets);
+      vkCmdBindIndexBuffer(command, mSkinning->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+      for (size_t i = 0; i < skinnedDraws.size(); ++i)
+      {
+        const auto& range = skinnedDraws[i];
+        vkCmdDrawIndexed(command, range.indexCount, 1, range.firstIndex, range.vertexOffset, snapshot.skinnedDraws[i].instance);
+      }
+      mShadowMap->endRenderPass(command);
+      mStats.shadowDrawCalls += static_cast<uint32_t>(skinnedDraws.size());
+    }
+  }
+
+  SceneRenderer::PushConstants SceneRenderer::makePushConstants(const FrameSnapshot& snapshot)
+  {
+    const auto& grid = snapshot.lightGrid;
+    const glm::mat4& view = snapshot.view;
+    return PushConstants{ snapshot.viewProjection, -glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]),
+      glm::uvec4(grid.tilesX, grid.tilesY, grid.slices, static_cast<uint32_t>(snapshot.lights.size())),
+      glm::vec4(grid.sliceScale, grid.sliceBias, 0.0f, 0.0f) };
+  }
+
+  void SceneRenderer::drawVisibility(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex, VkExtent2D outputExtent,
+    VkExtent2D renderExtent)
+  {
+    TRACE_COMMANDS(device, command, "visibility");
+    mRenderExtent = renderExtent;
+    // the queries can't be begun in a scene pass made of secondary command buffers
+    if (!usesStaticCommands(snapshot)) mFragments->reset(command, static_cast<uint32_t>(frameIndex), renderExtent);
+    if (snapshot.renderMode != RenderMode::Visibility || snapshot.instances.empty()) return;
+
+    const VkExtent2D size = mVisibility->getExtent();
+    if (size.width != outputExtent.width || size.height != outputExtent.height)
+    {
+      // the buffer is shared by the frames in flight
+      vkDeviceWaitIdle(device.getDevice());
+      mVisibility->resize(outputExtent);
+      mVisibilityDirty.fill(true);
+    }
+    if (mVisibilityDirty[frameIndex]) writeVisibilityDescriptors(frameIndex);
+
+    mVisibility->beginRenderPass(command, renderExtent);
+    mFragments->begin(command, static_cast<uint32_t>(frameIndex), FragmentCounter::PREPASS);
+    mVisibilityPipeline->bind(command);
+    const PushConstants push = makePushConstants(snapshot);
+    vkCmdPushConstants(command, mPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &push);
+    drawGeometry(command, snapshot, frameIndex);
+    mFragments->end(command, static_cast<uint32_t>(frameIndex), FragmentCounter::PREPASS);
+    mVisibility->endRenderPass(command);
+  }
+
+  bool SceneRenderer::usesStaticCommands(const FrameSnapshot& snapshot) const
+  {
+    return snapshot.staticCommands && snapshot.renderMode == RenderMode::Forward && !snapshot.instances.empty();
+  }
+
+  VkSubpassContents SceneRenderer::getSceneContents(const FrameSnapshot& snapshot) const
+  {
+    return usesStaticCommands(snapshot) ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+  }
+
+  void SceneRenderer::draw(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex, VkRenderPass renderPass)
+  {
+    // the depth prepass draws everything twice, the visibility buffer adds the resolve
+    mStats.drawCalls = static_cast<uint32_t>(snapshot.batches.size() + snapshot.skinnedDraws.size() + snapshot.streamedDraws.size());
+    if (snapshot.renderMode == RenderMode::DepthPrepass) mStats.drawCalls *= 2;
+    if (snapshot.renderMode == RenderMode::Visibility) mStats.drawCalls += 1;
+    mStats.instances = static_cast<uint32_t>(snapshot.instances.size());
+    mStats.skinnedDraws = static_cast<uint32_t>(snapshot.skinnedDraws.size());
+    mStats.skinnedVertices = mSkinning->getVertexCount(frameIndex);
+    mStats.streamedChunks = mStreamed->getResidentCount();
+    mStats.streamedBytes = mStreamed->getResidentBytes();
+    mStats.lights = static_cast<uint32_t>(snapshot.lights.size());
+    mStats.lightIndices = static_cast<uint32_t>(snapshot.lightIndices.size());
+    mStats.renderMode = snapshot.renderMode;
+    mStats.fragments = mFragments->getLast();
+    mStats.fragmentSamples = mFragments->getSampleCount();
+    mStats.points = mPoints->getPointCount(frameIndex);
+    mStats.pointInt64Atomics = mPoints->usesInt64Atomics();
+    if (mStats.points > 0) mStats.drawCalls += 1;
+    mStats.staticCommands = usesStaticCommands(snapshot);
+    mStats.staticRecorded = false;
+    if (mStats.staticCommands)
+    {
+      // labels and queries would be commands of the primary inside the pass, which may only execute
+      drawStatic(command, snapshot, frameIndex, renderPass);
+      return;
+    }
+
+    TRACE_COMMANDS(device, command, "scene");
+    if (!snapshot.instances.empty()) drawMeshes(command, snapshot, frameIndex);
+    // after the meshes, the visibility resolve overwrites the depth
+    mPoints->draw(command, frameIndex);
+  }
+
+  void SceneRenderer::drawMeshes(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex)
+  {
+    const auto frame = static_cast<uint32_t>(frameIndex);
+    const PushConstants push = makePushConstants(snapshot);
+    if (snapshot.renderMode == RenderMode::Visibility)
+    {
+      const glm::vec2 pixel = 2.0f / glm::vec2(static_cast<float>(mRenderExtent.width), static_cast<float>(mRenderExtent.height));
+      ResolvePushConstants resolve{ glm::inverse(snapshot.viewProjection), push.viewDepth, push.grid,
+        glm::vec4(push.slicing.x, push.slicing.y, pixel.x, pixel.y) };
+      std::array<VkDescriptorSet, 2> sets = { mLightBuffers[frameIndex].descriptorSet, mVisibilitySets[frameIndex] };
+
+      mFragments->begin(command, frame, FragmentCounter::SHADING);
+      mResolvePipeline->bind(command);
+      vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, mResolvePipelineLayout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 0,
+        nullptr);
+      vkCmdPushConstants(command, mResolvePipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ResolvePushConstants), &resolve);
+      vkCmdDraw(command, 3, 1, 0, 0);
+      mFragments->end(command, frame, FragmentCounter::SHADING);
+      return;
+    }
+
+    // the camera is in the set, the depth prepass needs it as well
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mLightBuffers[frameIndex].descriptorSet, 0, nullptr);
+    if (snapshot.renderMode == RenderMode::DepthPrepass)
+    {
+      mFragments->begin(command, frame, FragmentCounter::PREPASS);
+      mDepthPipeline->bind(command);
+      drawGeometry(command, snapshot, frameIndex);
+      mFragments->end(command, frame, FragmentCounter::PREPASS);
+    }
+
+    mFragments->begin(command, frame, FragmentCounter::SHADING);
+    (snapshot.renderMode == RenderMode::DepthPrepass ? mDepthEqualPipeline : mPipeline)->bind(command);
+    drawGeometry(command, snapshot, frameIndex);
+    mFragments->end(command, frame, FragmentCounter::SHADING);
+  }
+
+  void SceneRenderer::drawGeometry(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex)
+  {
+    bindInstances(command, frameIndex);
+    drawBatches(command, snapshot.batches);
+    drawMoving(command, snapshot, frameIndex);
+  }
+
+  void SceneRenderer::bindInstances(VkCommandBuffer command, int frameIndex)
+  {
+    VkBuffer instanceBuffers[] = { mInstanceBuffers[frameIndex]->getHandler() };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command, InstanceBatcher::INSTANCE_BINDING, 1, instanceBuffers, offsets);
+  }
+
+  void SceneRenderer::drawBatches(VkCommandBuffer command, const std::vector<DrawBatch>& batches)
+  {
+    // the batches come sorted by DrawKey, a mesh drawn with several materials is bound once
+    const Mesh* bound = nullptr;
+    for (const auto& batch : batches)
+    {
+      const auto& mesh = mMeshes[batch.mesh];
+      bindMesh(command, *mesh, bound);
+      mesh->draw(command, batch.instanceCount, batch.firstInstance);
+    }
+  }
+
+  void SceneRenderer::drawMoving(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex)
+  {
+    mStreamed->draw(command, snapshot);
+
+    // skinned nodes share one vertex buffer, each draw offsets into its own range of it
+    const auto& skinnedDraws = mSkinning->getDraws(frameIndex);
+    if (skinnedDraws.empty()) return;
+
+    VkBuffer skinnedBuffers[] = { mSkinning->getVertexBuffer(frameIndex) };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command, Mesh::VERTEX_BINDING, 1, skinnedBuffers, offsets);
+    vkCmdBindIndexBuffer(command, mSkinning->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    for (size_t i = 0; i < skinnedDraws.size(); ++i)
+    {
+      const auto& range = skinnedDraws[i];
+      vkCmdDrawIndexed(command, range.indexCount, 1, range.firstIndex, range.vertexOffset, snapshot.skinnedDraws[i].instance);
+    }
+  }
+
+  void SceneRenderer::drawStatic(VkCommandBuffer command, const FrameSnapshot& snapshot, int frameIndex, VkRenderPass renderPass)
+  {
+    if (renderPass == VK_NULL_HANDLE) RT_THROW("Static command buffers need the scene pass they are executed in");
+
+    auto& commands = mStaticCommands[frameIndex];
+    if (commands.batches == VK_NULL_HANDLE)
+    {
+      std::array<VkCommandBuffer, 2> buffers = {};
+      VkCommandBufferAllocateInfo allocInfo = {};
+      allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+      allocInfo.commandPool = mStaticPool;
+      allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+      allocInfo.commandBufferCount = static_cast<uint32_t>(buffers.size());
+      VK_CHECK(vkAllocateCommandBuffers(device.getDevice(), &allocInfo, buffers.data()), "Failed to allocate static command buffers");
+      commands.batches = buffers[0];
+      commands.dynamic = buffers[1];
+    }
+
+    const auto sameBatch = [](const DrawBatch& a, const DrawBatch& b) {
+      return a.mesh == b.mesh && a.material == b.material && a.firstInstance == b.firstInstance && a.instanceCount == b.instanceCount;
+    };
+    const bool current = commands.valid && commands.renderPass == renderPass && commands.extent.width == mRenderExtent.width &&
+      commands.extent.height == mRenderExtent.height &&
+      std::equal(snapshot.batches.begin(), snapshot.batches.end(), commands.recordedBatches.begin(), commands.recordedBatches.end(), sameBatch);
+    if (!current)
+    {
+      // the previous recording was last executed by this frame slot, whose fence was waited on
+      TRACE_SCOPE("record static batches");
+      const uint64_t start = nowNs();
+      beginSecondary(commands.batches, renderPass, 0);
+      mPipeline->bind(commands.batches);
+      vkCmdBindDescriptorSets(commands.batches, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mLightBuffers[frameIndex].descriptorSet, 0,
+        nullptr);
+      bindInstances(commands.batches, frameIndex);
+      drawBatches(commands.batches, snapshot.batches);
+      VK_CHECK(vkEndCommandBuffer(commands.batches), "Failed to record static batches");
+
+      commands.recordMs = nsToMs(nowNs() - start);
+      commands.renderPass = renderPass;
+      commands.extent = mRenderExtent;
+      commands.recordedBatches = snapshot.batches;
+      commands.valid = true;
+      mStats.staticRecorded = true;
+    }
+    mStats.staticRecordMs = commands.recordMs;
+
+    beginSecondary(commands.dynamic, renderPass, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    if (!snapshot.streamedDraws.empty() || !mSkinning->getDraws(frameIndex).empty())
+    {
+      mPipeline->bind(commands.dynamic);
+      vkCmdBindDescriptorSets(commands.dynamic, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mLightBuffers[frameIndex].descriptorSet, 0,
+        nullptr);
+      bindInstances(commands.dynamic, frameIndex);
+      drawMoving(commands.dynamic, snapshot, frameIndex);
+    }
+    mPoints->draw(commands.dynamic, frameIndex);
+    VK_CHECK(vkEndCommandBuffer(commands.dynamic), "Failed to record dynamic scene commands");
+
+    std::array<VkCommandBuffer, 2> secondaries = { commands.batches, commands.dynamic };
+    vkCmdExecuteCommands(command, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+  }
+
+  void SceneRenderer::beginSecondary(VkCommandBuffer secondary, VkRenderPass renderPass, VkCommandBufferUsageFlags flags)
+  {
+    // no framebuffer, any of the pass's framebuffers (one per swapchain image) may execute it
+    VkCommandBufferInheritanceInfo inheritance = {};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = renderPass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = VK_NULL_HANDLE;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+    VK_CHECK(vkBeginCommandBuffer(secondary, &beginInfo), "Failed to begin secondary command buffer");
+
+    // dynamic state is not inherited from the primary
+    VkViewport viewport = {};
+    viewport.width = static_cast<float>(mRenderExtent.width);
+    viewport.height = static_cast<float>(mRenderExtent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{ { 0, 0 }, mRenderExtent };
+    vkCmdSetViewport(secondary, 0, 1, &viewport);
+    vkCmdSetScissor(secondary, 0, 1, &scissor);
+  }
+
+  void SceneRenderer::invalidateStaticCommands()
+  {
+    for (auto& commands : mStaticCommands) commands.valid = false;
+  }
+
+  void SceneRenderer::bindMesh(VkCommandBuffer command, const Mesh& mesh, const Mesh*& bound)
+  {
+    if (bound == &mesh)
+    {
+      ++mStats.meshBindsSkipped;
+      return;
+    }
+    mesh.bind(command);
+    bound = &mesh;
+    ++mStats.meshBinds;
+  }
+}
@@ -0,0 +1,27 @@
+#include <render/ShaderCache.h>
+#include <render/Pipeline.h>
+
+namespace rw
+{
+  void ShaderCache::preload(const std::vector<std::string>& names)
+  {
+    for (const auto& name : names)
+    {
+      get(name);
+    }
+  }
+
+  const std::vector<char>& ShaderCache::get(const std::string& name)
+  {
+    {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      auto it = mCode.find(name);
+      if (it != mCode.end()) return it->second;
+    }
+
+    // read outside the lock, a concurrent load of the same shader just loses the race
+    auto code = Pipeline::readFile(Pipeline::shaderPath(name));
+    std::lock_guard<std::mutex> lock{ mMutex };
+    return mCode.try_emplace(name, std::move(code)).first->second;
+  }
+}
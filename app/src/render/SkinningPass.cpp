@@ -0,0 +1,224 @@
+#include <render/SkinningPass.h>
+#include <Log.h>
+
+#include <algorithm>
+
+namespace rw
+{
+  SkinningPass::SkinningPass(Device& dev, AsyncCompute& compute, ShaderCache& shaders, VkPipelineCache pipelineCache) : device{ dev }, mCompute{ compute }
+  {
+    createDescriptors();
+    createPipeline(shaders, pipelineCache);
+    mPassId = mCompute.addPass([this](VkCommandBuffer command, int frameIndex) { return record(command, frameIndex); });
+  }
+
+  SkinningPass::~SkinningPass()
+  {
+    mCompute.removePass(mPassId);
+    vkDeviceWaitIdle(device.getDevice());
+    mPipeline.reset();
+    vkDestroyPipelineLayout(device.getDevice(), mPipelineLayout, device.getAllocator());
+    vkDestroyDescriptorPool(device.getDevice(), mDescriptorPool, device.getAllocator());
+    vkDestroyDescriptorSetLayout(device.getDevice(), mSetLayout, device.getAllocator());
+  }
+
+  void SkinningPass::createDescriptors()
+  {
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+      bindings[i].binding = i;
+      bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[i].descriptorCount = 1;
+      bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    VK_CHECK(vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mSetLayout), "Failed to create skinning descriptor set layout");
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size() * mFrames.size());
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(mFrames.size());
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    VK_CHECK(vkCreateDescriptorPool(device.getDevice(), &poolInfo, device.getAllocator(), &mDescriptorPool), "Failed to create skinning descriptor pool");
+
+    std::array<VkDescriptorSetLayout, SwapChain::MAX_FRAMES_IN_FLIGHT> layouts;
+    layouts.fill(mSetLayout);
+    std::array<VkDescriptorSet, SwapChain::MAX_FRAMES_IN_FLIGHT> sets = {};
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mDescriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    allocInfo.pSetLayouts = layouts.data();
+    VK_CHECK(vkAllocateDescriptorSets(device.getDevice(), &allocInfo, sets.data()), "Failed to allocate skinning descriptor sets");
+    for (size_t i = 0; i < mFrames.size(); ++i) mFrames[i].descriptorSet = sets[i];
+  }
+
+  void SkinningPass::createPipeline(ShaderCache& shaders, VkPipelineCache pipelineCache)
+  {
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(Dispatch);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &mSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+    VK_CHECK(vkCreatePipelineLayout(device.getDevice(), &layoutInfo, device.getAllocator(), &mPipelineLayout), "Failed to create skinning pipeline layout");
+
+    mPipeline = std::make_unique<ComputePipeline>(device, shaders.get("skin.comp"), mPipelineLayout, pipelineCache);
+  }
+
+  void SkinningPass::upload(const Scene& scene)
+  {
+    vkDeviceWaitIdle(device.getDevice());
+    mMeshes.clear();
+    mSourceBuffer.reset();
+    mIndexBuffer.reset();
+
+    std::vector<SkinVertex> vertices;
+    std::vector<uint32_t> indices;
+    for (const auto& skinned : scene.getSkinnedMeshes())
+    {
+      const auto& mesh = skinned.mesh;
+      MeshRange range{ static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(mesh.vertices.size()),
+                       static_cast<uint32_t>(indices.size()), 0 };
+      for (size_t i = 0; i < mesh.vertices.size(); ++i)
+      {
+        const auto& v = mesh.vertices[i];
+        vertices.push_back(SkinVertex{ glm::vec4(v.position, v.uv.x), glm::vec4(v.normal, v.uv.y), skinned.joints[i], skinned.weights[i] });
+      }
+      // indices stay relative to the mesh, the draw adds the node's vertex offset
+      if (mesh.indices.empty())
+      {
+        for (uint32_t i = 0; i < range.vertexCount; ++i) indices.push_back(i);
+      }
+      else
+      {
+        indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+      }
+      range.indexCount = static_cast<uint32_t>(indices.size()) - range.firstIndex;
+      mMeshes.push_back(range);
+    }
+    if (vertices.empty()) return;
+
+    VkDeviceSize vertexBytes = sizeof(SkinVertex) * vertices.size();
+    Buffer vertexStaging{ device, vertexBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    VK_CHECK(vertexStaging.map(), "Failed to map skinning staging buffer");
+    vertexStaging.writeToBuffer(vertices.data(), vertexBytes);
+    // copied on the graphics queue, read on the compute queue
+    mSourceBuffer = std::make_unique<Buffer>(device, vertexBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, true);
+    device.copyBuffer(vertexStaging.getHandler(), mSourceBuffer->getHandler(), vertexBytes);
+
+    VkDeviceSize indexBytes = sizeof(uint32_t) * indices.size();
+    Buffer indexStaging{ device, indexBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    VK_CHECK(indexStaging.map(), "Failed to map skinning staging buffer");
+    indexStaging.writeToBuffer(indices.data(), indexBytes);
+    mIndexBuffer = std::make_unique<Buffer>(device, indexBytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    device.copyBuffer(indexStaging.getHandler(), mIndexBuffer->getHandler(), indexBytes);
+
+    LOG("Skinning upload: {} skinned mesh(es), {} KiB of bind pose", mMeshes.size(), getMemorySize() / 1024);
+  }
+
+  void SkinningPass::prepare(const FrameSnapshot& snapshot, int frameIndex)
+  {
+    auto& frame = mFrames[frameIndex];
+    frame.dispatches.clear();
+    frame.draws.clear();
+    frame.vertexCount = 0;
+    if (snapshot.skinnedDraws.empty() || !mSourceBuffer) return;
+
+    for (const auto& draw : snapshot.skinnedDraws)
+    {
+      const auto& mesh = mMeshes[draw.mesh];
+      frame.dispatches.push_back(Dispatch{ mesh.firstVertex, frame.vertexCount, mesh.vertexCount, draw.paletteOffset });
+      frame.draws.push_back(DrawRange{ mesh.firstIndex, mesh.indexCount, static_cast<int32_t>(frame.vertexCount) });
+      frame.vertexCount += mesh.vertexCount;
+    }
+
+    // both buffers grow by half again, like the instance buffers, so they settle after a few frames
+    VkDeviceSize paletteBytes = sizeof(glm::mat4) * snapshot.jointPalettes.size();
+    if (!frame.palette || frame.palette->getBufferSize() < paletteBytes)
+    {
+      VkDeviceSize bufferSize = std::max<VkDeviceSize>(paletteBytes + paletteBytes / 2, sizeof(glm::mat4) * 256);
+      frame.palette = std::make_unique<Buffer>(device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      VK_CHECK(frame.palette->map(), "Failed to map joint palette buffer");
+    }
+    frame.palette->writeToBuffer(snapshot.jointPalettes.data(), paletteBytes);
+
+    VkDeviceSize vertexBytes = sizeof(Vertex) * frame.vertexCount;
+    if (!frame.vertices || frame.vertices->getBufferSize() < vertexBytes)
+    {
+      VkDeviceSize bufferSize = std::max<VkDeviceSize>(vertexBytes + vertexBytes / 2, sizeof(Vertex) * 4096);
+      frame.vertices = std::make_unique<Buffer>(device, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, true);
+    }
+
+    updateDescriptorSet(frame);
+  }
+
+  void SkinningPass::updateDescriptorSet(FrameResources& frame)
+  {
+    std::array<VkBuffer, 3> buffers = { mSourceBuffer->getHandler(), frame.palette->getHandler(), frame.vertices->getHandler() };
+    if (buffers == frame.boundBuffers) return;
+
+    // the frame fence has signaled by now, so the set is not in use by the GPU
+    std::array<VkDescriptorBufferInfo, 3> infos = {};
+    std::array<VkWriteDescriptorSet, 3> writes = {};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+      infos[i].buffer = buffers[i];
+      infos[i].offset = 0;
+      infos[i].range = VK_WHOLE_SIZE;
+
+      writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[i].dstSet = frame.descriptorSet;
+      writes[i].dstBinding = i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[i].pBufferInfo = &infos[i];
+    }
+    vkUpdateDescriptorSets(device.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    frame.boundBuffers = buffers;
+  }
+
+  bool SkinningPass::record(VkCommandBuffer command, int frameIndex)
+  {
+    const auto& frame = mFrames[frameIndex];
+    if (frame.dispatches.empty()) return false;
+
+    mPipeline->bind(command);
+    vkCmdBindDescriptorSets(command, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+    for (const auto& dispatch : frame.dispatches)
+    {
+      vkCmdPushConstants(command, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Dispatch), &dispatch);
+      vkCmdDispatch(command, (dispatch.vertexCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+    }
+    // the finished semaphore of AsyncCompute makes the writes visible to the vertex input stage
+    return true;
+  }
+
+  VkBuffer SkinningPass::getVertexBuffer(int frameIndex) const
+  {
+    const auto& frame = mFrames[frameIndex];
+    return frame.vertices ? frame.vertices->getHandler() : VK_NULL_HANDLE;
+  }
+
+  VkDeviceSize SkinningPass::getMemorySize() const
+  {
+    return (mSourceBuffer ? mSourceBuffer->getBufferSize() : 0) + (mIndexBuffer ? mIndexBuffer->getBufferSize() : 0);
+  }
+}
@@ -0,0 +1,115 @@
+#include <render/StreamedGeometry.h>
+#include <render/CommandTrace.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace rw
+{
+  namespace
+  {
+    constexpr VkDeviceSize MIN_STAGING_SIZE = { 4ull << 20 };
+  }
+
+  StreamedGeometry::StreamedGeometry(Device& dev, VkDeviceSize budget) : device{ dev }, mBudget{ budget }
+  {
+  }
+
+  void StreamedGeometry::prepare(const FrameSnapshot& snapshot, int frameIndex, LinearArena& frameArena)
+  {
+    ++mFrame;
+    mUploads.clear();
+    VkDeviceSize uploadBytes = 0;
+    for (const auto& draw : snapshot.streamedDraws)
+    {
+      if (mChunks.find(draw.chunk) == mChunks.end()) uploadBytes += Mesh::getUploadSize(*draw.mesh);
+    }
+
+    Buffer* staging = uploadBytes > 0 ? &reserveStaging(frameIndex, uploadBytes) : nullptr;
+    VkDeviceSize offset = 0;
+    for (const auto& draw : snapshot.streamedDraws)
+    {
+      auto found = mChunks.find(draw.chunk);
+      if (found == mChunks.end())
+      {
+        const MeshData& data = *draw.mesh;
+        auto mesh = std::make_unique<Mesh>(device, static_cast<uint32_t>(data.vertices.size()), static_cast<uint32_t>(data.indices.size()));
+        Mesh::writeUpload(*staging, offset, data);
+        mUploads.push_back(Upload{ mesh.get(), offset });
+        offset += Mesh::getUploadSize(data);
+        mResidentBytes += mesh->getMemorySize();
+        found = mChunks.emplace(draw.chunk, Entry{ std::move(mesh), mFrame }).first;
+      }
+      found->second.lastUsedFrame = mFrame;
+    }
+    evict(frameArena);
+  }
+
+  Buffer& StreamedGeometry::reserveStaging(int frameIndex, VkDeviceSize size)
+  {
+    auto& staging = mStaging[frameIndex];
+    if (!staging || staging->getBufferSize() < size)
+    {
+      // the previous copy out of this slot's buffer finished with the fence
+      const VkDeviceSize grown = staging ? staging->getBufferSize() * 2 : MIN_STAGING_SIZE;
+      staging = std::make_unique<Buffer>(device, std::max(size, grown), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      VK_CHECK(staging->map(), "Failed to map streamed geometry staging buffer");
+    }
+    return *staging;
+  }
+
+  void StreamedGeometry::recordUploads(VkCommandBuffer command, int frameIndex)
+  {
+    if (mUploads.empty()) return;
+
+    TRACE_COMMANDS(device, command, "streamed uploads");
+    for (const auto& upload : mUploads)
+    {
+      upload.mesh->recordUpload(command, *mStaging[frameIndex], upload.offset);
+    }
+    mUploads.clear();
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(command, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+  }
+
+  void StreamedGeometry::evict(LinearArena& frameArena)
+  {
+    if (mResidentBytes <= mBudget) return;
+
+    // the fence of this frame slot was waited on, so frames older than the ring are done with their buffers
+    ArenaVector<std::pair<uint64_t, uint32_t>> candidates{ ArenaAllocator<std::pair<uint64_t, uint32_t>>(frameArena) };
+    for (const auto& [chunk, entry] : mChunks)
+    {
+      if (entry.lastUsedFrame + SwapChain::MAX_FRAMES_IN_FLIGHT <= mFrame) candidates.emplace_back(entry.lastUsedFrame, chunk);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& [lastUsed, chunk] : candidates)
+    {
+      if (mResidentBytes <= mBudget) break;
+      auto found = mChunks.find(chunk);
+      mResidentBytes -= found->second.mesh->getMemorySize();
+      mChunks.erase(found);
+    }
+    if (mResidentBytes > mBudget)
+    {
+      WLOG_EVERY_MS(5000, "Streamed geometry uses {} MiB, over its budget of {} MiB", mResidentBytes >> 20, mBudget >> 20);
+    }
+  }
+
+  void StreamedGeometry::draw(VkCommandBuffer command, const FrameSnapshot& snapshot) const
+  {
+    for (const auto& draw : snapshot.streamedDraws)
+    {
+      const auto& mesh = mChunks.at(draw.chunk).mesh;
+      mesh->bind(command);
+      mesh->draw(command, 1, draw.instance);
+    }
+  }
+}
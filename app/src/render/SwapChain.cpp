@@ -1,4 +1,5 @@
 #include <render/SwapChain.h>
+#include <core/Trace.h>
 #include <Log.h>
 
 #include <array>
@@ -19,32 +20,32 @@ namespace rw
   SwapChain::~SwapChain()
   {
     for (auto imageView : mSwapChainImageViews) {
-      vkDestroyImageView(device.getDevice(), imageView, nullptr);
+      vkDestroyImageView(device.getDevice(), imageView, device.getAllocator());
     }
     mSwapChainImageViews.clear();
 
     if (mSwapChain != VK_NULL_HANDLE) {
-      vkDestroySwapchainKHR(device.getDevice(), mSwapChain, nullptr);
+      vkDestroySwapchainKHR(device.getDevice(), mSwapChain, device.getAllocator());
       mSwapChain = VK_NULL_HANDLE;
     }
 
     for (int i = 0; i < mSwapChainDepthImages.size(); i++) {
-      vkDestroyImageView(device.getDevice(), mSwapChainDepthViews[i], nullptr);
-      vkDestroyImage(device.getDevice(), mSwapChainDepthImages[i], nullptr);
-      vkFreeMemory(device.getDevice(), mSwapChainDepthImageMemorys[i], nullptr);
+      vkDestroyImageView(device.getDevice(), mSwapChainDepthViews[i], device.getAllocator());
+      vkDestroyImage(device.getDevice(), mSwapChainDepthImages[i], device.getAllocator());
+      vkFreeMemory(device.getDevice(), mSwapChainDepthImageMemorys[i], device.getAllocator());
     }
 
     for (auto framebuffer : mSwapChainFramebuffers) {
-      vkDestroyFramebuffer(device.getDevice(), framebuffer, nullptr);
+      vkDestroyFramebuffer(device.getDevice(), framebuffer, device.getAllocator());
     }
 
-    vkDestroyRenderPass(device.getDevice(), mRenderPass, nullptr);
+    vkDestroyRenderPass(device.getDevice(), mRenderPass, device.getAllocator());
 
     // cleanup synchronization objects
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-      vkDestroySemaphore(device.getDevice(), mRenderFinishedSemaphores[i], nullptr);
-      vkDestroySemaphore(device.getDevice(), mImageAvailableSemaphores[i], nullptr);
-      vkDestroyFence(device.getDevice(), mInFlightFences[i], nullptr);
+      vkDestroySemaphore(device.getDevice(), mRenderFinishedSemaphores[i], device.getAllocator());
+      vkDestroySemaphore(device.getDevice(), mImageAvailableSemaphores[i], device.getAllocator());
+      vkDestroyFence(device.getDevice(), mInFlightFences[i], device.getAllocator());
     }
   }
 
@@ -82,6 +83,11 @@ namespace rw
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // frame capture copies straight out of the presentable image when the surface allows it
+    mSupportsReadback = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+    if (mSupportsReadback) {
+      createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
 
     QueueFamilyIndices indices = device.findQueueFamilies();
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
@@ -105,7 +111,7 @@ namespace rw
 
     createInfo.oldSwapchain = mOldSwapChain == nullptr ? VK_NULL_HANDLE : mOldSwapChain->mSwapChain;
 
-    if (vkCreateSwapchainKHR(device.getDevice(), &createInfo, nullptr, &mSwapChain) != VK_SUCCESS) {
+    if (vkCreateSwapchainKHR(device.getDevice(), &createInfo, device.getAllocator(), &mSwapChain) != VK_SUCCESS) {
       throw std::runtime_error("failed to create swap chain!");
     }
 
@@ -132,7 +138,7 @@ namespace rw
       viewInfo.subresourceRange.baseArrayLayer = 0;
       viewInfo.subresourceRange.layerCount = 1;
 
-      VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, nullptr, &mSwapChainImageViews[i]), "Failed to create image views");
+      VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocator(), &mSwapChainImageViews[i]), "Failed to create image views");
     }
   }
 
@@ -182,7 +188,7 @@ namespace rw
       viewInfo.subresourceRange.baseArrayLayer = 0;
       viewInfo.subresourceRange.layerCount = 1;
 
-      VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, nullptr, &mSwapChainDepthViews[i]), "Failed to create depth image view");
+      VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocator(), &mSwapChainDepthViews[i]), "Failed to create depth image view");
     }
   }
 
@@ -243,7 +249,7 @@ namespace rw
     renderPassInfo.dependencyCount = 1;
     renderPassInfo.pDependencies = &dependency;
 
-    VK_CHECK(vkCreateRenderPass(device.getDevice(), &renderPassInfo, nullptr, &mRenderPass), "Failed to create render pass");
+    VK_CHECK(vkCreateRenderPass(device.getDevice(), &renderPassInfo, device.getAllocator(), &mRenderPass), "Failed to create render pass");
   }
 
   void SwapChain::createFramebuffers()
@@ -263,7 +269,7 @@ namespace rw
       framebufferInfo.height = swapChainExtent.height;
       framebufferInfo.layers = 1;
 
-      VK_CHECK(vkCreateFramebuffer(device.getDevice(), &framebufferInfo, nullptr, &mSwapChainFramebuffers[i]), "Failed to create framebuffer");
+      VK_CHECK(vkCreateFramebuffer(device.getDevice(), &framebufferInfo, device.getAllocator(), &mSwapChainFramebuffers[i]), "Failed to create framebuffer");
     }
   }
 
@@ -284,9 +290,9 @@ namespace rw
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
     {
-      VK_CHECK(vkCreateSemaphore(device.getDevice(), &semaphoreInfo, nullptr, &mImageAvailableSemaphores[i]), "Failed to create image semaphore");
-      VK_CHECK(vkCreateSemaphore(device.getDevice(), &semaphoreInfo, nullptr, &mRenderFinishedSemaphores[i]), "Failed to create render semaphore");
-      VK_CHECK(vkCreateFence(device.getDevice(), &fenceInfo, nullptr, &mInFlightFences[i]), "Failed to create frame in flight fence");
+      VK_CHECK(vkCreateSemaphore(device.getDevice(), &semaphoreInfo, device.getAllocator(), &mImageAvailableSemaphores[i]), "Failed to create image semaphore");
+      VK_CHECK(vkCreateSemaphore(device.getDevice(), &semaphoreInfo, device.getAllocator(), &mRenderFinishedSemaphores[i]), "Failed to create render semaphore");
+      VK_CHECK(vkCreateFence(device.getDevice(), &fenceInfo, device.getAllocator(), &mInFlightFences[i]), "Failed to create frame in flight fence");
     }
 
   }
@@ -299,7 +305,7 @@ namespace rw
     for (const auto& format : availableFormats)
     {
       if (format.format == VK_FORMAT_B8G8R8A8_SRGB && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-        LOG("Choosen foramt VK_FORMAT_B8G8R8A8_SRGB and color space VK_COLOR_SPACE_SRGB_NONLINEAR_KHR");
+        DLOG("Choosen foramt VK_FORMAT_B8G8R8A8_SRGB and color space VK_COLOR_SPACE_SRGB_NONLINEAR_KHR");
         return format;
       }
     }
@@ -313,12 +319,12 @@ namespace rw
     {
       if (mode == VK_PRESENT_MODE_MAILBOX_KHR)
       {
-        LOG("Present mode: VK_PRESENT_MODE_MAILBOX_KHR");
+        DLOG("Present mode: VK_PRESENT_MODE_MAILBOX_KHR");
         return mode;
       }
     }
 
-    LOG("Present mode: VK_PRESENT_MODE_FIFO_KHR");
+    DLOG("Present mode: VK_PRESENT_MODE_FIFO_KHR");
     return VK_PRESENT_MODE_FIFO_KHR;
   }
  
@@ -346,15 +352,20 @@ namespace rw
 
   VkResult SwapChain::acquireNextImage(uint32_t* imageIdx) 
   {
-    vkWaitForFences(device.getDevice(), 1u, &mInFlightFences[mCurrentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    {
+      TRACE_SCOPE("frame fence wait");
+      vkWaitForFences(device.getDevice(), 1u, &mInFlightFences[mCurrentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
 
+    TRACE_SCOPE("acquire image");
     return vkAcquireNextImageKHR(device.getDevice(), mSwapChain, std::numeric_limits<uint64_t>::max(), mImageAvailableSemaphores[mCurrentFrame], VK_NULL_HANDLE, imageIdx);
   }
 
-  VkResult SwapChain::submitCommandBuffer(const VkCommandBuffer* commands, uint32_t* imageIdx)
+  VkResult SwapChain::submitCommandBuffer(const VkCommandBuffer* commands, uint32_t* imageIdx, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage)
   {
     if (mImagesInFlights[*imageIdx] != VK_NULL_HANDLE)
     {
+      TRACE_SCOPE("image fence wait");
       vkWaitForFences(device.getDevice(), 1u, &mImagesInFlights[*imageIdx], VK_TRUE, std::numeric_limits<uint64_t>::max());
     }
 
@@ -363,10 +374,10 @@ namespace rw
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = { mImageAvailableSemaphores[mCurrentFrame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    VkSemaphore waitSemaphores[] = { mImageAvailableSemaphores[mCurrentFrame], waitSemaphore };
+    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, waitStage };
 
-    submitInfo.waitSemaphoreCount = 1u;
+    submitInfo.waitSemaphoreCount = waitSemaphore != VK_NULL_HANDLE ? 2u : 1u;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
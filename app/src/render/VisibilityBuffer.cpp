@@ -0,0 +1,201 @@
+#include <render/VisibilityBuffer.h>
+#include <Log.h>
+
+#include <array>
+
+namespace rw
+{
+  namespace
+  {
+    constexpr VkFormat VISIBILITY_FORMAT = VK_FORMAT_R32G32_UINT;
+  }
+
+  VisibilityBuffer::VisibilityBuffer(Device& dev) : device{ dev }
+  {
+    // sampled by the resolve pass to rebuild the position
+    mDepthFormat = device.findSupportedFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM }, VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+    createRenderPass();
+    createSampler();
+  }
+
+  VisibilityBuffer::~VisibilityBuffer()
+  {
+    destroyImages();
+    vkDestroySampler(device.getDevice(), mSampler, device.getAllocator());
+    vkDestroyRenderPass(device.getDevice(), mRenderPass, device.getAllocator());
+  }
+
+  void VisibilityBuffer::createRenderPass()
+  {
+    VkAttachmentDescription visibilityAttachment = {};
+    visibilityAttachment.format = VISIBILITY_FORMAT;
+    visibilityAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    visibilityAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    visibilityAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    visibilityAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    visibilityAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    visibilityAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    visibilityAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkAttachmentDescription depthAttachment = visibilityAttachment;
+    depthAttachment.format = mDepthFormat;
+
+    VkAttachmentReference visibilityAttachmentRef = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depthAttachmentRef = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &visibilityAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    // wait for the previous frame's resolve to stop reading, and make both images visible to this frame's
+    std::array<VkSubpassDependency, 2> dependencies = {};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    std::array<VkAttachmentDescription, 2> attachments = { visibilityAttachment, depthAttachment };
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    VK_CHECK(vkCreateRenderPass(device.getDevice(), &renderPassInfo, device.getAllocator(), &mRenderPass), "Failed to create visibility render pass");
+  }
+
+  void VisibilityBuffer::createSampler()
+  {
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    VK_CHECK(vkCreateSampler(device.getDevice(), &samplerInfo, device.getAllocator(), &mSampler), "Failed to create visibility sampler");
+  }
+
+  void VisibilityBuffer::resize(VkExtent2D extent)
+  {
+    if (extent.width == mExtent.width && extent.height == mExtent.height) return;
+
+    destroyImages();
+    mExtent = extent;
+    if (extent.width == 0 || extent.height == 0) return;
+    createImages();
+  }
+
+  void VisibilityBuffer::createImages()
+  {
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { mExtent.width, mExtent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    imageInfo.format = VISIBILITY_FORMAT;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mVisibilityImage, mVisibilityMemory);
+
+    imageInfo.format = mDepthFormat;
+    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mDepthImage, mDepthMemory);
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    viewInfo.image = mVisibilityImage;
+    viewInfo.format = VISIBILITY_FORMAT;
+    VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocator(), &mVisibilityView), "Failed to create visibility view");
+
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    viewInfo.image = mDepthImage;
+    viewInfo.format = mDepthFormat;
+    VK_CHECK(vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocator(), &mDepthView), "Failed to create visibility depth view");
+
+    std::array<VkImageView, 2> attachments = { mVisibilityView, mDepthView };
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = mRenderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebufferInfo.pAttachments = attachments.data();
+    framebufferInfo.width = mExtent.width;
+    framebufferInfo.height = mExtent.height;
+    framebufferInfo.layers = 1;
+    VK_CHECK(vkCreateFramebuffer(device.getDevice(), &framebufferInfo, device.getAllocator(), &mFramebuffer), "Failed to create visibility framebuffer");
+  }
+
+  void VisibilityBuffer::destroyImages()
+  {
+    VkDevice handle = device.getDevice();
+    vkDestroyFramebuffer(handle, mFramebuffer, device.getAllocator());
+    vkDestroyImageView(handle, mVisibilityView, device.getAllocator());
+    vkDestroyImageView(handle, mDepthView, device.getAllocator());
+    vkDestroyImage(handle, mVisibilityImage, device.getAllocator());
+    vkDestroyImage(handle, mDepthImage, device.getAllocator());
+    vkFreeMemory(handle, mVisibilityMemory, device.getAllocator());
+    vkFreeMemory(handle, mDepthMemory, device.getAllocator());
+    mFramebuffer = VK_NULL_HANDLE;
+    mVisibilityView = mDepthView = VK_NULL_HANDLE;
+    mVisibilityImage = mDepthImage = VK_NULL_HANDLE;
+    mVisibilityMemory = mDepthMemory = VK_NULL_HANDLE;
+  }
+
+  void VisibilityBuffer::beginRenderPass(VkCommandBuffer command, VkExtent2D renderExtent)
+  {
+    if (mFramebuffer == VK_NULL_HANDLE) RT_THROW("Visibility buffer has no size");
+
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color.uint32[0] = NO_INSTANCE;
+    clearValues[1].depthStencil = { 1.0f, 0 };
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = mRenderPass;
+    renderPassInfo.framebuffer = mFramebuffer;
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = renderExtent;
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+    vkCmdBeginRenderPass(command, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport = {};
+    viewport.width = static_cast<float>(renderExtent.width);
+    viewport.height = static_cast<float>(renderExtent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{ { 0, 0 }, renderExtent };
+    vkCmdSetViewport(command, 0, 1, &viewport);
+    vkCmdSetScissor(command, 0, 1, &scissor);
+  }
+
+  void VisibilityBuffer::endRenderPass(VkCommandBuffer command)
+  {
+    vkCmdEndRenderPass(command);
+  }
+}
@@ -0,0 +1,147 @@
+#include <scene/Animation.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RW_SLERP_SSE 1
+#endif
+
+namespace rw {
+#ifdef RW_SLERP_SSE
+namespace {
+// horizontal dot product broadcast to all lanes, SSE2 only
+inline __m128 dot4(__m128 a, __m128 b)
+{
+    const __m128 m = _mm_mul_ps(a, b);
+    const __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+}
+#endif
+
+glm::vec4 slerp(const glm::vec4 &a, const glm::vec4 &b, float t)
+{
+#ifdef RW_SLERP_SSE
+    __m128 qa = _mm_setr_ps(a.x, a.y, a.z, a.w);
+    __m128 qb = _mm_setr_ps(b.x, b.y, b.z, b.w);
+    float cosTheta = _mm_cvtss_f32(dot4(qa, qb));
+    // take the short way around
+    if (cosTheta < 0.0f)
+    {
+        qb = _mm_sub_ps(_mm_setzero_ps(), qb);
+        cosTheta = -cosTheta;
+    }
+#else
+    glm::vec4 qb = b;
+    float cosTheta = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    if (cosTheta < 0.0f)
+    {
+        qb = glm::vec4(-b.x, -b.y, -b.z, -b.w);
+        cosTheta = -cosTheta;
+    }
+#endif
+
+    float wa = 1.0f - t;
+    float wb = t;
+    // nearly parallel, sin(theta) goes to zero; the linear weights are exact enough there
+    if (cosTheta < 0.9995f)
+    {
+        const float theta = std::acos(cosTheta);
+        const float invSin = 1.0f / std::sin(theta);
+        wa = std::sin((1.0f - t) * theta) * invSin;
+        wb = std::sin(t * theta) * invSin;
+    }
+
+#ifdef RW_SLERP_SSE
+    __m128 q = _mm_add_ps(_mm_mul_ps(qa, _mm_set1_ps(wa)), _mm_mul_ps(qb, _mm_set1_ps(wb)));
+    q = _mm_div_ps(q, _mm_sqrt_ps(dot4(q, q)));
+    alignas(16) float out[4];
+    _mm_store_ps(out, q);
+    return glm::vec4(out[0], out[1], out[2], out[3]);
+#else
+    glm::vec4 q(a.x * wa + qb.x * wb, a.y * wa + qb.y * wb, a.z * wa + qb.z * wb, a.w * wa + qb.w * wb);
+    const float invLength = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return glm::vec4(q.x * invLength, q.y * invLength, q.z * invLength, q.w * invLength);
+#endif
+}
+
+std::size_t findKey(const std::vector<float> &times, float time, std::size_t hint)
+{
+    const std::size_t last = times.size() - 1;
+    if (hint >= last) hint = 0;
+    if (time < times[hint]) hint = 0;
+    // a frame rarely advances more than a couple of keys
+    for (std::size_t step = 0; step < 4 && hint < last; ++step, ++hint)
+    {
+        if (time < times[hint + 1]) return hint;
+    }
+    auto it = std::upper_bound(times.begin() + static_cast<std::ptrdiff_t>(hint), times.end(), time);
+    const auto index = static_cast<std::size_t>(std::distance(times.begin(), it));
+    return index == 0 ? 0 : std::min(index - 1, last);
+}
+
+glm::mat4 composeTransform(const glm::vec3 &translation, const glm::vec4 &rotation, const glm::vec3 &scale)
+{
+    const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+
+    return glm::mat4(
+        glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f),
+        glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f),
+        glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f),
+        glm::vec4(translation, 1.0f));
+}
+
+void sampleLocalPose(const Skeleton &skeleton, const AnimationClip &clip, float time, std::size_t first, std::size_t last,
+                     glm::mat4 *local, std::uint32_t *cursors)
+{
+    for (std::size_t j = first; j < last; ++j)
+    {
+        const auto &joint = skeleton.joints[j];
+        if (j >= clip.tracks.size() || clip.tracks[j].times.empty())
+        {
+            local[j] = composeTransform(joint.translation, joint.rotation, joint.scale);
+            continue;
+        }
+
+        const auto &track = clip.tracks[j];
+        if (track.times.size() == 1 || time <= track.times.front())
+        {
+            local[j] = composeTransform(track.translations.front(), track.rotations.front(), track.scales.front());
+            continue;
+        }
+        if (time >= track.times.back())
+        {
+            local[j] = composeTransform(track.translations.back(), track.rotations.back(), track.scales.back());
+            continue;
+        }
+
+        const std::size_t key = findKey(track.times, time, cursors[j]);
+        cursors[j] = static_cast<std::uint32_t>(key);
+        const float span = track.times[key + 1] - track.times[key];
+        const float t = span > 0.0f ? (time - track.times[key]) / span : 0.0f;
+
+        const glm::vec3 translation = track.translations[key] + (track.translations[key + 1] - track.translations[key]) * t;
+        const glm::vec3 scale = track.scales[key] + (track.scales[key + 1] - track.scales[key]) * t;
+        local[j] = composeTransform(translation, slerp(track.rotations[key], track.rotations[key + 1], t), scale);
+    }
+}
+
+void buildPalette(const Skeleton &skeleton, const glm::mat4 *local, glm::mat4 *palette)
+{
+    // palette first holds the global transforms, parents are resolved before their children
+    for (std::size_t j = 0; j < skeleton.joints.size(); ++j)
+    {
+        const auto parent = skeleton.joints[j].parent;
+        palette[j] = parent >= 0 ? palette[parent] * local[j] : local[j];
+    }
+    for (std::size_t j = 0; j < skeleton.joints.size(); ++j)
+    {
+        palette[j] = palette[j] * skeleton.joints[j].inverseBind;
+    }
+}
+}
@@ -0,0 +1,69 @@
+#include <scene/AnimationPlayer.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rw {
+namespace {
+constexpr std::size_t JOINTS_PER_CHUNK = 256;
+}
+
+void AnimationPlayer::evaluate(const Scene &scene, const std::vector<std::uint32_t> &nodes, double time,
+                               std::vector<glm::mat4> &palettes, std::vector<std::uint32_t> &paletteOffsets)
+{
+    const auto &animated = scene.getAnimatedNodes();
+    if (mCursorOffsets.size() != animated.size())
+    {
+        mCursorOffsets.clear();
+        std::uint32_t total = 0;
+        for (const auto &node : animated)
+        {
+            mCursorOffsets.push_back(total);
+            total += static_cast<std::uint32_t>(scene.getSkeleton(node.skeleton).joints.size());
+        }
+        mCursors.assign(total, 0);
+    }
+
+    paletteOffsets.clear();
+    std::uint32_t jointCount = 0;
+    for (auto index : nodes)
+    {
+        paletteOffsets.push_back(jointCount);
+        jointCount += static_cast<std::uint32_t>(scene.getSkeleton(animated[index].skeleton).joints.size());
+    }
+    palettes.resize(jointCount);
+    mLocal.resize(jointCount);
+    if (jointCount == 0) return;
+
+    auto nodeTime = [&](const AnimatedNode &node) {
+        const float duration = scene.getClip(node.clip).duration;
+        const double t = time + node.timeOffset;
+        return duration > 0.0f ? static_cast<float>(std::fmod(t, static_cast<double>(duration))) : 0.0f;
+    };
+
+    // local poses, split over the joints of all nodes so one big skeleton still spreads out
+    mPool.parallelFor(jointCount, JOINTS_PER_CHUNK, [&](std::size_t begin, std::size_t end) {
+        auto it = std::upper_bound(paletteOffsets.begin(), paletteOffsets.end(), static_cast<std::uint32_t>(begin));
+        std::size_t n = static_cast<std::size_t>(std::distance(paletteOffsets.begin(), it)) - 1;
+        while (begin < end)
+        {
+            const auto &node = animated[nodes[n]];
+            const auto &skeleton = scene.getSkeleton(node.skeleton);
+            const std::size_t nodeFirst = paletteOffsets[n];
+            const std::size_t nodeEnd = std::min(end, nodeFirst + skeleton.joints.size());
+            sampleLocalPose(skeleton, scene.getClip(node.clip), nodeTime(node), begin - nodeFirst, nodeEnd - nodeFirst,
+                            mLocal.data() + nodeFirst, mCursors.data() + mCursorOffsets[nodes[n]]);
+            begin = nodeEnd;
+            ++n;
+        }
+    });
+
+    mPool.parallelFor(nodes.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t n = begin; n < end; ++n)
+        {
+            const auto &skeleton = scene.getSkeleton(animated[nodes[n]].skeleton);
+            buildPalette(skeleton, mLocal.data() + paletteOffsets[n], palettes.data() + paletteOffsets[n]);
+        }
+    });
+}
+}
@@ -0,0 +1,70 @@
+#include <scene/Camera.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rw {
+void Camera::setPerspective(float fovy, float aspect, float nearPlane, float farPlane)
+{
+    mFovy = fovy;
+    mAspect = aspect;
+    mNear = nearPlane;
+    mFar = farPlane;
+}
+
+void Camera::setAspectRatio(float aspect)
+{
+    mAspect = aspect;
+}
+
+void Camera::setOrbit(const glm::vec3 &target, float distance, float yaw, float pitch)
+{
+    mTarget = target;
+    mDistance = distance;
+    mYaw = yaw;
+    mPitch = std::clamp(pitch, -1.55f, 1.55f);
+}
+
+void Camera::orbit(float deltaYaw, float deltaPitch)
+{
+    mYaw += deltaYaw;
+    mPitch = std::clamp(mPitch + deltaPitch, -1.55f, 1.55f);
+}
+
+void Camera::zoom(float factor)
+{
+    mDistance = std::max(mDistance * factor, mNear * 2.0f);
+}
+
+void Camera::frame(const BoundingBox &bounds)
+{
+    if (!bounds.isValid()) return;
+
+    float radius = std::max(glm::length(bounds.extent()) * 0.5f, 0.01f);
+    mTarget = bounds.center();
+    mDistance = radius / std::sin(mFovy * 0.5f);
+    mNear = std::max(mDistance - radius, radius) * 0.001f;
+    mFar = (mDistance + radius) * 4.0f;
+}
+
+glm::vec3 Camera::getPosition() const
+{
+    glm::vec3 dir {std::cos(mPitch) * std::sin(mYaw), std::sin(mPitch), std::cos(mPitch) * std::cos(mYaw)};
+    return mTarget + dir * mDistance;
+}
+
+glm::mat4 Camera::getView() const
+{
+    return glm::lookAt(getPosition(), mTarget, glm::vec3 {0.0f, 1.0f, 0.0f});
+}
+
+glm::mat4 Camera::getProjection() const
+{
+    glm::mat4 proj = glm::perspective(mFovy, mAspect, mNear, mFar);
+    // Vulkan clip space has an inverted Y compared to OpenGL
+    proj[1][1] *= -1.0f;
+    return proj;
+}
+}
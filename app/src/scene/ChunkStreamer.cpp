@@ -0,0 +1,262 @@
+#include <scene/ChunkStreamer.h>
+#include <core/AllocationCounters.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rw {
+ChunkStreamer::ChunkStreamer(const std::string &path, const ChunkStreamerOptions &options)
+    : mPath {path}, mOptions {options}, mNodes {ChunkedModel::readIndex(path)}, mIoPool {std::max<std::size_t>(options.ioThreads, 1)}
+{
+    mResident.resize(mNodes.size());
+    mLruPosition.resize(mNodes.size(), mLru.end());
+    mState.resize(mNodes.size(), Idle);
+    mFailed.resize(mNodes.size(), 0);
+    mWantedGeneration = std::make_unique<std::atomic<std::uint32_t>[]>(mNodes.size());
+    for (std::size_t i = 0; i < mNodes.size(); ++i) mWantedGeneration[i].store(0, std::memory_order_relaxed);
+
+    LOG("Streaming {}: {} chunk(s), {} I/O thread(s), {} MiB cache", path, mNodes.size(), mIoPool.getThreadCount(), mOptions.cacheBytes >> 20);
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+    std::lock_guard<std::mutex> lock {mMutex};
+    mStopping = true;
+    mPending.clear();
+    // reads in progress see the stale generation and stop at their next block
+    mGeneration.fetch_add(2, std::memory_order_relaxed);
+}
+
+void ChunkStreamer::update(const Camera &camera, const Frustum &frustum, float viewportHeight, std::vector<StreamedChunk> &visible)
+{
+    takeLoaded();
+
+    mGeneration.fetch_add(1, std::memory_order_relaxed);
+    mWanted.clear();
+    visible.clear();
+    const float projectionScale = viewportHeight / (2.0f * std::tan(camera.getFovy() * 0.5f));
+    select(0, camera.getPosition(), projectionScale, frustum, visible);
+
+    std::sort(mWanted.begin(), mWanted.end(), [](const Request &a, const Request &b) { return a.priority < b.priority; });
+    const std::uint32_t generation = mGeneration.load(std::memory_order_relaxed);
+    std::size_t pumps = 0;
+    {
+        std::lock_guard<std::mutex> lock {mMutex};
+        // whatever is queued but no longer wanted is dropped before it touches the disk
+        for (const auto &request : mPending)
+        {
+            if (mWantedGeneration[request.id].load(std::memory_order_relaxed) != generation) ++mCancelled;
+        }
+        mPending.clear();
+        for (const auto &request : mWanted)
+        {
+            if (mState[request.id] == Idle && !mFailed[request.id]) mPending.push_back(request);
+        }
+        while (mActivePumps < mIoPool.getThreadCount() && mActivePumps < mPending.size())
+        {
+            ++mActivePumps;
+            ++pumps;
+        }
+    }
+    for (std::size_t i = 0; i < pumps; ++i)
+    {
+        mIoPool.submit([this]() { pump(); });
+    }
+
+    evict();
+}
+
+void ChunkStreamer::select(ChunkId id, const glm::vec3 &eye, float projectionScale, const Frustum &frustum, std::vector<StreamedChunk> &visible)
+{
+    const auto &node = mNodes[id];
+    if (!frustum.intersects(node.bounds)) return;
+
+    const glm::vec3 outside = glm::max(glm::max(node.bounds.min - eye, eye - node.bounds.max), glm::vec3(0.0f));
+    const float distance = std::max(glm::length(outside), 1.0e-3f);
+    const float screenError = node.geometricError * projectionScale / distance;
+
+    if (!isResident(id))
+    {
+        want(id, screenError);
+        return;
+    }
+    touch(id);
+
+    if (node.childCount > 0 && screenError > mOptions.maxScreenError)
+    {
+        bool ready = true;
+        for (ChunkId child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+        {
+            if (isResident(child))
+            {
+                touch(child);
+            }
+            else if (frustum.intersects(mNodes[child].bounds))
+            {
+                // children inherit the urgency of the parent that needs refining
+                want(child, screenError);
+                ready = false;
+            }
+        }
+        if (ready)
+        {
+            for (ChunkId child = node.firstChild; child < node.firstChild + node.childCount; ++child)
+            {
+                select(child, eye, projectionScale, frustum, visible);
+            }
+            return;
+        }
+    }
+
+    if (!node.isEmpty())
+    {
+        visible.push_back(StreamedChunk {id, mResident[id]});
+    }
+}
+
+void ChunkStreamer::want(ChunkId id, float priority)
+{
+    mWantedGeneration[id].store(mGeneration.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mWanted.push_back(Request {id, priority});
+}
+
+void ChunkStreamer::touch(ChunkId id)
+{
+    mWantedGeneration[id].store(mGeneration.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (mLruPosition[id] != mLru.end())
+    {
+        mLru.splice(mLru.begin(), mLru, mLruPosition[id]);
+    }
+}
+
+void ChunkStreamer::takeLoaded()
+{
+    std::vector<Loaded> loaded;
+    bool more = false;
+    {
+        std::lock_guard<std::mutex> lock {mMutex};
+        const std::size_t count = std::min<std::size_t>(mLoaded.size(), mOptions.maxLoadsPerUpdate);
+        loaded.assign(std::make_move_iterator(mLoaded.begin()), std::make_move_iterator(mLoaded.begin() + count));
+        mLoaded.erase(mLoaded.begin(), mLoaded.begin() + count);
+        for (const auto &chunk : loaded) mState[chunk.id] = Idle;
+        more = !mLoaded.empty();
+    }
+    // the rest is taken by the next update, make sure there is one
+    if (more && mLoadedCallback) mLoadedCallback();
+
+    for (auto &chunk : loaded)
+    {
+        if (mResident[chunk.id]) continue;
+        mResidentBytes += mNodes[chunk.id].byteSize();
+        mResident[chunk.id] = std::move(chunk.mesh);
+        mLru.push_front(chunk.id);
+        mLruPosition[chunk.id] = mLru.begin();
+    }
+}
+
+void ChunkStreamer::evict()
+{
+    const std::uint32_t generation = mGeneration.load(std::memory_order_relaxed);
+    while (mResidentBytes > mOptions.cacheBytes && !mLru.empty())
+    {
+        const ChunkId id = mLru.back();
+        // everything left was used by this very view, the cache is simply too small for it
+        if (mWantedGeneration[id].load(std::memory_order_relaxed) == generation)
+        {
+            WLOG_EVERY_MS(5000, "Streaming cache of {} MiB is too small for the current view", mOptions.cacheBytes >> 20);
+            break;
+        }
+        mLru.pop_back();
+        mLruPosition[id] = mLru.end();
+        mResidentBytes -= mNodes[id].byteSize();
+        // snapshots still drawing the chunk keep their own reference until they are recycled
+        mResident[id].reset();
+        ++mEvicted;
+    }
+}
+
+void ChunkStreamer::pump()
+{
+    AllocationScope allocations{AllocationTag::Streaming};
+    std::ifstream file {mPath, std::ios::binary};
+    for (;;)
+    {
+        Request request {};
+        {
+            std::lock_guard<std::mutex> lock {mMutex};
+            if (mStopping || mPending.empty() || !file)
+            {
+                --mActivePumps;
+                return;
+            }
+            request = mPending.back();
+            mPending.pop_back();
+            mState[request.id] = Reading;
+        }
+
+        // a request is stale once an update ran without wanting the chunk again
+        const auto stale = [this, id = request.id]() {
+            return mWantedGeneration[id].load(std::memory_order_relaxed) + 1 < mGeneration.load(std::memory_order_relaxed);
+        };
+
+        auto mesh = std::make_shared<MeshData>();
+        ChunkReadStats readStats;
+        bool completed = false;
+        bool failed = false;
+        try
+        {
+            TRACE_SCOPE("read chunk");
+            completed = ChunkedModel::readChunk(file, mNodes[request.id], *mesh, stale, &readStats);
+        }
+        catch (std::exception &e)
+        {
+            ELOG("Streaming chunk {} of {}: {}", request.id, mPath, e.what());
+            failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock {mMutex};
+            mState[request.id] = completed ? Ready : Idle;
+            if (failed)
+            {
+                mFailed[request.id] = 1;
+            }
+            else if (completed)
+            {
+                mLoaded.push_back(Loaded {request.id, std::move(mesh)});
+                ++mLoadedCount;
+                mReadStats.storedBytes += readStats.storedBytes;
+                mReadStats.rawBytes += readStats.rawBytes;
+                mReadStats.decodedBytes += readStats.decodedBytes;
+                mReadStats.decodeNs += readStats.decodeNs;
+            }
+            else
+            {
+                ++mCancelled;
+            }
+        }
+        if (completed && mLoadedCallback) mLoadedCallback();
+    }
+}
+
+ChunkStreamerStats ChunkStreamer::getStats() const
+{
+    ChunkStreamerStats stats;
+    stats.residentChunks = static_cast<std::uint32_t>(mLru.size());
+    stats.residentBytes = mResidentBytes;
+    stats.evicted = mEvicted;
+
+    std::lock_guard<std::mutex> lock {mMutex};
+    stats.pending = static_cast<std::uint32_t>(mPending.size());
+    stats.inFlight = static_cast<std::uint32_t>(std::count(mState.begin(), mState.end(), Reading));
+    stats.loaded = mLoadedCount;
+    stats.cancelled = mCancelled;
+    stats.storedBytes = mReadStats.storedBytes;
+    stats.rawBytes = mReadStats.rawBytes;
+    stats.decodedBytes = mReadStats.decodedBytes;
+    stats.decodeNs = mReadStats.decodeNs;
+    return stats;
+}
+}
@@ -0,0 +1,415 @@
+#include <scene/ChunkedModel.h>
+#include <core/Clock.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <unordered_map>
+
+namespace rw {
+namespace {
+constexpr char kMagic[4] = {'R', 'W', 'O', 'C'};
+// large enough for sequential throughput, small enough that a cancelled read stops quickly
+constexpr std::uint64_t kReadBlock = 4ull << 20;
+
+struct DiskHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t nodeCount;
+    std::uint32_t reserved;
+    std::uint64_t nodeTableOffset;
+};
+
+struct DiskNode {
+    float boundsMin[3];
+    float boundsMax[3];
+    float geometricError;
+    std::uint32_t firstChild;
+    std::uint32_t childCount;
+    std::uint32_t level;
+    std::uint32_t vertexCount;
+    std::uint32_t indexCount;
+    std::uint64_t offset;
+    std::uint64_t storedSize;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(DiskHeader) == 24 && sizeof(DiskNode) == 72, "chunk file layout changed");
+
+constexpr std::uint32_t kNodeCompressed = 1;
+
+// a triangle of the source scene: scene node and first index of the triangle in its mesh
+struct SourceTriangle {
+    std::uint32_t node;
+    std::uint32_t index;
+};
+
+class Builder {
+public:
+    Builder(const Scene &scene, std::ofstream &file, const ChunkedModelOptions &options)
+        : mScene {scene}, mFile {file}, mOptions {options}
+    {
+        for (const auto &node : scene.getNodes())
+        {
+            mNormalMatrices.push_back(glm::transpose(glm::inverse(glm::mat3(node.transform))));
+        }
+    }
+
+    std::vector<ChunkNode> run()
+    {
+        std::vector<SourceTriangle> triangles;
+        BoundingBox bounds;
+        const auto &nodes = mScene.getNodes();
+        for (std::uint32_t n = 0; n < nodes.size(); ++n)
+        {
+            const auto &mesh = mScene.getGeometry().get(nodes[n].mesh);
+            const std::size_t count = mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size();
+            for (std::uint32_t i = 0; i + 2 < count; i += 3)
+            {
+                triangles.push_back(SourceTriangle {n, i});
+            }
+            bounds.expand(nodes[n].worldBounds);
+        }
+        if (triangles.empty()) RT_THROW("Cannot build a chunked model from an empty scene");
+
+        // split cells are cubes so every level halves the simplification error
+        const glm::vec3 extent = bounds.extent();
+        const float size = std::max(extent.x, std::max(extent.y, extent.z));
+        BoundingBox cell;
+        cell.min = bounds.center() - glm::vec3(size * 0.5f);
+        cell.max = bounds.center() + glm::vec3(size * 0.5f);
+
+        mNodes.emplace_back();
+        buildNode(0, cell, 0, std::move(triangles));
+        return std::move(mNodes);
+    }
+
+private:
+    Vertex fetch(const SourceTriangle &triangle, std::uint32_t corner) const
+    {
+        const auto &node = mScene.getNodes()[triangle.node];
+        const auto &mesh = mScene.getGeometry().get(node.mesh);
+        const std::uint32_t index = mesh.indices.empty() ? triangle.index + corner : mesh.indices[triangle.index + corner];
+        Vertex vertex = mesh.vertices[index];
+        vertex.position = glm::vec3(node.transform * glm::vec4(vertex.position, 1.0f));
+        vertex.normal = glm::normalize(mNormalMatrices[triangle.node] * vertex.normal);
+        return vertex;
+    }
+
+    glm::vec3 centroid(const SourceTriangle &triangle) const
+    {
+        return (fetch(triangle, 0).position + fetch(triangle, 1).position + fetch(triangle, 2).position) / 3.0f;
+    }
+
+    void buildNode(std::uint32_t index, const BoundingBox &cell, std::uint32_t depth, std::vector<SourceTriangle> triangles)
+    {
+        mNodes[index].level = depth;
+        const bool leaf = triangles.size() <= mOptions.maxLeafTriangles || depth >= mOptions.maxDepth;
+        if (leaf)
+        {
+            writeGeometry(mNodes[index], makeLeaf(triangles));
+            return;
+        }
+
+        float error = 0.0f;
+        writeGeometry(mNodes[index], makeLod(triangles, cell, error));
+        mNodes[index].geometricError = error;
+
+        std::array<std::vector<SourceTriangle>, 8> octants;
+        const glm::vec3 center = cell.center();
+        for (const auto &triangle : triangles)
+        {
+            const glm::vec3 c = centroid(triangle);
+            octants[(c.x > center.x ? 1 : 0) | (c.y > center.y ? 2 : 0) | (c.z > center.z ? 4 : 0)].push_back(triangle);
+        }
+        triangles = {};
+
+        // children are allocated together so a node only needs the first index and a count
+        const auto firstChild = static_cast<std::uint32_t>(mNodes.size());
+        std::array<BoundingBox, 8> cells;
+        std::uint32_t childCount = 0;
+        for (std::uint32_t o = 0; o < octants.size(); ++o)
+        {
+            if (octants[o].empty()) continue;
+            cells[o].min = glm::vec3((o & 1) ? center.x : cell.min.x, (o & 2) ? center.y : cell.min.y, (o & 4) ? center.z : cell.min.z);
+            cells[o].max = glm::vec3((o & 1) ? cell.max.x : center.x, (o & 2) ? cell.max.y : center.y, (o & 4) ? cell.max.z : center.z);
+            ++childCount;
+        }
+        mNodes.resize(mNodes.size() + childCount);
+        mNodes[index].firstChild = firstChild;
+        mNodes[index].childCount = childCount;
+
+        std::uint32_t child = firstChild;
+        for (std::uint32_t o = 0; o < octants.size(); ++o)
+        {
+            if (octants[o].empty()) continue;
+            buildNode(child++, cells[o], depth + 1, std::move(octants[o]));
+        }
+    }
+
+    MeshData makeLeaf(const std::vector<SourceTriangle> &triangles) const
+    {
+        MeshData mesh;
+        std::unordered_map<std::uint64_t, std::uint32_t> remap;
+        for (const auto &triangle : triangles)
+        {
+            const auto &node = mScene.getNodes()[triangle.node];
+            const auto &source = mScene.getGeometry().get(node.mesh);
+            for (std::uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const std::uint32_t sourceIndex = source.indices.empty() ? triangle.index + corner : source.indices[triangle.index + corner];
+                const std::uint64_t key = (static_cast<std::uint64_t>(triangle.node) << 32) | sourceIndex;
+                auto [it, inserted] = remap.emplace(key, static_cast<std::uint32_t>(mesh.vertices.size()));
+                if (inserted)
+                {
+                    mesh.vertices.push_back(fetch(triangle, corner));
+                }
+                mesh.indices.push_back(it->second);
+            }
+        }
+        return mesh;
+    }
+
+    // Vertex clustering: every vertex snaps to the average of its grid cell and triangles which
+    // collapse are dropped. The error is the cell diagonal, the furthest a vertex can move.
+    MeshData makeLod(const std::vector<SourceTriangle> &triangles, const BoundingBox &cell, float &error) const
+    {
+        struct Cluster {
+            glm::vec3 position {0.0f};
+            glm::vec3 normal {0.0f};
+            glm::vec2 uv {0.0f};
+            std::uint32_t count = 0;
+        };
+
+        const std::uint64_t resolution = mOptions.lodResolution;
+        const float cellSize = cell.extent().x / static_cast<float>(resolution);
+        error = cellSize * std::sqrt(3.0f);
+
+        std::unordered_map<std::uint64_t, std::uint32_t> clusterByCell;
+        std::vector<Cluster> clusters;
+        std::vector<std::uint32_t> indices;
+        for (const auto &triangle : triangles)
+        {
+            std::uint32_t corners[3];
+            for (std::uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const Vertex vertex = fetch(triangle, corner);
+                const glm::vec3 coord = glm::floor((vertex.position - cell.min) / cellSize);
+                const auto clampAxis = [resolution](float v) {
+                    return static_cast<std::uint64_t>(std::clamp(v, 0.0f, static_cast<float>(resolution - 1)));
+                };
+                const std::uint64_t key = (clampAxis(coord.x) * resolution + clampAxis(coord.y)) * resolution + clampAxis(coord.z);
+                auto [it, inserted] = clusterByCell.emplace(key, static_cast<std::uint32_t>(clusters.size()));
+                if (inserted)
+                {
+                    clusters.emplace_back();
+                    clusters.back().uv = vertex.uv;
+                }
+                auto &cluster = clusters[it->second];
+                cluster.position += vertex.position;
+                cluster.normal += vertex.normal;
+                cluster.count++;
+                corners[corner] = it->second;
+            }
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2]) continue;
+            indices.insert(indices.end(), corners, corners + 3);
+        }
+
+        MeshData mesh;
+        mesh.vertices.reserve(clusters.size());
+        for (const auto &cluster : clusters)
+        {
+            const glm::vec3 normal = glm::length(cluster.normal) > 0.0f ? glm::normalize(cluster.normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+            mesh.vertices.push_back(Vertex {cluster.position / static_cast<float>(cluster.count), normal, cluster.uv});
+        }
+        mesh.indices = std::move(indices);
+        return mesh;
+    }
+
+    void writeGeometry(ChunkNode &node, const MeshData &mesh)
+    {
+        // fewer than one triangle is not worth a draw, the node stays as an empty cell
+        if (mesh.vertices.size() < 3 || mesh.indices.empty()) return;
+
+        for (const auto &vertex : mesh.vertices) node.bounds.expand(vertex.position);
+        node.vertexCount = static_cast<std::uint32_t>(mesh.vertices.size());
+        node.indexCount = static_cast<std::uint32_t>(mesh.indices.size());
+        node.offset = static_cast<std::uint64_t>(mFile.tellp());
+        node.storedSize = node.byteSize();
+
+        if (mOptions.compress)
+        {
+            mEncoded.clear();
+            GeometryCodec::encode(mesh, mOptions.codec, mEncoded);
+            if (mEncoded.size() < node.storedSize)
+            {
+                node.compressed = true;
+                node.storedSize = mEncoded.size();
+                mFile.write(reinterpret_cast<const char *>(mEncoded.data()), static_cast<std::streamsize>(mEncoded.size()));
+                if (!mFile) RT_THROW("Failed to write chunk geometry");
+                return;
+            }
+        }
+        mFile.write(reinterpret_cast<const char *>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex));
+        mFile.write(reinterpret_cast<const char *>(mesh.indices.data()), mesh.indices.size() * sizeof(std::uint32_t));
+        if (!mFile) RT_THROW("Failed to write chunk geometry");
+    }
+
+private:
+    const Scene &mScene;
+    std::ofstream &mFile;
+    ChunkedModelOptions mOptions;
+    std::vector<glm::mat3> mNormalMatrices;
+    std::vector<ChunkNode> mNodes;
+    std::vector<std::uint8_t> mEncoded;
+};
+}
+
+void ChunkedModel::build(const Scene &scene, const std::string &path, const ChunkedModelOptions &options)
+{
+    std::ofstream file {path, std::ios::binary | std::ios::trunc};
+    if (!file) RT_THROW("Failed to create " + path);
+
+    DiskHeader header {};
+    std::copy(std::begin(kMagic), std::end(kMagic), header.magic);
+    header.version = VERSION;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    auto nodes = Builder {scene, file, options}.run();
+
+    // inner nodes cover the bounds of their whole subtree, children were written after the parent
+    for (std::size_t i = nodes.size(); i-- > 0;)
+    {
+        for (std::uint32_t c = 0; c < nodes[i].childCount; ++c)
+        {
+            nodes[i].bounds.expand(nodes[nodes[i].firstChild + c].bounds);
+        }
+    }
+
+    header.nodeCount = static_cast<std::uint32_t>(nodes.size());
+    header.nodeTableOffset = static_cast<std::uint64_t>(file.tellp());
+    std::uint64_t geometryBytes = 0;
+    std::uint64_t storedBytes = 0;
+    for (const auto &node : nodes)
+    {
+        DiskNode disk {};
+        for (int a = 0; a < 3; ++a)
+        {
+            disk.boundsMin[a] = node.bounds.min[a];
+            disk.boundsMax[a] = node.bounds.max[a];
+        }
+        disk.geometricError = node.geometricError;
+        disk.firstChild = node.firstChild;
+        disk.childCount = node.childCount;
+        disk.level = node.level;
+        disk.vertexCount = node.vertexCount;
+        disk.indexCount = node.indexCount;
+        disk.offset = node.offset;
+        disk.storedSize = node.storedSize;
+        disk.flags = node.compressed ? kNodeCompressed : 0;
+        file.write(reinterpret_cast<const char *>(&disk), sizeof(disk));
+        geometryBytes += node.byteSize();
+        storedBytes += node.storedSize;
+    }
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (!file) RT_THROW("Failed to write " + path);
+
+    LOG("Chunked model {}: {} node(s), {} MiB of geometry including LODs, {} MiB stored (compression ratio {:.2f})", path, nodes.size(),
+        geometryBytes >> 20, storedBytes >> 20, storedBytes > 0 ? static_cast<double>(geometryBytes) / static_cast<double>(storedBytes) : 1.0);
+}
+
+std::vector<ChunkNode> ChunkedModel::readIndex(const std::string &path)
+{
+    std::ifstream file {path, std::ios::binary | std::ios::ate};
+    if (!file) RT_THROW("Failed to open " + path);
+    const auto fileSize = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+
+    DiskHeader header {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || !std::equal(std::begin(kMagic), std::end(kMagic), header.magic)) RT_THROW(path + " is not a chunked model");
+    if (header.version != VERSION) RT_THROW(path + " was written by an incompatible version");
+    if (header.nodeCount == 0 || header.nodeTableOffset + header.nodeCount * sizeof(DiskNode) > fileSize) RT_THROW(path + " is truncated");
+
+    std::vector<DiskNode> disk(header.nodeCount);
+    file.seekg(static_cast<std::streamoff>(header.nodeTableOffset));
+    file.read(reinterpret_cast<char *>(disk.data()), disk.size() * sizeof(DiskNode));
+    if (!file) RT_THROW("Failed to read the node table of " + path);
+
+    std::vector<ChunkNode> nodes(disk.size());
+    for (std::size_t i = 0; i < disk.size(); ++i)
+    {
+        auto &node = nodes[i];
+        node.bounds.min = glm::vec3(disk[i].boundsMin[0], disk[i].boundsMin[1], disk[i].boundsMin[2]);
+        node.bounds.max = glm::vec3(disk[i].boundsMax[0], disk[i].boundsMax[1], disk[i].boundsMax[2]);
+        node.geometricError = disk[i].geometricError;
+        node.firstChild = disk[i].firstChild;
+        node.childCount = disk[i].childCount;
+        node.level = disk[i].level;
+        node.vertexCount = disk[i].vertexCount;
+        node.indexCount = disk[i].indexCount;
+        node.offset = disk[i].offset;
+        node.storedSize = disk[i].storedSize;
+        node.compressed = (disk[i].flags & kNodeCompressed) != 0;
+
+        if ((node.childCount > 0 && (node.firstChild <= i || node.firstChild + node.childCount > nodes.size())) ||
+            node.offset + node.storedSize > fileSize || (!node.compressed && node.storedSize != node.byteSize()))
+        {
+            RT_THROW(path + " has a corrupt node table");
+        }
+    }
+    return nodes;
+}
+
+bool ChunkedModel::readChunk(std::ifstream &file, const ChunkNode &node, MeshData &mesh, const std::function<bool()> &cancelled,
+                             ChunkReadStats *stats)
+{
+    mesh.vertices.resize(node.vertexCount);
+    mesh.indices.resize(node.indexCount);
+    mesh.bounds = node.bounds;
+
+    const auto readBlocks = [&file, &cancelled](char *data, std::uint64_t size) {
+        for (std::uint64_t done = 0; done < size; done += kReadBlock)
+        {
+            if (cancelled()) return false;
+            file.read(data + done, static_cast<std::streamsize>(std::min(kReadBlock, size - done)));
+            if (!file) RT_THROW("Failed to read chunk geometry");
+        }
+        return true;
+    };
+
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(node.offset));
+    if (stats)
+    {
+        stats->storedBytes += node.storedSize;
+        stats->rawBytes += node.byteSize();
+    }
+    if (!node.compressed)
+    {
+        return readBlocks(reinterpret_cast<char *>(mesh.vertices.data()), node.vertexCount * sizeof(Vertex)) &&
+               readBlocks(reinterpret_cast<char *>(mesh.indices.data()), node.indexCount * sizeof(std::uint32_t));
+    }
+
+    // the compressed bytes stay in a per thread buffer, the decoder writes straight into the mesh
+    thread_local std::vector<std::uint8_t> encoded;
+    encoded.resize(node.storedSize);
+    if (!readBlocks(reinterpret_cast<char *>(encoded.data()), node.storedSize)) return false;
+    const std::uint64_t start = nowNs();
+    GeometryCodec::decode(encoded.data(), encoded.size(), mesh);
+    if (stats)
+    {
+        stats->decodedBytes += node.byteSize();
+        stats->decodeNs += nowNs() - start;
+    }
+    return true;
+}
+
+bool ChunkedModel::isChunkedModel(const std::string &path)
+{
+    return std::filesystem::path(path).extension() == ".rwoc";
+}
+}
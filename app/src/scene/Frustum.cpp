@@ -0,0 +1,38 @@
+#include <scene/Frustum.h>
+
+namespace rw {
+Frustum::Frustum(const glm::mat4 &m)
+{
+    auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+    mPlanes[0] = r3 + r0; // left
+    mPlanes[1] = r3 - r0; // right
+    mPlanes[2] = r3 + r1; // bottom
+    mPlanes[3] = r3 - r1; // top
+    mPlanes[4] = r2;      // near (depth 0..1)
+    mPlanes[5] = r3 - r2; // far
+
+    for (auto &plane : mPlanes)
+    {
+        float len = glm::length(glm::vec3(plane));
+        if (len > 0.0f) plane /= len;
+    }
+}
+
+bool Frustum::intersects(const BoundingBox &box) const
+{
+    for (const auto &plane : mPlanes)
+    {
+        // the box corner furthest along the plane normal
+        glm::vec3 positive {plane.x >= 0.0f ? box.max.x : box.min.x,
+                            plane.y >= 0.0f ? box.max.y : box.min.y,
+                            plane.z >= 0.0f ? box.max.z : box.min.z};
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
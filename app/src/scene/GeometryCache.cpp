@@ -0,0 +1,55 @@
+#include <scene/GeometryCache.h>
+
+#include <algorithm>
+
+namespace rw {
+namespace {
+float sizeKey(const MeshData &mesh)
+{
+    if (!mesh.bounds.isValid()) return 0.0f;
+    const glm::vec3 extent = mesh.bounds.extent();
+    return extent.x + extent.y + extent.z;
+}
+}
+
+MeshId GeometryCache::add(MeshData &&mesh)
+{
+    if (!mesh.bounds.isValid())
+    {
+        mesh.computeBounds();
+    }
+
+    const std::uint64_t hash = mesh.contentHash();
+    const MeshId existing = find(mesh, hash);
+    if (existing != INVALID_MESH)
+    {
+        ++mDuplicateCount;
+        mDeduplicatedBytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(std::uint32_t);
+        return existing;
+    }
+
+    const auto id = static_cast<MeshId>(mMeshes.size());
+    auto &bucket = mBuckets[hash];
+    bucket.meshBySize.emplace(sizeKey(mesh), id);
+    bucket.maxTolerance = std::max(bucket.maxTolerance, mesh.positionTolerance());
+    mMeshes.push_back(std::move(mesh));
+    mHashes.push_back(hash);
+    return id;
+}
+
+MeshId GeometryCache::find(const MeshData &mesh, std::uint64_t hash) const
+{
+    const auto found = mBuckets.find(hash);
+    if (found == mBuckets.end()) return INVALID_MESH;
+
+    // matching meshes differ by at most twice the larger tolerance in each of the three extents
+    const auto &bySize = found->second.meshBySize;
+    const float range = 6.0f * std::max(found->second.maxTolerance, mesh.positionTolerance());
+    const float key = sizeKey(mesh);
+    for (auto it = bySize.lower_bound(key - range); it != bySize.end() && it->first <= key + range; ++it)
+    {
+        if (mMeshes[it->second].isSameGeometry(mesh)) return it->second;
+    }
+    return INVALID_MESH;
+}
+}
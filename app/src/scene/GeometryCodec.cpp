@@ -0,0 +1,461 @@
+#include <scene/GeometryCodec.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RW_CODEC_SSE 1
+#endif
+
+namespace rw {
+namespace {
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "the codec addresses vertices as eight floats");
+
+constexpr std::uint8_t FLAG_QUANTIZED_NORMALS = 1;
+constexpr std::uint32_t PLANES = 4;
+
+constexpr std::uint8_t MODE_RAW = 0;
+constexpr std::uint8_t MODE_CONSTANT = 1;
+constexpr std::uint8_t MODE_RANS = 2;
+
+// byte-wise rANS with 32 bit state; four interleaved states keep the decoder's dependency chains short
+constexpr std::uint32_t SCALE_BITS = 12;
+constexpr std::uint32_t PROB_SCALE = 1u << SCALE_BITS;
+constexpr std::uint32_t RANS_L = 1u << 23;
+constexpr std::uint32_t LANES = 4;
+
+constexpr float OCT_SCALE = 32767.0f;
+
+// vertex fields as float offsets
+constexpr std::uint32_t POSITION = 0;
+constexpr std::uint32_t NORMAL = 3;
+constexpr std::uint32_t UV = 6;
+
+void putU8(std::vector<std::uint8_t> &out, std::uint8_t value)
+{
+    out.push_back(value);
+}
+
+void putU16(std::vector<std::uint8_t> &out, std::uint16_t value)
+{
+    out.push_back(static_cast<std::uint8_t>(value));
+    out.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) out.push_back(static_cast<std::uint8_t>(value >> shift));
+}
+
+class Reader {
+public:
+    Reader(const std::uint8_t *data, std::size_t size) : mPtr {data}, mEnd {data + size} {}
+
+    const std::uint8_t *take(std::size_t size)
+    {
+        if (static_cast<std::size_t>(mEnd - mPtr) < size) RT_THROW("Compressed geometry is truncated");
+        const std::uint8_t *data = mPtr;
+        mPtr += size;
+        return data;
+    }
+    std::uint8_t u8() { return *take(1); }
+    std::uint16_t u16()
+    {
+        const auto *p = take(2);
+        return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+    }
+    std::uint32_t u32()
+    {
+        const auto *p = take(4);
+        return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) | (static_cast<std::uint32_t>(p[2]) << 16) |
+               (static_cast<std::uint32_t>(p[3]) << 24);
+    }
+
+private:
+    const std::uint8_t *mPtr;
+    const std::uint8_t *mEnd;
+};
+
+std::uint32_t zigzag(std::uint32_t delta)
+{
+    return (delta << 1) ^ static_cast<std::uint32_t>(static_cast<std::int32_t>(delta) >> 31);
+}
+
+std::uint32_t unzigzag(std::uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+// Scales the byte histogram to PROB_SCALE keeping every present symbol encodable.
+void normalizeFrequencies(const std::array<std::uint32_t, 256> &counts, std::size_t total, std::array<std::uint32_t, 256> &freq)
+{
+    std::uint32_t sum = 0;
+    for (std::uint32_t s = 0; s < 256; ++s)
+    {
+        freq[s] = counts[s] == 0 ? 0 : std::max<std::uint32_t>(1, static_cast<std::uint32_t>(static_cast<std::uint64_t>(counts[s]) * PROB_SCALE / total));
+        sum += freq[s];
+    }
+    // rounding leaves the sum a little off, the most frequent symbols absorb the difference cheapest
+    while (sum != PROB_SCALE)
+    {
+        std::uint32_t largest = 0;
+        for (std::uint32_t s = 1; s < 256; ++s)
+        {
+            if (freq[s] > freq[largest]) largest = s;
+        }
+        if (sum > PROB_SCALE)
+        {
+            if (freq[largest] <= 1) RT_THROW("Cannot normalize symbol frequencies");
+            --freq[largest];
+            --sum;
+        }
+        else
+        {
+            ++freq[largest];
+            ++sum;
+        }
+    }
+}
+
+// Returns false when the entropy coded plane would not be smaller than the raw bytes.
+bool encodeRans(const std::uint8_t *src, std::size_t count, std::vector<std::uint8_t> &out)
+{
+    std::array<std::uint32_t, 256> counts {};
+    for (std::size_t i = 0; i < count; ++i) counts[src[i]]++;
+    std::array<std::uint32_t, 256> freq {};
+    normalizeFrequencies(counts, count, freq);
+    std::array<std::uint32_t, 256> start {};
+    std::uint32_t symbols = 0;
+    for (std::uint32_t s = 0, cumulative = 0; s < 256; ++s)
+    {
+        start[s] = cumulative;
+        cumulative += freq[s];
+        if (freq[s] > 0) ++symbols;
+    }
+
+    // the encoder runs backwards, a renormalization emits at most two bytes per symbol
+    std::vector<std::uint8_t> buffer(count * 2 + LANES * 4);
+    std::uint8_t *ptr = buffer.data() + buffer.size();
+    std::array<std::uint32_t, LANES> state;
+    state.fill(RANS_L);
+    for (std::size_t i = count; i-- > 0;)
+    {
+        const std::uint32_t s = src[i];
+        std::uint32_t x = state[i % LANES];
+        const std::uint32_t xMax = ((RANS_L >> SCALE_BITS) << 8) * freq[s];
+        while (x >= xMax)
+        {
+            *--ptr = static_cast<std::uint8_t>(x);
+            x >>= 8;
+        }
+        state[i % LANES] = ((x / freq[s]) << SCALE_BITS) + (x % freq[s]) + start[s];
+    }
+    // written last lane first, so the decoder reads lane 0 first
+    for (std::uint32_t lane = LANES; lane-- > 0;)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8) *--ptr = static_cast<std::uint8_t>(state[lane] >> shift);
+    }
+
+    const std::size_t streamSize = static_cast<std::size_t>(buffer.data() + buffer.size() - ptr);
+    const std::size_t payload = 2 + symbols * 3 + streamSize;
+    if (payload >= count) return false;
+
+    putU8(out, MODE_RANS);
+    putU32(out, static_cast<std::uint32_t>(payload));
+    putU16(out, static_cast<std::uint16_t>(symbols));
+    for (std::uint32_t s = 0; s < 256; ++s)
+    {
+        if (freq[s] == 0) continue;
+        putU8(out, static_cast<std::uint8_t>(s));
+        putU16(out, static_cast<std::uint16_t>(freq[s]));
+    }
+    out.insert(out.end(), ptr, buffer.data() + buffer.size());
+    return true;
+}
+
+void encodePlane(const std::uint8_t *src, std::size_t count, std::vector<std::uint8_t> &out)
+{
+    if (count > 0 && std::all_of(src, src + count, [first = src[0]](std::uint8_t value) { return value == first; }))
+    {
+        putU8(out, MODE_CONSTANT);
+        putU32(out, 1);
+        putU8(out, src[0]);
+        return;
+    }
+    if (count > 0 && encodeRans(src, count, out)) return;
+
+    putU8(out, MODE_RAW);
+    putU32(out, static_cast<std::uint32_t>(count));
+    out.insert(out.end(), src, src + count);
+}
+
+void decodeRans(Reader &payload, std::size_t payloadSize, std::uint8_t *dst, std::size_t count)
+{
+    // one entry per slot, so a symbol costs a single table lookup
+    struct Slot {
+        std::uint16_t freq;
+        std::uint16_t bias; // slot - start of the symbol
+        std::uint8_t symbol;
+    };
+    std::array<Slot, PROB_SCALE> slots;
+    const std::uint32_t symbols = payload.u16();
+    std::uint32_t cumulative = 0;
+    for (std::uint32_t i = 0; i < symbols; ++i)
+    {
+        const std::uint8_t s = payload.u8();
+        const std::uint32_t freq = payload.u16();
+        if (freq == 0 || cumulative + freq > PROB_SCALE) RT_THROW("Compressed geometry has a corrupt frequency table");
+        for (std::uint32_t slot = 0; slot < freq; ++slot)
+        {
+            slots[cumulative + slot] = Slot {static_cast<std::uint16_t>(freq), static_cast<std::uint16_t>(slot), s};
+        }
+        cumulative += freq;
+    }
+    if (cumulative != PROB_SCALE) RT_THROW("Compressed geometry has a corrupt frequency table");
+
+    std::array<std::uint32_t, LANES> state;
+    for (auto &x : state)
+    {
+        x = payload.u32();
+        // renormalization keeps every state at RANS_L or above, a lower one would read bytes without bound
+        if (x < RANS_L) RT_THROW("Compressed geometry has a corrupt rANS state");
+    }
+
+    // the rest of the payload is the byte stream
+    const std::size_t header = 2 + symbols * 3 + LANES * 4;
+    const std::size_t streamSize = payloadSize - header;
+    const std::uint8_t *ptr = payload.take(streamSize);
+    const std::uint8_t *end = ptr + streamSize;
+    const auto advance = [&slots](std::uint32_t &x) {
+        const Slot entry = slots[x & (PROB_SCALE - 1)];
+        x = entry.freq * (x >> SCALE_BITS) + entry.bias;
+        return entry.symbol;
+    };
+    // a symbol pulls at most two bytes, so while a group's worth is left no bounds checks are needed
+    const auto fastStep = [&](std::uint32_t &x) {
+        const std::uint8_t symbol = advance(x);
+        while (x < RANS_L) x = (x << 8) | *ptr++;
+        return symbol;
+    };
+    const auto step = [&](std::uint32_t &x) {
+        const std::uint8_t symbol = advance(x);
+        while (x < RANS_L)
+        {
+            if (ptr == end) RT_THROW("Compressed geometry is truncated");
+            x = (x << 8) | *ptr++;
+        }
+        return symbol;
+    };
+
+    std::size_t i = 0;
+    for (; i + LANES <= count && end - ptr >= static_cast<std::ptrdiff_t>(LANES * 2); i += LANES)
+    {
+        dst[i] = fastStep(state[0]);
+        dst[i + 1] = fastStep(state[1]);
+        dst[i + 2] = fastStep(state[2]);
+        dst[i + 3] = fastStep(state[3]);
+    }
+    for (; i < count; ++i) dst[i] = step(state[i % LANES]);
+}
+
+void decodePlane(Reader &reader, std::uint8_t *dst, std::size_t count)
+{
+    const std::uint8_t mode = reader.u8();
+    const std::uint32_t size = reader.u32();
+    Reader payload {reader.take(size), size};
+    switch (mode)
+    {
+    case MODE_RAW:
+        if (size != count) RT_THROW("Compressed geometry has a plane of the wrong size");
+        if (count > 0) std::memcpy(dst, payload.take(count), count);
+        break;
+    case MODE_CONSTANT:
+        std::memset(dst, payload.u8(), count);
+        break;
+    case MODE_RANS:
+        decodeRans(payload, size, dst, count);
+        break;
+    default:
+        RT_THROW("Compressed geometry uses an unknown plane mode");
+    }
+}
+
+// out[i] = sum of unzigzag(planes) up to i, wrapping at 32 bits
+void reconstruct(const std::uint8_t *planes, std::size_t count, std::uint32_t *out)
+{
+    const std::uint8_t *p0 = planes;
+    const std::uint8_t *p1 = planes + count;
+    const std::uint8_t *p2 = planes + count * 2;
+    const std::uint8_t *p3 = planes + count * 3;
+    std::size_t i = 0;
+    std::uint32_t previous = 0;
+#ifdef RW_CODEC_SSE
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    const auto decode4 = [&](__m128i word, std::uint32_t *dst) {
+        __m128i delta = _mm_xor_si128(_mm_srli_epi32(word, 1), _mm_sub_epi32(zero, _mm_and_si128(word, one)));
+        // prefix sum of the four lanes, then add the total carried over from the previous group
+        delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+        delta = _mm_add_epi32(delta, carry);
+        carry = _mm_shuffle_epi32(delta, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), delta);
+    };
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p0 + i));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p1 + i));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p2 + i));
+        const __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p3 + i));
+        const __m128i low01 = _mm_unpacklo_epi8(b0, b1);
+        const __m128i high01 = _mm_unpackhi_epi8(b0, b1);
+        const __m128i low23 = _mm_unpacklo_epi8(b2, b3);
+        const __m128i high23 = _mm_unpackhi_epi8(b2, b3);
+        decode4(_mm_unpacklo_epi16(low01, low23), out + i);
+        decode4(_mm_unpackhi_epi16(low01, low23), out + i + 4);
+        decode4(_mm_unpacklo_epi16(high01, high23), out + i + 8);
+        decode4(_mm_unpackhi_epi16(high01, high23), out + i + 12);
+    }
+    previous = static_cast<std::uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+    for (; i < count; ++i)
+    {
+        const std::uint32_t word = static_cast<std::uint32_t>(p0[i]) | (static_cast<std::uint32_t>(p1[i]) << 8) |
+                                   (static_cast<std::uint32_t>(p2[i]) << 16) | (static_cast<std::uint32_t>(p3[i]) << 24);
+        previous += unzigzag(word);
+        out[i] = previous;
+    }
+}
+
+void encodeWords(const std::vector<std::uint32_t> &words, std::vector<std::uint8_t> &planes, std::vector<std::uint8_t> &out)
+{
+    const std::size_t count = words.size();
+    planes.resize(count * PLANES);
+    std::uint32_t previous = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::uint32_t value = zigzag(words[i] - previous);
+        previous = words[i];
+        for (std::uint32_t p = 0; p < PLANES; ++p) planes[p * count + i] = static_cast<std::uint8_t>(value >> (p * 8));
+    }
+    for (std::uint32_t p = 0; p < PLANES; ++p) encodePlane(planes.data() + p * count, count, out);
+}
+
+void decodeWords(Reader &reader, std::size_t count, std::vector<std::uint8_t> &planes, std::uint32_t *out)
+{
+    planes.resize(count * PLANES);
+    for (std::uint32_t p = 0; p < PLANES; ++p) decodePlane(reader, planes.data() + p * count, count);
+    reconstruct(planes.data(), count, out);
+}
+
+std::uint32_t floatBits(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3 &normal)
+{
+    const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 <= 0.0f) return glm::vec2 {0.0f};
+    glm::vec2 oct {normal.x / l1, normal.y / l1};
+    if (normal.z < 0.0f)
+    {
+        // fold the lower hemisphere over the diagonals
+        oct = glm::vec2 {(1.0f - std::abs(oct.y)) * (oct.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(oct.x)) * (oct.y >= 0.0f ? 1.0f : -1.0f)};
+    }
+    return oct;
+}
+
+glm::vec3 decodeOctahedral(float x, float y)
+{
+    glm::vec3 normal {x, y, 1.0f - std::abs(x) - std::abs(y)};
+    const float t = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    const float length = glm::length(normal);
+    return length > 0.0f ? normal / length : glm::vec3 {0.0f, 0.0f, 1.0f};
+}
+
+std::uint32_t quantizeOctahedral(float value)
+{
+    return static_cast<std::uint32_t>(static_cast<std::int32_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * OCT_SCALE)));
+}
+} // namespace
+
+void GeometryCodec::encode(const MeshData &mesh, const GeometryCodecOptions &options, std::vector<std::uint8_t> &out)
+{
+    const std::size_t vertexCount = mesh.vertices.size();
+    const auto *fields = reinterpret_cast<const float *>(mesh.vertices.data());
+
+    std::vector<std::uint32_t> offsets {POSITION, POSITION + 1, POSITION + 2, UV, UV + 1};
+    if (!options.quantizeNormals)
+    {
+        offsets.insert(offsets.end(), {NORMAL, NORMAL + 1, NORMAL + 2});
+    }
+    putU8(out, options.quantizeNormals ? FLAG_QUANTIZED_NORMALS : 0);
+    putU8(out, static_cast<std::uint8_t>(offsets.size()));
+
+    std::vector<std::uint32_t> words(vertexCount);
+    std::vector<std::uint8_t> planes;
+    for (const auto offset : offsets)
+    {
+        for (std::size_t i = 0; i < vertexCount; ++i) words[i] = floatBits(fields[i * 8 + offset]);
+        encodeWords(words, planes, out);
+    }
+    if (options.quantizeNormals)
+    {
+        for (std::uint32_t axis = 0; axis < 2; ++axis)
+        {
+            for (std::size_t i = 0; i < vertexCount; ++i) words[i] = quantizeOctahedral(encodeOctahedral(mesh.vertices[i].normal)[axis]);
+            encodeWords(words, planes, out);
+        }
+    }
+
+    encodeWords(mesh.indices, planes, out);
+}
+
+void GeometryCodec::decode(const std::uint8_t *data, std::size_t size, MeshData &mesh)
+{
+    // scratch reused by every decode on the same I/O thread
+    thread_local std::vector<std::uint8_t> planes;
+    thread_local std::vector<std::uint32_t> words;
+    thread_local std::vector<std::uint32_t> octX;
+
+    Reader reader {data, size};
+    const std::uint8_t flags = reader.u8();
+    const bool quantizedNormals = (flags & FLAG_QUANTIZED_NORMALS) != 0;
+    const std::uint32_t componentCount = reader.u8();
+    if (componentCount != (quantizedNormals ? 5u : 8u)) RT_THROW("Compressed geometry has an unexpected vertex layout");
+
+    const std::size_t vertexCount = mesh.vertices.size();
+    auto *fields = reinterpret_cast<float *>(mesh.vertices.data());
+    static constexpr std::array<std::uint32_t, 8> offsets {POSITION, POSITION + 1, POSITION + 2, UV, UV + 1, NORMAL, NORMAL + 1, NORMAL + 2};
+    words.resize(vertexCount);
+    for (std::uint32_t c = 0; c < componentCount; ++c)
+    {
+        decodeWords(reader, vertexCount, planes, words.data());
+        for (std::size_t i = 0; i < vertexCount; ++i) std::memcpy(&fields[i * 8 + offsets[c]], &words[i], sizeof(float));
+    }
+    if (quantizedNormals)
+    {
+        octX.resize(vertexCount);
+        decodeWords(reader, vertexCount, planes, octX.data());
+        decodeWords(reader, vertexCount, planes, words.data());
+        for (std::size_t i = 0; i < vertexCount; ++i)
+        {
+            mesh.vertices[i].normal = decodeOctahedral(static_cast<float>(static_cast<std::int32_t>(octX[i])) / OCT_SCALE,
+                                                       static_cast<float>(static_cast<std::int32_t>(words[i])) / OCT_SCALE);
+        }
+    }
+
+    // indices need no scatter, they are rebuilt in place
+    decodeWords(reader, mesh.indices.size(), planes, mesh.indices.data());
+}
+}
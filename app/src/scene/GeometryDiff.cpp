@@ -0,0 +1,92 @@
+#include <scene/GeometryDiff.h>
+
+#include <cstring>
+
+namespace rw {
+namespace {
+// First and one-past-last element that differs, {0, 0} when the arrays are identical.
+template <typename T>
+std::pair<std::uint32_t, std::uint32_t> changedRange(const std::vector<T> &a, const std::vector<T> &b)
+{
+    const auto equal = [&a, &b](std::size_t i) { return std::memcmp(&a[i], &b[i], sizeof(T)) == 0; };
+    std::size_t first = 0;
+    while (first < a.size() && equal(first)) ++first;
+    if (first == a.size()) return {0, 0};
+    std::size_t last = a.size();
+    while (last > first && equal(last - 1)) --last;
+    return {static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last)};
+}
+
+// Unclaimed previous mesh with the same vertex and index counts closest to id.
+MeshId findSameTopology(const GeometryCache &previous, const std::vector<char> &claimed, const MeshData &mesh, MeshId id)
+{
+    MeshId best = INVALID_MESH;
+    std::size_t bestDistance = ~std::size_t(0);
+    for (MeshId candidate = 0; candidate < previous.size(); ++candidate)
+    {
+        const auto &old = previous.get(candidate);
+        if (claimed[candidate] || old.vertices.size() != mesh.vertices.size() || old.indices.size() != mesh.indices.size()) continue;
+        const std::size_t distance = candidate > id ? candidate - id : id - candidate;
+        if (distance < bestDistance)
+        {
+            best = candidate;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+} // namespace
+
+GeometryDiff GeometryDiff::compute(const GeometryCache &previous, const GeometryCache &next)
+{
+    GeometryDiff diff;
+    diff.meshes.resize(next.size());
+    std::vector<char> claimed(previous.size(), 0);
+
+    // unchanged content first, wherever it moved to
+    for (MeshId id = 0; id < next.size(); ++id)
+    {
+        const MeshId match = previous.find(next.get(id), next.getHash(id));
+        if (match == INVALID_MESH || claimed[match]) continue;
+        claimed[match] = 1;
+        diff.meshes[id].previous = match;
+        ++diff.kept;
+    }
+
+    for (MeshId id = 0; id < next.size(); ++id)
+    {
+        auto &change = diff.meshes[id];
+        if (change.previous != INVALID_MESH) continue;
+
+        const auto &mesh = next.get(id);
+        change.data = std::make_shared<MeshData>(mesh);
+        // an edited part usually keeps its topology and its place in the file, give or take the
+        // parts added or removed before it
+        const MeshId match = findSameTopology(previous, claimed, mesh, id);
+        if (match != INVALID_MESH)
+        {
+            claimed[match] = 1;
+            const auto &old = previous.get(match);
+            const auto vertices = changedRange(old.vertices, mesh.vertices);
+            const auto indices = changedRange(old.indices, mesh.indices);
+            change.previous = match;
+            change.firstVertex = vertices.first;
+            change.vertexCount = vertices.second - vertices.first;
+            change.firstIndex = indices.first;
+            change.indexCount = indices.second - indices.first;
+            diff.uploadBytes += change.vertexCount * sizeof(Vertex) + change.indexCount * sizeof(std::uint32_t);
+            ++diff.updated;
+            continue;
+        }
+
+        diff.uploadBytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(std::uint32_t);
+        ++diff.created;
+    }
+
+    for (const char used : claimed)
+    {
+        if (!used) ++diff.removed;
+    }
+    return diff;
+}
+}
@@ -0,0 +1,265 @@
+#include <scene/LightBinner.h>
+#include <core/Clock.h>
+#include <core/LinearArena.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RW_BINNING_SSE 1
+#endif
+
+namespace rw {
+namespace {
+constexpr std::uint64_t DROPPED = ~0ull;
+
+// Bounding sphere of the light's volume, the cone of a spot light is bounded more tightly
+// than by its range.
+void boundLight(const Light &light, glm::vec3 &center, float &radius)
+{
+    center = light.position;
+    radius = light.range;
+    if (light.type != LightType::Spot) return;
+
+    const float cosAngle = std::cos(light.outerAngle);
+    if (light.outerAngle > 0.785398f)
+    {
+        center = light.position + light.direction * (cosAngle * light.range);
+        radius = std::sin(light.outerAngle) * light.range;
+    }
+    else
+    {
+        radius = light.range / (2.0f * cosAngle);
+        center = light.position + light.direction * radius;
+    }
+}
+
+// Tile range covered by the sphere's view space box between two depths; false when it misses
+// the screen. scale is the projection's x or y scale, the view coordinate of ndc n at depth d
+// is n * d / scale.
+bool tileRange(float center, float radius, float scale, float nearDepth, float farDepth, std::uint32_t tiles, std::uint32_t &first, std::uint32_t &last)
+{
+    const float a = (center - radius) * scale;
+    const float b = (center + radius) * scale;
+    const float ndcMin = std::min({a / nearDepth, a / farDepth, b / nearDepth, b / farDepth});
+    const float ndcMax = std::max({a / nearDepth, a / farDepth, b / nearDepth, b / farDepth});
+    if (ndcMax < -1.0f || ndcMin > 1.0f) return false;
+
+    const auto toTile = [tiles](float ndc) {
+        const float tile = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(tiles));
+        return static_cast<std::uint32_t>(std::clamp(tile, 0.0f, static_cast<float>(tiles - 1)));
+    };
+    first = toTile(ndcMin);
+    last = toTile(ndcMax);
+    return true;
+}
+
+// View space bounds of a tile between two depths.
+void tileBounds(std::uint32_t tile, std::uint32_t tiles, float scale, float nearDepth, float farDepth, float &minimum, float &maximum)
+{
+    const float k0 = (-1.0f + 2.0f * static_cast<float>(tile) / static_cast<float>(tiles)) / scale;
+    const float k1 = (-1.0f + 2.0f * static_cast<float>(tile + 1) / static_cast<float>(tiles)) / scale;
+    const float kMin = std::min(k0, k1);
+    const float kMax = std::max(k0, k1);
+    minimum = std::min(kMin * nearDepth, kMin * farDepth);
+    maximum = std::max(kMax * nearDepth, kMax * farDepth);
+}
+} // namespace
+
+LightBinner::LightBinner(ThreadPool &pool, const ClusterOptions &options) : mPool {pool}, mOptions {options}
+{
+    mOptions.tilesX = std::max(mOptions.tilesX, 1u);
+    mOptions.tilesY = std::max(mOptions.tilesY, 1u);
+    mOptions.slices = std::max(mOptions.slices, 1u);
+    mSlices.resize(mOptions.slices);
+}
+
+void LightBinner::bin(const std::vector<Light> &lights, const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane,
+                      ClusterGrid &grid, std::vector<ClusterLight> &packed, std::vector<glm::uvec2> &clusters, std::vector<std::uint32_t> &indices)
+{
+    const std::uint64_t start = nowNs();
+    mStats = {};
+    mStats.lights = static_cast<std::uint32_t>(lights.size());
+
+    const float logRatio = std::log(farPlane / nearPlane);
+    grid.tilesX = mOptions.tilesX;
+    grid.tilesY = mOptions.tilesY;
+    grid.slices = mOptions.slices;
+    grid.sliceScale = static_cast<float>(grid.slices) / logRatio;
+    grid.sliceBias = -static_cast<float>(grid.slices) * std::log(nearPlane) / logRatio;
+
+    packed.clear();
+    clusters.clear();
+    indices.clear();
+    if (lights.empty()) return;
+
+    mSliceDepths.resize(grid.slices + 1);
+    for (std::uint32_t i = 0; i <= grid.slices; ++i)
+    {
+        mSliceDepths[i] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(i) / static_cast<float>(grid.slices));
+    }
+    const auto sliceOf = [&grid](float depth) {
+        const float slice = std::floor(std::log(depth) * grid.sliceScale + grid.sliceBias);
+        return static_cast<std::uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(grid.slices - 1)));
+    };
+
+    // bounding spheres of the lights inside the frustum, in the order they are packed
+    mSpheres.clear();
+    for (auto &slice : mSlices) slice.spheres.clear();
+    for (const auto &light : lights)
+    {
+        glm::vec3 worldCenter;
+        float radius;
+        boundLight(light, worldCenter, radius);
+        const glm::vec3 center = glm::vec3(view * glm::vec4(worldCenter, 1.0f));
+        const float depth = -center.z;
+        if (depth + radius < nearPlane || depth - radius > farPlane) continue;
+
+        const float nearDepth = std::max(depth - radius, nearPlane);
+        const float farDepth = std::min(depth + radius, farPlane);
+        Sphere sphere {center, radius};
+        if (!tileRange(center.x, radius, projection[0][0], nearDepth, farDepth, grid.tilesX, sphere.tileX0, sphere.tileX1)) continue;
+        if (!tileRange(center.y, radius, projection[1][1], nearDepth, farDepth, grid.tilesY, sphere.tileY0, sphere.tileY1)) continue;
+        sphere.slice0 = sliceOf(nearDepth);
+        sphere.slice1 = sliceOf(farDepth);
+
+        const auto id = static_cast<std::uint32_t>(mSpheres.size());
+        for (std::uint32_t slice = sphere.slice0; slice <= sphere.slice1; ++slice) mSlices[slice].spheres.push_back(id);
+        mSpheres.push_back(sphere);
+
+        const float cosOuter = std::cos(light.outerAngle);
+        packed.push_back(ClusterLight {glm::vec4(light.position, light.range), glm::vec4(light.color * light.intensity, static_cast<float>(light.type)),
+                                       glm::vec4(light.direction, cosOuter), glm::vec4(std::cos(light.innerAngle), 0.0f, 0.0f, 0.0f)});
+    }
+
+    mPool.parallelFor(grid.slices, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t slice = begin; slice < end; ++slice) binSlice(static_cast<std::uint32_t>(slice), projection);
+    });
+
+    // concatenate the slices, cluster id = (slice * tilesY + y) * tilesX + x
+    const std::uint32_t clustersPerSlice = grid.tilesX * grid.tilesY;
+    clusters.resize(grid.getClusterCount());
+    ArenaScope scratch {getThreadArena()};
+    auto binned = scratch.makeVector<char>();
+    binned.resize(mSpheres.size(), 0);
+    for (std::uint32_t slice = 0; slice < grid.slices; ++slice)
+    {
+        const auto &result = mSlices[slice];
+        auto offset = static_cast<std::uint32_t>(indices.size());
+        for (std::uint32_t cluster = 0; cluster < clustersPerSlice; ++cluster)
+        {
+            const std::uint32_t count = result.spheres.empty() ? 0 : result.counts[cluster];
+            clusters[slice * clustersPerSlice + cluster] = glm::uvec2(offset, count);
+            offset += count;
+            mStats.maxPerCluster = std::max(mStats.maxPerCluster, count);
+            if (count > 0) ++mStats.litClusters;
+        }
+        if (result.spheres.empty()) continue;
+        indices.insert(indices.end(), result.indices.begin(), result.indices.end());
+        for (const auto sphere : result.indices) binned[sphere] = 1;
+        mStats.overflow += result.overflow;
+    }
+    mStats.binnedLights = static_cast<std::uint32_t>(std::count(binned.begin(), binned.end(), 1));
+    mStats.indices = indices.size();
+    mStats.binMs = nsToMs(nowNs() - start);
+}
+
+void LightBinner::binSlice(std::uint32_t slice, const glm::mat4 &projection)
+{
+    auto &result = mSlices[slice];
+    if (result.spheres.empty()) return;
+
+    const std::uint32_t tilesX = mOptions.tilesX;
+    const std::uint32_t tilesY = mOptions.tilesY;
+    const float nearDepth = mSliceDepths[slice];
+    const float farDepth = mSliceDepths[slice + 1];
+
+    // padding lanes get an empty range, they never pass the test
+    const std::uint32_t padded = (tilesX + 3u) & ~3u;
+    result.minX.assign(padded, std::numeric_limits<float>::max());
+    result.maxX.assign(padded, std::numeric_limits<float>::lowest());
+    for (std::uint32_t x = 0; x < tilesX; ++x)
+    {
+        tileBounds(x, tilesX, projection[0][0], nearDepth, farDepth, result.minX[x], result.maxX[x]);
+    }
+
+    result.assignment.clear();
+    for (const auto id : result.spheres)
+    {
+        const auto &sphere = mSpheres[id];
+        const float depth = -sphere.center.z;
+        const float dz = std::max({nearDepth - depth, depth - farDepth, 0.0f});
+        const float radius2 = sphere.radius * sphere.radius;
+        if (dz * dz > radius2) continue;
+
+        for (std::uint32_t y = sphere.tileY0; y <= sphere.tileY1; ++y)
+        {
+            float minY, maxY;
+            tileBounds(y, tilesY, projection[1][1], nearDepth, farDepth, minY, maxY);
+            const float dy = std::max({minY - sphere.center.y, sphere.center.y - maxY, 0.0f});
+            const float remaining = radius2 - dy * dy - dz * dz;
+            if (remaining < 0.0f) continue;
+
+            const std::uint64_t row = static_cast<std::uint64_t>(y) * tilesX;
+#ifdef RW_BINNING_SSE
+            const __m128 centerX = _mm_set1_ps(sphere.center.x);
+            const __m128 limit = _mm_set1_ps(remaining);
+            for (std::uint32_t x = sphere.tileX0 & ~3u; x <= sphere.tileX1; x += 4)
+            {
+                const __m128 below = _mm_sub_ps(_mm_loadu_ps(&result.minX[x]), centerX);
+                const __m128 above = _mm_sub_ps(centerX, _mm_loadu_ps(&result.maxX[x]));
+                const __m128 dx = _mm_max_ps(_mm_max_ps(below, above), _mm_setzero_ps());
+                const int mask = _mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(dx, dx), limit));
+                if (mask == 0) continue;
+                for (std::uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    const std::uint32_t tile = x + lane;
+                    if ((mask & (1 << lane)) && tile >= sphere.tileX0 && tile <= sphere.tileX1)
+                    {
+                        result.assignment.push_back((row + tile) << 32 | id);
+                    }
+                }
+            }
+#else
+            for (std::uint32_t x = sphere.tileX0; x <= sphere.tileX1; ++x)
+            {
+                const float dx = std::max({result.minX[x] - sphere.center.x, sphere.center.x - result.maxX[x], 0.0f});
+                if (dx * dx <= remaining) result.assignment.push_back((row + x) << 32 | id);
+            }
+#endif
+        }
+    }
+
+    // group by cluster, keeping the light order; counting sort over the clusters of the slice
+    result.counts.assign(tilesX * tilesY, 0);
+    result.overflow = 0;
+    for (auto &entry : result.assignment)
+    {
+        auto &count = result.counts[entry >> 32];
+        if (count < mOptions.maxLightsPerCluster)
+        {
+            ++count;
+        }
+        else
+        {
+            entry = DROPPED;
+            ++result.overflow;
+        }
+    }
+    result.cursor.resize(result.counts.size());
+    std::uint32_t offset = 0;
+    for (std::size_t cluster = 0; cluster < result.counts.size(); ++cluster)
+    {
+        result.cursor[cluster] = offset;
+        offset += result.counts[cluster];
+    }
+    result.indices.resize(offset);
+    for (const auto entry : result.assignment)
+    {
+        if (entry == DROPPED) continue;
+        result.indices[result.cursor[entry >> 32]++] = static_cast<std::uint32_t>(entry);
+    }
+}
+}
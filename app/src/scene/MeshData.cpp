@@ -0,0 +1,111 @@
+#include <scene/MeshData.h>
+#include <core/Hash.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace rw {
+namespace {
+// baking a transform leaves a few ulps of noise on every coordinate, positions may differ by far more
+constexpr float kNoiseUlps = 64.0f;
+// small parts near the origin still tolerate 2^-16 of their size
+constexpr float kRelativeTolerance = 1.0f / 65536.0f;
+constexpr float kNormalTolerance = 1.0f / 512.0f;
+constexpr float kUvTolerance = 1.0f / 2048.0f;
+
+float maxComponent(const glm::vec3 &value)
+{
+    return std::max(value.x, std::max(value.y, value.z));
+}
+
+float magnitude(const BoundingBox &bounds)
+{
+    return bounds.isValid() ? maxComponent(glm::max(glm::abs(bounds.min), glm::abs(bounds.max))) : 0.0f;
+}
+
+bool isNear(const glm::vec3 &a, const glm::vec3 &b, float tolerance)
+{
+    const glm::vec3 difference = glm::abs(a - b);
+    return difference.x <= tolerance && difference.y <= tolerance && difference.z <= tolerance;
+}
+}
+
+BoundingBox BoundingBox::transformed(const glm::mat4 &transform) const
+{
+    BoundingBox result;
+    if (!isValid()) return result;
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner {(i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z};
+        result.expand(glm::vec3(transform * glm::vec4(corner, 1.0f)));
+    }
+    return result;
+}
+
+void MeshData::computeBounds()
+{
+    bounds = BoundingBox {};
+    for (const auto &vertex : vertices)
+    {
+        bounds.expand(vertex.position);
+    }
+}
+
+glm::vec3 MeshData::recenter()
+{
+    computeBounds();
+    if (!bounds.isValid()) return glm::vec3 {0.0f};
+
+    bakedMagnitude = std::max(bakedMagnitude, magnitude(bounds));
+    glm::vec3 offset = bounds.center();
+    for (auto &vertex : vertices)
+    {
+        vertex.position -= offset;
+    }
+    bounds.min -= offset;
+    bounds.max -= offset;
+    return offset;
+}
+
+float MeshData::positionTolerance() const
+{
+    const float size = bounds.isValid() ? maxComponent(bounds.extent()) : 0.0f;
+    const float noise = std::max(bakedMagnitude, magnitude(bounds)) * kNoiseUlps * std::numeric_limits<float>::epsilon();
+    return std::max(std::max(size * kRelativeTolerance, noise), std::numeric_limits<float>::min());
+}
+
+std::uint64_t MeshData::contentHash() const
+{
+    // any snapping of the positions would put some noisy copies on both sides of a grid line
+    std::uint64_t h = hashBytes(indices.data(), indices.size() * sizeof(std::uint32_t));
+    h = hashCombine(h, vertices.size());
+    return hashMix(h);
+}
+
+bool MeshData::isSameGeometry(const MeshData &other) const
+{
+    if (vertices.size() != other.vertices.size() || indices != other.indices)
+    {
+        return false;
+    }
+
+    const float tolerance = std::max(positionTolerance(), other.positionTolerance());
+    // parts sharing their topology but not their shape mostly differ in size already
+    if (bounds.isValid() && other.bounds.isValid() && !isNear(bounds.extent(), other.bounds.extent(), 2.0f * tolerance))
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        const auto &a = vertices[i];
+        const auto &b = other.vertices[i];
+        const glm::vec2 duv = glm::abs(a.uv - b.uv);
+        if (!isNear(a.position, b.position, tolerance) || !isNear(a.normal, b.normal, kNormalTolerance) ||
+            duv.x > kUvTolerance || duv.y > kUvTolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
@@ -0,0 +1,261 @@
+#include <scene/ObjLoader.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+namespace rw {
+namespace {
+struct IndexTriple {
+    int position;
+    int uv;
+    int normal;
+
+    bool operator==(const IndexTriple &other) const {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct IndexTripleHash {
+    std::size_t operator()(const IndexTriple &t) const {
+        return (static_cast<std::size_t>(t.position) * 73856093u) ^ (static_cast<std::size_t>(t.uv) * 19349663u) ^ (static_cast<std::size_t>(t.normal) * 83492791u);
+    }
+};
+
+struct MeshBuilder {
+    MeshData mesh;
+    std::unordered_map<IndexTriple, std::uint32_t, IndexTripleHash> vertexByIndex;
+    bool hasNormals = true;
+};
+
+const char *skipSpaces(const char *p)
+{
+    while (*p == ' ' || *p == '\t') ++p;
+    return p;
+}
+
+float parseFloat(const char *&p)
+{
+    char *end = nullptr;
+    float value = std::strtof(p, &end);
+    p = end;
+    return value;
+}
+
+// OBJ indices are 1-based, negative values are relative to the end of the list.
+int resolveIndex(long index, std::size_t count)
+{
+    if (index > 0) return static_cast<int>(index - 1);
+    if (index < 0) return static_cast<int>(static_cast<long>(count) + index);
+    return -1;
+}
+
+bool parseFaceVertex(const char *&p, IndexTriple &out, std::size_t positions, std::size_t uvs, std::size_t normals)
+{
+    p = skipSpaces(p);
+    if (*p == '\0' || *p == '\r' || *p == '\n') return false;
+
+    char *end = nullptr;
+    out = IndexTriple {resolveIndex(std::strtol(p, &end, 10), positions), -1, -1};
+    p = end;
+    if (*p == '/')
+    {
+        ++p;
+        if (*p != '/')
+        {
+            out.uv = resolveIndex(std::strtol(p, &end, 10), uvs);
+            p = end;
+        }
+        if (*p == '/')
+        {
+            ++p;
+            out.normal = resolveIndex(std::strtol(p, &end, 10), normals);
+            p = end;
+        }
+    }
+    while (*p && *p != ' ' && *p != '\t') ++p;
+    return true;
+}
+
+void computeNormals(MeshData &mesh)
+{
+    for (auto &vertex : mesh.vertices)
+    {
+        vertex.normal = glm::vec3 {0.0f};
+    }
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        auto &a = mesh.vertices[mesh.indices[i]];
+        auto &b = mesh.vertices[mesh.indices[i + 1]];
+        auto &c = mesh.vertices[mesh.indices[i + 2]];
+        glm::vec3 n = glm::cross(b.position - a.position, c.position - a.position);
+        a.normal += n;
+        b.normal += n;
+        c.normal += n;
+    }
+    for (auto &vertex : mesh.vertices)
+    {
+        float len = glm::length(vertex.normal);
+        vertex.normal = len > 0.0f ? vertex.normal / len : glm::vec3 {0.0f, 1.0f, 0.0f};
+    }
+}
+}
+
+void ObjLoader::load(const std::string &path, Scene &scene)
+{
+    TRACE_SCOPE("obj import");
+    std::ifstream file {path};
+    if (!file.is_open())
+    {
+        RT_THROW("Failed to open model " + path);
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+
+    std::map<MaterialId, MeshBuilder> builders;
+    MaterialId currentMaterial = Scene::DEFAULT_MATERIAL;
+    std::size_t nodeCount = scene.getNodes().size();
+
+    auto flushGroup = [&]() {
+        for (auto &[material, builder] : builders)
+        {
+            if (builder.mesh.indices.empty()) continue;
+            if (!builder.hasNormals) computeNormals(builder.mesh);
+
+            glm::vec3 offset = builder.mesh.recenter();
+            MeshId mesh = scene.getGeometry().add(std::move(builder.mesh));
+            scene.addNode(mesh, material, glm::translate(glm::mat4 {1.0f}, offset));
+        }
+        builders.clear();
+    };
+
+    std::string line;
+    std::vector<IndexTriple> face;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const char *p = skipSpaces(line.c_str());
+        if (p[0] == 'v' && p[1] == ' ')
+        {
+            p += 2;
+            float x = parseFloat(p), y = parseFloat(p), z = parseFloat(p);
+            positions.emplace_back(x, y, z);
+        }
+        else if (p[0] == 'v' && p[1] == 'n')
+        {
+            p += 2;
+            float x = parseFloat(p), y = parseFloat(p), z = parseFloat(p);
+            normals.emplace_back(x, y, z);
+        }
+        else if (p[0] == 'v' && p[1] == 't')
+        {
+            p += 2;
+            float u = parseFloat(p), v = parseFloat(p);
+            uvs.emplace_back(u, 1.0f - v);
+        }
+        else if (p[0] == 'f' && p[1] == ' ')
+        {
+            p += 2;
+            face.clear();
+            IndexTriple triple {};
+            while (parseFaceVertex(p, triple, positions.size(), uvs.size(), normals.size()))
+            {
+                if (triple.position < 0 || triple.position >= static_cast<int>(positions.size()))
+                {
+                    RT_THROW("Invalid face index in " + path);
+                }
+                face.push_back(triple);
+            }
+
+            auto &builder = builders[currentMaterial];
+            auto emit = [&](const IndexTriple &t) {
+                auto [it, inserted] = builder.vertexByIndex.try_emplace(t, static_cast<std::uint32_t>(builder.mesh.vertices.size()));
+                if (inserted)
+                {
+                    Vertex vertex {};
+                    vertex.position = positions[t.position];
+                    if (t.normal >= 0 && t.normal < static_cast<int>(normals.size()))
+                        vertex.normal = normals[t.normal];
+                    else
+                        builder.hasNormals = false;
+                    if (t.uv >= 0 && t.uv < static_cast<int>(uvs.size()))
+                        vertex.uv = uvs[t.uv];
+                    builder.mesh.vertices.push_back(vertex);
+                }
+                builder.mesh.indices.push_back(it->second);
+            };
+            // triangulate polygons as a fan
+            for (std::size_t i = 1; i + 1 < face.size(); ++i)
+            {
+                emit(face[0]);
+                emit(face[i]);
+                emit(face[i + 1]);
+            }
+        }
+        else if ((p[0] == 'o' || p[0] == 'g') && (p[1] == ' ' || p[1] == '\0'))
+        {
+            flushGroup();
+        }
+        else if (line.compare(p - line.c_str(), 7, "usemtl ") == 0)
+        {
+            currentMaterial = scene.findMaterial(skipSpaces(p + 7));
+        }
+        else if (line.compare(p - line.c_str(), 7, "mtllib ") == 0)
+        {
+            auto mtlPath = std::filesystem::path(path).parent_path() / skipSpaces(p + 7);
+            loadMaterials(mtlPath.string(), scene);
+        }
+    }
+    flushGroup();
+
+    const auto &geometry = scene.getGeometry();
+    LOG("Loaded {}: {} node(s), {} unique mesh(es), {} duplicate(s) removed ({} KiB saved)",
+        path, scene.getNodes().size() - nodeCount, geometry.size(), geometry.getDuplicateCount(),
+        geometry.getDeduplicatedBytes() / 1024);
+}
+
+void ObjLoader::loadMaterials(const std::string &path, Scene &scene)
+{
+    std::ifstream file {path};
+    if (!file.is_open())
+    {
+        WLOG("Failed to open material library {}", path);
+        return;
+    }
+
+    Material material;
+    bool hasMaterial = false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const char *p = skipSpaces(line.c_str());
+        if (line.compare(p - line.c_str(), 7, "newmtl ") == 0)
+        {
+            if (hasMaterial) scene.addMaterial(material);
+            material = Material {skipSpaces(p + 7)};
+            hasMaterial = true;
+        }
+        else if (p[0] == 'K' && p[1] == 'd')
+        {
+            p += 2;
+            float r = parseFloat(p), g = parseFloat(p), b = parseFloat(p);
+            material.baseColor = glm::vec4 {r, g, b, material.baseColor.w};
+        }
+        else if (p[0] == 'd' && p[1] == ' ')
+        {
+            p += 1;
+            material.baseColor.w = parseFloat(p);
+        }
+    }
+    if (hasMaterial) scene.addMaterial(material);
+}
+}
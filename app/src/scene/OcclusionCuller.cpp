@@ -0,0 +1,323 @@
+#include <scene/OcclusionCuller.h>
+#include <core/Clock.h>
+#include <core/LinearArena.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RW_RASTER_SSE 1
+#endif
+
+namespace rw {
+namespace {
+constexpr std::uint32_t ROWS_PER_BAND = 16;
+constexpr std::size_t NODES_PER_CHUNK = 256;
+// corners closer than this in clip w are behind or at the camera, the bounds are kept
+constexpr float MIN_W = 1.0e-4f;
+// occluders are tested against their own depth, keep interpolation noise from hiding them
+constexpr float DEPTH_BIAS = 1.0e-6f;
+}
+
+OcclusionCuller::OcclusionCuller(ThreadPool &pool, const OcclusionOptions &options) : mPool {pool}, mOptions {options}
+{
+    mOptions.width = (std::max(mOptions.width, 4u) + 3u) & ~3u;
+    mOptions.height = std::max(mOptions.height, 1u);
+
+    std::uint32_t width = mOptions.width;
+    std::uint32_t height = mOptions.height;
+    for (;;)
+    {
+        mLevels.push_back(Level {width, height, std::vector<float>(static_cast<std::size_t>(width) * height, 1.0f)});
+        if (width == 1 && height == 1) break;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+}
+
+void OcclusionCuller::prepare(const Scene &scene, const std::vector<std::uint32_t> &nodes, const glm::mat4 &viewProjection, const glm::vec3 &eye)
+{
+    mViewProjection = viewProjection;
+    mStats = {};
+
+    const std::uint64_t start = nowNs();
+    selectOccluders(scene, nodes, eye);
+    setupTriangles(scene);
+
+    auto &depth = mLevels.front().depth;
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    // bands own disjoint rows of the depth buffer, so they need no synchronization
+    const std::uint32_t bands = (mOptions.height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+    mPool.parallelFor(bands, 1, [this](std::size_t begin, std::size_t end) {
+        for (std::size_t band = begin; band < end; ++band)
+        {
+            const auto rowBegin = static_cast<std::uint32_t>(band) * ROWS_PER_BAND;
+            rasterizeBand(rowBegin, std::min(rowBegin + ROWS_PER_BAND, mOptions.height));
+        }
+    });
+    const std::uint64_t rasterized = nowNs();
+    buildPyramid();
+    mStats.rasterMs = nsToMs(rasterized - start);
+    mStats.pyramidMs = nsToMs(nowNs() - rasterized);
+}
+
+void OcclusionCuller::selectOccluders(const Scene &scene, const std::vector<std::uint32_t> &nodes, const glm::vec3 &eye)
+{
+    const auto &sceneNodes = scene.getNodes();
+    ArenaScope scratch {getThreadArena()};
+    auto candidates = scratch.makeVector<std::pair<float, std::uint32_t>>();
+    for (auto index : nodes)
+    {
+        const auto &node = sceneNodes[index];
+        const auto &mesh = scene.getGeometry().get(node.mesh);
+        const std::size_t triangles = (mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size()) / 3;
+        if (triangles == 0 || triangles > mOptions.maxOccluderTriangles) continue;
+
+        // angular size of the bounds, a cheap stand-in for the covered screen area
+        const float radius = glm::length(node.worldBounds.extent()) * 0.5f;
+        const float distance = std::max(glm::length(node.worldBounds.center() - eye) - radius, radius * 0.1f);
+        const float size = radius / std::max(distance, 1.0e-3f);
+        if (size >= mOptions.minOccluderSize) candidates.emplace_back(size, index);
+    }
+
+    const std::size_t count = std::min<std::size_t>(candidates.size(), mOptions.maxOccluders);
+    std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(count), candidates.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+
+    mOccluders.clear();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        mOccluders.push_back(candidates[i].second);
+    }
+    mStats.occluders = static_cast<std::uint32_t>(mOccluders.size());
+}
+
+void OcclusionCuller::setupTriangles(const Scene &scene)
+{
+    mTriangles.clear();
+    const float width = static_cast<float>(mOptions.width);
+    const float height = static_cast<float>(mOptions.height);
+    ArenaScope scratch {getThreadArena()};
+    auto clip = scratch.makeVector<glm::vec4>();
+
+    for (auto index : mOccluders)
+    {
+        const auto &node = scene.getNodes()[index];
+        const auto &mesh = scene.getGeometry().get(node.mesh);
+        const glm::mat4 transform = mViewProjection * node.transform;
+
+        clip.resize(mesh.vertices.size());
+        for (std::size_t v = 0; v < mesh.vertices.size(); ++v)
+        {
+            clip[v] = transform * glm::vec4(mesh.vertices[v].position, 1.0f);
+        }
+
+        const std::size_t count = mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size();
+        for (std::size_t i = 0; i + 2 < count; i += 3)
+        {
+            Triangle triangle;
+            bool valid = true;
+            for (std::size_t c = 0; c < 3 && valid; ++c)
+            {
+                const glm::vec4 &p = clip[mesh.indices.empty() ? i + c : mesh.indices[i + c]];
+                // skipping triangles crossing the near plane only loses occlusion, it never hides anything
+                if (p.w < MIN_W || p.z < 0.0f)
+                {
+                    valid = false;
+                    break;
+                }
+                const float invW = 1.0f / p.w;
+                triangle.v[c] = glm::vec3((p.x * invW * 0.5f + 0.5f) * width, (p.y * invW * 0.5f + 0.5f) * height, p.z * invW);
+            }
+            if (valid) mTriangles.push_back(triangle);
+        }
+    }
+    mStats.occluderTriangles = static_cast<std::uint32_t>(mTriangles.size());
+}
+
+void OcclusionCuller::rasterizeBand(std::uint32_t rowBegin, std::uint32_t rowEnd)
+{
+    auto &level = mLevels.front();
+    for (const auto &triangle : mTriangles)
+    {
+        const glm::vec3 &a = triangle.v[0];
+        glm::vec3 b = triangle.v[1];
+        glm::vec3 c = triangle.v[2];
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1.0e-8f) continue;
+        // occluders are often open meshes seen from behind, so both windings are drawn
+        if (area < 0.0f)
+        {
+            std::swap(b, c);
+            area = -area;
+        }
+
+        const float minX = std::min(a.x, std::min(b.x, c.x));
+        const float maxX = std::max(a.x, std::max(b.x, c.x));
+        const float minY = std::min(a.y, std::min(b.y, c.y));
+        const float maxY = std::max(a.y, std::max(b.y, c.y));
+        const int x0 = std::max(static_cast<int>(std::floor(minX)), 0) & ~3;
+        const int x1 = std::min(static_cast<int>(std::ceil(maxX)), static_cast<int>(level.width));
+        const int y0 = std::max(static_cast<int>(std::floor(minY)), static_cast<int>(rowBegin));
+        const int y1 = std::min(static_cast<int>(std::ceil(maxY)), static_cast<int>(rowEnd));
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        // edge functions e(x, y) = A x + B y + C, positive inside
+        const float edgeA[3] = {a.y - b.y, b.y - c.y, c.y - a.y};
+        const float edgeB[3] = {b.x - a.x, c.x - b.x, a.x - c.x};
+        const float edgeC[3] = {a.x * b.y - a.y * b.x, b.x * c.y - b.y * c.x, c.x * a.y - c.y * a.x};
+        // depth is linear in screen space after the perspective divide
+        const float invArea = 1.0f / area;
+        const float depthA = (edgeA[1] * a.z + edgeA[2] * b.z + edgeA[0] * c.z) * invArea;
+        const float depthB = (edgeB[1] * a.z + edgeB[2] * b.z + edgeB[0] * c.z) * invArea;
+        const float depthC = (edgeC[1] * a.z + edgeC[2] * b.z + edgeC[0] * c.z) * invArea;
+
+        for (int y = y0; y < y1; ++y)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            float *row = level.depth.data() + static_cast<std::size_t>(y) * level.width;
+#ifdef RW_RASTER_SSE
+            const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero = _mm_setzero_ps();
+            __m128 stepA[3], rowE[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                stepA[e] = _mm_set1_ps(edgeA[e]);
+                rowE[e] = _mm_set1_ps(edgeB[e] * py + edgeC[e]);
+            }
+            const __m128 depthStep = _mm_set1_ps(depthA);
+            const __m128 depthRow = _mm_set1_ps(depthB * py + depthC);
+            for (int x = x0; x < x1; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[0], px), rowE[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[1], px), rowE[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[2], px), rowE[2]), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                const __m128 depth = _mm_add_ps(_mm_mul_ps(depthStep, px), depthRow);
+                const __m128 old = _mm_loadu_ps(row + x);
+                const __m128 nearer = _mm_min_ps(old, depth);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+#else
+            for (int x = x0; x < x1; ++x)
+            {
+                const float px = static_cast<float>(x) + 0.5f;
+                if (edgeA[0] * px + edgeB[0] * py + edgeC[0] < 0.0f || edgeA[1] * px + edgeB[1] * py + edgeC[1] < 0.0f ||
+                    edgeA[2] * px + edgeB[2] * py + edgeC[2] < 0.0f)
+                {
+                    continue;
+                }
+                row[x] = std::min(row[x], depthA * px + depthB * py + depthC);
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    // every texel keeps the farthest depth below it, so a test against it is conservative
+    for (std::size_t l = 1; l < mLevels.size(); ++l)
+    {
+        const auto &src = mLevels[l - 1];
+        auto &dst = mLevels[l];
+        for (std::uint32_t y = 0; y < dst.height; ++y)
+        {
+            const std::uint32_t sy0 = y * 2;
+            const std::uint32_t sy1 = std::min(sy0 + 1, src.height - 1);
+            for (std::uint32_t x = 0; x < dst.width; ++x)
+            {
+                const std::uint32_t sx0 = x * 2;
+                const std::uint32_t sx1 = std::min(sx0 + 1, src.width - 1);
+                dst.depth[y * dst.width + x] = std::max(std::max(src.depth[sy0 * src.width + sx0], src.depth[sy0 * src.width + sx1]),
+                                                        std::max(src.depth[sy1 * src.width + sx0], src.depth[sy1 * src.width + sx1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const BoundingBox &bounds) const
+{
+    if (mTriangles.empty()) return true;
+
+    float minX = std::numeric_limits<float>::max(), minY = minX, minZ = minX;
+    float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner {(i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z};
+        const glm::vec4 p = mViewProjection * glm::vec4(corner, 1.0f);
+        if (p.w < MIN_W) return true;
+        const float invW = 1.0f / p.w;
+        minX = std::min(minX, p.x * invW);
+        maxX = std::max(maxX, p.x * invW);
+        minY = std::min(minY, p.y * invW);
+        maxY = std::max(maxY, p.y * invW);
+        minZ = std::min(minZ, p.z * invW);
+    }
+    if (minZ <= 0.0f) return true;
+
+    const auto &base = mLevels.front();
+    const float width = static_cast<float>(base.width);
+    const float height = static_cast<float>(base.height);
+    const int x0 = std::clamp(static_cast<int>(std::floor((minX * 0.5f + 0.5f) * width)), 0, static_cast<int>(base.width) - 1);
+    const int x1 = std::clamp(static_cast<int>(std::floor((maxX * 0.5f + 0.5f) * width)), 0, static_cast<int>(base.width) - 1);
+    const int y0 = std::clamp(static_cast<int>(std::floor((minY * 0.5f + 0.5f) * height)), 0, static_cast<int>(base.height) - 1);
+    const int y1 = std::clamp(static_cast<int>(std::floor((maxY * 0.5f + 0.5f) * height)), 0, static_cast<int>(base.height) - 1);
+
+    // the level on which the rectangle spans at most two texels per axis
+    const int span = std::max(x1 - x0, y1 - y0) + 1;
+    std::size_t l = 0;
+    while ((1 << l) * 2 < span && l + 1 < mLevels.size()) ++l;
+
+    const auto &level = mLevels[l];
+    float farthest = 0.0f;
+    for (int y = y0 >> l; y <= (y1 >> l); ++y)
+    {
+        for (int x = x0 >> l; x <= (x1 >> l); ++x)
+        {
+            farthest = std::max(farthest, level.depth[static_cast<std::size_t>(y) * level.width + static_cast<std::size_t>(x)]);
+        }
+    }
+    return minZ <= farthest + DEPTH_BIAS;
+}
+
+template <typename Bounds>
+void OcclusionCuller::cullNodes(const std::vector<Bounds> &all, std::vector<std::uint32_t> &nodes)
+{
+    const std::uint64_t start = nowNs();
+    mVisible.assign(nodes.size(), 1);
+    if (!mTriangles.empty())
+    {
+        mPool.parallelFor(nodes.size(), NODES_PER_CHUNK, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                mVisible[i] = isVisible(all[nodes[i]].worldBounds) ? 1 : 0;
+            }
+        });
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (mVisible[i]) nodes[kept++] = nodes[i];
+    }
+    mStats.tested += static_cast<std::uint32_t>(nodes.size());
+    mStats.culled += static_cast<std::uint32_t>(nodes.size() - kept);
+    nodes.resize(kept);
+    mStats.testMs += nsToMs(nowNs() - start);
+}
+
+void OcclusionCuller::cull(const Scene &scene, std::vector<std::uint32_t> &nodes)
+{
+    cullNodes(scene.getNodes(), nodes);
+}
+
+void OcclusionCuller::cullAnimated(const Scene &scene, std::vector<std::uint32_t> &nodes)
+{
+    cullNodes(scene.getAnimatedNodes(), nodes);
+}
+}
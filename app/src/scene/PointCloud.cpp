@@ -0,0 +1,171 @@
+#include <scene/PointCloud.h>
+#include <core/Trace.h>
+#include <Log.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <utility>
+
+namespace rw {
+namespace {
+// far away chunks still show their outline
+constexpr float MIN_CHUNK_POINTS = 64.0f;
+constexpr std::uint32_t DEFAULT_COLOR = 0xffb3b3b3u;
+
+std::uint32_t packColor(float r, float g, float b)
+{
+    const auto channel = [](float value) { return static_cast<std::uint32_t>(std::clamp(value, 0.0f, 255.0f) + 0.5f); };
+    return channel(r) | channel(g) << 8 | channel(b) << 16 | 0xff000000u;
+}
+} // namespace
+
+PointCloud::PointCloud(const PointCloudOptions &options) : mOptions {options}
+{
+    mOptions.pointsPerChunk = std::max(mOptions.pointsPerChunk, 1u);
+}
+
+bool PointCloud::isPointCloud(const std::string &path)
+{
+    auto extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".xyz" || extension == ".pts";
+}
+
+void PointCloud::load(const std::string &path)
+{
+    TRACE_SCOPE("point cloud import");
+    std::ifstream file {path};
+    if (!file)
+    {
+        RT_THROW("Failed to open point cloud " + path);
+    }
+
+    mPoints.clear();
+    mBounds = {};
+    std::string line;
+    std::array<float, 7> values {};
+    while (std::getline(file, line))
+    {
+        const char *p = line.c_str();
+        std::size_t count = 0;
+        while (count < values.size())
+        {
+            char *end = nullptr;
+            const float value = std::strtof(p, &end);
+            if (end == p) break;
+            values[count++] = value;
+            p = end;
+        }
+        // the point count heading a .pts file and comments have fewer columns
+        if (count < 3) continue;
+
+        PointVertex point {glm::vec3(values[0], values[1], values[2]), DEFAULT_COLOR};
+        if (count >= 6) point.color = packColor(values[count - 3], values[count - 2], values[count - 1]);
+        mBounds.expand(point.position);
+        mPoints.push_back(point);
+    }
+    if (mPoints.empty()) RT_THROW("No points in " + path);
+
+    buildChunks();
+    LOG("Point cloud {}: {} point(s) in {} chunk(s)", path, mPoints.size(), mChunks.size());
+}
+
+void PointCloud::buildChunks()
+{
+    mChunks.clear();
+    std::vector<std::pair<std::size_t, std::size_t>> ranges {{0, mPoints.size()}};
+    while (!ranges.empty())
+    {
+        const auto [begin, end] = ranges.back();
+        ranges.pop_back();
+
+        BoundingBox bounds;
+        for (std::size_t i = begin; i < end; ++i) bounds.expand(mPoints[i].position);
+        if (end - begin > mOptions.pointsPerChunk)
+        {
+            // split the longest side at the median, so the chunks stay balanced on uneven scans
+            const glm::vec3 extent = bounds.extent();
+            const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            const std::size_t middle = begin + (end - begin) / 2;
+            std::nth_element(mPoints.begin() + begin, mPoints.begin() + middle, mPoints.begin() + end,
+                             [axis](const PointVertex &a, const PointVertex &b) { return a.position[axis] < b.position[axis]; });
+            ranges.emplace_back(middle, end);
+            ranges.emplace_back(begin, middle);
+            continue;
+        }
+
+        // seeded, so a chunk is subsampled the same way every run
+        std::mt19937 random {static_cast<std::uint32_t>(mChunks.size())};
+        std::shuffle(mPoints.begin() + begin, mPoints.begin() + end, random);
+        mChunks.push_back(PointChunk {bounds, static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(end - begin)});
+    }
+}
+
+void PointCloud::fitTo(std::uint64_t maxPoints)
+{
+    if (mPoints.size() <= maxPoints) return;
+
+    const double fraction = static_cast<double>(maxPoints) / static_cast<double>(mPoints.size());
+    std::vector<PointVertex> kept;
+    kept.reserve(maxPoints);
+    for (auto &chunk : mChunks)
+    {
+        const auto count = std::max<std::uint32_t>(static_cast<std::uint32_t>(chunk.pointCount * fraction), 1u);
+        const auto first = mPoints.begin() + chunk.firstPoint;
+        chunk.firstPoint = static_cast<std::uint32_t>(kept.size());
+        chunk.pointCount = count;
+        kept.insert(kept.end(), first, first + count);
+    }
+    WLOG("Point cloud reduced from {} to {} point(s) to fit into video memory", mPoints.size(), kept.size());
+    mPoints = std::move(kept);
+}
+
+void PointCloud::select(const Camera &camera, const Frustum &frustum, float viewportHeight, std::vector<PointSelection> &selection)
+{
+    mStats = {};
+    mStats.chunks = static_cast<std::uint32_t>(mChunks.size());
+    selection.clear();
+
+    const float projectionScale = viewportHeight / (2.0f * std::tan(camera.getFovy() * 0.5f));
+    const glm::vec3 eye = camera.getPosition();
+    const float density = mOptions.density * mRefinement;
+    const auto budget = static_cast<std::uint64_t>(static_cast<double>(mOptions.pointBudget) * mRefinement);
+    std::uint64_t total = 0;
+    for (std::uint32_t i = 0; i < mChunks.size(); ++i)
+    {
+        const auto &chunk = mChunks[i];
+        if (!frustum.intersects(chunk.bounds)) continue;
+        ++mStats.visibleChunks;
+        mStats.visiblePoints += chunk.pointCount;
+
+        // about density points per pixel of the square the chunk's diagonal spans on screen
+        const glm::vec3 outside = glm::max(glm::max(chunk.bounds.min - eye, eye - chunk.bounds.max), glm::vec3(0.0f));
+        const float distance = std::max(glm::length(outside), 1.0e-3f);
+        const float size = glm::length(chunk.bounds.extent()) * projectionScale / distance;
+        const float wanted = std::max(size * size * density, MIN_CHUNK_POINTS);
+        const auto count = static_cast<std::uint32_t>(std::min(wanted, static_cast<float>(chunk.pointCount)));
+        selection.push_back(PointSelection {i, count});
+        total += count;
+    }
+
+    if (total > budget)
+    {
+        // every chunk gives up the same share, the near ones still draw the most
+        const double scale = static_cast<double>(budget) / static_cast<double>(total);
+        total = 0;
+        for (auto &chunk : selection)
+        {
+            chunk.count = std::max<std::uint32_t>(static_cast<std::uint32_t>(chunk.count * scale), 1u);
+            total += chunk.count;
+        }
+        mStats.budgetLimited = true;
+    }
+    mStats.selectedPoints = total;
+}
+}
@@ -0,0 +1,91 @@
+#include <scene/Scene.h>
+#include <Log.h>
+
+namespace rw {
+Scene::Scene()
+{
+    addMaterial(Material {"default"});
+}
+
+MaterialId Scene::addMaterial(const Material &material)
+{
+    auto found = mMaterialByName.find(material.name);
+    if (found != mMaterialByName.end())
+    {
+        mMaterials[found->second] = material;
+        return found->second;
+    }
+
+    const auto id = static_cast<MaterialId>(mMaterials.size());
+    mMaterials.push_back(material);
+    mMaterialByName.emplace(material.name, id);
+    return id;
+}
+
+MaterialId Scene::findMaterial(const std::string &name) const
+{
+    auto found = mMaterialByName.find(name);
+    return found != mMaterialByName.end() ? found->second : DEFAULT_MATERIAL;
+}
+
+void Scene::addNode(MeshId mesh, MaterialId material, const glm::mat4 &transform)
+{
+    mNodes.push_back(SceneNode {mesh, material, transform, mGeometry.get(mesh).bounds.transformed(transform)});
+}
+
+SkinnedMeshId Scene::addSkinnedMesh(SkinnedMeshData &&mesh)
+{
+    if (mesh.joints.size() != mesh.mesh.vertices.size() || mesh.weights.size() != mesh.mesh.vertices.size())
+    {
+        RT_THROW("Skinned mesh needs joints and weights for every vertex");
+    }
+    if (!mesh.mesh.bounds.isValid()) mesh.mesh.computeBounds();
+    mSkinnedMeshes.push_back(std::move(mesh));
+    return static_cast<SkinnedMeshId>(mSkinnedMeshes.size() - 1);
+}
+
+SkeletonId Scene::addSkeleton(Skeleton &&skeleton)
+{
+    for (std::size_t j = 0; j < skeleton.joints.size(); ++j)
+    {
+        if (skeleton.joints[j].parent >= static_cast<std::int32_t>(j)) RT_THROW("Skeleton joints must be ordered parents first");
+    }
+    mSkeletons.push_back(std::move(skeleton));
+    return static_cast<SkeletonId>(mSkeletons.size() - 1);
+}
+
+ClipId Scene::addClip(AnimationClip &&clip)
+{
+    mClips.push_back(std::move(clip));
+    return static_cast<ClipId>(mClips.size() - 1);
+}
+
+void Scene::addAnimatedNode(SkinnedMeshId mesh, SkeletonId skeleton, ClipId clip, MaterialId material, const glm::mat4 &transform, float timeOffset)
+{
+    // joints move vertices out of the bind pose, keep a margin around it for culling
+    BoundingBox bounds = mSkinnedMeshes.at(mesh).mesh.bounds;
+    const glm::vec3 margin = bounds.extent() * 0.5f;
+    bounds.min = bounds.min - margin;
+    bounds.max = bounds.max + margin;
+    mAnimatedNodes.push_back(AnimatedNode {mesh, skeleton, clip, material, transform, timeOffset, bounds.transformed(transform)});
+}
+
+BoundingBox Scene::getBounds() const
+{
+    BoundingBox bounds;
+    for (const auto &node : mNodes)
+    {
+        bounds.expand(node.worldBounds);
+    }
+    for (const auto &node : mAnimatedNodes)
+    {
+        bounds.expand(node.worldBounds);
+    }
+    return bounds;
+}
+
+void Scene::clear()
+{
+    *this = Scene {};
+}
+}
@@ -0,0 +1,154 @@
+#include <scene/ShadowCascades.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rw {
+namespace {
+// cascades end where the scene does, rounded up to an eighth of an octave so small zooms keep the splits
+constexpr float REACH_STEPS_PER_OCTAVE = 8.0f;
+// depth range margin, casters exactly on the bounds must not be clipped
+constexpr float DEPTH_MARGIN = 0.01f;
+}
+
+ShadowCascades::ShadowCascades(const ShadowOptions &options) : mOptions {options}
+{
+    mOptions.cascades = std::clamp(mOptions.cascades, 1u, MAX_CASCADES);
+    mOptions.resolution = std::max(mOptions.resolution, 1u);
+    mCascades.resize(mOptions.cascades);
+    mStats.cascades = mOptions.cascades;
+    setLightDirection(mOptions.lightDirection);
+}
+
+void ShadowCascades::setLightDirection(const glm::vec3 &direction)
+{
+    mOptions.lightDirection = glm::normalize(direction);
+    const glm::vec3 reference = std::abs(mOptions.lightDirection.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    mRight = glm::normalize(glm::cross(reference, mOptions.lightDirection));
+    mUp = glm::cross(mOptions.lightDirection, mRight);
+    invalidate();
+}
+
+void ShadowCascades::invalidate()
+{
+    for (auto &placement : mPlacements)
+    {
+        if (placement.valid) ++mStats.changed;
+        placement.valid = false;
+    }
+}
+
+void ShadowCascades::confirm(std::uint32_t cascade, std::uint64_t key)
+{
+    if (cascade >= mCascades.size() || mCascades[cascade].key != key) return;
+    mPlacements[cascade].confirmed = key;
+    mCascades[cascade].needsCasters = false;
+}
+
+void ShadowCascades::resetStats()
+{
+    mStats = {};
+    mStats.cascades = mOptions.cascades;
+}
+
+void ShadowCascades::update(const Camera &camera, const BoundingBox &sceneBounds, std::uint64_t staticVersion)
+{
+    if (staticVersion != mStaticVersion)
+    {
+        invalidate();
+        mStaticVersion = staticVersion;
+    }
+
+    const float nearPlane = camera.getNear();
+    float farPlane = camera.getFar();
+    if (sceneBounds.isValid())
+    {
+        const float reach = glm::length(camera.getPosition() - sceneBounds.center()) + 0.5f * glm::length(sceneBounds.extent());
+        const float rounded = std::exp2(std::ceil(std::log2(std::max(reach, nearPlane * 2.0f)) * REACH_STEPS_PER_OCTAVE) / REACH_STEPS_PER_OCTAVE);
+        farPlane = std::min(farPlane, rounded);
+    }
+
+    // light space depth of the casters; larger is closer to the light
+    const glm::vec3 &toLight = mOptions.lightDirection;
+    float depthMin = std::numeric_limits<float>::max();
+    float depthMax = std::numeric_limits<float>::lowest();
+    if (sceneBounds.isValid())
+    {
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const glm::vec3 point {corner & 1 ? sceneBounds.max.x : sceneBounds.min.x, corner & 2 ? sceneBounds.max.y : sceneBounds.min.y,
+                                   corner & 4 ? sceneBounds.max.z : sceneBounds.min.z};
+            const float depth = glm::dot(point, toLight);
+            depthMin = std::min(depthMin, depth);
+            depthMax = std::max(depthMax, depth);
+        }
+    }
+
+    // the slice between two view depths dn, df of a symmetric frustum is bounded by a sphere centred on
+    // the view axis; k is the squared half diagonal of the frustum at depth 1
+    const glm::mat4 projection = camera.getProjection();
+    const float k = 1.0f / (projection[0][0] * projection[0][0]) + 1.0f / (projection[1][1] * projection[1][1]);
+    const glm::mat4 toWorld = glm::inverse(camera.getView());
+    const auto count = static_cast<std::uint32_t>(mCascades.size());
+    float splitNear = nearPlane;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        const float t = static_cast<float>(i + 1) / static_cast<float>(count);
+        const float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+        const float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+        const float splitFar = mOptions.splitLambda * logSplit + (1.0f - mOptions.splitLambda) * uniformSplit;
+
+        const float centerDepth = std::clamp(0.5f * (splitNear + splitFar) * (1.0f + k), splitNear, splitFar);
+        const float radius = std::sqrt((splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * k);
+        const glm::vec3 center = glm::vec3(toWorld * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+        const glm::vec2 lightCenter {glm::dot(center, mRight), glm::dot(center, mUp)};
+        const float halfSize = radius * (1.0f + mOptions.padding);
+
+        float sliceMin = depthMin;
+        float sliceMax = depthMax;
+        if (!sceneBounds.isValid())
+        {
+            sliceMin = glm::dot(center, toLight) - radius;
+            sliceMax = glm::dot(center, toLight) + radius;
+        }
+        const float margin = std::max(sliceMax - sliceMin, radius) * DEPTH_MARGIN;
+        sliceMin -= margin;
+        sliceMax += margin;
+
+        auto &placement = mPlacements[i];
+        const glm::vec2 offset = glm::abs(lightCenter - placement.center);
+        const bool fits = placement.valid && placement.halfSize == halfSize && placement.depthMin == sliceMin && placement.depthMax == sliceMax &&
+                          std::max(offset.x, offset.y) + radius <= halfSize;
+        auto &cascade = mCascades[i];
+        if (!fits)
+        {
+            if (placement.valid) ++mStats.moved;
+            // whole texel steps keep the rasterization of the casters identical between placements
+            const float texel = 2.0f * halfSize / static_cast<float>(mOptions.resolution);
+            placement.valid = true;
+            placement.center = glm::floor(lightCenter / texel) * texel;
+            placement.halfSize = halfSize;
+            placement.depthMin = sliceMin;
+            placement.depthMax = sliceMax;
+
+            const float depthScale = 1.0f / (sliceMax - sliceMin);
+            glm::mat4 &m = cascade.viewProjection;
+            m = glm::mat4 {1.0f};
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                m[axis][0] = mRight[axis] / halfSize;
+                m[axis][1] = mUp[axis] / halfSize;
+                m[axis][2] = -toLight[axis] * depthScale;
+            }
+            m[3][0] = -placement.center.x / halfSize;
+            m[3][1] = -placement.center.y / halfSize;
+            m[3][2] = sliceMax * depthScale;
+            cascade.key = ++mNextKey;
+        }
+        cascade.splitDepth = splitFar;
+        cascade.needsCasters = cascade.key != placement.confirmed;
+        splitNear = splitFar;
+    }
+}
+}
@@ -0,0 +1,120 @@
+#include <scene/GeometryCache.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdio>
+#include <iterator>
+#include <random>
+
+namespace {
+int gFailures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++gFailures;                                                        \
+        }                                                                       \
+    } while (false)
+
+// Bumpy grid of about two units, centered at the origin, so a wrong match does not hide in symmetry.
+rw::MeshData makePart(float scale)
+{
+    constexpr std::uint32_t kSide = 8;
+    rw::MeshData mesh;
+    for (std::uint32_t y = 0; y <= kSide; ++y)
+    {
+        for (std::uint32_t x = 0; x <= kSide; ++x)
+        {
+            const float u = static_cast<float>(x) / kSide;
+            const float v = static_cast<float>(y) / kSide;
+            const glm::vec3 position {u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.1f * static_cast<float>((x * 7 + y * 3) % 5) - 0.2f};
+            mesh.vertices.push_back(rw::Vertex {position * scale, glm::vec3 {0.0f, 0.0f, 1.0f}, glm::vec2 {u, v}});
+        }
+    }
+    for (std::uint32_t y = 0; y < kSide; ++y)
+    {
+        for (std::uint32_t x = 0; x < kSide; ++x)
+        {
+            const std::uint32_t corner = y * (kSide + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), {corner, corner + 1, corner + kSide + 1, corner + 1, corner + kSide + 2, corner + kSide + 1});
+        }
+    }
+    mesh.computeBounds();
+    return mesh;
+}
+
+// What an exporter writes for a placed copy: the transform baked into float world positions, plus
+// the rounding noise of its own math. The loader then moves the copy back to the origin.
+rw::MeshData bakeAndRecenter(const rw::MeshData &part, const glm::mat4 &placement, float noiseAmplitude, std::mt19937 &random)
+{
+    std::uniform_real_distribution<float> noise {-noiseAmplitude, noiseAmplitude};
+    rw::MeshData copy = part;
+    for (auto &vertex : copy.vertices)
+    {
+        vertex.position = glm::vec3(placement * glm::vec4(vertex.position, 1.0f)) + glm::vec3(noise(random), noise(random), noise(random));
+    }
+    copy.recenter();
+    return copy;
+}
+
+void testCopiesFarFromOrigin()
+{
+    const glm::vec3 placements[] = {
+        {1000.3f, -2000.7f, 1500.1f}, {1003.9f, -2000.7f, 1500.1f}, {-3999.2f, 12.5f, 998.6f}, {4096.0f, 4096.0f, -4095.5f}};
+
+    std::mt19937 random {26};
+    const rw::MeshData part = makePart(1.0f);
+    rw::GeometryCache cache;
+    rw::MeshId first = rw::INVALID_MESH;
+    for (const auto &placement : placements)
+    {
+        const rw::MeshId id = cache.add(bakeAndRecenter(part, glm::translate(glm::mat4 {1.0f}, placement), 1.0e-4f, random));
+        if (first == rw::INVALID_MESH) first = id;
+        CHECK(id == first);
+    }
+    CHECK(cache.getDuplicateCount() == std::size(placements) - 1);
+
+    // the same topology with a different shape has to stay a mesh of its own
+    const rw::MeshId larger = cache.add(bakeAndRecenter(makePart(1.05f), glm::translate(glm::mat4 {1.0f}, placements[0]), 1.0e-4f, random));
+    CHECK(larger != first);
+}
+
+void testSmallPartsNearOrigin()
+{
+    std::mt19937 random {26};
+    const rw::MeshData part = makePart(0.01f);
+    rw::GeometryCache cache;
+    // a few ulps of the coordinates, all a copy at the origin picks up
+    const rw::MeshId id = cache.add(bakeAndRecenter(part, glm::mat4 {1.0f}, 2.0e-8f, random));
+    CHECK(cache.add(bakeAndRecenter(part, glm::mat4 {1.0f}, 2.0e-8f, random)) == id);
+    // the far placement tolerance must not swallow small differences of parts at the origin
+    CHECK(cache.add(makePart(0.011f)) != id);
+}
+}
+
+// pipe segments of many lengths share one tessellation, and so one content hash
+void testPartsSharingTopology()
+{
+    constexpr std::uint32_t kParts = 2000;
+    std::mt19937 random {26};
+    rw::GeometryCache cache;
+    for (std::uint32_t i = 0; i < kParts; ++i)
+    {
+        CHECK(cache.add(makePart(1.0f + 0.1f * static_cast<float>(i))) == i);
+    }
+    CHECK(cache.size() == kParts);
+    CHECK(cache.getDuplicateCount() == 0);
+
+    const glm::mat4 placement = glm::translate(glm::mat4 {1.0f}, glm::vec3 {2500.0f, -750.0f, 1200.0f});
+    CHECK(cache.add(bakeAndRecenter(makePart(1.0f + 0.1f * 1234.0f), placement, 1.0e-4f, random)) == 1234);
+}
+int main()
+{
+    testCopiesFarFromOrigin();
+    testSmallPartsNearOrigin();
+    testPartsSharingTopology();
+    if (gFailures == 0) std::printf("all geometry cache checks passed\n");
+    return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include <scene/GeometryCodec.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+int gFailures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++gFailures;                                                        \
+        }                                                                       \
+    } while (false)
+
+// Grid of side * side vertices. Flat, it has constant heights and normals; with noise, every
+// vertex has a random height and a random normal.
+rw::MeshData makeGrid(std::uint32_t side, float noise, std::mt19937 &random)
+{
+    std::uniform_real_distribution<float> offset {-noise, noise};
+    std::normal_distribution<float> direction;
+    rw::MeshData mesh;
+    for (std::uint32_t y = 0; y < side; ++y)
+    {
+        for (std::uint32_t x = 0; x < side; ++x)
+        {
+            const float u = static_cast<float>(x) / static_cast<float>(side - 1);
+            const float v = static_cast<float>(y) / static_cast<float>(side - 1);
+            glm::vec3 normal {0.0f, 0.0f, 1.0f};
+            if (noise > 0.0f) normal = glm::normalize(glm::vec3 {direction(random), direction(random), direction(random)});
+            mesh.vertices.push_back(rw::Vertex {glm::vec3 {u * 10.0f, v * 10.0f, offset(random)}, normal, glm::vec2 {u, v}});
+        }
+    }
+    for (std::uint32_t y = 0; y + 1 < side; ++y)
+    {
+        for (std::uint32_t x = 0; x + 1 < side; ++x)
+        {
+            const std::uint32_t corner = y * side + x;
+            mesh.indices.insert(mesh.indices.end(), {corner, corner + 1, corner + side, corner + 1, corner + side + 1, corner + side});
+        }
+    }
+    return mesh;
+}
+
+rw::MeshData roundTrip(const rw::MeshData &mesh, bool quantizeNormals)
+{
+    rw::GeometryCodecOptions options;
+    options.quantizeNormals = quantizeNormals;
+    std::vector<std::uint8_t> encoded;
+    rw::GeometryCodec::encode(mesh, options, encoded);
+
+    rw::MeshData decoded;
+    decoded.vertices.resize(mesh.vertices.size());
+    decoded.indices.resize(mesh.indices.size());
+    rw::GeometryCodec::decode(encoded.data(), encoded.size(), decoded);
+    return decoded;
+}
+
+bool sameBits(const rw::MeshData &a, const rw::MeshData &b)
+{
+    return a.vertices.size() == b.vertices.size() && a.indices == b.indices &&
+           (a.vertices.empty() || std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(rw::Vertex)) == 0);
+}
+
+void testExactRoundTrip()
+{
+    std::mt19937 random {39};
+    // 17 * 17 vertices, so the decoder also runs the scalar tail after its groups of 16
+    for (const float noise : {0.0f, 0.5f})
+    {
+        const rw::MeshData mesh = makeGrid(17, noise, random);
+        CHECK(sameBits(roundTrip(mesh, false), mesh));
+    }
+    const rw::MeshData large = makeGrid(128, 0.5f, random);
+    CHECK(sameBits(roundTrip(large, false), large));
+
+    const rw::MeshData empty;
+    CHECK(sameBits(roundTrip(empty, false), empty));
+    CHECK(sameBits(roundTrip(empty, true), empty));
+}
+
+void testQuantizedNormals()
+{
+    std::mt19937 random {39};
+    const rw::MeshData mesh = makeGrid(64, 0.5f, random);
+    const rw::MeshData decoded = roundTrip(mesh, true);
+    CHECK(decoded.indices == mesh.indices);
+    float largestError = 0.0f;
+    bool othersExact = true;
+    for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        othersExact = othersExact && decoded.vertices[i].position == mesh.vertices[i].position && decoded.vertices[i].uv == mesh.vertices[i].uv;
+        largestError = std::max(largestError, glm::length(decoded.vertices[i].normal - mesh.vertices[i].normal));
+    }
+    CHECK(othersExact);
+    // 16 bit octahedral components are good to a few 1e-5
+    CHECK(largestError < 1.0e-4f);
+}
+
+// Offset of the first lane state of the first rANS coded plane, 0 when every plane was stored otherwise.
+std::size_t findRansState(const std::vector<std::uint8_t> &encoded)
+{
+    std::size_t offset = 2;
+    while (offset + 5 <= encoded.size())
+    {
+        const std::uint8_t mode = encoded[offset];
+        const std::uint32_t size = encoded[offset + 1] | (encoded[offset + 2] << 8) | (encoded[offset + 3] << 16) |
+                                   (static_cast<std::uint32_t>(encoded[offset + 4]) << 24);
+        if (mode == 2)
+        {
+            const std::uint32_t symbols = encoded[offset + 5] | (encoded[offset + 6] << 8);
+            return offset + 5 + 2 + symbols * 3;
+        }
+        offset += 5 + size;
+    }
+    return 0;
+}
+
+void testCorruptData()
+{
+    std::mt19937 random {39};
+    const rw::MeshData mesh = makeGrid(64, 0.5f, random);
+    std::vector<std::uint8_t> encoded;
+    rw::GeometryCodec::encode(mesh, rw::GeometryCodecOptions {}, encoded);
+
+    // the message of the error decoding throws, empty when it succeeds
+    const auto decodeError = [&mesh](const std::vector<std::uint8_t> &data, std::size_t size) {
+        rw::MeshData decoded;
+        decoded.vertices.resize(mesh.vertices.size());
+        decoded.indices.resize(mesh.indices.size());
+        try
+        {
+            rw::GeometryCodec::decode(data.data(), size, decoded);
+        }
+        catch (const std::runtime_error &error)
+        {
+            return std::string {error.what()};
+        }
+        return std::string {};
+    };
+    CHECK(decodeError(encoded, encoded.size()).empty());
+    CHECK(decodeError(encoded, encoded.size() - 1).find("truncated") != std::string::npos);
+
+    // a state below the renormalization bound would make the decoder read bytes without bound
+    const std::size_t state = findRansState(encoded);
+    CHECK(state != 0);
+    if (state != 0)
+    {
+        std::vector<std::uint8_t> corrupt = encoded;
+        std::memset(corrupt.data() + state, 0, 4);
+        CHECK(decodeError(corrupt, corrupt.size()).find("rANS state") != std::string::npos);
+    }
+}
+}
+
+int main()
+{
+    testExactRoundTrip();
+    testQuantizedNormals();
+    testCorruptData();
+    if (gFailures == 0) std::printf("all geometry codec checks passed\n");
+    return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include <core/RadixSort.h>
+#include <render/InstanceBatcher.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace {
+int gFailures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++gFailures;                                                        \
+        }                                                                       \
+    } while (false)
+
+std::vector<rw::SortItem> makeItems(std::size_t count, std::uint64_t prefix, std::uint64_t lowMask, std::mt19937_64 &random)
+{
+    std::vector<rw::SortItem> items(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        items[i] = rw::SortItem {prefix | (random() & lowMask), static_cast<std::uint32_t>(i)};
+    }
+    return items;
+}
+
+// Equal keys have to keep their input order, so the indices are compared as well as the keys.
+bool matchesStableSort(rw::RadixSorter &sorter, std::vector<rw::SortItem> items)
+{
+    std::vector<rw::SortItem> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const rw::SortItem &a, const rw::SortItem &b) { return a.key < b.key; });
+    sorter.sort(items);
+    return std::equal(items.begin(), items.end(), expected.begin(), expected.end(),
+        [](const rw::SortItem &a, const rw::SortItem &b) { return a.key == b.key && a.index == b.index; });
+}
+
+void testSmallInputs(rw::RadixSorter &sorter)
+{
+    std::mt19937_64 random {49};
+    CHECK(matchesStableSort(sorter, {}));
+    CHECK(matchesStableSort(sorter, makeItems(1, 0, ~0ull, random)));
+    CHECK(matchesStableSort(sorter, makeItems(2, 0, ~0ull, random)));
+    // below the block size, one block does all the work
+    CHECK(matchesStableSort(sorter, makeItems(1000, 0, ~0ull, random)));
+    CHECK(sorter.getStats().blocks == 1);
+}
+
+void testMultipleBlocks(rw::RadixSorter &sorter)
+{
+    std::mt19937_64 random {49};
+    CHECK(matchesStableSort(sorter, makeItems(200000, 0, ~0ull, random)));
+    CHECK(sorter.getStats().blocks > 1);
+    CHECK(sorter.getStats().passes == 8);
+    // few distinct keys, long runs of equal ones spread over every block
+    CHECK(matchesStableSort(sorter, makeItems(100000, 0, 0xf, random)));
+    // sizes that do not split evenly into blocks
+    CHECK(matchesStableSort(sorter, makeItems(65537, 0, ~0ull, random)));
+}
+
+void testSharedPrefix(rw::RadixSorter &sorter)
+{
+    std::mt19937_64 random {49};
+    // only the two lowest digits differ, the others need no pass
+    CHECK(matchesStableSort(sorter, makeItems(50000, 0xabcd'0000'0000'0000ull, 0xffff, random)));
+    CHECK(sorter.getStats().passes == 2);
+    // a differing bit in the middle of an otherwise shared digit
+    CHECK(matchesStableSort(sorter, makeItems(50000, 0x1234'5600'0000'0000ull, 0x0000'0010'0000'00ffull, random)));
+    CHECK(sorter.getStats().passes == 2);
+    // all keys equal: nothing moves
+    CHECK(matchesStableSort(sorter, makeItems(50000, 0x42ull, 0, random)));
+    CHECK(sorter.getStats().passes == 0);
+}
+
+void testDrawKeys(rw::RadixSorter &sorter)
+{
+    using rw::DrawKey;
+    // ids past their field are folded into it, the fields above stay intact
+    CHECK(DrawKey::encode(rw::DrawPass::Scene, 0, 5u + (1u << DrawKey::MESH_BITS), 7u, 3u) == DrawKey::encode(rw::DrawPass::Scene, 0, 5u, 7u, 3u));
+    CHECK(DrawKey::encode(rw::DrawPass::Scene, 0, 5u, 7u + (1u << DrawKey::MATERIAL_BITS), 3u) == DrawKey::encode(rw::DrawPass::Scene, 0, 5u, 7u, 3u));
+    CHECK(DrawKey::encode(rw::DrawPass::Shadow, 0, ~0u, ~0u, 0u) < DrawKey::encode(rw::DrawPass::Scene, 0, 0u, 0u, 0u));
+
+    std::mt19937 random {49};
+    std::uniform_int_distribution<std::uint32_t> mesh {0, (1u << DrawKey::MESH_BITS) * 2};
+    std::uniform_int_distribution<std::uint32_t> material {0, (1u << DrawKey::MATERIAL_BITS) * 2};
+    std::uniform_int_distribution<std::uint32_t> depth {0, (1u << DrawKey::DEPTH_BITS) - 1};
+    std::vector<rw::SortItem> items(60000);
+    for (std::uint32_t i = 0; i < items.size(); ++i)
+    {
+        const auto pass = i % 3 == 0 ? rw::DrawPass::Shadow : rw::DrawPass::Scene;
+        items[i] = rw::SortItem {DrawKey::encode(pass, 0, mesh(random), material(random), depth(random)), i};
+    }
+    CHECK(matchesStableSort(sorter, items));
+}
+}
+
+int main()
+{
+    rw::ThreadPool pool {3};
+    rw::RadixSorter sorter {pool};
+    testSmallInputs(sorter);
+    testMultipleBlocks(sorter);
+    testSharedPrefix(sorter);
+    testDrawKeys(sorter);
+    if (gFailures == 0) std::printf("all radix sort checks passed\n");
+    return gFailures == 0 ? 0 : 1;
+}